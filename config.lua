@@ -30,6 +30,8 @@ render =
     antialias_samples = 4;                      -- Maximum depends and is limited by hardware capabilities.
     z_depth = 24;                               -- Maximum and recommended is 24.
     texture_border = 16;
+    texture_compression = 0;                    -- 1 - atlas pages are S3TC (BC1 / BC3) compressed and cached, if supported.
+    transparency_mode = 0;                      -- 0 - rebuild whole BSP each frame; 1 - rooms BSP on load, entities depth sorted (experimental, opt-in until validated).
     fog_color = {r = 255, g = 255, b = 255};
 }
 
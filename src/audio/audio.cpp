@@ -18,6 +18,7 @@ extern "C" {
 #include "../core/vmath.h"
 #include "../core/gl_text.h"
 #include "../core/console.h"
+#include "../core/jobs.h"
 #include "../script/script.h"
 #include "../render/camera.h"
 #include "../vt/vt_level.h"
@@ -30,9 +31,7 @@ extern "C" {
 #include "audio.h"
 #include "audio_stream.h"
 #include "audio_fx.h"
-
-#define STB_VORBIS_HEADER_ONLY
-#include "stb_vorbis.c"
+#include "audio_decoder.h"
 
 static ALCdevice              *al_device      = NULL;
 static ALCcontext             *al_context     = NULL;
@@ -101,18 +100,23 @@ public:
     void SetRange(ALfloat range_value);     // Set max. audible distance.
 
     bool IsActive();            // Check if source is active.
+    bool IsLooped();            // Check if source is looped.
 
     int32_t     emitter_ID;     // Entity of origin. -1 means no entity (hence - empty source).
     uint32_t    emitter_type;   // 0 - ordinary entity, 1 - sound source, 2 - global sound.
     uint32_t    effect_index;   // Effect index. Used to associate effect with entity for R/W flags.
     uint32_t    sample_index;   // OpenAL sample (buffer) index. May be the same for different sources.
     uint32_t    sample_count;   // How many buffers to use, beginning with sample_index.
+    ALfloat     priority;       // Audibility score; least scored source is stolen first.
 
     friend int Audio_IsEffectPlaying(int effect_ID, int entity_type, int entity_ID);
 
 private:
     bool        active;         // Source gets autostopped and destroyed on next frame, if it's not set.
     bool        is_water;       // Marker to define if sample is in underwater state or not.
+    bool        is_looped;      // Looped sources are virtualized instead of being lost.
+    ALfloat     gain;           // Gain set to source (without global sound volume).
+    ALfloat     range;          // Max. audible distance set to source.
     ALuint      source_index;   // Source index. Should be unique for each source.
 
     void LinkEmitter();                             // Link source to parent emitter.
@@ -121,46 +125,71 @@ private:
 };
 
 
-class StreamTrackBuffer
+// Stream track info keeps only scripted soundtrack parameters; track itself is
+// not loaded, but read by stream decoder (see audio_decoder.h) while playing.
+
+class StreamTrackInfo
 {
 public:
-    StreamTrackBuffer();
-   ~StreamTrackBuffer();
+    StreamTrackInfo();
 
     bool Load(int track_index);
 
-private:
-    bool Load_Ogg(const char *path);                        // Ogg file loading routine.
-    bool Load_Wad(const char *path, uint32_t track);        // Wad file loading routine.
-    bool Load_Wav(const char *path);                        // Wav file loading routine.
-    bool Load_WavRW(SDL_RWops *file);                       // Wav file loading routine.
-
-public:
     int             track_index;
-    uint32_t        buffer_size;
-    uint32_t        buffer_part;
-    uint8_t        *buffer;
     int             stream_type;         // Either BACKGROUND, ONESHOT or CHAT.
-    int             channels;
-    int             sample_bitsize;
-    int             rate;
+    int             load_method;
+    uint32_t        resume_sample;       // Where background track was left, it continues from there.
+    char            file_path[1024];
 };
 
 
+// Level sample, decoded from its WAV data to PCM.
+
+typedef struct audio_sample_s
+{
+    uint8_t    *wav;                // WAV data in level samples block.
+    uint32_t    wav_size;
+    uint32_t    uncomp_size;        // TR4/5 raw sample data size, 0 if not specified.
+    uint8_t    *data;               // Decoded PCM, SDL_LoadWAV_RW buffer.
+    uint32_t    size;
+    int         sample_bitsize;
+    int         channels;
+    int         rate;
+}audio_sample_t, *audio_sample_p;
+
+// TR2/TR3 levels share MAIN.SFX sample bank, so last decoded bank is kept
+// for the whole session and reused while levels of the same game are loaded.
+
+static struct audio_bank_cache_s
+{
+    uint64_t        hash;
+    uint32_t        size;
+    uint32_t        samples_count;
+    audio_sample_p  samples;
+} audio_bank_cache = {0};
+
+
 // ======== PRIVATE PROTOTYPES =============
 int  Audio_LogALError(int error_marker = 0);    // AL-specific error handler.
 void Audio_LogOGGError(int code);               // Ogg-specific error handler.
 
 bool Audio_FillALBuffer(ALuint buf_number, Uint8* buffer_data, Uint32 buffer_size, int sample_bitsize, int channels, int frequency);
-int  Audio_LoadALbufferFromWAV_Mem(ALuint buf_number, uint8_t *sample_pointer, uint32_t sample_size, uint32_t uncomp_sample_size = 0);
+static void Audio_DecodeSamplesJob(void *data, uint32_t first, uint32_t last);
+static void Audio_FreeSamples(audio_sample_p samples, uint32_t count);
+static uint64_t Audio_HashData(const uint8_t *data, uint32_t size);
 int  Audio_LoadALbufferFromWAV_File(ALuint buf_number, const char *fname);
 void Audio_LoadOverridedSamples();
 
-int  Audio_GetFreeSource();
+int  Audio_GetFreeSource(float priority);          // Get free source, or steal less audible one.
 int  Audio_GetFreeStream();                         // Get free (stopped) stream.
 int  Audio_TrackAlreadyPlayed(uint32_t track_index, int8_t mask = 0);     // Check if track played with given activation mask.
 void Audio_UpdateStreams(float time);               // Update all streams.
+int  Audio_FillStream(stream_track_p s);            // Queue decoded chunks of stream.
 int  Audio_IsInRange(int entity_type, int entity_ID, float range, float gain);
+float Audio_GetVoicePriority(int entity_type, int entity_ID, float range, float gain, bool looped);
+void Audio_AddVirtualVoice(int effect_ID, int entity_type, int entity_ID);
+bool Audio_RemoveVirtualVoice(int effect_ID, int entity_type, int entity_ID);
+void Audio_UpdateVirtualVoices();   // Restart virtual voices which are heard again.
 
 void Audio_PauseAllSources();    // Used to pause all effects currently playing.
 void Audio_StopAllSources();     // Used in audio deinit.
@@ -170,242 +199,46 @@ void Audio_UpdateListenerByCamera(struct camera_s *cam, float time);
 void Audio_UpdateListenerByEntity(struct entity_s *ent);
 int  Audio_IsTrackPlaying(uint32_t track_index);
 
-// ==== STREAMTRACK BUFFER CLASS IMPLEMENTATION =====
-StreamTrackBuffer::StreamTrackBuffer() :
+// ==== STREAMTRACK INFO CLASS IMPLEMENTATION =====
+StreamTrackInfo::StreamTrackInfo() :
     track_index(-1),
-    buffer_size(0),
-    buffer(NULL),
     stream_type(TR_AUDIO_STREAM_TYPE_ONESHOT),
-    channels(0),
-    sample_bitsize(0),
-    rate(0)
+    load_method(TR_AUDIO_STREAM_METHOD_OGG),
+    resume_sample(0)
 {
+    file_path[0] = 0;
 }
 
 
-StreamTrackBuffer::~StreamTrackBuffer()
-{
-    if(buffer)
-    {
-        buffer_size = 0;
-        free(buffer);
-        buffer = NULL;
-    }
-}
-
-
-bool StreamTrackBuffer::Load(int track_index)
+bool StreamTrackInfo::Load(int track_index)
 {
     if(this->track_index < 0)
     {
-        this->track_index = track_index;
-        char file_path[1024];
-        int load_method = 0;
-
         if(!Script_GetSoundtrack(engine_lua, track_index, file_path, sizeof(file_path), &load_method, &stream_type))
         {
             return false;
         }
-
-        switch(load_method)
-        {
-            case TR_AUDIO_STREAM_METHOD_OGG:
-                return Load_Ogg(file_path);
-
-            case TR_AUDIO_STREAM_METHOD_WAD:
-                return Load_Wad(file_path, track_index);
-
-            case TR_AUDIO_STREAM_METHOD_WAV:
-                return Load_Wav(file_path);
-
-            default:
-                return false;
-        }
-    }
-
-    return (this->buffer != NULL);
-}
-
-///@TODO: fix vorbis streaming! ov_bitrate may differ in differ section
-bool StreamTrackBuffer::Load_Ogg(const char *path)
-{
-    int err = 0;
-    stb_vorbis_alloc alloc;
-    alloc.alloc_buffer_length_in_bytes = 256 * 1024;
-    alloc.alloc_buffer = (char*)Sys_GetTempMem(alloc.alloc_buffer_length_in_bytes);
-    stb_vorbis *ov = stb_vorbis_open_filename(path, &err, &alloc);
-
-    if(!ov)
-    {
-        Sys_DebugLog(SYS_LOG_FILENAME, "OGG: Couldn't open file: %s.", path);
-        Sys_ReturnTempMem(alloc.alloc_buffer_length_in_bytes);
-        return false;
-    }
-
-    stb_vorbis_info info = stb_vorbis_get_info(ov);
-    channels = info.channels;
-    sample_bitsize = 16;
-    buffer_part = 96 * info.max_frame_size;
-    rate = info.sample_rate;
-
-    {
-        const size_t temp_buf_size = 64 * 1024 * 1024;
-        size_t buffer_left = temp_buf_size / 2;
-        short *temp_buff = (short*)malloc(temp_buf_size);
-        size_t readed = 0;
-        buffer_size = 0;
-        while(0 != (readed = stb_vorbis_get_frame_short_interleaved(ov, channels, temp_buff + buffer_size, buffer_left)))
-        {
-            buffer_size += readed * channels;
-            buffer_left -= readed * channels;
-        }
-        buffer_size *= 2;
-        stb_vorbis_close(ov);
-        Sys_ReturnTempMem(alloc.alloc_buffer_length_in_bytes);
-
-        if(buffer_size > 0)
-        {
-            buffer = (uint8_t*)malloc(buffer_size);
-            memcpy(buffer, temp_buff, buffer_size);
-            Con_Notify("file \"%s\" loaded with rate=%d, bitrate=%.1f", path, rate, ((float)info.sample_rate / 1000.0f));
-        }
-        free(temp_buff);
+        this->track_index = track_index;
     }
 
-    return buffer_size > 0;
+    return (load_method >= TR_AUDIO_STREAM_METHOD_OGG) && (load_method < TR_AUDIO_STREAM_METHOD_LASTINDEX);
 }
 
 
-bool StreamTrackBuffer::Load_Wad(const char *path, uint32_t track)
-{
-    const int TR_AUDIO_STREAM_WAD_STRIDE = 268;
-    const int TR_AUDIO_STREAM_WAD_NAMELENGTH = 260;
-    const int TR_AUDIO_STREAM_WAD_COUNT = 130;
-    char track_name[TR_AUDIO_STREAM_WAD_NAMELENGTH];
-    SDL_RWops *file = NULL;
-    uint32_t offset = 0;
-    uint32_t length = 0;
-
-    if(track > TR_AUDIO_STREAM_WAD_COUNT)
-    {
-        return false;
-    }
-
-    file = SDL_RWFromFile(path, "rb");
-    if(file == NULL)
-    {
-        return false;
-    }
-
-    if(SDL_RWseek(file, (track * TR_AUDIO_STREAM_WAD_STRIDE), RW_SEEK_SET) < 0)
-    {
-        SDL_RWclose(file);
-        return false;
-    }
-
-    if(TR_AUDIO_STREAM_WAD_NAMELENGTH != SDL_RWread(file, track_name, 1, TR_AUDIO_STREAM_WAD_NAMELENGTH))
-    {
-        SDL_RWclose(file);
-        return false;
-    }
-
-    if(1 != SDL_RWread(file, &length, sizeof(uint32_t), 1))
-    {
-        SDL_RWclose(file);
-        return false;
-    }
-
-    if(1 != SDL_RWread(file, &offset, sizeof(uint32_t), 1))
-    {
-        SDL_RWclose(file);
-        return false;
-    }
-
-    if(SDL_RWseek(file, offset, RW_SEEK_SET) < 0)
-    {
-        SDL_RWclose(file);
-        return false;
-    }
+// ========== GLOBALS ==============
+ALfloat                     listener_position[3];
+struct audio_settings_s     audio_settings = {0};
 
-    return Load_WavRW(file);
-}
 
+// Virtual voice is a looped effect which is not played right now (it is
+// not heard or has lost its channel), but should go on when heard again.
 
-bool StreamTrackBuffer::Load_Wav(const char *path)
+typedef struct audio_virtual_voice_s
 {
-    return Load_WavRW(SDL_RWFromFile(path, "rb"));
-}
-
-
-bool StreamTrackBuffer::Load_WavRW(SDL_RWops *file)
-{
-    SDL_AudioSpec wav_spec;
-    uint8_t      *wav_buffer;
-    uint32_t      wav_length;
-    if(SDL_LoadWAV_RW(file, 1, &wav_spec, &wav_buffer, &wav_length) == NULL)
-    {
-        Sys_DebugLog(SYS_LOG_FILENAME, "Error: can't load track");
-        return false;
-    }
-
-    // Extract bitsize from SDL audio spec for further usage.
-    sample_bitsize = (uint8_t)(wav_spec.format & SDL_AUDIO_MASK_BITSIZE);
-    channels = wav_spec.channels;
-
-    if(wav_spec.channels > 2)   // We can't use non-mono and barely can use stereo samples.
-    {
-        Sys_DebugLog(SYS_LOG_FILENAME, "Error: track has more than 2 channels!");
-        return false;
-    }
-
-    // Check if bitsize is supported.
-    // We rarely encounter samples with exotic bitsizes, but just in case...
-    if((sample_bitsize != 32) && (sample_bitsize != 16) && (sample_bitsize != 8))
-    {
-        Sys_DebugLog(SYS_LOG_FILENAME, "Can't load sample - wrong bitsize (%d)", sample_bitsize);
-        return false;
-    }
-
-    if(false)//use_SDL_resampler
-    {
-        int FrameSize = channels * 4; // sizeof(float);
-        SDL_AudioCVT cvt;
-        SDL_BuildAudioCVT(&cvt, wav_spec.format, wav_spec.channels, wav_spec.freq, AUDIO_F32, wav_spec.channels, 44100);
-
-        cvt.len = wav_length;
-        buffer_size = wav_length * cvt.len_mult;
-        if(buffer_size % FrameSize)
-        {
-            buffer_size += FrameSize - (buffer_size % FrameSize);   // make align
-        }
-
-        buffer = (uint8_t*)calloc(buffer_size, 1);
-        cvt.buf = buffer;
-        memcpy(cvt.buf, wav_buffer, cvt.len);
-
-        if(cvt.needed)
-        {
-            SDL_ConvertAudio(&cvt);
-        }
-
-        rate = 44100;
-    }
-    else    // Standard OpenAL sample loading process.
-    {
-        buffer_size = wav_length;
-        buffer = (uint8_t*)malloc(buffer_size);
-        buffer_part = 128 * 1024;
-        rate = wav_spec.freq;
-        memcpy(buffer, wav_buffer, buffer_size);
-    }
-
-    SDL_FreeWAV(wav_buffer);
-    return true;
-}
-
-// ========== GLOBALS ==============
-ALfloat                     listener_position[3];
-struct audio_settings_s     audio_settings = {0};
+    int32_t     effect_ID;
+    uint32_t    emitter_type;
+    int32_t     emitter_ID;
+}audio_virtual_voice_t, *audio_virtual_voice_p;
 
 
 struct audio_world_data_s
@@ -422,13 +255,15 @@ struct audio_world_data_s
     ALuint                         *audio_buffers;          // Samples.
     uint32_t                        audio_sources_count;    // Amount of runtime channels.
     AudioSource                    *audio_sources;          // Channels.
+    uint32_t                        virtual_voices_count;   // Amount of looped effects without channel.
+    audio_virtual_voice_t           virtual_voices[TR_AUDIO_MAX_VIRTUAL_VOICES];
 
     bool                            damp_active;            // Global flag for damping BGM tracks.
     uint32_t                        stream_tracks_count;    // Amount of stream track channels.
     struct stream_track_s          *stream_tracks;          // Stream tracks.
 
-    uint32_t                        stream_buffers_count;    // Amount of stream track source buffers.
-    StreamTrackBuffer             **stream_buffers;
+    uint32_t                        stream_infos_count;     // Amount of scripted stream tracks.
+    StreamTrackInfo               **stream_infos;
 
     uint32_t                        stream_track_map_count; // Stream track flag map count.
     uint8_t                        *stream_track_map;       // Stream track flag map.
@@ -446,7 +281,11 @@ AudioSource::AudioSource()
     effect_index = 0;
     sample_index = 0;
     sample_count = 0;
+    priority     = 0.0;
     is_water     = false;
+    is_looped    = false;
+    gain         = 0.0;
+    range        = 0.0;
     alGenSources(1, &source_index);
 
     if(alIsSource(source_index))
@@ -487,6 +326,12 @@ bool AudioSource::IsActive()
 }
 
 
+bool AudioSource::IsLooped()
+{
+    return is_looped;
+}
+
+
 void AudioSource::Play()
 {
     if(alIsSource(source_index))
@@ -542,7 +387,6 @@ void AudioSource::Stop()
 void AudioSource::Update()
 {
     ALint   state;
-    ALfloat range, gain;
 
     alGetSourcei(source_index, AL_SOURCE_STATE, &state);
 
@@ -566,14 +410,12 @@ void AudioSource::Update()
         return;
     }
 
-    alGetSourcef(source_index, AL_GAIN, &gain);
-    alGetSourcef(source_index, AL_MAX_DISTANCE, &range);
-
-    // Check if source is in listener's range, and if so, update position,
-    // else stop and disable it.
-    if(Audio_IsInRange(emitter_type, emitter_ID, range, gain))
+    // Check if source is in listener's range, and if so, update position
+    // and priority, else stop and disable it (looped one becomes virtual).
+    if(Audio_IsInRange(emitter_type, emitter_ID, range, gain * audio_settings.sound_volume))
     {
         LinkEmitter();
+        priority = Audio_GetVoicePriority(emitter_type, emitter_ID, range, gain, is_looped);
 
         if((audio_settings.use_effects) && (is_water != Audio_GetFXWaterState()))
         {
@@ -583,6 +425,10 @@ void AudioSource::Update()
     }
     else
     {
+        if(is_looped)
+        {
+            Audio_AddVirtualVoice(effect_index, emitter_type, emitter_ID);
+        }
         Stop();
     }
 }
@@ -618,6 +464,7 @@ void AudioSource::SetBuffer(ALint buffer)
 void AudioSource::SetLooping(ALboolean is_looping)
 {
     alSourcei(source_index, AL_LOOPING, is_looping);
+    is_looped = (is_looping == AL_TRUE);
 }
 
 
@@ -626,6 +473,7 @@ void AudioSource::SetGain(ALfloat gain_value)
     // Clamp gain value.
     gain_value = (gain_value > 1.0) ? (1.0) : (gain_value);
     gain_value = (gain_value < 0.0) ? (0.0) : (gain_value);
+    gain = gain_value;
 
     alSourcef(source_index, AL_GAIN, gain_value * audio_settings.sound_volume);
 }
@@ -646,6 +494,7 @@ void AudioSource::SetRange(ALfloat range_value)
     // Source will become fully audible on 1/6 of overall position.
     alSourcef(source_index, AL_REFERENCE_DISTANCE, range_value / 6.0);
     alSourcef(source_index, AL_MAX_DISTANCE, range_value);
+    range = range_value;
 }
 
 
@@ -693,6 +542,8 @@ void Audio_CoreInit()
         ALC_MONO_SOURCES,   (TR_AUDIO_MAX_CHANNELS - TR_AUDIO_STREAM_NUMSOURCES),
         ALC_FREQUENCY,       44100, 0};
 
+    StreamDecoder_InitWorker();
+
     al_device = alcOpenDevice(NULL);
     if (!al_device)
     {
@@ -717,7 +568,10 @@ void Audio_CoreInit()
 
 void Audio_CoreDeinit()
 {
-    StreamTrack_Clear(&audio_world_data.external_stream);
+    if(audio_world_data.external_stream.internal)                               // not initialized without AL device
+    {
+        StreamTrack_Clear(&audio_world_data.external_stream);
+    }
 
     if(al_context)  // T4Larson <t4larson@gmail.com>: fixed
     {
@@ -731,6 +585,12 @@ void Audio_CoreDeinit()
         alcCloseDevice(al_device);
         al_device = NULL;
     }
+
+    Audio_FreeSamples(audio_bank_cache.samples, audio_bank_cache.samples_count);
+    audio_bank_cache.samples = NULL;
+    audio_bank_cache.samples_count = 0;
+
+    StreamDecoder_DeinitWorker();
 }
 
 
@@ -741,7 +601,7 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
     // Don't even try to do anything with track, if its index is greater than overall amount of
     // soundtracks specified in a stream track map count (which is derived from script).
     if((track_index >= audio_world_data.stream_track_map_count) ||
-       (track_index >= audio_world_data.stream_buffers_count))
+       (track_index >= audio_world_data.stream_infos_count))
     {
         Con_AddLine("StreamPlay: CANCEL, track index is out of bounds.", FONTSTYLE_CONSOLE_WARNING);
         return TR_AUDIO_STREAMPLAY_WRONGTRACK;
@@ -759,12 +619,12 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
     // in "stream_type" argument, file path into "file_path" argument and load method into
     // "load_method" argument. Function itself returns false, if script wasn't found or
     // request was broken; in this case, we quit.
-    if(!audio_world_data.stream_buffers[track_index])
+    if(!audio_world_data.stream_infos[track_index])
     {
         Audio_CacheTrack(track_index);
     }
-    StreamTrackBuffer *stb = audio_world_data.stream_buffers[track_index];
-    if(!stb)
+    StreamTrackInfo *sti = audio_world_data.stream_infos[track_index];
+    if(!sti)
     {
         Con_AddLine("StreamPlay: CANCEL, wrong track index or broken script.", FONTSTYLE_CONSOLE_WARNING);
         return TR_AUDIO_STREAMPLAY_LOADERROR;
@@ -774,15 +634,15 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
     // Additionally, TrackAlreadyPlayed function applies specified bit mask to track map.
     // Also, bit mask is valid only for non-looped tracks, since looped tracks are played
     // in any way.
-    if((stb->stream_type != TR_AUDIO_STREAM_TYPE_BACKGROUND) &&
+    if((sti->stream_type != TR_AUDIO_STREAM_TYPE_BACKGROUND) &&
         Audio_TrackAlreadyPlayed(track_index, mask))
     {
         return TR_AUDIO_STREAMPLAY_IGNORED;
     }
 
-    if(stb->stream_type != TR_AUDIO_STREAM_TYPE_ONESHOT)
+    if(sti->stream_type != TR_AUDIO_STREAM_TYPE_ONESHOT)
     {
-        Audio_StopStreams(stb->stream_type);
+        Audio_StopStreams(sti->stream_type);
     }
 
     // Entry found, now process to actual track loading.
@@ -794,22 +654,26 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
     }
 
     stream_track_p s = audio_world_data.stream_tracks + target_stream;
-    s->track = stb->track_index;
-    s->type = stb->stream_type;
-    s->state = TR_AUDIO_STREAM_PLAYING;
-    s->current_volume = (s->type == TR_AUDIO_STREAM_TYPE_BACKGROUND) ? (0.0f) : (audio_settings.sound_volume);
-    while(StreamTrack_IsNeedUpdateBuffer(s) && (s->buffer_offset < stb->buffer_size))
+    // Track is opened and decoded by audio worker; its first chunks are
+    // queued by Audio_UpdateStreams as soon as they are ready, so there is
+    // no stall here even for long tracks.
+    s->decoder = StreamDecoder_Create(sti->file_path, sti->load_method, sti->track_index, sti->stream_type == TR_AUDIO_STREAM_TYPE_BACKGROUND);
+    if(!s->decoder)
     {
-        size_t bytes = stb->buffer_part;
-        if(bytes > stb->buffer_size - s->buffer_offset)
-        {
-            bytes = stb->buffer_size - s->buffer_offset;
-        }
-        if(StreamTrack_UpdateBuffer(s, stb->buffer + s->buffer_offset, bytes, stb->sample_bitsize, stb->channels, stb->rate) <= 0)
-        {
-            break;
-        }
+        Con_AddLine("StreamPlay: CANCEL, can't create stream decoder.", FONTSTYLE_CONSOLE_WARNING);
+        return TR_AUDIO_STREAMPLAY_LOADERROR;
+    }
+    if((sti->stream_type == TR_AUDIO_STREAM_TYPE_BACKGROUND) && (sti->resume_sample > 0))
+    {
+        // Crossfade back to background track continues it instead of restart.
+        StreamDecoder_Seek(s->decoder, sti->resume_sample);
+        s->played_samples = sti->resume_sample;
     }
+    s->track = sti->track_index;
+    s->type = sti->stream_type;
+    s->state = TR_AUDIO_STREAM_PLAYING;
+    s->current_volume = (s->type == TR_AUDIO_STREAM_TYPE_BACKGROUND) ? (0.0f) : (audio_settings.sound_volume);
+    Audio_FillStream(s);
 
     if(audio_settings.use_effects)
     {
@@ -818,6 +682,7 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
 
     if(StreamTrack_Play(s) <= 0)
     {
+        StreamTrack_Stop(s);
         Con_AddLine("StreamPlay: CANCEL, stream play error.", FONTSTYLE_CONSOLE_WARNING);
         return TR_AUDIO_STREAMPLAY_PLAYERROR;
     }
@@ -826,33 +691,61 @@ int Audio_StreamPlay(uint32_t track_index, const uint8_t mask)
 }
 
 
+// Queues decoded chunks into free stream buffers, returns amount of queued ones.
+int  Audio_FillStream(stream_track_p s)
+{
+    int ret = 0;
+    uint8_t *chunk;
+    size_t size;
+    int sample_bitsize, channels, rate;
+
+    while(s->decoder && StreamTrack_IsNeedUpdateBuffer(s) &&
+          (chunk = StreamDecoder_GetChunk(s->decoder, &size, &sample_bitsize, &channels, &rate)))
+    {
+        int updated = StreamTrack_UpdateBuffer(s, chunk, size, sample_bitsize, channels, rate);
+        StreamDecoder_ReleaseChunk(s->decoder);
+        if(updated <= 0)
+        {
+            break;
+        }
+        ret++;
+    }
+
+    return ret;
+}
+
+
+// Remembers background track position, so it is resumed when played again.
+static void Audio_KeepStreamPosition(stream_track_p s)
+{
+    if((s->type == TR_AUDIO_STREAM_TYPE_BACKGROUND) && (s->state != TR_AUDIO_STREAM_STOPPED) && (s->track >= 0) &&
+       ((uint32_t)s->track < audio_world_data.stream_infos_count) && audio_world_data.stream_infos[s->track])
+    {
+        audio_world_data.stream_infos[s->track]->resume_sample = StreamTrack_GetPosition(s);
+    }
+}
+
+
 // Update routine for all streams. Should be placed into main loop.
 void Audio_UpdateStreams(float time)
 {
     stream_track_p s = audio_world_data.stream_tracks;
     for(uint32_t i = 0; i < audio_world_data.stream_tracks_count; ++i, ++s)
     {
-        if(StreamTrack_UpdateState(s, time, audio_settings.sound_volume))
+        Audio_KeepStreamPosition(s);      // before fade out may stop it
+        const char *error = (s->decoder) ? (StreamDecoder_GetError(s->decoder)) : (NULL);
+        if(error)
         {
-            StreamTrackBuffer *stb = ((s->track >= 0) && (s->track < audio_world_data.stream_buffers_count)) ?
-                (audio_world_data.stream_buffers[s->track]) : (NULL);
-
-            while(stb && StreamTrack_IsNeedUpdateBuffer(s) && (s->buffer_offset < stb->buffer_size))
-            {
-                size_t bytes = stb->buffer_part;
-                if(bytes + s->buffer_offset > stb->buffer_size)
-                {
-                    bytes = stb->buffer_size - s->buffer_offset;
-                }
-                if(StreamTrack_UpdateBuffer(s, stb->buffer + s->buffer_offset, bytes, stb->sample_bitsize, stb->channels, stb->rate) <= 0)
-                {
-                    break;
-                }
-            }
-
-            if((s->buffer_offset >= stb->buffer_size) && (s->type == TR_AUDIO_STREAM_TYPE_BACKGROUND))
+            Sys_DebugLog(SYS_LOG_FILENAME, "Stream track %d: %s", s->track, error);
+            StreamTrack_Stop(s);
+        }
+        else if(StreamTrack_UpdateState(s, time, audio_settings.sound_volume))
+        {
+            // Source runs dry if worker is behind (or at delayed start), so
+            // restart it once new chunks are queued.
+            if((Audio_FillStream(s) > 0) && (s->state != TR_AUDIO_STREAM_PAUSED))
             {
-                s->buffer_offset = 0;
+                StreamTrack_Play(s);
             }
         }
     }
@@ -939,6 +832,7 @@ int  Audio_StopStreams(int stream_type)
     {
         if((stream_type == -1) || (s->type == stream_type))
         {
+            Audio_KeepStreamPosition(s);
             ret += (StreamTrack_Stop(s) > 0);
         }
     }
@@ -1002,9 +896,12 @@ int  Audio_ResumeStreams(int stream_type)
 
 
 // ======== Audio source global methods ========
-int  Audio_IsInRange(int entity_type, int entity_ID, float range, float gain)
+/*
+ * Gets emitter position; returns 0 if there is no such emitter. Global
+ * emitters have no position, they are always at the listener.
+ */
+static int Audio_GetEmitterPosition(int entity_type, int entity_ID, ALfloat pos[3])
 {
-    ALfloat  vec[3] = {0.0, 0.0, 0.0}, dist;
     entity_p ent;
 
     switch(entity_type)
@@ -1015,22 +912,38 @@ int  Audio_IsInRange(int entity_type, int entity_ID, float range, float gain)
             {
                 return 0;
             }
-            vec3_copy(vec, ent->transform.M4x4 + 12);
-            break;
+            vec3_copy(pos, ent->transform.M4x4 + 12);
+            return 1;
 
         case TR_AUDIO_EMITTER_SOUNDSOURCE:
             if((uint32_t)entity_ID + 1 > audio_world_data.audio_emitters_count)
             {
                 return 0;
             }
-            vec3_copy(vec, audio_world_data.audio_emitters[entity_ID].position);
-            break;
+            vec3_copy(pos, audio_world_data.audio_emitters[entity_ID].position);
+            return 1;
 
         case TR_AUDIO_EMITTER_GLOBAL:
+            vec3_copy(pos, listener_position);
             return 1;
+    }
 
-        default:
-            return 0;
+    return 0;
+}
+
+
+int  Audio_IsInRange(int entity_type, int entity_ID, float range, float gain)
+{
+    ALfloat  vec[3] = {0.0, 0.0, 0.0}, dist;
+
+    if(entity_type == TR_AUDIO_EMITTER_GLOBAL)
+    {
+        return 1;
+    }
+
+    if(!Audio_GetEmitterPosition(entity_type, entity_ID, vec))
+    {
+        return 0;
     }
 
     dist = vec3_dist_sq(listener_position, vec);
@@ -1044,6 +957,106 @@ int  Audio_IsInRange(int entity_type, int entity_ID, float range, float gain)
 }
 
 
+/*
+ * Priority is approximated audibility: gain with the same distance rolloff
+ * as set to source in SetRange (full gain up to 1/6 of range, linearly
+ * fading to silence at max. distance).
+ */
+float Audio_GetVoicePriority(int entity_type, int entity_ID, float range, float gain, bool looped)
+{
+    ALfloat vec[3], dist, ref_dist, ret = gain;
+
+    if(entity_type == TR_AUDIO_EMITTER_GLOBAL)
+    {
+        ret += TR_AUDIO_PRIORITY_GLOBAL;
+    }
+    else if(Audio_GetEmitterPosition(entity_type, entity_ID, vec))
+    {
+        dist = vec3_dist(listener_position, vec);
+        ref_dist = range / 6.0;
+        if(dist >= range)
+        {
+            ret = 0.0;
+        }
+        else if(dist > ref_dist)
+        {
+            ret *= (range - dist) / (range - ref_dist);
+        }
+    }
+    else
+    {
+        return 0.0;
+    }
+
+    return (looped) ? (ret * TR_AUDIO_PRIORITY_LOOPED) : (ret);
+}
+
+
+/*
+ * Only entities and global sounds are kept; sound sources are re-sent
+ * each frame by Audio_UpdateSources anyway.
+ */
+void Audio_AddVirtualVoice(int effect_ID, int entity_type, int entity_ID)
+{
+    audio_virtual_voice_p v = audio_world_data.virtual_voices;
+
+    if(((entity_type != TR_AUDIO_EMITTER_ENTITY) && (entity_type != TR_AUDIO_EMITTER_GLOBAL)) ||
+       ((entity_type == TR_AUDIO_EMITTER_ENTITY) && !World_GetEntityByID(entity_ID)))
+    {
+        return;
+    }
+
+    for(uint32_t i = 0; i < audio_world_data.virtual_voices_count; i++, v++)
+    {
+        if((v->effect_ID == effect_ID) && (v->emitter_type == (uint32_t)entity_type) && (v->emitter_ID == entity_ID))
+        {
+            return;
+        }
+    }
+
+    if(audio_world_data.virtual_voices_count < TR_AUDIO_MAX_VIRTUAL_VOICES)
+    {
+        v->effect_ID = effect_ID;
+        v->emitter_type = entity_type;
+        v->emitter_ID = entity_ID;
+        audio_world_data.virtual_voices_count++;
+    }
+}
+
+
+bool Audio_RemoveVirtualVoice(int effect_ID, int entity_type, int entity_ID)
+{
+    audio_virtual_voice_p v = audio_world_data.virtual_voices;
+
+    for(uint32_t i = 0; i < audio_world_data.virtual_voices_count; i++, v++)
+    {
+        if((v->effect_ID == effect_ID) && (v->emitter_type == (uint32_t)entity_type) && (v->emitter_ID == entity_ID))
+        {
+            *v = audio_world_data.virtual_voices[--audio_world_data.virtual_voices_count];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void Audio_UpdateVirtualVoices()
+{
+    audio_virtual_voice_t voices[TR_AUDIO_MAX_VIRTUAL_VOICES];
+    uint32_t voices_count = audio_world_data.virtual_voices_count;
+
+    // Each voice is sent again; the ones still not heard (or without channel)
+    // are put back to the list by Audio_Send.
+    memcpy(voices, audio_world_data.virtual_voices, voices_count * sizeof(audio_virtual_voice_t));
+    audio_world_data.virtual_voices_count = 0;
+    for(uint32_t i = 0; i < voices_count; i++)
+    {
+        Audio_Send(voices[i].effect_ID, voices[i].emitter_type, voices[i].emitter_ID);
+    }
+}
+
+
 void Audio_UpdateSources()
 {
     if(audio_world_data.audio_sources_count < 1)
@@ -1058,6 +1071,8 @@ void Audio_UpdateSources()
         Audio_Send(audio_world_data.audio_emitters[i].sound_index, TR_AUDIO_EMITTER_SOUNDSOURCE, i);
     }
 
+    Audio_UpdateVirtualVoices();
+
     for(uint32_t i = 0; i < audio_world_data.audio_sources_count; i++)
     {
         audio_world_data.audio_sources[i].Update();
@@ -1083,6 +1098,7 @@ void Audio_StopAllSources()
     {
         audio_world_data.audio_sources[i].Stop();
     }
+    audio_world_data.virtual_voices_count = 0;
 }
 
 
@@ -1098,17 +1114,38 @@ void Audio_ResumeAllSources()
 }
 
 
-int Audio_GetFreeSource()   ///@FIXME: add condition (compare max_dist with new source dist)
+int Audio_GetFreeSource(float priority)
 {
+    int ret = -1;
+    float min_priority = priority;
+
     for(uint32_t i = 0; i < audio_world_data.audio_sources_count; i++)
     {
-        if(audio_world_data.audio_sources[i].IsActive() == false)
+        AudioSource *src = audio_world_data.audio_sources + i;
+        if(src->IsActive() == false)
         {
             return i;
         }
+        if(src->priority < min_priority)
+        {
+            min_priority = src->priority;
+            ret = i;
+        }
     }
 
-    return -1;
+    // All channels are busy: steal the least audible one, if new sound is
+    // more audible than it.
+    if(ret >= 0)
+    {
+        AudioSource *src = audio_world_data.audio_sources + ret;
+        if(src->IsLooped())
+        {
+            Audio_AddVirtualVoice(src->effect_index, src->emitter_type, src->emitter_ID);
+        }
+        src->Stop();
+    }
+
+    return ret;
 }
 
 
@@ -1138,7 +1175,7 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
 {
     int32_t         source_number;
     uint16_t        random_value;
-    ALfloat         random_float;
+    ALfloat         random_float, priority;
     audio_effect_p  effect = NULL;
     AudioSource    *source = NULL;
 
@@ -1182,13 +1219,19 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
 
     // Pre-step 3: Calculate if effect's hearing sphere intersect listener's hearing sphere.
     // If it's not, bypass audio send (cause we don't want it to occupy channel, if it's not
-    // heard).
+    // heard). Looped effect is kept as virtual voice, to start it when it is heard.
 
     if(Audio_IsInRange(entity_type, entity_ID, effect->range, effect->gain ) == false)
     {
+        if(effect->loop == TR_AUDIO_LOOP_LOOPED)
+        {
+            Audio_AddVirtualVoice(effect_ID, entity_type, entity_ID);
+        }
         return TR_AUDIO_SEND_IGNORED;
     }
 
+    priority = Audio_GetVoicePriority(entity_type, entity_ID, effect->range, effect->gain, effect->loop == TR_AUDIO_LOOP_LOOPED);
+
     // Pre-step 4: check if R (Rewind) flag is set for this effect, if so,
     // find any effect with similar ID playing for this entity, and stop it.
     // Otherwise, if W (Wait) or L (Looped) flag is set, and same effect is
@@ -1209,7 +1252,7 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
     }
     else
     {
-        source_number = Audio_GetFreeSource();  // Get free source.
+        source_number = Audio_GetFreeSource(priority);  // Get free (or less audible) source.
     }
 
     if(source_number != -1)  // Everything is OK, we're sending audio to channel.
@@ -1250,6 +1293,7 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
         source->emitter_ID   = entity_ID;
         source->emitter_type = entity_type;
         source->effect_index = effect_ID;
+        source->priority     = priority;
 
         // Step 4. Apply sound effect properties.
 
@@ -1283,6 +1327,10 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
     }
     else
     {
+        if(effect->loop == TR_AUDIO_LOOP_LOOPED)
+        {
+            Audio_AddVirtualVoice(effect_ID, entity_type, entity_ID);
+        }
         return TR_AUDIO_SEND_NOCHANNEL;
     }
 }
@@ -1291,6 +1339,7 @@ int Audio_Send(int effect_ID, int entity_type, int entity_ID)
 int Audio_Kill(int effect_ID, int entity_type, int entity_ID)
 {
     int playing_sound = Audio_IsEffectPlaying(effect_ID, entity_type, entity_ID);
+    bool was_virtual = Audio_RemoveVirtualVoice(effect_ID, entity_type, entity_ID);
 
     if(playing_sound != -1)
     {
@@ -1298,7 +1347,7 @@ int Audio_Kill(int effect_ID, int entity_type, int entity_ID)
         return TR_AUDIO_SEND_PROCESSED;
     }
 
-    return TR_AUDIO_SEND_IGNORED;
+    return (was_virtual) ? (TR_AUDIO_SEND_PROCESSED) : (TR_AUDIO_SEND_IGNORED);
 }
 
 
@@ -1347,6 +1396,7 @@ void Audio_InitGlobals()
 
     audio_world_data.audio_sources = NULL;
     audio_world_data.audio_sources_count = 0;
+    audio_world_data.virtual_voices_count = 0;
     audio_world_data.audio_buffers = NULL;
     audio_world_data.audio_buffers_count = 0;
     audio_world_data.audio_effects = NULL;
@@ -1384,16 +1434,16 @@ void Audio_Init(uint32_t num_Sources)
 
 void Audio_CacheTrack(int id)
 {
-    if((id >= 0) && (id < audio_world_data.stream_buffers_count) && !audio_world_data.stream_buffers[id])
+    if((id >= 0) && (id < audio_world_data.stream_infos_count) && !audio_world_data.stream_infos[id])
     {
-        StreamTrackBuffer *stb = new StreamTrackBuffer();
-        if(stb->Load(id))
+        StreamTrackInfo *sti = new StreamTrackInfo();
+        if(sti->Load(id))
         {
-            audio_world_data.stream_buffers[id] = stb;
+            audio_world_data.stream_infos[id] = sti;
         }
         else
         {
-            delete stb;
+            delete sti;
         }
     }
 }
@@ -1402,17 +1452,16 @@ void Audio_CacheTrack(int id)
 void Audio_GenSamples(class VT_Level *tr)
 {
     uint8_t      *pointer = tr->samples_data;
-    int8_t        flag;
     uint32_t      ind1, ind2;
     uint32_t      comp_size, uncomp_size;
     uint32_t      i;
 
-    // Generate stream tracks buffers
-    audio_world_data.stream_buffers = NULL;
-    audio_world_data.stream_buffers_count = Script_GetNumTracks(engine_lua);
-    if(audio_world_data.stream_buffers_count > 0)
+    // Generate stream tracks infos
+    audio_world_data.stream_infos = NULL;
+    audio_world_data.stream_infos_count = Script_GetNumTracks(engine_lua);
+    if(audio_world_data.stream_infos_count > 0)
     {
-        audio_world_data.stream_buffers = (StreamTrackBuffer**)calloc(audio_world_data.stream_buffers_count, sizeof(StreamTrackBuffer*));
+        audio_world_data.stream_infos = (StreamTrackInfo**)calloc(audio_world_data.stream_infos_count, sizeof(StreamTrackInfo*));
         Audio_CacheTrack(Script_GetSecretTrackNumber(engine_lua));
     }
 
@@ -1444,7 +1493,7 @@ void Audio_GenSamples(class VT_Level *tr)
     audio_world_data.audio_map = tr->soundmap;
     tr->soundmap = NULL;                   /// without it VT destructor free(tr->soundmap)
 
-    // Cycle through raw samples block and parse them to OpenAL buffers.
+    // Cycle through raw samples block and split it to separate WAV samples.
 
     // Different TR versions have different ways of storing samples.
     // TR1:     sample block size, sample block, num samples, sample offsets.
@@ -1452,9 +1501,15 @@ void Audio_GenSamples(class VT_Level *tr)
     // TR4/TR5: num samples, (uncomp_size-comp_size-sample_data) chain.
     //
     // Hence, we specify certain parse method for each game version.
+    // Samples are decoded to PCM by jobs and then loaded to OpenAL buffers here.
 
     if(pointer)
     {
+        audio_sample_p samples = NULL;
+        uint32_t samples_count = 0;
+        uint64_t bank_hash = 0;
+        bool from_cache = false;
+
         switch(tr->game_version)
         {
             case TR_I:
@@ -1462,53 +1517,63 @@ void Audio_GenSamples(class VT_Level *tr)
             case TR_I_UB:
                 audio_world_data.audio_map_count = TR_AUDIO_MAP_SIZE_TR1;
 
-                for(i = 0; i < audio_world_data.audio_buffers_count-1; i++)
+                samples_count = (tr->sample_indices_count < audio_world_data.audio_buffers_count) ? (tr->sample_indices_count) : (audio_world_data.audio_buffers_count);
+                samples = (audio_sample_p)calloc(samples_count, sizeof(audio_sample_t));
+                for(i = 0; i < samples_count; i++)
                 {
-                    pointer = tr->samples_data + tr->sample_indices[i];
-                    uint32_t size = tr->sample_indices[i + 1] - tr->sample_indices[i];
-                    Audio_LoadALbufferFromWAV_Mem(audio_world_data.audio_buffers[i], pointer, size);
+                    ind1 = tr->sample_indices[i];
+                    ind2 = (i + 1 < tr->sample_indices_count) ? (tr->sample_indices[i + 1]) : (tr->samples_data_size);
+                    if((ind1 <= ind2) && (ind2 <= tr->samples_data_size))
+                    {
+                        samples[i].wav = tr->samples_data + ind1;
+                        samples[i].wav_size = ind2 - ind1;
+                    }
                 }
-                i = audio_world_data.audio_buffers_count-1;
-                Audio_LoadALbufferFromWAV_Mem(audio_world_data.audio_buffers[i], pointer, (tr->samples_count - tr->sample_indices[i]));
                 break;
 
             case TR_II:
             case TR_II_DEMO:
             case TR_III:
                 audio_world_data.audio_map_count = (tr->game_version == TR_III) ? (TR_AUDIO_MAP_SIZE_TR3) : (TR_AUDIO_MAP_SIZE_TR2);
-                ind1 = 0;
-                ind2 = 0;
-                flag = 0;
-                i = 0;
-                while(pointer < tr->samples_data + tr->samples_data_size - 4)
+
+                // MAIN.SFX is the same for all levels of the game, so its
+                // samples are decoded only once.
+                bank_hash = Audio_HashData(tr->samples_data, tr->samples_data_size);
+                if(audio_bank_cache.samples && (audio_bank_cache.hash == bank_hash) && (audio_bank_cache.size == tr->samples_data_size))
                 {
-                    pointer = tr->samples_data + ind2;
+                    samples = audio_bank_cache.samples;
+                    samples_count = audio_bank_cache.samples_count;
+                    from_cache = true;
+                    break;
+                }
+
+                samples = (audio_sample_p)calloc(audio_world_data.audio_buffers_count, sizeof(audio_sample_t));
+                ind1 = tr->samples_data_size;                                   // End of the last sample.
+                for(ind2 = 0; ind2 + 4 <= tr->samples_data_size; ind2++)
+                {
+                    pointer = (uint8_t*)memchr(tr->samples_data + ind2, 'R', tr->samples_data_size - ind2 - 3);
+                    if(!pointer)
+                    {
+                        break;
+                    }
+                    ind2 = pointer - tr->samples_data;
                     if(!memcmp(pointer, "RIFF", 4))
                     {
-                        if(flag == 0x00)
+                        if(samples_count >= audio_world_data.audio_buffers_count)
                         {
                             ind1 = ind2;
-                            flag = 0x01;
+                            break;
                         }
-                        else
+                        if(samples_count > 0)
                         {
-                            uncomp_size = ind2 - ind1;
-                            Audio_LoadALbufferFromWAV_Mem(audio_world_data.audio_buffers[i], tr->samples_data + ind1, uncomp_size);
-                            i++;
-                            if(i > audio_world_data.audio_buffers_count - 1)
-                            {
-                                break;
-                            }
-                            ind1 = ind2;
+                            samples[samples_count - 1].wav_size = pointer - samples[samples_count - 1].wav;
                         }
+                        samples[samples_count++].wav = pointer;
                     }
-                    ind2++;
                 }
-                uncomp_size = tr->samples_data_size - ind1;
-                pointer = tr->samples_data + ind1;
-                if(i < audio_world_data.audio_buffers_count)
+                if(samples_count > 0)
                 {
-                    Audio_LoadALbufferFromWAV_Mem(audio_world_data.audio_buffers[i], pointer, uncomp_size);
+                    samples[samples_count - 1].wav_size = tr->samples_data + ind1 - samples[samples_count - 1].wav;
                 }
                 break;
 
@@ -1517,17 +1582,28 @@ void Audio_GenSamples(class VT_Level *tr)
             case TR_V:
                 audio_world_data.audio_map_count = (tr->game_version == TR_V) ? (TR_AUDIO_MAP_SIZE_TR5) : (TR_AUDIO_MAP_SIZE_TR4);
 
+                samples = (audio_sample_p)calloc(tr->samples_count, sizeof(audio_sample_t));
                 for(i = 0; i < tr->samples_count; i++)
                 {
+                    if(pointer + 8 > tr->samples_data + tr->samples_data_size)
+                    {
+                        break;
+                    }
                     // Parse sample sizes.
                     // Always use comp_size as block length, as uncomp_size is used to cut raw sample data.
                     uncomp_size = *((uint32_t*)pointer);
                     pointer += 4;
                     comp_size   = *((uint32_t*)pointer);
                     pointer += 4;
+                    if(comp_size > tr->samples_data + tr->samples_data_size - pointer)
+                    {
+                        break;
+                    }
 
-                    // Load WAV sample into OpenAL buffer.
-                    Audio_LoadALbufferFromWAV_Mem(audio_world_data.audio_buffers[i], pointer, comp_size, uncomp_size);
+                    samples[i].wav = pointer;
+                    samples[i].wav_size = comp_size;
+                    samples[i].uncomp_size = uncomp_size;
+                    samples_count++;
 
                     // Now we can safely move pointer through current sample data.
                     pointer += comp_size;
@@ -1542,6 +1618,41 @@ void Audio_GenSamples(class VT_Level *tr)
                 return;
         }
 
+        if(!from_cache)
+        {
+            Jobs_ParallelFor(Audio_DecodeSamplesJob, samples, samples_count, 4);
+        }
+
+        for(i = 0; (i < samples_count) && (i < audio_world_data.audio_buffers_count); i++)
+        {
+            audio_sample_p s = samples + i;
+            if(!s->data)
+            {
+                Sys_DebugLog(SYS_LOG_FILENAME, "Error: can't load sample #%03d from sample block!", audio_world_data.audio_buffers[i]);
+            }
+            else
+            {
+                Audio_FillALBuffer(audio_world_data.audio_buffers[i], s->data, s->size, s->sample_bitsize, s->channels, s->rate);
+            }
+        }
+
+        if(bank_hash && !from_cache)
+        {
+            Audio_FreeSamples(audio_bank_cache.samples, audio_bank_cache.samples_count);
+            for(i = 0; i < samples_count; i++)
+            {
+                samples[i].wav = NULL;                                          // Points to level data.
+            }
+            audio_bank_cache.hash = bank_hash;
+            audio_bank_cache.size = tr->samples_data_size;
+            audio_bank_cache.samples_count = samples_count;
+            audio_bank_cache.samples = samples;
+        }
+        else if(!from_cache)
+        {
+            Audio_FreeSamples(samples, samples_count);
+        }
+
         free(tr->samples_data);
         tr->samples_data = NULL;
         tr->samples_data_size = 0;
@@ -1676,6 +1787,7 @@ int Audio_DeInit()
         delete[] audio_world_data.audio_sources;
         audio_world_data.audio_sources = NULL;
     }
+    audio_world_data.virtual_voices_count = 0;
 
     if(audio_world_data.audio_emitters)
     {
@@ -1728,19 +1840,19 @@ int Audio_DeInit()
 
     Audio_DeinitFX();
 
-    if(audio_world_data.stream_buffers)
+    if(audio_world_data.stream_infos)
     {
-        for(uint32_t i = 0; i < audio_world_data.stream_buffers_count; i++)
+        for(uint32_t i = 0; i < audio_world_data.stream_infos_count; i++)
         {
-            if(audio_world_data.stream_buffers[i])
+            if(audio_world_data.stream_infos[i])
             {
-                delete audio_world_data.stream_buffers[i];
+                delete audio_world_data.stream_infos[i];
             }
-            audio_world_data.stream_buffers[i] = NULL;
+            audio_world_data.stream_infos[i] = NULL;
         }
-        audio_world_data.stream_buffers_count = 0;
-        free(audio_world_data.stream_buffers);
-        audio_world_data.stream_buffers = NULL;
+        audio_world_data.stream_infos_count = 0;
+        free(audio_world_data.stream_infos);
+        audio_world_data.stream_infos = NULL;
     }
 
     return 1;
@@ -1784,46 +1896,76 @@ int  Audio_LogALError(int error_marker)
 }*/
 
 
-int Audio_LoadALbufferFromWAV_Mem(ALuint buf_number, uint8_t *sample_pointer, uint32_t sample_size, uint32_t uncomp_sample_size)
+/*
+ * Decodes WAV samples to PCM; runs on job workers, so errors are only marked
+ * by NULL data and reported on OpenAL buffers loading.
+ */
+static void Audio_DecodeSamplesJob(void *data, uint32_t first, uint32_t last)
 {
-    SDL_AudioSpec wav_spec;
-    Uint8        *wav_buffer;
-    Uint32        wav_length;
-
-    SDL_RWops *src = SDL_RWFromMem(sample_pointer, sample_size);
+    audio_sample_p s = (audio_sample_p)data + first;
+    for(uint32_t i = first; i < last; i++, s++)
+    {
+        SDL_AudioSpec wav_spec;
+        SDL_RWops *src = (s->wav) ? (SDL_RWFromMem(s->wav, s->wav_size)) : (NULL);
+
+        // Decode WAV structure with SDL methods.
+        // SDL automatically defines file format (PCM/ADPCM), so we shouldn't bother
+        // about if it is TR4 compressed samples or TRLE uncompressed samples.
+        s->data = NULL;
+        s->size = 0;
+        if(src && (SDL_LoadWAV_RW(src, 1, &wav_spec, &s->data, &s->size) != NULL))
+        {
+            // Uncomp_size explicitly specifies amount of raw sample data
+            // to load into buffer. It is only used in TR4/5 with ADPCM samples,
+            // because full-sized ADPCM sample contains a bit of silence at the end,
+            // which should be removed.
+            // Note that we also need to compare if uncomp_size is smaller
+            // than native wav length, because for some reason many TR5 uncomp sizes
+            // are messed up and actually more than actual sample size.
+            if((s->uncomp_size > 0) && (s->uncomp_size < s->size))
+            {
+                s->size = s->uncomp_size;
+            }
+            s->sample_bitsize = wav_spec.format & SDL_AUDIO_MASK_BITSIZE;
+            s->channels = wav_spec.channels;
+            s->rate = wav_spec.freq;
+        }
+    }
+}
 
-    // Decode WAV structure with SDL methods.
-    // SDL automatically defines file format (PCM/ADPCM), so we shouldn't bother
-    // about if it is TR4 compressed samples or TRLE uncompressed samples.
 
-    if(SDL_LoadWAV_RW(src, 1, &wav_spec, &wav_buffer, &wav_length) == NULL)
+static void Audio_FreeSamples(audio_sample_p samples, uint32_t count)
+{
+    if(samples)
     {
-        Sys_DebugLog(SYS_LOG_FILENAME, "Error: can't load sample #%03d from sample block!", buf_number);
-        return -1;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            if(samples[i].data)
+            {
+                SDL_FreeWAV(samples[i].data);
+            }
+        }
+        free(samples);
     }
+}
 
-    // Uncomp_sample_size explicitly specifies amount of raw sample data
-    // to load into buffer. It is only used in TR4/5 with ADPCM samples,
-    // because full-sized ADPCM sample contains a bit of silence at the end,
-    // which should be removed. That's where uncomp_sample_size comes into
-    // business.
-    // Note that we also need to compare if uncomp_sample_size is smaller
-    // than native wav length, because for some reason many TR5 uncomp sizes
-    // are messed up and actually more than actual sample size.
 
-    if((uncomp_sample_size == 0) || (wav_length < uncomp_sample_size))
+// FNV-1a by 64 bit words, it is enough to tell MAIN.SFX files apart.
+static uint64_t Audio_HashData(const uint8_t *data, uint32_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    uint32_t i = 0;
+    for(; i + 8 <= size; i += 8)
     {
-        uncomp_sample_size = wav_length;
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
     }
-
-    // Find out sample format and load it correspondingly.
-    // Note that with OpenAL, we can have samples of different formats in same level.
-
-    bool result = Audio_FillALBuffer(buf_number, wav_buffer, uncomp_sample_size, wav_spec.format & SDL_AUDIO_MASK_BITSIZE, wav_spec.channels, wav_spec.freq);
-
-    SDL_FreeWAV(wav_buffer);
-
-    return (result) ? (0) : (-3);   // Zero means success.
+    for(; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+    return hash ^ size;
 }
 
 
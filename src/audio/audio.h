@@ -17,6 +17,22 @@
 
 #define TR_AUDIO_MAX_CHANNELS 32
 
+// MAX_VIRTUAL_VOICES is the amount of looped effects which may be kept
+// without a channel (out of hearing range, or when their channel was given
+// to more audible sound); they are restarted as soon as they are heard
+// again and there is a channel for them.
+
+#define TR_AUDIO_MAX_VIRTUAL_VOICES 64
+
+// Priority multipliers for channel allocation. Each sound is scored by its
+// audibility (gain and distance attenuation); when all channels are busy,
+// the least scored sound is stopped in favour of more audible one. Looped
+// sounds score a little less, as they are restarted later anyway, and
+// global sounds (menus, secrets, etc.) are always preferred.
+
+#define TR_AUDIO_PRIORITY_LOOPED 0.75
+#define TR_AUDIO_PRIORITY_GLOBAL 2.0
+
 // NUMSOURCES tells the engine how many sources we should reserve for
 // in-game music and BGMs, considering crossfades. By default, it's 6,
 // as it's more than enough for typical TR audio setup (one BGM track
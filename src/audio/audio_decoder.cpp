@@ -0,0 +1,650 @@
+
+#include <SDL2/SDL.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_stream.h"
+#include "audio_decoder.h"
+
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_vorbis.c"
+
+#define TR_AUDIO_DECODER_WAD_STRIDE     268
+#define TR_AUDIO_DECODER_WAD_NAMELENGTH 260
+#define TR_AUDIO_DECODER_WAD_COUNT      130
+
+#define TR_AUDIO_DECODER_WAV_PCM        0x0001
+#define TR_AUDIO_DECODER_WAV_MSADPCM    0x0002
+#define TR_AUDIO_DECODER_WAV_FLOAT      0x0003
+#define TR_AUDIO_DECODER_WAV_EXTENSIBLE 0xFFFE
+#define TR_AUDIO_DECODER_MAX_COEFS      32
+
+
+struct stream_decoder_s
+{
+    char                       *path;
+    int                         method;
+    uint32_t                    track;
+    int                         looped;
+
+    // Decoding state, used only by worker while decoder is busy.
+    stb_vorbis                 *ogg;
+    SDL_RWops                  *file;
+    uint32_t                    data_begin;         // WAV data chunk, absolute file offset.
+    uint32_t                    data_size;
+    uint32_t                    data_pos;
+    uint16_t                    wav_format;
+    uint16_t                    block_align;
+    uint32_t                    samples_per_block;
+    uint16_t                    coefs_count;
+    int16_t                     coefs[TR_AUDIO_DECODER_MAX_COEFS][2];
+    uint8_t                    *block;              // One ADPCM block and its decoded samples.
+    int16_t                    *block_pcm;
+    uint32_t                    block_pcm_count;
+    uint32_t                    block_pcm_pos;
+    uint32_t                    block_pcm_skip;
+    int                         opened;             // 0 - not yet, 1 - ok, -1 - failed.
+
+    int                         channels;
+    int                         sample_bitsize;
+    int                         rate;
+
+    // Shared state, guarded by decoders_mutex.
+    const char                 *error;
+    int                         end;
+    int                         busy;
+    int                         seek_pending;
+    uint32_t                    seek_sample;
+    uint32_t                    generation;
+    uint32_t                    chunk_first;
+    uint32_t                    chunks_ready;
+    size_t                      chunk_size[TR_AUDIO_DECODER_CHUNKS];
+    uint8_t                    *chunks;
+
+    struct stream_decoder_s    *next;
+};
+
+static SDL_Thread          *decoders_thread = NULL;
+static SDL_mutex           *decoders_mutex = NULL;
+static SDL_cond            *decoders_work_cond = NULL;
+static SDL_cond            *decoders_done_cond = NULL;
+static int                  decoders_stop = 0;
+static stream_decoder_p     decoders_list = NULL;
+
+static const int16_t msadpcm_adapt[16] =
+{
+    230, 230, 230, 230, 307, 409, 512, 614,
+    768, 614, 512, 409, 307, 230, 230, 230
+};
+
+static const int16_t msadpcm_coefs[7][2] =
+{
+    {256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232}
+};
+
+
+static uint16_t StreamDecoder_Get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+
+static uint32_t StreamDecoder_Get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+static int StreamDecoder_ParseWavFormat(stream_decoder_p dec, const uint8_t *fmt, uint32_t size)
+{
+    if(size < 16)
+    {
+        return 0;
+    }
+
+    dec->wav_format = StreamDecoder_Get16(fmt);
+    dec->channels = StreamDecoder_Get16(fmt + 2);
+    dec->rate = StreamDecoder_Get32(fmt + 4);
+    dec->block_align = StreamDecoder_Get16(fmt + 12);
+    dec->sample_bitsize = StreamDecoder_Get16(fmt + 14);
+    if((dec->wav_format == TR_AUDIO_DECODER_WAV_EXTENSIBLE) && (size >= 26))
+    {
+        dec->wav_format = StreamDecoder_Get16(fmt + 24);
+    }
+
+    if((dec->channels < 1) || (dec->channels > 2) || (dec->rate <= 0) || (dec->block_align == 0))
+    {
+        return 0;
+    }
+
+    switch(dec->wav_format)
+    {
+        case TR_AUDIO_DECODER_WAV_PCM:
+            return ((dec->sample_bitsize == 8) || (dec->sample_bitsize == 16)) &&
+                   (dec->block_align == dec->channels * dec->sample_bitsize / 8);
+
+        case TR_AUDIO_DECODER_WAV_FLOAT:
+            return (dec->sample_bitsize == 32) && (dec->block_align == dec->channels * 4);
+
+        case TR_AUDIO_DECODER_WAV_MSADPCM:
+            if((dec->sample_bitsize != 4) || (dec->block_align < 7 * dec->channels))
+            {
+                return 0;
+            }
+            // Block header holds 2 samples, then 2 samples per byte for all channels.
+            dec->samples_per_block = 2 + (dec->block_align - 7 * dec->channels) * 2 / dec->channels;
+            dec->coefs_count = 7;
+            memcpy(dec->coefs, msadpcm_coefs, sizeof(msadpcm_coefs));
+            if(size >= 22)
+            {
+                uint16_t count = StreamDecoder_Get16(fmt + 20);
+                if((count > TR_AUDIO_DECODER_MAX_COEFS) || (size < 22 + 4 * (uint32_t)count))
+                {
+                    return 0;
+                }
+                for(uint16_t i = 0; i < count; i++)
+                {
+                    dec->coefs[i][0] = (int16_t)StreamDecoder_Get16(fmt + 22 + 4 * i);
+                    dec->coefs[i][1] = (int16_t)StreamDecoder_Get16(fmt + 24 + 4 * i);
+                }
+                dec->coefs_count = (count > 0) ? (count) : (dec->coefs_count);
+            }
+            dec->sample_bitsize = 16;
+            dec->block = (uint8_t*)malloc(dec->block_align);
+            dec->block_pcm = (int16_t*)malloc(dec->samples_per_block * dec->channels * sizeof(int16_t));
+            return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Reads RIFF headers of a WAV file placed at base offset (for CDAUDIO.WAD
+ * entries) and stops at the beginning of its data chunk.
+ */
+static int StreamDecoder_OpenWav(stream_decoder_p dec, uint32_t base, uint32_t length)
+{
+    uint8_t header[12];
+    uint8_t fmt[22 + 4 * TR_AUDIO_DECODER_MAX_COEFS];
+    uint32_t pos = base + 12;
+    uint32_t end = (length > 0) ? (base + length) : (0xFFFFFFFF);
+    int fmt_found = 0;
+
+    if((SDL_RWseek(dec->file, base, RW_SEEK_SET) < 0) ||
+       (SDL_RWread(dec->file, header, 1, 12) != 12) ||
+       (memcmp(header, "RIFF", 4) != 0) || (memcmp(header + 8, "WAVE", 4) != 0))
+    {
+        return 0;
+    }
+
+    while(pos + 8 <= end)
+    {
+        uint32_t size;
+        if((SDL_RWseek(dec->file, pos, RW_SEEK_SET) < 0) || (SDL_RWread(dec->file, header, 1, 8) != 8))
+        {
+            return 0;
+        }
+        size = StreamDecoder_Get32(header + 4);
+
+        if(memcmp(header, "fmt ", 4) == 0)
+        {
+            uint32_t fmt_size = (size < sizeof(fmt)) ? (size) : (sizeof(fmt));
+            if((SDL_RWread(dec->file, fmt, 1, fmt_size) != fmt_size) || !StreamDecoder_ParseWavFormat(dec, fmt, fmt_size))
+            {
+                return 0;
+            }
+            fmt_found = 1;
+        }
+        else if(memcmp(header, "data", 4) == 0)
+        {
+            if(!fmt_found)
+            {
+                return 0;
+            }
+            dec->data_begin = pos + 8;
+            dec->data_size = (size < end - dec->data_begin) ? (size) : (end - dec->data_begin);
+            if(dec->wav_format != TR_AUDIO_DECODER_WAV_MSADPCM)
+            {
+                dec->data_size -= dec->data_size % dec->block_align;
+            }
+            dec->data_pos = 0;
+            return 1;
+        }
+        if(size >= end - pos - 8)
+        {
+            return 0;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    return 0;
+}
+
+
+static int StreamDecoder_Open(stream_decoder_p dec)
+{
+    switch(dec->method)
+    {
+        case TR_AUDIO_STREAM_METHOD_OGG:
+            {
+                int err = 0;
+                stb_vorbis_info info;
+                dec->ogg = stb_vorbis_open_filename(dec->path, &err, NULL);
+                if(!dec->ogg)
+                {
+                    return 0;
+                }
+                info = stb_vorbis_get_info(dec->ogg);
+                dec->channels = info.channels;
+                dec->sample_bitsize = 16;
+                dec->rate = info.sample_rate;
+                return (dec->channels >= 1) && (dec->channels <= 2);
+            }
+
+        case TR_AUDIO_STREAM_METHOD_WAD:
+            {
+                uint8_t entry[8];
+                dec->file = SDL_RWFromFile(dec->path, "rb");
+                if(!dec->file || (dec->track > TR_AUDIO_DECODER_WAD_COUNT) ||
+                   (SDL_RWseek(dec->file, dec->track * TR_AUDIO_DECODER_WAD_STRIDE + TR_AUDIO_DECODER_WAD_NAMELENGTH, RW_SEEK_SET) < 0) ||
+                   (SDL_RWread(dec->file, entry, 1, 8) != 8))
+                {
+                    return 0;
+                }
+                // Entry is track name, then its length and offset in WAD.
+                return StreamDecoder_OpenWav(dec, StreamDecoder_Get32(entry + 4), StreamDecoder_Get32(entry));
+            }
+
+        case TR_AUDIO_STREAM_METHOD_WAV:
+            dec->file = SDL_RWFromFile(dec->path, "rb");
+            return dec->file && StreamDecoder_OpenWav(dec, 0, 0);
+    }
+
+    return 0;
+}
+
+
+static void StreamDecoder_SeekInternal(stream_decoder_p dec, uint32_t sample)
+{
+    if(dec->ogg)
+    {
+        uint32_t length = stb_vorbis_stream_length_in_samples(dec->ogg);
+        sample = (dec->looped && (length > 0)) ? (sample % length) : (sample);
+        if((sample == 0) || !stb_vorbis_seek(dec->ogg, sample))
+        {
+            stb_vorbis_seek_start(dec->ogg);
+        }
+    }
+    else if(dec->file)
+    {
+        uint32_t samples_per_block = (dec->wav_format == TR_AUDIO_DECODER_WAV_MSADPCM) ? (dec->samples_per_block) : (1);
+        uint32_t tail = dec->data_size % dec->block_align;
+        uint32_t length = (dec->data_size / dec->block_align) * samples_per_block;
+        if((dec->wav_format == TR_AUDIO_DECODER_WAV_MSADPCM) && (tail >= 7 * dec->channels))
+        {
+            length += 2 + (tail - 7 * dec->channels) * 2 / dec->channels;      // short last block
+        }
+        sample = (dec->looped && (length > 0)) ? (sample % length) : (sample);
+        uint64_t pos = (uint64_t)(sample / samples_per_block) * dec->block_align;
+        dec->data_pos = (pos < dec->data_size) ? ((uint32_t)pos) : (0);
+        dec->block_pcm_skip = (pos < dec->data_size) ? ((sample % samples_per_block) * dec->channels) : (0);
+        dec->block_pcm_count = 0;
+        dec->block_pcm_pos = 0;
+        SDL_RWseek(dec->file, dec->data_begin + dec->data_pos, RW_SEEK_SET);
+    }
+}
+
+
+/*
+ * Decodes one MS ADPCM block, returns amount of samples per channel.
+ */
+static uint32_t StreamDecoder_DecodeMSADPCM(stream_decoder_p dec, const uint8_t *src, uint32_t size, int16_t *dst)
+{
+    const int ch = dec->channels;
+    int coef[2][2], delta[2], s1[2], s2[2];
+    uint32_t samples;
+
+    if(size < 7 * ch)
+    {
+        return 0;
+    }
+
+    for(int c = 0; c < ch; c++)
+    {
+        uint8_t predictor = src[c];
+        predictor = (predictor < dec->coefs_count) ? (predictor) : (0);
+        coef[c][0] = dec->coefs[predictor][0];
+        coef[c][1] = dec->coefs[predictor][1];
+        delta[c] = (int16_t)StreamDecoder_Get16(src + ch + 2 * c);
+        s1[c] = (int16_t)StreamDecoder_Get16(src + 3 * ch + 2 * c);
+        s2[c] = (int16_t)StreamDecoder_Get16(src + 5 * ch + 2 * c);
+        dst[c] = s2[c];
+        dst[ch + c] = s1[c];
+    }
+
+    src += 7 * ch;
+    samples = 2 + (size - 7 * ch) * 2 / ch;
+    samples = (samples < dec->samples_per_block) ? (samples) : (dec->samples_per_block);
+    for(uint32_t i = 0; i < (samples - 2) * ch; i++)
+    {
+        const int c = i % ch;
+        int nibble = (i & 1) ? (src[i / 2] & 0x0F) : (src[i / 2] >> 4);
+        int sample = (s1[c] * coef[c][0] + s2[c] * coef[c][1]) / 256;
+        sample += ((nibble & 0x08) ? (nibble - 0x10) : (nibble)) * delta[c];
+        sample = (sample < -32768) ? (-32768) : ((sample > 32767) ? (32767) : (sample));
+        delta[c] = (msadpcm_adapt[nibble] * delta[c]) / 256;
+        delta[c] = (delta[c] < 16) ? (16) : ((delta[c] > 0x7FFFFFFF / 768) ? (0x7FFFFFFF / 768) : (delta[c]));  // broken data
+        s2[c] = s1[c];
+        s1[c] = sample;
+        dst[2 * ch + i] = sample;
+    }
+
+    return samples;
+}
+
+
+static size_t StreamDecoder_DecodeWav(stream_decoder_p dec, uint8_t *buff, size_t size)
+{
+    size_t ret = 0;
+
+    if(dec->wav_format != TR_AUDIO_DECODER_WAV_MSADPCM)
+    {
+        size_t left = dec->data_size - dec->data_pos;
+        size -= size % dec->block_align;
+        size = (size < left) ? (size) : (left);
+        ret = SDL_RWread(dec->file, buff, 1, size);
+        ret -= ret % dec->block_align;
+        dec->data_pos = (ret == size) ? (dec->data_pos + ret) : (dec->data_size);
+        return ret;
+    }
+
+    size -= size % (2 * dec->channels);
+    while(ret < size)
+    {
+        if(dec->block_pcm_pos >= dec->block_pcm_count)
+        {
+            uint32_t bytes = dec->data_size - dec->data_pos;
+            bytes = (bytes < dec->block_align) ? (bytes) : (dec->block_align);
+            if((bytes == 0) || (SDL_RWread(dec->file, dec->block, 1, bytes) != bytes))
+            {
+                dec->data_pos = dec->data_size;
+                break;
+            }
+            dec->data_pos += bytes;
+            dec->block_pcm_count = StreamDecoder_DecodeMSADPCM(dec, dec->block, bytes, dec->block_pcm) * dec->channels;
+            dec->block_pcm_pos = (dec->block_pcm_skip < dec->block_pcm_count) ? (dec->block_pcm_skip) : (dec->block_pcm_count);
+            dec->block_pcm_skip = 0;
+        }
+        else
+        {
+            size_t count = dec->block_pcm_count - dec->block_pcm_pos;
+            count = (count < (size - ret) / 2) ? (count) : ((size - ret) / 2);
+            memcpy(buff + ret, dec->block_pcm + dec->block_pcm_pos, count * 2);
+            dec->block_pcm_pos += count;
+            ret += count * 2;
+        }
+    }
+
+    return ret;
+}
+
+
+static size_t StreamDecoder_Decode(stream_decoder_p dec, uint8_t *buff, size_t size)
+{
+    if(dec->ogg)
+    {
+        int shorts = (size / (2 * dec->channels)) * dec->channels;
+        return 2 * dec->channels * stb_vorbis_get_samples_short_interleaved(dec->ogg, dec->channels, (short*)buff, shorts);
+    }
+    return StreamDecoder_DecodeWav(dec, buff, size);
+}
+
+
+static stream_decoder_p StreamDecoder_FindWork()
+{
+    for(stream_decoder_p dec = decoders_list; dec; dec = dec->next)
+    {
+        if(dec->seek_pending || (!dec->end && (dec->chunks_ready < TR_AUDIO_DECODER_CHUNKS)))
+        {
+            return dec;
+        }
+    }
+    return NULL;
+}
+
+
+static int StreamDecoder_Worker(void *data)
+{
+    SDL_LockMutex(decoders_mutex);
+    while(!decoders_stop)
+    {
+        stream_decoder_p dec = StreamDecoder_FindWork();
+        if(!dec)
+        {
+            SDL_CondWait(decoders_work_cond, decoders_mutex);
+            continue;
+        }
+
+        const uint32_t generation = dec->generation;
+        const uint32_t slot = (dec->chunk_first + dec->chunks_ready) % TR_AUDIO_DECODER_CHUNKS;
+        const int seek = dec->seek_pending;
+        const uint32_t seek_sample = dec->seek_sample;
+        uint8_t *chunk = dec->chunks + slot * TR_AUDIO_DECODER_CHUNK_SIZE;
+        const char *error = NULL;
+        size_t size = 0;
+        dec->seek_pending = 0;
+        dec->busy = 1;
+        SDL_UnlockMutex(decoders_mutex);
+
+        if(dec->opened == 0)
+        {
+            dec->opened = StreamDecoder_Open(dec) ? (1) : (-1);
+        }
+
+        if(dec->opened > 0)
+        {
+            if(seek)
+            {
+                StreamDecoder_SeekInternal(dec, seek_sample);
+            }
+            size = StreamDecoder_Decode(dec, chunk, TR_AUDIO_DECODER_CHUNK_SIZE);
+            while((size < TR_AUDIO_DECODER_CHUNK_SIZE) && dec->looped)
+            {
+                // Rewind right here, so loop has no gap between chunks.
+                size_t bytes;
+                StreamDecoder_SeekInternal(dec, 0);
+                bytes = StreamDecoder_Decode(dec, chunk + size, TR_AUDIO_DECODER_CHUNK_SIZE - size);
+                if(bytes == 0)
+                {
+                    break;
+                }
+                size += bytes;
+            }
+        }
+        else
+        {
+            error = "can't open track or track format is not supported";
+        }
+
+        SDL_LockMutex(decoders_mutex);
+        dec->busy = 0;
+        if(generation == dec->generation)
+        {
+            if(size > 0)
+            {
+                dec->chunk_size[slot] = size;
+                dec->chunks_ready++;
+            }
+            dec->end = (size < TR_AUDIO_DECODER_CHUNK_SIZE);
+            dec->error = error;
+        }
+        SDL_CondBroadcast(decoders_done_cond);
+    }
+    SDL_UnlockMutex(decoders_mutex);
+
+    return 0;
+}
+
+
+void StreamDecoder_InitWorker()
+{
+    if(!decoders_thread)
+    {
+        decoders_stop = 0;
+        decoders_mutex = SDL_CreateMutex();
+        decoders_work_cond = SDL_CreateCond();
+        decoders_done_cond = SDL_CreateCond();
+        decoders_thread = SDL_CreateThread(StreamDecoder_Worker, "audio_decoder", NULL);
+    }
+}
+
+
+void StreamDecoder_DeinitWorker()
+{
+    if(decoders_thread)
+    {
+        SDL_LockMutex(decoders_mutex);
+        decoders_stop = 1;
+        SDL_CondBroadcast(decoders_work_cond);
+        SDL_UnlockMutex(decoders_mutex);
+        SDL_WaitThread(decoders_thread, NULL);
+        decoders_thread = NULL;
+
+        while(decoders_list)
+        {
+            StreamDecoder_Destroy(decoders_list);
+        }
+        SDL_DestroyCond(decoders_done_cond);
+        SDL_DestroyCond(decoders_work_cond);
+        SDL_DestroyMutex(decoders_mutex);
+        decoders_done_cond = NULL;
+        decoders_work_cond = NULL;
+        decoders_mutex = NULL;
+    }
+}
+
+
+stream_decoder_p StreamDecoder_Create(const char *path, int method, uint32_t track, int looped)
+{
+    stream_decoder_p dec;
+
+    if(!decoders_thread)
+    {
+        return NULL;
+    }
+
+    dec = (stream_decoder_p)calloc(1, sizeof(struct stream_decoder_s));
+    dec->path = strdup(path);
+    dec->method = method;
+    dec->track = track;
+    dec->looped = looped;
+    dec->chunks = (uint8_t*)malloc(TR_AUDIO_DECODER_CHUNKS * TR_AUDIO_DECODER_CHUNK_SIZE);
+
+    SDL_LockMutex(decoders_mutex);
+    dec->next = decoders_list;
+    decoders_list = dec;
+    SDL_CondSignal(decoders_work_cond);
+    SDL_UnlockMutex(decoders_mutex);
+
+    return dec;
+}
+
+
+void StreamDecoder_Destroy(stream_decoder_p dec)
+{
+    SDL_LockMutex(decoders_mutex);
+    while(dec->busy)
+    {
+        SDL_CondWait(decoders_done_cond, decoders_mutex);
+    }
+    for(stream_decoder_p *ptr = &decoders_list; *ptr; ptr = &(*ptr)->next)
+    {
+        if(*ptr == dec)
+        {
+            *ptr = dec->next;
+            break;
+        }
+    }
+    SDL_UnlockMutex(decoders_mutex);
+
+    if(dec->ogg)
+    {
+        stb_vorbis_close(dec->ogg);
+    }
+    if(dec->file)
+    {
+        SDL_RWclose(dec->file);
+    }
+    free(dec->block);
+    free(dec->block_pcm);
+    free(dec->chunks);
+    free(dec->path);
+    free(dec);
+}
+
+
+void StreamDecoder_Seek(stream_decoder_p dec, uint32_t sample)
+{
+    SDL_LockMutex(decoders_mutex);
+    dec->generation++;
+    dec->seek_pending = 1;
+    dec->seek_sample = sample;
+    dec->chunk_first = 0;
+    dec->chunks_ready = 0;
+    dec->end = 0;
+    dec->error = NULL;
+    SDL_CondSignal(decoders_work_cond);
+    SDL_UnlockMutex(decoders_mutex);
+}
+
+
+uint8_t *StreamDecoder_GetChunk(stream_decoder_p dec, size_t *size, int *sample_bitsize, int *channels, int *rate)
+{
+    uint8_t *ret = NULL;
+    SDL_LockMutex(decoders_mutex);
+    if(dec->chunks_ready > 0)
+    {
+        ret = dec->chunks + dec->chunk_first * TR_AUDIO_DECODER_CHUNK_SIZE;
+        *size = dec->chunk_size[dec->chunk_first];
+        *sample_bitsize = dec->sample_bitsize;
+        *channels = dec->channels;
+        *rate = dec->rate;
+    }
+    SDL_UnlockMutex(decoders_mutex);
+    return ret;
+}
+
+
+void StreamDecoder_ReleaseChunk(stream_decoder_p dec)
+{
+    SDL_LockMutex(decoders_mutex);
+    if(dec->chunks_ready > 0)
+    {
+        dec->chunk_first = (dec->chunk_first + 1) % TR_AUDIO_DECODER_CHUNKS;
+        dec->chunks_ready--;
+        SDL_CondSignal(decoders_work_cond);
+    }
+    SDL_UnlockMutex(decoders_mutex);
+}
+
+
+int StreamDecoder_IsFinished(stream_decoder_p dec)
+{
+    int ret;
+    SDL_LockMutex(decoders_mutex);
+    ret = dec->end && !dec->seek_pending && (dec->chunks_ready == 0);
+    SDL_UnlockMutex(decoders_mutex);
+    return ret;
+}
+
+
+const char *StreamDecoder_GetError(stream_decoder_p dec)
+{
+    const char *ret;
+    SDL_LockMutex(decoders_mutex);
+    ret = dec->error;
+    SDL_UnlockMutex(decoders_mutex);
+    return ret;
+}
@@ -0,0 +1,46 @@
+
+#ifndef AUDIO_DECODER_H
+#define AUDIO_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Stream decoders read soundtracks piece by piece instead of loading whole
+// track into memory. Decoding is done by single audio worker thread, which
+// keeps a small ring of decoded PCM chunks ahead of playback for each opened
+// decoder; main thread takes ready chunks and feeds them to stream track
+// OpenAL buffers. So memory used by music does not depend on track length.
+
+// Size of one decoded PCM chunk in bytes, and amount of chunks in ring.
+// With 44100 Hz 16 bit stereo track, chunk is ~0.37 sec. of sound, and
+// together with TR_AUDIO_STREAM_NUMBUFFERS queued OpenAL buffers it gives
+// ~3 sec. reserve for the case of slow worker.
+
+#define TR_AUDIO_DECODER_CHUNK_SIZE     (64 * 1024)
+#define TR_AUDIO_DECODER_CHUNKS         4
+
+struct stream_decoder_s;
+typedef struct stream_decoder_s *stream_decoder_p;
+
+void StreamDecoder_InitWorker();
+void StreamDecoder_DeinitWorker();
+
+// Decoder is only created here, file is opened and decoded by the worker;
+// method is one of TR_AUDIO_STREAM_METHOD (track is a WAD entry index).
+stream_decoder_p StreamDecoder_Create(const char *path, int method, uint32_t track, int looped);
+void StreamDecoder_Destroy(stream_decoder_p dec);
+
+// Drops chunks decoded ahead and restarts decoding from given sample
+// (per channel) position; looped track position wraps by track length.
+void StreamDecoder_Seek(stream_decoder_p dec, uint32_t sample);
+
+// Returns next ready chunk or NULL if there is none yet; chunk stays valid
+// until StreamDecoder_ReleaseChunk call.
+uint8_t *StreamDecoder_GetChunk(stream_decoder_p dec, size_t *size, int *sample_bitsize, int *channels, int *rate);
+void StreamDecoder_ReleaseChunk(stream_decoder_p dec);
+
+// Track is decoded to the end (or failed) and all its chunks were taken.
+int StreamDecoder_IsFinished(stream_decoder_p dec);
+const char *StreamDecoder_GetError(stream_decoder_p dec);     // NULL if none.
+
+#endif // AUDIO_DECODER_H
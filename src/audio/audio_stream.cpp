@@ -11,6 +11,7 @@ extern "C" {
 
 #include "audio.h"
 #include "audio_stream.h"
+#include "audio_decoder.h"
 
 
 // ======== PRIVATE PROTOTYPES =============
@@ -31,8 +32,10 @@ void StreamTrack_Init(stream_track_p s)
     s->state = TR_AUDIO_STREAM_STOPPED;
     s->linked_buffers = 0;
     s->buffer_offset = 0;
+    s->played_samples = 0;
     s->current_volume = 0.0f;
     s->track = -1;
+    s->decoder = NULL;
     s->internal = (struct stream_internal_s*)malloc(sizeof(struct stream_internal_s));
     alGenBuffers(TR_AUDIO_STREAM_NUMBUFFERS, s->internal->buffers);
     alGenSources(1, &s->internal->source);
@@ -106,7 +109,15 @@ int StreamTrack_UpdateBuffer(stream_track_p s, uint8_t *buff, size_t size, int s
             if(processed > 0)
             {
                 ALuint buffer_index = 0;
+                ALint buffer_size = 0, buffer_bits = 0, buffer_channels = 0;
                 alSourceUnqueueBuffers(s->internal->source, 1, &buffer_index);
+                alGetBufferi(buffer_index, AL_SIZE, &buffer_size);
+                alGetBufferi(buffer_index, AL_BITS, &buffer_bits);
+                alGetBufferi(buffer_index, AL_CHANNELS, &buffer_channels);
+                if((buffer_bits >= 8) && (buffer_channels > 0))
+                {
+                    s->played_samples += buffer_size / (buffer_channels * buffer_bits / 8);
+                }
                 if(Audio_FillALBuffer(buffer_index, buff, size, sample_bitsize, channels, frequency))
                 {
                     s->buffer_offset += size;
@@ -142,7 +153,7 @@ int StreamTrack_Play(stream_track_p s)
         alGetSourcei(s->internal->source, AL_SOURCE_STATE, &state);
         if(state != AL_PLAYING)
         {
-            s->state = TR_AUDIO_STREAM_PLAYING;
+            s->state = (s->state == TR_AUDIO_STREAM_STOPPING) ? (TR_AUDIO_STREAM_STOPPING) : (TR_AUDIO_STREAM_PLAYING);
             alSourcePlay(s->internal->source);
         }
         alSourcef(s->internal->source, AL_GAIN, s->current_volume);
@@ -154,6 +165,12 @@ int StreamTrack_Play(stream_track_p s)
 
 int StreamTrack_Stop(stream_track_p s)
 {
+    if(s->decoder)
+    {
+        StreamDecoder_Destroy(s->decoder);
+        s->decoder = NULL;
+    }
+
     if(alIsSource(s->internal->source))
     {
         ALint queued = 0;
@@ -172,6 +189,7 @@ int StreamTrack_Stop(stream_track_p s)
         }
         s->linked_buffers = 0;
         s->buffer_offset = 0;
+        s->played_samples = 0;
         s->state = TR_AUDIO_STREAM_STOPPED;
         return 1;
     }
@@ -195,6 +213,11 @@ int StreamTrack_CheckForEnd(stream_track_p s)
     {
         ALint processed = 0;
         ALint state = AL_STOPPED;  // AL_STOPPED, AL_INITIAL, AL_PLAYING, AL_PAUSED
+        if(s->decoder && !StreamDecoder_IsFinished(s->decoder))
+        {
+            return 0;   // Source may be starved while decoder is behind, it is restarted on refill.
+        }
+
         alGetSourcei(s->internal->source, AL_SOURCE_STATE, &state);
         if((state == AL_STOPPED) || ((state == AL_PAUSED) && (s->state != TR_AUDIO_STREAM_PAUSED)))
         {
@@ -208,6 +231,18 @@ int StreamTrack_CheckForEnd(stream_track_p s)
 }
 
 
+uint32_t StreamTrack_GetPosition(stream_track_p s)
+{
+    ALint offset = 0;
+    if((s->state != TR_AUDIO_STREAM_STOPPED) && alIsSource(s->internal->source))
+    {
+        // offset is counted from the first still queued buffer
+        alGetSourcei(s->internal->source, AL_SAMPLE_OFFSET, &offset);
+    }
+    return s->played_samples + ((offset > 0) ? (offset) : (0));
+}
+
+
 int StreamTrack_UpdateState(stream_track_p s, float time, float volume)
 {
     if((s->state != TR_AUDIO_STREAM_STOPPED) && alIsSource(s->internal->source))
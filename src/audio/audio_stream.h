@@ -65,6 +65,7 @@ enum TR_AUDIO_STREAM_METHOD
 #define TR_AUDIO_STREAM_STOPPING    (3)
 
 struct stream_internal_s;
+struct stream_decoder_s;
 
 typedef struct stream_track_s
 {
@@ -73,7 +74,9 @@ typedef struct stream_track_s
     uint16_t                    state;
     uint32_t                    linked_buffers;
     uint32_t                    buffer_offset;
+    uint32_t                    played_samples;     // Per channel, of buffers already unqueued, from track start.
     float                       current_volume;     // Stream volume, considering fades.
+    struct stream_decoder_s    *decoder;            // Soundtrack decoder, NULL for external streams.
     struct stream_internal_s   *internal;
 }stream_track_t, *stream_track_p;
 
@@ -85,6 +88,7 @@ int StreamTrack_Play(stream_track_p s);
 int StreamTrack_Stop(stream_track_p s);
 int StreamTrack_Pause(stream_track_p s);
 int StreamTrack_CheckForEnd(stream_track_p s);
+uint32_t StreamTrack_GetPosition(stream_track_p s);   // Samples per channel played from track start.
 
 int StreamTrack_IsNeedUpdateBuffer(stream_track_p s);
 int StreamTrack_UpdateBuffer(stream_track_p s, uint8_t *buff, size_t size, int sample_bitsize, int channels, int frequency);
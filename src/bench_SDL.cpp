@@ -0,0 +1,160 @@
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/system.h"
+#include "audio/audio.h"
+#include "render/camera.h"
+#include "render/render.h"
+#include "engine.h"
+#include "game.h"
+
+/*
+ * Headless level playback benchmark: loads level through World_Open, drives
+ * Game_Frame with fixed time step (no window, no GL context, no input) and
+ * writes per phase timings as JSON. With -render renderer list generation
+ * and submission are also measured (CPU side only, GL calls are stubs).
+ *
+ * usage: opentomb_bench [-level "path"] [-frames N] [-dt seconds] [-out "file.json"] [-render]
+ *                       [-config / -autoexec / -base_path as for OpenTomb]
+ */
+
+static void Bench_WriteJSON(FILE *f, const char *level_name, int frames, float dt, double load_time,
+                            double total_time, double max_frame_time, double audio_time, double render_time, game_frame_stats_p stats)
+{
+    double other_time = total_time - audio_time - render_time - stats->scripts - stats->character - stats->entity_frame - stats->physics;
+
+    fprintf(f, "{\n");
+    fprintf(f, "    \"level\": \"%s\",\n", level_name);
+    fprintf(f, "    \"frames\": %d,\n", frames);
+    fprintf(f, "    \"dt\": %.6f,\n", dt);
+    fprintf(f, "    \"load_ms\": %.3f,\n", load_time * 1000.0);
+    fprintf(f, "    \"total_ms\": %.3f,\n", total_time * 1000.0);
+    fprintf(f, "    \"frame_avg_ms\": %.4f,\n", (frames > 0) ? (total_time * 1000.0 / frames) : (0.0));
+    fprintf(f, "    \"frame_max_ms\": %.4f,\n", max_frame_time * 1000.0);
+    fprintf(f, "    \"phases_ms\": {\n");
+    fprintf(f, "        \"scripts\": %.3f,\n", stats->scripts * 1000.0);
+    fprintf(f, "        \"character_update\": %.3f,\n", stats->character * 1000.0);
+    fprintf(f, "        \"entity_frame\": %.3f,\n", stats->entity_frame * 1000.0);
+    fprintf(f, "        \"physics_step\": %.3f,\n", stats->physics * 1000.0);
+    fprintf(f, "        \"audio_update\": %.3f,\n", audio_time * 1000.0);
+    fprintf(f, "        \"render\": %.3f,\n", render_time * 1000.0);
+    fprintf(f, "        \"other\": %.3f\n", other_time * 1000.0);
+    fprintf(f, "    }\n");
+    fprintf(f, "}\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *level_name = "tests/heavy1/LEVEL1.PHD";
+    const char *out_name = NULL;
+    int frames = 1000;
+    int render = 0;
+    float dt = GAME_LOGIC_REFRESH_INTERVAL;
+    int engine_argc = 1;
+    char **engine_argv = (char**)malloc(argc * sizeof(char*));
+
+    engine_argv[0] = argv[0];
+    for(int i = 1; i < argc; ++i)
+    {
+        if((0 == strcmp(argv[i], "-level")) && (i + 1 < argc))
+        {
+            level_name = argv[++i];
+        }
+        else if((0 == strcmp(argv[i], "-frames")) && (i + 1 < argc))
+        {
+            frames = atoi(argv[++i]);
+        }
+        else if((0 == strcmp(argv[i], "-dt")) && (i + 1 < argc))
+        {
+            dt = atof(argv[++i]);
+        }
+        else if((0 == strcmp(argv[i], "-out")) && (i + 1 < argc))
+        {
+            out_name = argv[++i];
+        }
+        else if(0 == strcmp(argv[i], "-render"))
+        {
+            render = 1;
+        }
+        else
+        {
+            engine_argv[engine_argc++] = argv[i];
+        }
+    }
+
+    srand(0);
+    Engine_StartHeadless(engine_argc, engine_argv);
+    free(engine_argv);
+
+    double load_time = Sys_DoubleTime();
+    if(!Engine_LoadMap(level_name))
+    {
+        fprintf(stderr, "opentomb_bench: can not load level \"%s\"\n", level_name);
+        Engine_Shutdown(EXIT_FAILURE);
+    }
+    load_time = Sys_DoubleTime() - load_time;
+
+    // The same seed and the same time step every run: simulation is repeatable.
+    srand(0);
+    Game_ResetFrameStats();
+
+    double total_time = 0.0;
+    double max_frame_time = 0.0;
+    double audio_time = 0.0;
+    double render_time = 0.0;
+    for(int i = 0; i < frames; ++i)
+    {
+        double t = Sys_DoubleTime();
+        Sys_ResetTempMem();
+        engine_frame_time = dt;
+        Game_Frame(dt);
+
+        double t_audio = Sys_DoubleTime();
+        Audio_Update(dt);
+        double t_end = Sys_DoubleTime();
+        audio_time += t_end - t_audio;
+
+        if(render)
+        {
+            renderer.BeginFrame();
+            Cam_Apply(&engine_camera);
+            Cam_RecalcClipPlanes(&engine_camera);
+            renderer.GenWorldList(&engine_camera);
+            renderer.DrawList();
+            double t_render = Sys_DoubleTime();
+            render_time += t_render - t_end;
+            t_end = t_render;
+        }
+
+        total_time += t_end - t;
+        if(t_end - t > max_frame_time)
+        {
+            max_frame_time = t_end - t;
+        }
+    }
+
+    game_frame_stats_t stats;
+    Game_GetFrameStats(&stats);
+
+    FILE *f = (out_name) ? (fopen(out_name, "w")) : (stdout);
+    if(f)
+    {
+        Bench_WriteJSON(f, level_name, frames, dt, load_time, total_time, max_frame_time, audio_time, render_time, &stats);
+        if(f != stdout)
+        {
+            fclose(f);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "opentomb_bench: can not write \"%s\"\n", out_name);
+    }
+
+    Engine_Shutdown((f) ? (EXIT_SUCCESS) : (EXIT_FAILURE));
+
+    return(EXIT_SUCCESS);
+}
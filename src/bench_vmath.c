@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "core/vmath.h"
+#include "core/vmath_simd.h"
+
+/*
+ * Bone update kernels benchmark: compares scalar vec4_slerp,
+ * Mat4_set_qrotation and Mat4_Mat4_mul with SIMD four lanes versions on
+ * random data; prints max absolute error and time of each.
+ *
+ * usage: opentomb_vmath_bench [N]
+ */
+
+static float Bench_Rand(float min, float max)
+{
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+
+static void Bench_RandQuat(float q[4])
+{
+    float t;
+    do
+    {
+        q[0] = Bench_Rand(-1.0f, 1.0f);
+        q[1] = Bench_Rand(-1.0f, 1.0f);
+        q[2] = Bench_Rand(-1.0f, 1.0f);
+        q[3] = Bench_Rand(-1.0f, 1.0f);
+        t = vec4_abs(q);
+    }
+    while(t < 0.01f);
+    q[0] /= t;
+    q[1] /= t;
+    q[2] /= t;
+    q[3] /= t;
+}
+
+
+static float Bench_MaxError(const float *a, const float *b, int count)
+{
+    float ret = 0.0f;
+    for(int i = 0; i < count; i++)
+    {
+        float d = fabsf(a[i] - b[i]);
+        ret = (d > ret) ? (d) : (ret);
+    }
+    return ret;
+}
+
+
+static double Bench_Time(clock_t start)
+{
+    return 1000.0 * (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+}
+
+
+int main(int argc, char **argv)
+{
+    int count = (argc > 1) ? (atoi(argv[1])) : (1 << 16);
+    int repeats = 64;
+    float *q1, *q2, *t, *q_ref, *q_simd, *m1, *m2, *m_ref, *m_simd;
+    float *p_ret[4], *p_q1[4], *p_q2[4];
+    float err;
+    double scalar_ms, simd_ms;
+    clock_t start;
+
+    count = (count < 4) ? (4) : (count & ~3);
+    q1 = (float*)malloc(4 * count * sizeof(float));
+    q2 = (float*)malloc(4 * count * sizeof(float));
+    t = (float*)malloc(count * sizeof(float));
+    q_ref = (float*)malloc(4 * count * sizeof(float));
+    q_simd = (float*)malloc(4 * count * sizeof(float));
+    m1 = (float*)malloc(16 * count * sizeof(float));
+    m2 = (float*)malloc(16 * count * sizeof(float));
+    m_ref = (float*)malloc(16 * count * sizeof(float));
+    m_simd = (float*)malloc(16 * count * sizeof(float));
+
+    srand(1);
+    for(int i = 0; i < count; i++)
+    {
+        Bench_RandQuat(q1 + 4 * i);
+        switch(i % 8)
+        {
+            case 0:                                                             // identical rotations
+                vec4_copy(q2 + 4 * i, q1 + 4 * i);
+                break;
+
+            case 1:                                                             // opposite hemisphere
+                vec4_copy(q2 + 4 * i, q1 + 4 * i);
+                vec4_copy_inv(q2 + 4 * i, q2 + 4 * i);
+                q2[4 * i + 0] += 0.01f;
+                break;
+
+            default:
+                Bench_RandQuat(q2 + 4 * i);
+                break;
+        }
+        t[i] = (i % 16 == 2) ? (0.0f) : ((i % 16 == 3) ? (1.0f) : (Bench_Rand(0.0f, 1.0f)));
+    }
+    for(int i = 0; i < 16 * count; i++)
+    {
+        m1[i] = Bench_Rand(-2.0f, 2.0f);
+        m2[i] = Bench_Rand(-2.0f, 2.0f);
+    }
+    for(int i = 0; i < 16 * count; i++)
+    {
+        m_ref[i] = m_simd[i] = 0.0f;
+    }
+
+    printf("SIMD: %s, N = %d, repeats = %d\n", SIMD_GetInstructionSet(), count, repeats);
+
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            vec4_slerp(q_ref + 4 * i, q1 + 4 * i, q2 + 4 * i, t[i]);
+        }
+    }
+    scalar_ms = Bench_Time(start);
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i += 4)
+        {
+            for(int j = 0; j < 4; j++)
+            {
+                p_ret[j] = q_simd + 4 * (i + j);
+                p_q1[j] = q1 + 4 * (i + j);
+                p_q2[j] = q2 + 4 * (i + j);
+            }
+            vec4_slerp_x4(p_ret, p_q1, p_q2, t + i);
+        }
+    }
+    simd_ms = Bench_Time(start);
+    err = Bench_MaxError(q_ref, q_simd, 4 * count);
+    printf("slerp:      scalar %8.3f ms, simd %8.3f ms, x%.2f, max error %g\n", scalar_ms, simd_ms, scalar_ms / simd_ms, err);
+
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            Mat4_set_qrotation(m_ref + 16 * i, q_ref + 4 * i);
+        }
+    }
+    scalar_ms = Bench_Time(start);
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i += 4)
+        {
+            for(int j = 0; j < 4; j++)
+            {
+                p_ret[j] = m_simd + 16 * (i + j);
+                p_q1[j] = q_ref + 4 * (i + j);
+            }
+            Mat4_set_qrotation_x4(p_ret, p_q1);
+        }
+    }
+    simd_ms = Bench_Time(start);
+    err = Bench_MaxError(m_ref, m_simd, 16 * count);
+    printf("qrotation:  scalar %8.3f ms, simd %8.3f ms, x%.2f, max error %g\n", scalar_ms, simd_ms, scalar_ms / simd_ms, err);
+
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            Mat4_Mat4_mul(m_ref + 16 * i, m1 + 16 * i, m2 + 16 * i);
+        }
+    }
+    scalar_ms = Bench_Time(start);
+    start = clock();
+    for(int r = 0; r < repeats; r++)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            Mat4_Mat4_mul_simd(m_simd + 16 * i, m1 + 16 * i, m2 + 16 * i);
+        }
+    }
+    simd_ms = Bench_Time(start);
+    err = Bench_MaxError(m_ref, m_simd, 16 * count);
+    printf("mat4 mul:   scalar %8.3f ms, simd %8.3f ms, x%.2f, max error %g\n", scalar_ms, simd_ms, scalar_ms / simd_ms, err);
+
+    free(q1);
+    free(q2);
+    free(t);
+    free(q_ref);
+    free(q_simd);
+    free(m1);
+    free(m2);
+    free(m_ref);
+    free(m_simd);
+
+    return 0;
+}
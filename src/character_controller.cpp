@@ -234,24 +234,14 @@ void Character_UpdatePath(struct entity_s *ent, struct room_sector_s *target)
 {
     if(ent->character && ent->self->sector && ent->self->sector->box && target && target->box)
     {
-        const int buf_size = sizeof(room_box_p) * World_GetRoomBoxesCount();
-        room_box_p *path = (room_box_p*)Sys_GetTempMem(buf_size);
+        const int max_dist = sizeof(ent->character->path) / sizeof(ent->character->path[0]);
         box_validition_options_t op;
         op.zone = ent->character->ai_zone;
         op.zone_type = (ent->move_type == MOVE_FLY) ? (ZONE_TYPE_FLY) : (ent->character->ai_zone_type);
         op.zone_alt = ent->self->room->is_swapped;
         op.step_up = (ent->character->max_step_up_height > ent->character->max_climb_height) ? (ent->character->max_step_up_height) : (ent->character->max_climb_height);
         op.step_down = ent->character->fall_down_height;
-        int dist = Room_FindPath(path, World_GetRoomBoxesCount(), ent->self->sector, target, &op);
-        const int max_dist = sizeof(ent->character->path) / sizeof(ent->character->path[0]);
-        ent->character->path_dist = (dist > max_dist) ? (max_dist) : dist;
-
-        for(int i = 0; i < ent->character->path_dist; ++i)
-        {
-            ent->character->path[i] = path[dist - i - 1];
-        }
-
-        Sys_ReturnTempMem(buf_size);
+        ent->character->path_dist = Room_FindPath(ent->character->path, max_dist, ent->self->sector, target, &op);
     }
 }
 
@@ -2286,17 +2276,19 @@ struct entity_s *Character_FindTarget(struct entity_s *ent)
     entity_p ret = NULL;
     float max_dot = 0.0f;
     collision_result_t cs;
+    room_p rooms[4 * ENTITY_NEAR_ROOMS_MAX];
+    uint32_t rooms_count = World_GetRoomsNearPos(rooms, 4 * ENTITY_NEAR_ROOMS_MAX, ent->transform.M4x4 + 12, CHARACTER_TARGET_RANGE);
 
-    for(int ri = -1; ri < ent->self->room->content->near_room_list_size; ++ri)
+    for(uint32_t ri = 0; ri < rooms_count; ++ri)
     {
-        room_p r = (ri >= 0) ? (ent->self->room->content->near_room_list[ri]) : (ent->self->room);
-        for(engine_container_p cont = r->containers; cont; cont = cont->next)
+        for(engine_container_p cont = rooms[ri]->containers; cont; cont = cont->next)
         {
             if(cont->object_type == OBJECT_ENTITY)
             {
                 entity_p target = (entity_p)cont->object;
-                if((target->type_flags & ENTITY_TYPE_ACTOR) && (target->state_flags & ENTITY_STATE_ACTIVE) &&
-                   (!target->character || (target->character->parameters.param[PARAM_HEALTH] > 0.0f)))
+                if((target != ent) && (target->type_flags & ENTITY_TYPE_ACTOR) && (target->state_flags & ENTITY_STATE_ACTIVE) &&
+                   (!target->character || (target->character->parameters.param[PARAM_HEALTH] > 0.0f)) &&
+                   (vec3_dist_sq(target->transform.M4x4 + 12, ent->transform.M4x4 + 12) < CHARACTER_TARGET_RANGE * CHARACTER_TARGET_RANGE))
                 {
                     float dir[3], t;
                     vec3_sub(dir, target->transform.M4x4 + 12, ent->transform.M4x4 + 12);
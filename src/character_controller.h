@@ -62,6 +62,7 @@
 #define CHARACTER_BOX_HALF_SIZE (128.0)
 #define CHARACTER_BASE_RADIUS   (128.0)
 #define CHARACTER_BASE_HEIGHT   (512.0)
+#define CHARACTER_TARGET_RANGE  (8192.0)                // weapons range, 8 sectors
 
 /*
  * ENTITY MOVEMENT TYPES
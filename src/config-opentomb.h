@@ -0,0 +1,16 @@
+//
+//  config-opentomb.h.in.h
+//  OpenTomb
+//
+//  Created by Torsten Kammer on 27.06.16.
+//
+//
+
+#ifndef config_opentomb_h_in_h
+#define config_opentomb_h_in_h
+
+#define HAVE_ALC_H 1
+#define HAVE_EFX_H 1
+#define HAVE_EFX_PRESETS_H 1
+
+#endif /* config_opentomb_h_in_h */
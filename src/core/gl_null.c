@@ -0,0 +1,503 @@
+/*****************************************************************
+ * Null OpenGL driver: every entry point is a stub, no context is
+ * needed. Used for headless runs (benchmarks, CI) where the world
+ * must be loaded and simulated, but nothing is ever drawn.
+ *****************************************************************/
+
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+#include <string.h>
+
+#include "gl_null.h"
+
+
+static GLuint   gl_null_last_texture = 0;
+static GLuint   gl_null_last_buffer  = 0;
+static GLuint   gl_null_last_array   = 0;
+static GLuint   gl_null_last_object  = 0;
+
+static const GLubyte *APIENTRY GLNull_GetString(GLenum name)
+{
+    switch(name)
+    {
+        case GL_VENDOR:
+            return (const GLubyte*)"OpenTomb";
+
+        case GL_RENDERER:
+            return (const GLubyte*)"null";
+
+        case GL_VERSION:
+            return (const GLubyte*)"2.1 null";
+
+        case GL_SHADING_LANGUAGE_VERSION:
+            return (const GLubyte*)"1.20 null";
+
+        case GL_EXTENSIONS:
+            return (const GLubyte*)"GL_ARB_vertex_buffer_object GL_ARB_shading_language_100 "
+                                   "GL_ARB_shader_objects GL_ARB_vertex_array_object GL_ARB_multitexture "
+                                   "GL_ARB_draw_instanced GL_ARB_instanced_arrays GL_ARB_texture_compression "
+                                   "GL_EXT_texture_compression_s3tc";
+    };
+
+    return (const GLubyte*)"";
+}
+
+
+static void APIENTRY GLNull_GetIntegerv(GLenum pname, GLint *params)
+{
+    switch(pname)
+    {
+        case GL_MAX_TEXTURE_SIZE:
+            params[0] = 4096;
+            break;
+
+        case GL_MAX_VIEWPORT_DIMS:
+            params[0] = 4096;
+            params[1] = 4096;
+            break;
+
+        case GL_VIEWPORT:
+            params[0] = 0;
+            params[1] = 0;
+            params[2] = 1;
+            params[3] = 1;
+            break;
+
+        case GL_MAX_VERTEX_ATTRIBS_ARB:
+            params[0] = 16;
+            break;
+
+        case GL_MAX_VERTEX_UNIFORM_COMPONENTS_ARB:
+        case GL_MAX_FRAGMENT_UNIFORM_COMPONENTS_ARB:
+            params[0] = 1024;
+            break;
+
+        case GL_MAX_TEXTURE_UNITS_ARB:
+            params[0] = 4;
+            break;
+
+        default:
+            params[0] = 0;
+            break;
+    };
+}
+
+
+static void APIENTRY GLNull_GetFloatv(GLenum pname, GLfloat *params)
+{
+    params[0] = 1.0f;
+}
+
+
+static void APIENTRY GLNull_GenTextures(GLsizei n, GLuint *textures)
+{
+    for(GLsizei i = 0; i < n; ++i)
+    {
+        textures[i] = ++gl_null_last_texture;
+    }
+}
+
+
+static void APIENTRY GLNull_GenBuffers(GLsizei n, GLuint *buffers)
+{
+    for(GLsizei i = 0; i < n; ++i)
+    {
+        buffers[i] = ++gl_null_last_buffer;
+    }
+}
+
+
+static void APIENTRY GLNull_GenVertexArrays(GLsizei n, GLuint *arrays)
+{
+    for(GLsizei i = 0; i < n; ++i)
+    {
+        arrays[i] = ++gl_null_last_array;
+    }
+}
+
+
+static GLhandleARB APIENTRY GLNull_CreateObject(GLenum type)
+{
+    return ++gl_null_last_object;
+}
+
+
+/*
+ * Shader objects: every shader compiles and links, info logs are empty,
+ * no uniform or attribute is active (same answer as a real driver gives
+ * for the names optimized out of a program).
+ */
+static void APIENTRY GLNull_GetObjectParameteriv(GLhandleARB obj, GLenum pname, GLint *params)
+{
+    params[0] = (pname == GL_OBJECT_INFO_LOG_LENGTH_ARB) ? (0) : (1);
+}
+
+
+static void APIENTRY GLNull_GetShaderOrProgramiv(GLuint obj, GLenum pname, GLint *params)
+{
+    params[0] = (pname == GL_INFO_LOG_LENGTH) ? (0) : (1);
+}
+
+
+static void APIENTRY GLNull_GetInfoLog(GLhandleARB obj, GLsizei max_length, GLsizei *length, GLcharARB *info_log)
+{
+    if(length)
+    {
+        *length = 0;
+    }
+    if(info_log && (max_length > 0))
+    {
+        info_log[0] = 0;
+    }
+}
+
+
+static GLint APIENTRY GLNull_GetLocation(GLhandleARB program, const GLcharARB *name)
+{
+    return -1;
+}
+
+
+static void APIENTRY GLNull_ShaderSource(GLhandleARB obj, GLsizei count, const GLcharARB **string, const GLint *length)
+{
+}
+
+
+static void APIENTRY GLNull_Object(GLhandleARB obj)
+{
+}
+
+
+static void APIENTRY GLNull_AttachObject(GLhandleARB container, GLhandleARB obj)
+{
+}
+
+
+static void APIENTRY GLNull_Uniform1f(GLint location, GLfloat v0)
+{
+}
+
+
+static void APIENTRY GLNull_Uniform1i(GLint location, GLint v0)
+{
+}
+
+
+static void APIENTRY GLNull_Uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+}
+
+
+static void APIENTRY GLNull_Uniformfv(GLint location, GLsizei count, const GLfloat *value)
+{
+}
+
+
+static void APIENTRY GLNull_UniformMatrixfv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+}
+
+
+/*
+ * Objects names
+ */
+static GLboolean APIENTRY GLNull_IsTexture(GLuint texture)
+{
+    return ((texture > 0) && (texture <= gl_null_last_texture)) ? (GL_TRUE) : (GL_FALSE);
+}
+
+
+static GLboolean APIENTRY GLNull_IsBuffer(GLuint buffer)
+{
+    return ((buffer > 0) && (buffer <= gl_null_last_buffer)) ? (GL_TRUE) : (GL_FALSE);
+}
+
+
+static GLboolean APIENTRY GLNull_IsVertexArray(GLuint array)
+{
+    return ((array > 0) && (array <= gl_null_last_array)) ? (GL_TRUE) : (GL_FALSE);
+}
+
+
+static void APIENTRY GLNull_DeleteNames(GLsizei n, const GLuint *names)
+{
+}
+
+
+/*
+ * State, buffers, textures and draw calls: no-ops
+ */
+static GLenum APIENTRY GLNull_GetError(void)
+{
+    return GL_NO_ERROR;
+}
+
+
+static void APIENTRY GLNull_Void(void)
+{
+}
+
+
+static void APIENTRY GLNull_Enum(GLenum cap)
+{
+}
+
+
+static void APIENTRY GLNull_EnumEnum(GLenum e0, GLenum e1)
+{
+}
+
+
+static void APIENTRY GLNull_EnumEnumEnum(GLenum e0, GLenum e1, GLenum e2)
+{
+}
+
+
+static void APIENTRY GLNull_EnumUint(GLenum target, GLuint id)
+{
+}
+
+
+static void APIENTRY GLNull_EnumFloat(GLenum func, GLfloat ref)
+{
+}
+
+
+static void APIENTRY GLNull_EnumInt(GLenum pname, GLint param)
+{
+}
+
+
+static void APIENTRY GLNull_EnumEnumInt(GLenum target, GLenum pname, GLint param)
+{
+}
+
+
+static void APIENTRY GLNull_EnumEnumFloat(GLenum target, GLenum pname, GLfloat param)
+{
+}
+
+
+static void APIENTRY GLNull_EnumIntUint(GLenum func, GLint ref, GLuint mask)
+{
+}
+
+
+static void APIENTRY GLNull_Uint(GLuint index)
+{
+}
+
+
+static void APIENTRY GLNull_UintUint(GLuint index, GLuint divisor)
+{
+}
+
+
+static void APIENTRY GLNull_Boolean(GLboolean flag)
+{
+}
+
+
+static void APIENTRY GLNull_Float(GLfloat width)
+{
+}
+
+
+static void APIENTRY GLNull_FloatFloat(GLfloat x, GLfloat y)
+{
+}
+
+
+static void APIENTRY GLNull_ClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+}
+
+
+static void APIENTRY GLNull_Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+}
+
+
+static void APIENTRY GLNull_BufferData(GLenum target, GLsizeiptrARB size, const void *data, GLenum usage)
+{
+}
+
+
+static void APIENTRY GLNull_BufferSubData(GLenum target, GLintptrARB offset, GLsizeiptrARB size, const void *data)
+{
+}
+
+
+static GLboolean APIENTRY GLNull_UnmapBuffer(GLenum target)
+{
+    return GL_TRUE;
+}
+
+
+static void APIENTRY GLNull_Pointer(GLint size, GLenum type, GLsizei stride, const void *pointer)
+{
+}
+
+
+static void APIENTRY GLNull_NormalPointer(GLenum type, GLsizei stride, const void *pointer)
+{
+}
+
+
+static void APIENTRY GLNull_VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+{
+}
+
+
+static void APIENTRY GLNull_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+}
+
+
+static void APIENTRY GLNull_DrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+}
+
+
+static void APIENTRY GLNull_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount)
+{
+}
+
+
+static void APIENTRY GLNull_TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)
+{
+}
+
+
+static void APIENTRY GLNull_CompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei image_size, const void *data)
+{
+}
+
+
+static void APIENTRY GLNull_ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels)
+{
+    if((type == GL_UNSIGNED_BYTE) && ((format == GL_RGBA) || (format == GL_BGRA)))
+    {
+        memset(pixels, 0, width * height * 4);
+    }
+}
+
+
+typedef struct gl_null_proc_s
+{
+    const char *name;
+    void       *proc;
+} gl_null_proc_t, *gl_null_proc_p;
+
+/*
+ * Every entry point the engine calls, with a stub of the exact signature.
+ * Anything else stays NULL, same as a missing entry point of a real driver.
+ */
+static const gl_null_proc_t gl_null_procs[] =
+{
+    {"glGetString",                     (void*)GLNull_GetString},
+    {"glGetIntegerv",                   (void*)GLNull_GetIntegerv},
+    {"glGetFloatv",                     (void*)GLNull_GetFloatv},
+    {"glGetError",                      (void*)GLNull_GetError},
+
+    {"glEnable",                        (void*)GLNull_Enum},
+    {"glDisable",                       (void*)GLNull_Enum},
+    {"glEnableClientState",             (void*)GLNull_Enum},
+    {"glDisableClientState",            (void*)GLNull_Enum},
+    {"glClear",                         (void*)GLNull_Enum},
+    {"glDepthFunc",                     (void*)GLNull_Enum},
+    {"glFrontFace",                     (void*)GLNull_Enum},
+    {"glCullFace",                      (void*)GLNull_Enum},
+    {"glPushAttrib",                    (void*)GLNull_Enum},
+    {"glPushClientAttrib",              (void*)GLNull_Enum},
+    {"glPopAttrib",                     (void*)GLNull_Void},
+    {"glPopClientAttrib",               (void*)GLNull_Void},
+    {"glActiveTextureARB",              (void*)GLNull_Enum},
+    {"glClientActiveTextureARB",        (void*)GLNull_Enum},
+    {"glGenerateMipmap",                (void*)GLNull_Enum},
+    {"glBlendFunc",                     (void*)GLNull_EnumEnum},
+    {"glPolygonMode",                   (void*)GLNull_EnumEnum},
+    {"glStencilOp",                     (void*)GLNull_EnumEnumEnum},
+    {"glStencilFunc",                   (void*)GLNull_EnumIntUint},
+    {"glAlphaFunc",                     (void*)GLNull_EnumFloat},
+    {"glPixelStorei",                   (void*)GLNull_EnumInt},
+    {"glTexParameteri",                 (void*)GLNull_EnumEnumInt},
+    {"glTexParameterf",                 (void*)GLNull_EnumEnumFloat},
+    {"glDepthMask",                     (void*)GLNull_Boolean},
+    {"glLineWidth",                     (void*)GLNull_Float},
+    {"glPointSize",                     (void*)GLNull_Float},
+    {"glPixelZoom",                     (void*)GLNull_FloatFloat},
+    {"glClearColor",                    (void*)GLNull_ClearColor},
+    {"glViewport",                      (void*)GLNull_Viewport},
+    {"glReadPixels",                    (void*)GLNull_ReadPixels},
+
+    {"glGenTextures",                   (void*)GLNull_GenTextures},
+    {"glDeleteTextures",                (void*)GLNull_DeleteNames},
+    {"glIsTexture",                     (void*)GLNull_IsTexture},
+    {"glBindTexture",                   (void*)GLNull_EnumUint},
+    {"glTexImage2D",                    (void*)GLNull_TexImage2D},
+    {"glCompressedTexImage2DARB",       (void*)GLNull_CompressedTexImage2D},
+
+    {"glGenBuffersARB",                 (void*)GLNull_GenBuffers},
+    {"glDeleteBuffersARB",              (void*)GLNull_DeleteNames},
+    {"glIsBufferARB",                   (void*)GLNull_IsBuffer},
+    {"glBindBufferARB",                 (void*)GLNull_EnumUint},
+    {"glBufferDataARB",                 (void*)GLNull_BufferData},
+    {"glBufferSubDataARB",              (void*)GLNull_BufferSubData},
+    {"glUnmapBufferARB",                (void*)GLNull_UnmapBuffer},
+    {"glGenVertexArrays",               (void*)GLNull_GenVertexArrays},
+    {"glDeleteVertexArrays",            (void*)GLNull_DeleteNames},
+    {"glIsVertexArray",                 (void*)GLNull_IsVertexArray},
+    {"glBindVertexArray",               (void*)GLNull_Uint},
+
+    {"glVertexPointer",                 (void*)GLNull_Pointer},
+    {"glColorPointer",                  (void*)GLNull_Pointer},
+    {"glTexCoordPointer",               (void*)GLNull_Pointer},
+    {"glNormalPointer",                 (void*)GLNull_NormalPointer},
+    {"glVertexAttribPointerARB",        (void*)GLNull_VertexAttribPointer},
+    {"glEnableVertexAttribArrayARB",    (void*)GLNull_Uint},
+    {"glDisableVertexAttribArrayARB",   (void*)GLNull_Uint},
+    {"glVertexAttribDivisorARB",        (void*)GLNull_UintUint},
+    {"glDrawArrays",                    (void*)GLNull_DrawArrays},
+    {"glDrawElements",                  (void*)GLNull_DrawElements},
+    {"glDrawElementsInstancedARB",      (void*)GLNull_DrawElementsInstanced},
+
+    {"glCreateProgramObjectARB",        (void*)GLNull_CreateObject},
+    {"glCreateShaderObjectARB",         (void*)GLNull_CreateObject},
+    {"glDeleteObjectARB",               (void*)GLNull_Object},
+    {"glShaderSourceARB",               (void*)GLNull_ShaderSource},
+    {"glCompileShaderARB",              (void*)GLNull_Object},
+    {"glAttachObjectARB",               (void*)GLNull_AttachObject},
+    {"glLinkProgramARB",                (void*)GLNull_Object},
+    {"glUseProgramObjectARB",           (void*)GLNull_Object},
+    {"glGetObjectParameterivARB",       (void*)GLNull_GetObjectParameteriv},
+    {"glGetShaderiv",                   (void*)GLNull_GetShaderOrProgramiv},
+    {"glGetProgramiv",                  (void*)GLNull_GetShaderOrProgramiv},
+    {"glGetInfoLogARB",                 (void*)GLNull_GetInfoLog},
+    {"glGetUniformLocationARB",         (void*)GLNull_GetLocation},
+    {"glGetAttribLocationARB",          (void*)GLNull_GetLocation},
+    {"glUniform1fARB",                  (void*)GLNull_Uniform1f},
+    {"glUniform1iARB",                  (void*)GLNull_Uniform1i},
+    {"glUniform4fARB",                  (void*)GLNull_Uniform4f},
+    {"glUniform1fvARB",                 (void*)GLNull_Uniformfv},
+    {"glUniform2fvARB",                 (void*)GLNull_Uniformfv},
+    {"glUniform3fvARB",                 (void*)GLNull_Uniformfv},
+    {"glUniform4fvARB",                 (void*)GLNull_Uniformfv},
+    {"glUniformMatrix4fvARB",           (void*)GLNull_UniformMatrixfv},
+
+    {NULL,                              NULL}
+};
+
+
+void *GLNull_GetProcAddress(const char *proc)
+{
+    for(const gl_null_proc_t *p = gl_null_procs; p->name; ++p)
+    {
+        if(0 == strcmp(proc, p->name))
+        {
+            return p->proc;
+        }
+    }
+
+    return NULL;
+}
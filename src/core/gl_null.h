@@ -0,0 +1,19 @@
+
+#ifndef GL_NULL_H
+#define GL_NULL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Null GL driver loader, replaces SDL_GL_GetProcAddress when there is no
+ * GL context at all (headless mode).
+ */
+void *GLNull_GetProcAddress(const char *proc);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
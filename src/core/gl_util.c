@@ -11,6 +11,7 @@
 #include <stdio.h>
 
 #include "gl_util.h"
+#include "gl_null.h"
 #include "system.h"
 
 #define GL_LOG_FILENAME "gl_log.txt"
@@ -271,8 +272,23 @@ PFNGLISVERTEXARRAYPROC                  qglIsVertexArray = NULL;
 
 PFNGLGENERATEMIPMAPEXTPROC              qglGenerateMipmap = NULL;
 
+/*buffer mapping and sync ARB (optional)*/
+PFNGLMAPBUFFERRANGEPROC                 qglMapBufferRange = NULL;
+PFNGLBUFFERSTORAGEPROC                  qglBufferStorage = NULL;
+PFNGLFENCESYNCPROC                      qglFenceSync = NULL;
+PFNGLCLIENTWAITSYNCPROC                 qglClientWaitSync = NULL;
+PFNGLDELETESYNCPROC                     qglDeleteSync = NULL;
+
+/*instancing ARB (optional)*/
+PFNGLDRAWELEMENTSINSTANCEDARBPROC       qglDrawElementsInstancedARB = NULL;
+PFNGLVERTEXATTRIBDIVISORARBPROC         qglVertexAttribDivisorARB = NULL;
+
+/*S3TC compressed textures (optional)*/
+PFNGLCOMPRESSEDTEXIMAGE2DARBPROC        qglCompressedTexImage2DARB = NULL;
+
 static char *engine_gl_ext_str = NULL;
 static GLuint whiteTexture = 0;
+static void *(*gl_get_proc_address)(const char *proc) = NULL;
 
 static void FillGLExtensionsStringBuffer()
 {
@@ -288,7 +304,7 @@ static void FillGLExtensionsStringBuffer()
 /**
  * Get addresses of GL functions and initialise engine_gl_ext_str string.
  */
-void InitGLExtFuncs()
+static void InitGLFuncs()
 {
     // white texture data for coloured polygons and debug lines.
     const GLubyte whtx[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -297,158 +313,158 @@ void InitGLExtFuncs()
                             0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
     /* Miscellaneous */
-    qglClearIndex = (PFNGLCLEARINDEXPROC)SDL_GL_GetProcAddress("glClearIndex");
-    qglClearColor = (PFNGLCLEARCOLORPROC)SDL_GL_GetProcAddress("glClearColor");
-    qglClear = (PFNGLCLEARPROC)SDL_GL_GetProcAddress("glClear");
-    qglIndexMask = (PFNGLINDEXMASKPROC)SDL_GL_GetProcAddress("glIndexMask");
-    qglColorMask = (PFNGLCOLORMASKPROC)SDL_GL_GetProcAddress("glColorMask");
-    qglAlphaFunc = (PFNGLALPHAFUNCPROC)SDL_GL_GetProcAddress("glAlphaFunc");
-    qglBlendFunc = (PFNGLBLENDFUNCPROC)SDL_GL_GetProcAddress("glBlendFunc");
-    qglLogicOp = (PFNGLLOGICOPPROC)SDL_GL_GetProcAddress("glLogicOp");
-    qglCullFace = (PFNGLCULLFACEPROC)SDL_GL_GetProcAddress("glCullFace");
-    qglFrontFace = (PFNGLFRONTFACEPROC)SDL_GL_GetProcAddress("glFrontFace");
-    qglPushAttrib = (PFNGLPUSHATTRIBPROC)SDL_GL_GetProcAddress("glPushAttrib");
-    qglPointSize = (PFNGLPOINTSIZEPROC)SDL_GL_GetProcAddress("glPointSize");
-    qglLineWidth = (PFNGLLINEWIDTHPROC)SDL_GL_GetProcAddress("glLineWidth");
-    qglLineStipple = (PFNGLLINESTIPPLEPROC)SDL_GL_GetProcAddress("glLineStipple");
-    qglPolygonMode = (PFNGLPOLYGONMODEPROC)SDL_GL_GetProcAddress("glPolygonMode");
-    qglPolygonOffset = (PFNGLPOLYGONOFFSETPROC)SDL_GL_GetProcAddress("glPolygonOffset");
-    qglPolygonStipple = (PFNGLPOLYGONSTIPPLEPROC)SDL_GL_GetProcAddress("glPolygonStipple");
-    qglGetPolygonStipple = (PFNGLGETPOLYGONSTIPPLEPROC)SDL_GL_GetProcAddress("glGetPolygonStipple");
-    qglEdgeFlag = (PFNGLEDGEFLAGPROC)SDL_GL_GetProcAddress("glEdgeFlag");
-    qglEdgeFlagv = (PFNGLEDGEFLAGVPROC)SDL_GL_GetProcAddress("glEdgeFlagv");
-    qglScissor = (PFNGLSCISSORPROC)SDL_GL_GetProcAddress("glScissor");
-    qglClipPlane = (PFNGLCLIPPLANEPROC)SDL_GL_GetProcAddress("glClipPlane");
-    qglGetClipPlane = (PFNGLGETCLIPPLANEPROC)SDL_GL_GetProcAddress("glGetClipPlane");
-    qglDrawBuffer = (PFNGLDRAWBUFFERPROC)SDL_GL_GetProcAddress("glDrawBuffer");
-    qglReadBuffer = (PFNGLREADBUFFERPROC)SDL_GL_GetProcAddress("glReadBuffer");
-    qglEnable = (PFNGLENABLEPROC)SDL_GL_GetProcAddress("glEnable");
-    qglDisable = (PFNGLDISABLEPROC)SDL_GL_GetProcAddress("glDisable");
-    qglIsEnabled = (PFNGLISENABLEDPROC)SDL_GL_GetProcAddress("glIsEnabled");
-    qglEnableClientState = (PFNGLENABLECLIENTSTATEPROC)SDL_GL_GetProcAddress("glEnableClientState");
-    qglDisableClientState = (PFNGLDISABLECLIENTSTATEPROC)SDL_GL_GetProcAddress("glDisableClientState");
-    qglGetError = (PFNGLGETERRORPROC)SDL_GL_GetProcAddress("glGetError");
-    qglGetString = (PFNGLGETSTRINGPROC)SDL_GL_GetProcAddress("glGetString");
-    qglGetBooleanv = (PFNGLGETBOOLEANVPROC)SDL_GL_GetProcAddress("glGetBooleanv");
-    qglGetDoublev = (PFNGLGETDOUBLEVPROC)SDL_GL_GetProcAddress("glGetDoublev");
-    qglGetFloatv = (PFNGLGETFLOATVPROC)SDL_GL_GetProcAddress("glGetFloatv");
-    qglGetIntegerv = (PFNGLGETIINTEGERVPROC)SDL_GL_GetProcAddress("glGetIntegerv");
-    qglPushAttrib = (PFNGLPUSHATTRIBPROC)SDL_GL_GetProcAddress("glPushAttrib");
-    qglPopAttrib = (PFNGLPOPATTRIBPROC)SDL_GL_GetProcAddress("glPopAttrib");
-    qglPushClientAttrib = (PFNGLPUSHCLIENTATTRIBPROC)SDL_GL_GetProcAddress("glPushClientAttrib");  /* 1.1 */
-    qglPopClientAttrib = (PFNGLPOPCLIENTATTRIBPROC)SDL_GL_GetProcAddress("glPopClientAttrib");  /* 1.1 */
-    qglRenderMode = (PFNGLRENDERMODEPROC)SDL_GL_GetProcAddress("glRenderMode");
-    qglFinish = (PFNGLFINISHPROC)SDL_GL_GetProcAddress("glFinish");
-    qglFlush = (PFNGLFLUSHPROC)SDL_GL_GetProcAddress("glFlush");
-    qglHint = (PFNGLHINTPROC)SDL_GL_GetProcAddress("glHint");
+    qglClearIndex = (PFNGLCLEARINDEXPROC)gl_get_proc_address("glClearIndex");
+    qglClearColor = (PFNGLCLEARCOLORPROC)gl_get_proc_address("glClearColor");
+    qglClear = (PFNGLCLEARPROC)gl_get_proc_address("glClear");
+    qglIndexMask = (PFNGLINDEXMASKPROC)gl_get_proc_address("glIndexMask");
+    qglColorMask = (PFNGLCOLORMASKPROC)gl_get_proc_address("glColorMask");
+    qglAlphaFunc = (PFNGLALPHAFUNCPROC)gl_get_proc_address("glAlphaFunc");
+    qglBlendFunc = (PFNGLBLENDFUNCPROC)gl_get_proc_address("glBlendFunc");
+    qglLogicOp = (PFNGLLOGICOPPROC)gl_get_proc_address("glLogicOp");
+    qglCullFace = (PFNGLCULLFACEPROC)gl_get_proc_address("glCullFace");
+    qglFrontFace = (PFNGLFRONTFACEPROC)gl_get_proc_address("glFrontFace");
+    qglPushAttrib = (PFNGLPUSHATTRIBPROC)gl_get_proc_address("glPushAttrib");
+    qglPointSize = (PFNGLPOINTSIZEPROC)gl_get_proc_address("glPointSize");
+    qglLineWidth = (PFNGLLINEWIDTHPROC)gl_get_proc_address("glLineWidth");
+    qglLineStipple = (PFNGLLINESTIPPLEPROC)gl_get_proc_address("glLineStipple");
+    qglPolygonMode = (PFNGLPOLYGONMODEPROC)gl_get_proc_address("glPolygonMode");
+    qglPolygonOffset = (PFNGLPOLYGONOFFSETPROC)gl_get_proc_address("glPolygonOffset");
+    qglPolygonStipple = (PFNGLPOLYGONSTIPPLEPROC)gl_get_proc_address("glPolygonStipple");
+    qglGetPolygonStipple = (PFNGLGETPOLYGONSTIPPLEPROC)gl_get_proc_address("glGetPolygonStipple");
+    qglEdgeFlag = (PFNGLEDGEFLAGPROC)gl_get_proc_address("glEdgeFlag");
+    qglEdgeFlagv = (PFNGLEDGEFLAGVPROC)gl_get_proc_address("glEdgeFlagv");
+    qglScissor = (PFNGLSCISSORPROC)gl_get_proc_address("glScissor");
+    qglClipPlane = (PFNGLCLIPPLANEPROC)gl_get_proc_address("glClipPlane");
+    qglGetClipPlane = (PFNGLGETCLIPPLANEPROC)gl_get_proc_address("glGetClipPlane");
+    qglDrawBuffer = (PFNGLDRAWBUFFERPROC)gl_get_proc_address("glDrawBuffer");
+    qglReadBuffer = (PFNGLREADBUFFERPROC)gl_get_proc_address("glReadBuffer");
+    qglEnable = (PFNGLENABLEPROC)gl_get_proc_address("glEnable");
+    qglDisable = (PFNGLDISABLEPROC)gl_get_proc_address("glDisable");
+    qglIsEnabled = (PFNGLISENABLEDPROC)gl_get_proc_address("glIsEnabled");
+    qglEnableClientState = (PFNGLENABLECLIENTSTATEPROC)gl_get_proc_address("glEnableClientState");
+    qglDisableClientState = (PFNGLDISABLECLIENTSTATEPROC)gl_get_proc_address("glDisableClientState");
+    qglGetError = (PFNGLGETERRORPROC)gl_get_proc_address("glGetError");
+    qglGetString = (PFNGLGETSTRINGPROC)gl_get_proc_address("glGetString");
+    qglGetBooleanv = (PFNGLGETBOOLEANVPROC)gl_get_proc_address("glGetBooleanv");
+    qglGetDoublev = (PFNGLGETDOUBLEVPROC)gl_get_proc_address("glGetDoublev");
+    qglGetFloatv = (PFNGLGETFLOATVPROC)gl_get_proc_address("glGetFloatv");
+    qglGetIntegerv = (PFNGLGETIINTEGERVPROC)gl_get_proc_address("glGetIntegerv");
+    qglPushAttrib = (PFNGLPUSHATTRIBPROC)gl_get_proc_address("glPushAttrib");
+    qglPopAttrib = (PFNGLPOPATTRIBPROC)gl_get_proc_address("glPopAttrib");
+    qglPushClientAttrib = (PFNGLPUSHCLIENTATTRIBPROC)gl_get_proc_address("glPushClientAttrib");  /* 1.1 */
+    qglPopClientAttrib = (PFNGLPOPCLIENTATTRIBPROC)gl_get_proc_address("glPopClientAttrib");  /* 1.1 */
+    qglRenderMode = (PFNGLRENDERMODEPROC)gl_get_proc_address("glRenderMode");
+    qglFinish = (PFNGLFINISHPROC)gl_get_proc_address("glFinish");
+    qglFlush = (PFNGLFLUSHPROC)gl_get_proc_address("glFlush");
+    qglHint = (PFNGLHINTPROC)gl_get_proc_address("glHint");
 
     /* Depth Buffer */
-    qglClearDepth = (PFNGLCLEARDEPTHPROC)SDL_GL_GetProcAddress("glClearDepth");
-    qglDepthFunc = (PFNGLDEPTHFUNCPROC)SDL_GL_GetProcAddress("glDepthFunc");
-    qglDepthMask = (PFNGLDEPTHMASKPROC)SDL_GL_GetProcAddress("glDepthMask");
-    qglDepthRange = (PFNGLDEPTHRANGEPROC)SDL_GL_GetProcAddress("glDepthRange");
+    qglClearDepth = (PFNGLCLEARDEPTHPROC)gl_get_proc_address("glClearDepth");
+    qglDepthFunc = (PFNGLDEPTHFUNCPROC)gl_get_proc_address("glDepthFunc");
+    qglDepthMask = (PFNGLDEPTHMASKPROC)gl_get_proc_address("glDepthMask");
+    qglDepthRange = (PFNGLDEPTHRANGEPROC)gl_get_proc_address("glDepthRange");
 
     /* Accumulation Buffer */
-    qglClearAccum = (PFNGLCLEARACCUMPROC)SDL_GL_GetProcAddress("glClearAccum");
-    qglAccum = (PFNGLACCUMPROC)SDL_GL_GetProcAddress("glAccum");
+    qglClearAccum = (PFNGLCLEARACCUMPROC)gl_get_proc_address("glClearAccum");
+    qglAccum = (PFNGLACCUMPROC)gl_get_proc_address("glAccum");
 
     /* Transformation */
-    qglMatrixMode = (PFNGLMATRIXMODEPROC)SDL_GL_GetProcAddress("glMatrixMode");
-    qglOrtho = (PFNGLORTHOPROC)SDL_GL_GetProcAddress("glOrtho");
-    qglFrustum = (PFNGLFRUSTUMPROC)SDL_GL_GetProcAddress("glFrustum");
-    qglViewport = (PFNGLVIEWPORTPROC)SDL_GL_GetProcAddress("glViewport");
-    qglPushMatrix = (PFNGLPUSHMATRIXPROC)SDL_GL_GetProcAddress("glPushMatrix");
-    qglPopMatrix = (PFNGLPOPMATRIXPROC)SDL_GL_GetProcAddress("glPopMatrix");
-    qglLoadIdentity = (PFNGLLOADIDENTITYPROC)SDL_GL_GetProcAddress("glLoadIdentity");
-    qglLoadMatrixd = (PFNGLLOADMATRIXDPROC)SDL_GL_GetProcAddress("glLoadMatrixd");
-    qglLoadMatrixf = (PFNGLLOADMATRIXFPROC)SDL_GL_GetProcAddress("glLoadMatrixf");
-    qglMultMatrixd = (PFNGLMULTMATRIXDPROC)SDL_GL_GetProcAddress("glMultMatrixd");
-    qglMultMatrixf = (PFNGLMULTMATRIXFPROC)SDL_GL_GetProcAddress("glMultMatrixf");
-    qglRotated = (PFNGLROTATEDPROC)SDL_GL_GetProcAddress("glRotated");
-    qglRotatef = (PFNGLROTATEFPROC)SDL_GL_GetProcAddress("glRotatef");
-    qglScaled = (PFNGLSCALEDPROC)SDL_GL_GetProcAddress("glScaled");
-    qglScalef = (PFNGLSCALEFPROC)SDL_GL_GetProcAddress("glScalef");
-    qglTranslated = (PFNGLTRANSLATEDPROC)SDL_GL_GetProcAddress("glTranslated");
-    qglTranslatef = (PFNGLTRANSLATEFPROC)SDL_GL_GetProcAddress("glTranslatef");
+    qglMatrixMode = (PFNGLMATRIXMODEPROC)gl_get_proc_address("glMatrixMode");
+    qglOrtho = (PFNGLORTHOPROC)gl_get_proc_address("glOrtho");
+    qglFrustum = (PFNGLFRUSTUMPROC)gl_get_proc_address("glFrustum");
+    qglViewport = (PFNGLVIEWPORTPROC)gl_get_proc_address("glViewport");
+    qglPushMatrix = (PFNGLPUSHMATRIXPROC)gl_get_proc_address("glPushMatrix");
+    qglPopMatrix = (PFNGLPOPMATRIXPROC)gl_get_proc_address("glPopMatrix");
+    qglLoadIdentity = (PFNGLLOADIDENTITYPROC)gl_get_proc_address("glLoadIdentity");
+    qglLoadMatrixd = (PFNGLLOADMATRIXDPROC)gl_get_proc_address("glLoadMatrixd");
+    qglLoadMatrixf = (PFNGLLOADMATRIXFPROC)gl_get_proc_address("glLoadMatrixf");
+    qglMultMatrixd = (PFNGLMULTMATRIXDPROC)gl_get_proc_address("glMultMatrixd");
+    qglMultMatrixf = (PFNGLMULTMATRIXFPROC)gl_get_proc_address("glMultMatrixf");
+    qglRotated = (PFNGLROTATEDPROC)gl_get_proc_address("glRotated");
+    qglRotatef = (PFNGLROTATEFPROC)gl_get_proc_address("glRotatef");
+    qglScaled = (PFNGLSCALEDPROC)gl_get_proc_address("glScaled");
+    qglScalef = (PFNGLSCALEFPROC)gl_get_proc_address("glScalef");
+    qglTranslated = (PFNGLTRANSLATEDPROC)gl_get_proc_address("glTranslated");
+    qglTranslatef = (PFNGLTRANSLATEFPROC)gl_get_proc_address("glTranslatef");
 
     /* Raster functions */
-    qglPixelZoom = (PFNGLPIXELZOOMPROC)SDL_GL_GetProcAddress("glPixelZoom");
-    qglPixelStoref = (PFNGLPIXELSTOREFPROC)SDL_GL_GetProcAddress("glPixelStoref");
-    qglPixelStorei = (PFNGLPIXELSTOREIPROC)SDL_GL_GetProcAddress("glPixelStorei");
-    qglPixelTransferf = (PFNGLPIXELTRANSFERFPROC)SDL_GL_GetProcAddress("glPixelTransferf");
-    qglPixelTransferi = (PFNGLPIXELTRANSFERIPROC)SDL_GL_GetProcAddress("glPixelTransferi");
-    qglPixelMapfv = (PFNGLPIXELMAPFVPROC)SDL_GL_GetProcAddress("glPixelMapfv");
-    qglPixelMapuiv = (PFNGLPIXELMAPUIVPROC)SDL_GL_GetProcAddress("glPixelMapuiv");
-    qglPixelMapusv = (PFNGLPIXELMAPUSVPROC)SDL_GL_GetProcAddress("glPixelMapusv");
-    qglGetPixelMapfv = (PFNGLGETPIXELMAPFVPROC)SDL_GL_GetProcAddress("glGetPixelMapfv");
-    qglGetPixelMapuiv = (PFNGLGETPIXELMAPUIVPROC)SDL_GL_GetProcAddress("glGetPixelMapuiv");
-    qglGetPixelMapusv = (PFNGLGETPIXELMAPUSVPROC)SDL_GL_GetProcAddress("glGetPixelMapusv");
-    qglBitmap = (PFNGLBITMAPPROC)SDL_GL_GetProcAddress("glBitmap");
-    qglReadPixels = (PFNGLREADPIXELSPROC)SDL_GL_GetProcAddress("glReadPixels");
-    qglDrawPixels = (PFNGLDRAWPIXELSPROC)SDL_GL_GetProcAddress("glDrawPixels");
-    qglCopyPixels = (PFNGLCOPYPIXELSPROC)SDL_GL_GetProcAddress("glCopyPixels");
+    qglPixelZoom = (PFNGLPIXELZOOMPROC)gl_get_proc_address("glPixelZoom");
+    qglPixelStoref = (PFNGLPIXELSTOREFPROC)gl_get_proc_address("glPixelStoref");
+    qglPixelStorei = (PFNGLPIXELSTOREIPROC)gl_get_proc_address("glPixelStorei");
+    qglPixelTransferf = (PFNGLPIXELTRANSFERFPROC)gl_get_proc_address("glPixelTransferf");
+    qglPixelTransferi = (PFNGLPIXELTRANSFERIPROC)gl_get_proc_address("glPixelTransferi");
+    qglPixelMapfv = (PFNGLPIXELMAPFVPROC)gl_get_proc_address("glPixelMapfv");
+    qglPixelMapuiv = (PFNGLPIXELMAPUIVPROC)gl_get_proc_address("glPixelMapuiv");
+    qglPixelMapusv = (PFNGLPIXELMAPUSVPROC)gl_get_proc_address("glPixelMapusv");
+    qglGetPixelMapfv = (PFNGLGETPIXELMAPFVPROC)gl_get_proc_address("glGetPixelMapfv");
+    qglGetPixelMapuiv = (PFNGLGETPIXELMAPUIVPROC)gl_get_proc_address("glGetPixelMapuiv");
+    qglGetPixelMapusv = (PFNGLGETPIXELMAPUSVPROC)gl_get_proc_address("glGetPixelMapusv");
+    qglBitmap = (PFNGLBITMAPPROC)gl_get_proc_address("glBitmap");
+    qglReadPixels = (PFNGLREADPIXELSPROC)gl_get_proc_address("glReadPixels");
+    qglDrawPixels = (PFNGLDRAWPIXELSPROC)gl_get_proc_address("glDrawPixels");
+    qglCopyPixels = (PFNGLCOPYPIXELSPROC)gl_get_proc_address("glCopyPixels");
 
     /* Stenciling */
-    qglStencilFunc = (PFNGLSTENCILFUNCPROC)SDL_GL_GetProcAddress("glStencilFunc");
-    qglStencilMask = (PFNGLSTENCILMASKPROC)SDL_GL_GetProcAddress("glStencilMask");
-    qglStencilOp = (PFNGLSTENCILOPPROC)SDL_GL_GetProcAddress("glStencilOp");
-    qglClearStencil = (PFNGLCLEARSTENCILPROC)SDL_GL_GetProcAddress("glClearStencil");
+    qglStencilFunc = (PFNGLSTENCILFUNCPROC)gl_get_proc_address("glStencilFunc");
+    qglStencilMask = (PFNGLSTENCILMASKPROC)gl_get_proc_address("glStencilMask");
+    qglStencilOp = (PFNGLSTENCILOPPROC)gl_get_proc_address("glStencilOp");
+    qglClearStencil = (PFNGLCLEARSTENCILPROC)gl_get_proc_address("glClearStencil");
 
     /* Texture mapping */
-    qglTexGend = (PFNGLTEXGENDPROC)SDL_GL_GetProcAddress("glTexGend");
-    qglTexGenf = (PFNGLTEXGENFPROC)SDL_GL_GetProcAddress("glTexGenf");
-    qglTexGeni = (PFNGLTEXGENIPROC)SDL_GL_GetProcAddress("glTexGeni");
-    qglTexGendv = (PFNGLTEXGENDVPROC)SDL_GL_GetProcAddress("glTexGendv");
-    qglTexGenfv = (PFNGLTEXGENFVPROC)SDL_GL_GetProcAddress("glTexGenfv");
-    qglTexGeniv = (PFNGLTEXGENIVPROC)SDL_GL_GetProcAddress("glTexGeniv");
-    qglGetTexGendv = (PFNGLGETTEXGENDVPROC)SDL_GL_GetProcAddress("glGetTexGendv");
-    qglGetTexGenfv = (PFNGLGETTEXGENFVPROC)SDL_GL_GetProcAddress("glGetTexGenfv");
-    qglGetTexGeniv = (PFNGLGETTEXGENIVPROC)SDL_GL_GetProcAddress("glGetTexGeniv");
-    qglTexEnvf = (PFNGLTEXENVFPROC)SDL_GL_GetProcAddress("glTexEnvf");
-    qglTexEnvi = (PFNGLTEXENVIPROC)SDL_GL_GetProcAddress("glTexEnvi");
-    qglTexEnvfv = (PFNGLTEXENVFVPROC)SDL_GL_GetProcAddress("glTexEnvfv");
-    qglTexEnviv = (PFNGLTEXENVIVPROC)SDL_GL_GetProcAddress("glTexEnviv");
-    qglGetTexEnvfv = (PFNGLGETTEXENVFVPROC)SDL_GL_GetProcAddress("glGetTexEnvfv");
-    qglGetTexEnviv = (PFNGLGETTEXENVIVPROC)SDL_GL_GetProcAddress("glGetTexEnviv");
-    qglTexParameterf = (PFNGLTEXPARAMETERFPROC)SDL_GL_GetProcAddress("glTexParameterf");
-    qglTexParameteri = (PFNGLTEXPARAMETERIPROC)SDL_GL_GetProcAddress("glTexParameteri");
-    qglTexParameterfv = (PFNGLTEXPARAMETERFVPROC)SDL_GL_GetProcAddress("glTexParameterfv");
-    qglTexParameteriv = (PFNGLTEXPARAMETERIVPROC)SDL_GL_GetProcAddress("glTexParameteriv");
-    qglGetTexParameterfv = (PFNGLGETTEXPARAMETERFVPROC)SDL_GL_GetProcAddress("glGetTexParameterfv");
-    qglGetTexParameteriv = (PFNGLGETTEXPARAMETERIVPROC)SDL_GL_GetProcAddress("glGetTexParameteriv");
-    qglGetTexLevelParameterfv = (PFNGLGETTEXLEVELPARAMETERFVPROC)SDL_GL_GetProcAddress("glGetTexLevelParameterfv");
-    qglGetTexLevelParameteriv = (PFNGLGETTEXLEVELPARAMETERIVPROC)SDL_GL_GetProcAddress("glGetTexLevelParameteriv");
-    qglTexImage1D = (PFNGLTEXIMAGE1DPROC)SDL_GL_GetProcAddress("glTexImage1D");
-    qglTexImage2D = (PFNGLTEXIMAGE2DPROC)SDL_GL_GetProcAddress("glTexImage2D");
-    qglGetTexImage = (PFNGLGETTEXIMAGEPROC)SDL_GL_GetProcAddress("glGetTexImage");
+    qglTexGend = (PFNGLTEXGENDPROC)gl_get_proc_address("glTexGend");
+    qglTexGenf = (PFNGLTEXGENFPROC)gl_get_proc_address("glTexGenf");
+    qglTexGeni = (PFNGLTEXGENIPROC)gl_get_proc_address("glTexGeni");
+    qglTexGendv = (PFNGLTEXGENDVPROC)gl_get_proc_address("glTexGendv");
+    qglTexGenfv = (PFNGLTEXGENFVPROC)gl_get_proc_address("glTexGenfv");
+    qglTexGeniv = (PFNGLTEXGENIVPROC)gl_get_proc_address("glTexGeniv");
+    qglGetTexGendv = (PFNGLGETTEXGENDVPROC)gl_get_proc_address("glGetTexGendv");
+    qglGetTexGenfv = (PFNGLGETTEXGENFVPROC)gl_get_proc_address("glGetTexGenfv");
+    qglGetTexGeniv = (PFNGLGETTEXGENIVPROC)gl_get_proc_address("glGetTexGeniv");
+    qglTexEnvf = (PFNGLTEXENVFPROC)gl_get_proc_address("glTexEnvf");
+    qglTexEnvi = (PFNGLTEXENVIPROC)gl_get_proc_address("glTexEnvi");
+    qglTexEnvfv = (PFNGLTEXENVFVPROC)gl_get_proc_address("glTexEnvfv");
+    qglTexEnviv = (PFNGLTEXENVIVPROC)gl_get_proc_address("glTexEnviv");
+    qglGetTexEnvfv = (PFNGLGETTEXENVFVPROC)gl_get_proc_address("glGetTexEnvfv");
+    qglGetTexEnviv = (PFNGLGETTEXENVIVPROC)gl_get_proc_address("glGetTexEnviv");
+    qglTexParameterf = (PFNGLTEXPARAMETERFPROC)gl_get_proc_address("glTexParameterf");
+    qglTexParameteri = (PFNGLTEXPARAMETERIPROC)gl_get_proc_address("glTexParameteri");
+    qglTexParameterfv = (PFNGLTEXPARAMETERFVPROC)gl_get_proc_address("glTexParameterfv");
+    qglTexParameteriv = (PFNGLTEXPARAMETERIVPROC)gl_get_proc_address("glTexParameteriv");
+    qglGetTexParameterfv = (PFNGLGETTEXPARAMETERFVPROC)gl_get_proc_address("glGetTexParameterfv");
+    qglGetTexParameteriv = (PFNGLGETTEXPARAMETERIVPROC)gl_get_proc_address("glGetTexParameteriv");
+    qglGetTexLevelParameterfv = (PFNGLGETTEXLEVELPARAMETERFVPROC)gl_get_proc_address("glGetTexLevelParameterfv");
+    qglGetTexLevelParameteriv = (PFNGLGETTEXLEVELPARAMETERIVPROC)gl_get_proc_address("glGetTexLevelParameteriv");
+    qglTexImage1D = (PFNGLTEXIMAGE1DPROC)gl_get_proc_address("glTexImage1D");
+    qglTexImage2D = (PFNGLTEXIMAGE2DPROC)gl_get_proc_address("glTexImage2D");
+    qglGetTexImage = (PFNGLGETTEXIMAGEPROC)gl_get_proc_address("glGetTexImage");
 
     /* 1.1 functions */
     /* texture objects */
-    qglGenTextures = (PFNGLGENTEXTURESPROC)SDL_GL_GetProcAddress("glGenTextures");
-    qglDeleteTextures = (PFNGLDELETETEXTURESPROC)SDL_GL_GetProcAddress("glDeleteTextures");
-    qglBindTexture = (PFNGLBINDTEXTUREPROC)SDL_GL_GetProcAddress("glBindTexture");
-    qglPrioritizeTextures = (PFNGLPRIORITIZETEXTURESPROC)SDL_GL_GetProcAddress("glPrioritizeTextures");
-    qglAreTexturesResident = (PFNGLARETEXTURESRESIDENTPROC)SDL_GL_GetProcAddress("glAreTexturesResident");
-    qglIsTexture = (PFNGLISTEXTUREPROC)SDL_GL_GetProcAddress("glIsTexture");
+    qglGenTextures = (PFNGLGENTEXTURESPROC)gl_get_proc_address("glGenTextures");
+    qglDeleteTextures = (PFNGLDELETETEXTURESPROC)gl_get_proc_address("glDeleteTextures");
+    qglBindTexture = (PFNGLBINDTEXTUREPROC)gl_get_proc_address("glBindTexture");
+    qglPrioritizeTextures = (PFNGLPRIORITIZETEXTURESPROC)gl_get_proc_address("glPrioritizeTextures");
+    qglAreTexturesResident = (PFNGLARETEXTURESRESIDENTPROC)gl_get_proc_address("glAreTexturesResident");
+    qglIsTexture = (PFNGLISTEXTUREPROC)gl_get_proc_address("glIsTexture");
     /* texture mapping */
-    qglTexSubImage1D = (PFNGLTEXSUBIMAGE1DPROC)SDL_GL_GetProcAddress("glTexSubImage1D");
-    qglTexSubImage2D = (PFNGLTEXSUBIMAGE2DPROC)SDL_GL_GetProcAddress("glTexSubImage2D");
-    qglCopyTexImage1D = (PFNGLCOPYTEXIMAGE1DPROC)SDL_GL_GetProcAddress("glCopyTexImage1D");
-    qglCopyTexImage2D = (PFNGLCOPYTEXIMAGE2DPROC)SDL_GL_GetProcAddress("glCopyTexImage2D");
-    qglCopyTexSubImage1D = (PFNGLCOPYTEXSUBIMAGE1DPROC)SDL_GL_GetProcAddress("glCopyTexSubImage1D");
-    qglCopyTexSubImage2D = (PFNGLCOPYTEXSUBIMAGE2DPROC)SDL_GL_GetProcAddress("glCopyTexSubImage2D");
+    qglTexSubImage1D = (PFNGLTEXSUBIMAGE1DPROC)gl_get_proc_address("glTexSubImage1D");
+    qglTexSubImage2D = (PFNGLTEXSUBIMAGE2DPROC)gl_get_proc_address("glTexSubImage2D");
+    qglCopyTexImage1D = (PFNGLCOPYTEXIMAGE1DPROC)gl_get_proc_address("glCopyTexImage1D");
+    qglCopyTexImage2D = (PFNGLCOPYTEXIMAGE2DPROC)gl_get_proc_address("glCopyTexImage2D");
+    qglCopyTexSubImage1D = (PFNGLCOPYTEXSUBIMAGE1DPROC)gl_get_proc_address("glCopyTexSubImage1D");
+    qglCopyTexSubImage2D = (PFNGLCOPYTEXSUBIMAGE2DPROC)gl_get_proc_address("glCopyTexSubImage2D");
     /* vertex arrays */
-    qglVertexPointer = (PFNGLVERTEXPOINTERPROC)SDL_GL_GetProcAddress("glVertexPointer");
-    qglNormalPointer = (PFNGLNORMALPOINTERPROC)SDL_GL_GetProcAddress("glNormalPointer");
-    qglColorPointer = (PFNGLCOLORPOINTERPROC)SDL_GL_GetProcAddress("glColorPointer");
-    qglIndexPointer = (PFNGLINDEXPOINTERPROC)SDL_GL_GetProcAddress("glIndexPointer");
-    qglTexCoordPointer = (PFNGLTEXCOORDPOINTERPROC)SDL_GL_GetProcAddress("glTexCoordPointer");
-    qglEdgeFlagPointer = (PFNGLEDGEFLAGPOINTERPROC)SDL_GL_GetProcAddress("glEdgeFlagPointer");
-    qglGetPointerv = (PFNGLGETPOINTERVPROC)SDL_GL_GetProcAddress("glGetPointerv");
-    qglArrayElement = (PFNGLARRAYELEMENTPROC)SDL_GL_GetProcAddress("glArrayElement");
-    qglDrawArrays = (PFNGLDRAWARRAYSPROC)SDL_GL_GetProcAddress("glDrawArrays");
-    qglDrawElements = (PFNGLDRAWELEMENTSPROC)SDL_GL_GetProcAddress("glDrawElements");
-    qglInterleavedArrays = (PFNGLINTERLEAVEDARRAYSPROC)SDL_GL_GetProcAddress("glInterleavedArrays");
+    qglVertexPointer = (PFNGLVERTEXPOINTERPROC)gl_get_proc_address("glVertexPointer");
+    qglNormalPointer = (PFNGLNORMALPOINTERPROC)gl_get_proc_address("glNormalPointer");
+    qglColorPointer = (PFNGLCOLORPOINTERPROC)gl_get_proc_address("glColorPointer");
+    qglIndexPointer = (PFNGLINDEXPOINTERPROC)gl_get_proc_address("glIndexPointer");
+    qglTexCoordPointer = (PFNGLTEXCOORDPOINTERPROC)gl_get_proc_address("glTexCoordPointer");
+    qglEdgeFlagPointer = (PFNGLEDGEFLAGPOINTERPROC)gl_get_proc_address("glEdgeFlagPointer");
+    qglGetPointerv = (PFNGLGETPOINTERVPROC)gl_get_proc_address("glGetPointerv");
+    qglArrayElement = (PFNGLARRAYELEMENTPROC)gl_get_proc_address("glArrayElement");
+    qglDrawArrays = (PFNGLDRAWARRAYSPROC)gl_get_proc_address("glDrawArrays");
+    qglDrawElements = (PFNGLDRAWELEMENTSPROC)gl_get_proc_address("glDrawElements");
+    qglInterleavedArrays = (PFNGLINTERLEAVEDARRAYSPROC)gl_get_proc_address("glInterleavedArrays");
 
     FillGLExtensionsStringBuffer();
 
@@ -463,63 +479,63 @@ void InitGLExtFuncs()
     /// VBO funcs
     if(IsGLExtensionSupported("GL_ARB_vertex_buffer_object"))
     {
-        qglBindBufferARB = (PFNGLBINDBUFFERARBPROC)SDL_GL_GetProcAddress("glBindBufferARB");
-        qglDeleteBuffersARB = (PFNGLDELETEBUFFERSARBPROC)SDL_GL_GetProcAddress("glDeleteBuffersARB");
-        qglGenBuffersARB = (PFNGLGENBUFFERSARBPROC)SDL_GL_GetProcAddress("glGenBuffersARB");
-        qglIsBufferARB = (PFNGLISBUFFERARBPROC)SDL_GL_GetProcAddress("glIsBufferARB");
-        qglBufferDataARB = (PFNGLBUFFERDATAARBPROC)SDL_GL_GetProcAddress("glBufferDataARB");
-        qglBufferSubDataARB = (PFNGLBUFFERSUBDATAARBPROC)SDL_GL_GetProcAddress("glBufferSubDataARB");
-        qglGetBufferSubDataARB = (PFNGLGETBUFFERSUBDATAARBPROC)SDL_GL_GetProcAddress("glGetBufferSubDataARB");
-        qglMapBufferARB = (PFNGLMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glMapBufferARB");
-        qglUnmapBufferARB = (PFNGLUNMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glUnmapBufferARB");
-        qglGetBufferParameterivARB = (PFNGLGETBUFFERPARAMETERIVARBPROC)SDL_GL_GetProcAddress("glGetBufferParameterivARB");
-        qglGetBufferPointervARB = (PFNGLGETBUFFERPOINTERVARBPROC)SDL_GL_GetProcAddress("glGetBufferPointervARB");
-
-        qglActiveTextureARB = (PFNGLACTIVETEXTUREARBPROC)SDL_GL_GetProcAddress("glActiveTextureARB");
-        qglClientActiveTextureARB = (PFNGLCLIENTACTIVETEXTUREARBPROC)SDL_GL_GetProcAddress("glClientActiveTextureARB");
-
-        qglMultiTexCoord1dARB = (PFNGLMULTITEXCOORD1DARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1dARB");
-        qglMultiTexCoord1dvARB = (PFNGLMULTITEXCOORD1DVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1dvARB");
-        qglMultiTexCoord1fARB = (PFNGLMULTITEXCOORD1FARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1fARB");
-        qglMultiTexCoord1fvARB = (PFNGLMULTITEXCOORD1FVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1fvARB");
-        qglMultiTexCoord1iARB = (PFNGLMULTITEXCOORD1IARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1iARB");
-        qglMultiTexCoord1ivARB = (PFNGLMULTITEXCOORD1IVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1ivARB");
-        qglMultiTexCoord1sARB = (PFNGLMULTITEXCOORD1SARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1sARB");
-        qglMultiTexCoord1svARB = (PFNGLMULTITEXCOORD1SVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord1svARB");
-
-        qglMultiTexCoord2dARB = (PFNGLMULTITEXCOORD2DARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2dARB");
-        qglMultiTexCoord2dvARB = (PFNGLMULTITEXCOORD2DVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2dvARB");
-        qglMultiTexCoord2fARB = (PFNGLMULTITEXCOORD2FARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2fARB");
-        qglMultiTexCoord2fvARB = (PFNGLMULTITEXCOORD2FVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2fvARB");
-        qglMultiTexCoord2iARB = (PFNGLMULTITEXCOORD2IARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2iARB");
-        qglMultiTexCoord2ivARB = (PFNGLMULTITEXCOORD2IVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2ivARB");
-        qglMultiTexCoord2sARB = (PFNGLMULTITEXCOORD2SARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2sARB");
-        qglMultiTexCoord2svARB = (PFNGLMULTITEXCOORD2SVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord2svARB");
-
-        qglMultiTexCoord3dARB = (PFNGLMULTITEXCOORD3DARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3dARB");
-        qglMultiTexCoord3dvARB = (PFNGLMULTITEXCOORD3DVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3dvARB");
-        qglMultiTexCoord3fARB = (PFNGLMULTITEXCOORD3FARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3fARB");
-        qglMultiTexCoord3fvARB = (PFNGLMULTITEXCOORD3FVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3fvARB");
-        qglMultiTexCoord3iARB = (PFNGLMULTITEXCOORD3IARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3iARB");
-        qglMultiTexCoord3ivARB = (PFNGLMULTITEXCOORD3IVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3ivARB");
-        qglMultiTexCoord3sARB = (PFNGLMULTITEXCOORD3SARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3sARB");
-        qglMultiTexCoord3svARB = (PFNGLMULTITEXCOORD3SVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord3svARB");
-
-        qglMultiTexCoord4dARB = (PFNGLMULTITEXCOORD4DARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4dARB");
-        qglMultiTexCoord4dvARB = (PFNGLMULTITEXCOORD4DVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4dvARB");
-        qglMultiTexCoord4fARB = (PFNGLMULTITEXCOORD4FARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4fARB");
-        qglMultiTexCoord4fvARB = (PFNGLMULTITEXCOORD4FVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4fvARB");
-        qglMultiTexCoord4iARB = (PFNGLMULTITEXCOORD4IARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4iARB");
-        qglMultiTexCoord4ivARB = (PFNGLMULTITEXCOORD4IVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4ivARB");
-        qglMultiTexCoord4sARB = (PFNGLMULTITEXCOORD4SARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4sARB");
-        qglMultiTexCoord4svARB = (PFNGLMULTITEXCOORD4SVARBPROC)SDL_GL_GetProcAddress("glMultiTexCoord4svARB");
-
-        qglBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)SDL_GL_GetProcAddress("glBindVertexArray");
-        qglDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)SDL_GL_GetProcAddress("glDeleteVertexArrays");
-        qglGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)SDL_GL_GetProcAddress("glGenVertexArrays");
-        qglIsVertexArray = (PFNGLISVERTEXARRAYPROC)SDL_GL_GetProcAddress("glIsVertexArray");
-
-        qglGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)SDL_GL_GetProcAddress("glGenerateMipmap");
+        qglBindBufferARB = (PFNGLBINDBUFFERARBPROC)gl_get_proc_address("glBindBufferARB");
+        qglDeleteBuffersARB = (PFNGLDELETEBUFFERSARBPROC)gl_get_proc_address("glDeleteBuffersARB");
+        qglGenBuffersARB = (PFNGLGENBUFFERSARBPROC)gl_get_proc_address("glGenBuffersARB");
+        qglIsBufferARB = (PFNGLISBUFFERARBPROC)gl_get_proc_address("glIsBufferARB");
+        qglBufferDataARB = (PFNGLBUFFERDATAARBPROC)gl_get_proc_address("glBufferDataARB");
+        qglBufferSubDataARB = (PFNGLBUFFERSUBDATAARBPROC)gl_get_proc_address("glBufferSubDataARB");
+        qglGetBufferSubDataARB = (PFNGLGETBUFFERSUBDATAARBPROC)gl_get_proc_address("glGetBufferSubDataARB");
+        qglMapBufferARB = (PFNGLMAPBUFFERARBPROC)gl_get_proc_address("glMapBufferARB");
+        qglUnmapBufferARB = (PFNGLUNMAPBUFFERARBPROC)gl_get_proc_address("glUnmapBufferARB");
+        qglGetBufferParameterivARB = (PFNGLGETBUFFERPARAMETERIVARBPROC)gl_get_proc_address("glGetBufferParameterivARB");
+        qglGetBufferPointervARB = (PFNGLGETBUFFERPOINTERVARBPROC)gl_get_proc_address("glGetBufferPointervARB");
+
+        qglActiveTextureARB = (PFNGLACTIVETEXTUREARBPROC)gl_get_proc_address("glActiveTextureARB");
+        qglClientActiveTextureARB = (PFNGLCLIENTACTIVETEXTUREARBPROC)gl_get_proc_address("glClientActiveTextureARB");
+
+        qglMultiTexCoord1dARB = (PFNGLMULTITEXCOORD1DARBPROC)gl_get_proc_address("glMultiTexCoord1dARB");
+        qglMultiTexCoord1dvARB = (PFNGLMULTITEXCOORD1DVARBPROC)gl_get_proc_address("glMultiTexCoord1dvARB");
+        qglMultiTexCoord1fARB = (PFNGLMULTITEXCOORD1FARBPROC)gl_get_proc_address("glMultiTexCoord1fARB");
+        qglMultiTexCoord1fvARB = (PFNGLMULTITEXCOORD1FVARBPROC)gl_get_proc_address("glMultiTexCoord1fvARB");
+        qglMultiTexCoord1iARB = (PFNGLMULTITEXCOORD1IARBPROC)gl_get_proc_address("glMultiTexCoord1iARB");
+        qglMultiTexCoord1ivARB = (PFNGLMULTITEXCOORD1IVARBPROC)gl_get_proc_address("glMultiTexCoord1ivARB");
+        qglMultiTexCoord1sARB = (PFNGLMULTITEXCOORD1SARBPROC)gl_get_proc_address("glMultiTexCoord1sARB");
+        qglMultiTexCoord1svARB = (PFNGLMULTITEXCOORD1SVARBPROC)gl_get_proc_address("glMultiTexCoord1svARB");
+
+        qglMultiTexCoord2dARB = (PFNGLMULTITEXCOORD2DARBPROC)gl_get_proc_address("glMultiTexCoord2dARB");
+        qglMultiTexCoord2dvARB = (PFNGLMULTITEXCOORD2DVARBPROC)gl_get_proc_address("glMultiTexCoord2dvARB");
+        qglMultiTexCoord2fARB = (PFNGLMULTITEXCOORD2FARBPROC)gl_get_proc_address("glMultiTexCoord2fARB");
+        qglMultiTexCoord2fvARB = (PFNGLMULTITEXCOORD2FVARBPROC)gl_get_proc_address("glMultiTexCoord2fvARB");
+        qglMultiTexCoord2iARB = (PFNGLMULTITEXCOORD2IARBPROC)gl_get_proc_address("glMultiTexCoord2iARB");
+        qglMultiTexCoord2ivARB = (PFNGLMULTITEXCOORD2IVARBPROC)gl_get_proc_address("glMultiTexCoord2ivARB");
+        qglMultiTexCoord2sARB = (PFNGLMULTITEXCOORD2SARBPROC)gl_get_proc_address("glMultiTexCoord2sARB");
+        qglMultiTexCoord2svARB = (PFNGLMULTITEXCOORD2SVARBPROC)gl_get_proc_address("glMultiTexCoord2svARB");
+
+        qglMultiTexCoord3dARB = (PFNGLMULTITEXCOORD3DARBPROC)gl_get_proc_address("glMultiTexCoord3dARB");
+        qglMultiTexCoord3dvARB = (PFNGLMULTITEXCOORD3DVARBPROC)gl_get_proc_address("glMultiTexCoord3dvARB");
+        qglMultiTexCoord3fARB = (PFNGLMULTITEXCOORD3FARBPROC)gl_get_proc_address("glMultiTexCoord3fARB");
+        qglMultiTexCoord3fvARB = (PFNGLMULTITEXCOORD3FVARBPROC)gl_get_proc_address("glMultiTexCoord3fvARB");
+        qglMultiTexCoord3iARB = (PFNGLMULTITEXCOORD3IARBPROC)gl_get_proc_address("glMultiTexCoord3iARB");
+        qglMultiTexCoord3ivARB = (PFNGLMULTITEXCOORD3IVARBPROC)gl_get_proc_address("glMultiTexCoord3ivARB");
+        qglMultiTexCoord3sARB = (PFNGLMULTITEXCOORD3SARBPROC)gl_get_proc_address("glMultiTexCoord3sARB");
+        qglMultiTexCoord3svARB = (PFNGLMULTITEXCOORD3SVARBPROC)gl_get_proc_address("glMultiTexCoord3svARB");
+
+        qglMultiTexCoord4dARB = (PFNGLMULTITEXCOORD4DARBPROC)gl_get_proc_address("glMultiTexCoord4dARB");
+        qglMultiTexCoord4dvARB = (PFNGLMULTITEXCOORD4DVARBPROC)gl_get_proc_address("glMultiTexCoord4dvARB");
+        qglMultiTexCoord4fARB = (PFNGLMULTITEXCOORD4FARBPROC)gl_get_proc_address("glMultiTexCoord4fARB");
+        qglMultiTexCoord4fvARB = (PFNGLMULTITEXCOORD4FVARBPROC)gl_get_proc_address("glMultiTexCoord4fvARB");
+        qglMultiTexCoord4iARB = (PFNGLMULTITEXCOORD4IARBPROC)gl_get_proc_address("glMultiTexCoord4iARB");
+        qglMultiTexCoord4ivARB = (PFNGLMULTITEXCOORD4IVARBPROC)gl_get_proc_address("glMultiTexCoord4ivARB");
+        qglMultiTexCoord4sARB = (PFNGLMULTITEXCOORD4SARBPROC)gl_get_proc_address("glMultiTexCoord4sARB");
+        qglMultiTexCoord4svARB = (PFNGLMULTITEXCOORD4SVARBPROC)gl_get_proc_address("glMultiTexCoord4svARB");
+
+        qglBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)gl_get_proc_address("glBindVertexArray");
+        qglDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)gl_get_proc_address("glDeleteVertexArrays");
+        qglGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)gl_get_proc_address("glGenVertexArrays");
+        qglIsVertexArray = (PFNGLISVERTEXARRAYPROC)gl_get_proc_address("glIsVertexArray");
+
+        qglGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)gl_get_proc_address("glGenerateMipmap");
     }
     else
     {
@@ -528,58 +544,99 @@ void InitGLExtFuncs()
     }
     if(IsGLExtensionSupported("GL_ARB_shading_language_100"))
     {
-        qglDeleteObjectARB = (PFNGLDELETEOBJECTARBPROC)SDL_GL_GetProcAddress("glDeleteObjectARB");
-        qglGetHandleARB = (PFNGLGETHANDLEARBPROC)SDL_GL_GetProcAddress("glGetHandleARB");
-        qglDetachObjectARB = (PFNGLDETACHOBJECTARBPROC)SDL_GL_GetProcAddress("glDetachObjectARB");
-        qglCreateShaderObjectARB = (PFNGLCREATESHADEROBJECTARBPROC)SDL_GL_GetProcAddress("glCreateShaderObjectARB");
-        qglShaderSourceARB = (PFNGLSHADERSOURCEARBPROC)SDL_GL_GetProcAddress("glShaderSourceARB");
-        qglCompileShaderARB = (PFNGLCOMPILESHADERARBPROC)SDL_GL_GetProcAddress("glCompileShaderARB");
-        qglCreateProgramObjectARB = (PFNGLCREATEPROGRAMOBJECTARBPROC)SDL_GL_GetProcAddress("glCreateProgramObjectARB");
-        qglAttachObjectARB = (PFNGLATTACHOBJECTARBPROC)SDL_GL_GetProcAddress("glAttachObjectARB");
-        qglLinkProgramARB = (PFNGLLINKPROGRAMARBPROC)SDL_GL_GetProcAddress("glLinkProgramARB");
-        qglUseProgramObjectARB = (PFNGLUSEPROGRAMOBJECTARBPROC)SDL_GL_GetProcAddress("glUseProgramObjectARB");
-        qglValidateProgramARB = (PFNGLVALIDATEPROGRAMARBPROC)SDL_GL_GetProcAddress("glValidateProgramARB");
-        qglUniform1fARB = (PFNGLUNIFORM1FARBPROC)SDL_GL_GetProcAddress("glUniform1fARB");
-        qglUniform2fARB = (PFNGLUNIFORM2FARBPROC)SDL_GL_GetProcAddress("glUniform2fARB");
-        qglUniform3fARB = (PFNGLUNIFORM3FARBPROC)SDL_GL_GetProcAddress("glUniform3fARB");
-        qglUniform4fARB = (PFNGLUNIFORM4FARBPROC)SDL_GL_GetProcAddress("glUniform4fARB");
-        qglUniform1iARB = (PFNGLUNIFORM1IARBPROC)SDL_GL_GetProcAddress("glUniform1iARB");
-        qglUniform2iARB = (PFNGLUNIFORM2IARBPROC)SDL_GL_GetProcAddress("glUniform2iARB");
-        qglUniform3iARB = (PFNGLUNIFORM3IARBPROC)SDL_GL_GetProcAddress("glUniform3iARB");
-        qglUniform4iARB = (PFNGLUNIFORM4IARBPROC)SDL_GL_GetProcAddress("glUniform4iARB");
-        qglUniform1fvARB = (PFNGLUNIFORM1FVARBPROC)SDL_GL_GetProcAddress("glUniform1fvARB");
-        qglUniform2fvARB = (PFNGLUNIFORM2FVARBPROC)SDL_GL_GetProcAddress("glUniform2fvARB");
-        qglUniform3fvARB = (PFNGLUNIFORM3FVARBPROC)SDL_GL_GetProcAddress("glUniform3fvARB");
-        qglUniform4fvARB = (PFNGLUNIFORM4FVARBPROC)SDL_GL_GetProcAddress("glUniform4fvARB");
-        qglUniform1ivARB = (PFNGLUNIFORM1IVARBPROC)SDL_GL_GetProcAddress("glUniform1ivARB");
-        qglUniform2ivARB = (PFNGLUNIFORM2IVARBPROC)SDL_GL_GetProcAddress("glUniform2ivARB");
-        qglUniform3ivARB = (PFNGLUNIFORM3IVARBPROC)SDL_GL_GetProcAddress("glUniform3ivARB");
-        qglUniform4ivARB = (PFNGLUNIFORM4IVARBPROC)SDL_GL_GetProcAddress("glUniform4ivARB");
-        qglUniformMatrix2fvARB = (PFNGLUNIFORMMATRIX2FVARBPROC)SDL_GL_GetProcAddress("glUniformMatrix2fvARB");
-        qglUniformMatrix3fvARB = (PFNGLUNIFORMMATRIX3FVARBPROC)SDL_GL_GetProcAddress("glUniformMatrix3fvARB");
-        qglUniformMatrix4fvARB = (PFNGLUNIFORMMATRIX4FVARBPROC)SDL_GL_GetProcAddress("glUniformMatrix4fvARB");
-        qglGetObjectParameterfvARB = (PFNGLGETOBJECTPARAMETERFVARBPROC)SDL_GL_GetProcAddress("glGetObjectParameterfvARB");
-        qglGetObjectParameterivARB = (PFNGLGETOBJECTPARAMETERIVARBPROC)SDL_GL_GetProcAddress("glGetObjectParameterivARB");
-        qglGetInfoLogARB = (PFNGLGETINFOLOGARBPROC)SDL_GL_GetProcAddress("glGetInfoLogARB");
-        qglGetAttachedObjectsARB = (PFNGLGETATTACHEDOBJECTSARBPROC)SDL_GL_GetProcAddress("glGetAttachedObjectsARB");
-        qglGetUniformLocationARB = (PFNGLGETUNIFORMLOCATIONARBPROC)SDL_GL_GetProcAddress("glGetUniformLocationARB");
-        qglGetActiveUniformARB = (PFNGLGETACTIVEUNIFORMARBPROC)SDL_GL_GetProcAddress("glGetActiveUniformARB");
-        qglGetUniformfvARB = (PFNGLGETUNIFORMFVARBPROC)SDL_GL_GetProcAddress("glGetUniformfvARB");
-        qglGetUniformivARB = (PFNGLGETUNIFORMIVARBPROC)SDL_GL_GetProcAddress("glGetUniformivARB");
-        qglGetShaderSourceARB = (PFNGLGETSHADERSOURCEARBPROC)SDL_GL_GetProcAddress("glGetShaderSourceARB");
-
-        qglBindAttribLocationARB = (PFNGLBINDATTRIBLOCATIONARBPROC)SDL_GL_GetProcAddress("glBindAttribLocationARB");
-        qglGetActiveAttribARB = (PFNGLGETACTIVEATTRIBARBPROC)SDL_GL_GetProcAddress("glGetActiveAttribARB");
-        qglGetAttribLocationARB = (PFNGLGETATTRIBLOCATIONARBPROC)SDL_GL_GetProcAddress("glGetAttribLocationARB");
-        qglEnableVertexAttribArrayARB = (PFNGLENABLEVERTEXATTRIBARRAYARBPROC)SDL_GL_GetProcAddress("glEnableVertexAttribArrayARB");
-        qglDisableVertexAttribArrayARB = (PFNGLDISABLEVERTEXATTRIBARRAYARBPROC)SDL_GL_GetProcAddress("glDisableVertexAttribArrayARB");
-
-        qglVertexAttribPointerARB = (PFNGLVERTEXATTRIBPOINTERARBPROC)SDL_GL_GetProcAddress("glVertexAttribPointerARB");
+        qglDeleteObjectARB = (PFNGLDELETEOBJECTARBPROC)gl_get_proc_address("glDeleteObjectARB");
+        qglGetHandleARB = (PFNGLGETHANDLEARBPROC)gl_get_proc_address("glGetHandleARB");
+        qglDetachObjectARB = (PFNGLDETACHOBJECTARBPROC)gl_get_proc_address("glDetachObjectARB");
+        qglCreateShaderObjectARB = (PFNGLCREATESHADEROBJECTARBPROC)gl_get_proc_address("glCreateShaderObjectARB");
+        qglShaderSourceARB = (PFNGLSHADERSOURCEARBPROC)gl_get_proc_address("glShaderSourceARB");
+        qglCompileShaderARB = (PFNGLCOMPILESHADERARBPROC)gl_get_proc_address("glCompileShaderARB");
+        qglCreateProgramObjectARB = (PFNGLCREATEPROGRAMOBJECTARBPROC)gl_get_proc_address("glCreateProgramObjectARB");
+        qglAttachObjectARB = (PFNGLATTACHOBJECTARBPROC)gl_get_proc_address("glAttachObjectARB");
+        qglLinkProgramARB = (PFNGLLINKPROGRAMARBPROC)gl_get_proc_address("glLinkProgramARB");
+        qglUseProgramObjectARB = (PFNGLUSEPROGRAMOBJECTARBPROC)gl_get_proc_address("glUseProgramObjectARB");
+        qglValidateProgramARB = (PFNGLVALIDATEPROGRAMARBPROC)gl_get_proc_address("glValidateProgramARB");
+        qglUniform1fARB = (PFNGLUNIFORM1FARBPROC)gl_get_proc_address("glUniform1fARB");
+        qglUniform2fARB = (PFNGLUNIFORM2FARBPROC)gl_get_proc_address("glUniform2fARB");
+        qglUniform3fARB = (PFNGLUNIFORM3FARBPROC)gl_get_proc_address("glUniform3fARB");
+        qglUniform4fARB = (PFNGLUNIFORM4FARBPROC)gl_get_proc_address("glUniform4fARB");
+        qglUniform1iARB = (PFNGLUNIFORM1IARBPROC)gl_get_proc_address("glUniform1iARB");
+        qglUniform2iARB = (PFNGLUNIFORM2IARBPROC)gl_get_proc_address("glUniform2iARB");
+        qglUniform3iARB = (PFNGLUNIFORM3IARBPROC)gl_get_proc_address("glUniform3iARB");
+        qglUniform4iARB = (PFNGLUNIFORM4IARBPROC)gl_get_proc_address("glUniform4iARB");
+        qglUniform1fvARB = (PFNGLUNIFORM1FVARBPROC)gl_get_proc_address("glUniform1fvARB");
+        qglUniform2fvARB = (PFNGLUNIFORM2FVARBPROC)gl_get_proc_address("glUniform2fvARB");
+        qglUniform3fvARB = (PFNGLUNIFORM3FVARBPROC)gl_get_proc_address("glUniform3fvARB");
+        qglUniform4fvARB = (PFNGLUNIFORM4FVARBPROC)gl_get_proc_address("glUniform4fvARB");
+        qglUniform1ivARB = (PFNGLUNIFORM1IVARBPROC)gl_get_proc_address("glUniform1ivARB");
+        qglUniform2ivARB = (PFNGLUNIFORM2IVARBPROC)gl_get_proc_address("glUniform2ivARB");
+        qglUniform3ivARB = (PFNGLUNIFORM3IVARBPROC)gl_get_proc_address("glUniform3ivARB");
+        qglUniform4ivARB = (PFNGLUNIFORM4IVARBPROC)gl_get_proc_address("glUniform4ivARB");
+        qglUniformMatrix2fvARB = (PFNGLUNIFORMMATRIX2FVARBPROC)gl_get_proc_address("glUniformMatrix2fvARB");
+        qglUniformMatrix3fvARB = (PFNGLUNIFORMMATRIX3FVARBPROC)gl_get_proc_address("glUniformMatrix3fvARB");
+        qglUniformMatrix4fvARB = (PFNGLUNIFORMMATRIX4FVARBPROC)gl_get_proc_address("glUniformMatrix4fvARB");
+        qglGetObjectParameterfvARB = (PFNGLGETOBJECTPARAMETERFVARBPROC)gl_get_proc_address("glGetObjectParameterfvARB");
+        qglGetObjectParameterivARB = (PFNGLGETOBJECTPARAMETERIVARBPROC)gl_get_proc_address("glGetObjectParameterivARB");
+        qglGetInfoLogARB = (PFNGLGETINFOLOGARBPROC)gl_get_proc_address("glGetInfoLogARB");
+        qglGetAttachedObjectsARB = (PFNGLGETATTACHEDOBJECTSARBPROC)gl_get_proc_address("glGetAttachedObjectsARB");
+        qglGetUniformLocationARB = (PFNGLGETUNIFORMLOCATIONARBPROC)gl_get_proc_address("glGetUniformLocationARB");
+        qglGetActiveUniformARB = (PFNGLGETACTIVEUNIFORMARBPROC)gl_get_proc_address("glGetActiveUniformARB");
+        qglGetUniformfvARB = (PFNGLGETUNIFORMFVARBPROC)gl_get_proc_address("glGetUniformfvARB");
+        qglGetUniformivARB = (PFNGLGETUNIFORMIVARBPROC)gl_get_proc_address("glGetUniformivARB");
+        qglGetShaderSourceARB = (PFNGLGETSHADERSOURCEARBPROC)gl_get_proc_address("glGetShaderSourceARB");
+
+        qglBindAttribLocationARB = (PFNGLBINDATTRIBLOCATIONARBPROC)gl_get_proc_address("glBindAttribLocationARB");
+        qglGetActiveAttribARB = (PFNGLGETACTIVEATTRIBARBPROC)gl_get_proc_address("glGetActiveAttribARB");
+        qglGetAttribLocationARB = (PFNGLGETATTRIBLOCATIONARBPROC)gl_get_proc_address("glGetAttribLocationARB");
+        qglEnableVertexAttribArrayARB = (PFNGLENABLEVERTEXATTRIBARRAYARBPROC)gl_get_proc_address("glEnableVertexAttribArrayARB");
+        qglDisableVertexAttribArrayARB = (PFNGLDISABLEVERTEXATTRIBARRAYARBPROC)gl_get_proc_address("glDisableVertexAttribArrayARB");
+
+        qglVertexAttribPointerARB = (PFNGLVERTEXATTRIBPOINTERARBPROC)gl_get_proc_address("glVertexAttribPointerARB");
     }
     else
     {
         Sys_Error("Shaders not supported");
     }
+
+    // optional: left NULL if not supported, renderer streams with orphaning / sub data
+    if(IsGLExtensionSupported("GL_ARB_map_buffer_range"))
+    {
+        qglMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)gl_get_proc_address("glMapBufferRange");
+    }
+    if(IsGLExtensionSupported("GL_ARB_buffer_storage") && IsGLExtensionSupported("GL_ARB_sync"))
+    {
+        qglBufferStorage = (PFNGLBUFFERSTORAGEPROC)gl_get_proc_address("glBufferStorage");
+        qglFenceSync = (PFNGLFENCESYNCPROC)gl_get_proc_address("glFenceSync");
+        qglClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)gl_get_proc_address("glClientWaitSync");
+        qglDeleteSync = (PFNGLDELETESYNCPROC)gl_get_proc_address("glDeleteSync");
+    }
+
+    // optional: left NULL if not supported, renderer falls back to one draw per instance
+    if(IsGLExtensionSupported("GL_ARB_draw_instanced") && IsGLExtensionSupported("GL_ARB_instanced_arrays"))
+    {
+        qglDrawElementsInstancedARB = (PFNGLDRAWELEMENTSINSTANCEDARBPROC)gl_get_proc_address("glDrawElementsInstancedARB");
+        qglVertexAttribDivisorARB = (PFNGLVERTEXATTRIBDIVISORARBPROC)gl_get_proc_address("glVertexAttribDivisorARB");
+    }
+
+    // optional: left NULL if not supported, atlas pages are uploaded as RGBA
+    if(IsGLExtensionSupported("GL_ARB_texture_compression") && IsGLExtensionSupported("GL_EXT_texture_compression_s3tc"))
+    {
+        qglCompressedTexImage2DARB = (PFNGLCOMPRESSEDTEXIMAGE2DARBPROC)gl_get_proc_address("glCompressedTexImage2DARB");
+    }
+}
+
+void InitGLExtFuncs()
+{
+    gl_get_proc_address = SDL_GL_GetProcAddress;
+    InitGLFuncs();
+}
+
+/**
+ * Same as InitGLExtFuncs(), but binds null driver stubs (no GL context needed).
+ */
+void InitGLNullFuncs()
+{
+    gl_get_proc_address = GLNull_GetProcAddress;
+    InitGLFuncs();
 }
 
 /**
@@ -428,7 +428,22 @@ extern PFNGLISVERTEXARRAYPROC qglIsVertexArray;
 
 extern PFNGLGENERATEMIPMAPPROC qglGenerateMipmap;
 
+/*buffer mapping and sync ARB (optional, NULL if not supported)*/
+extern PFNGLMAPBUFFERRANGEPROC qglMapBufferRange;
+extern PFNGLBUFFERSTORAGEPROC qglBufferStorage;
+extern PFNGLFENCESYNCPROC qglFenceSync;
+extern PFNGLCLIENTWAITSYNCPROC qglClientWaitSync;
+extern PFNGLDELETESYNCPROC qglDeleteSync;
+
+/*instancing ARB (optional, NULL if not supported)*/
+extern PFNGLDRAWELEMENTSINSTANCEDARBPROC qglDrawElementsInstancedARB;
+extern PFNGLVERTEXATTRIBDIVISORARBPROC qglVertexAttribDivisorARB;
+
+/*S3TC compressed textures (optional, NULL if not supported)*/
+extern PFNGLCOMPRESSEDTEXIMAGE2DARBPROC qglCompressedTexImage2DARB;
+
 void InitGLExtFuncs();
+void InitGLNullFuncs();
 int IsGLExtensionSupported(const char *ext);
 
 int checkOpenGLError();
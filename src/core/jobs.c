@@ -0,0 +1,273 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_cpuinfo.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+#include "jobs.h"
+
+
+typedef struct job_s
+{
+    job_func_t          func;
+    void               *data;
+    uint32_t            first;
+    uint32_t            last;
+    SDL_atomic_t       *pending;                // jobs of the same Jobs_ParallelFor call
+}job_t, *job_p;
+
+typedef struct job_queue_s
+{
+    SDL_mutex          *mutex;
+    uint32_t            top;                    // thieves side
+    uint32_t            bottom;                 // owner side
+    job_t               jobs[JOBS_QUEUE_SIZE];
+}job_queue_t, *job_queue_p;
+
+static job_queue_t      jobs_queues[JOBS_MAX_WORKERS];
+static SDL_Thread      *jobs_threads[JOBS_MAX_WORKERS] = {NULL};
+static int              jobs_workers_count = 0;
+static SDL_atomic_t     jobs_queued = {0};
+static SDL_atomic_t     jobs_stop = {0};
+static SDL_mutex       *jobs_sleep_mutex = NULL;
+static SDL_cond        *jobs_sleep_cond = NULL;
+
+
+static int Jobs_Push(job_queue_p q, const job_t *job)
+{
+    int ret = 0;
+
+    SDL_LockMutex(q->mutex);
+    if(q->bottom - q->top < JOBS_QUEUE_SIZE)
+    {
+        q->jobs[q->bottom & (JOBS_QUEUE_SIZE - 1)] = *job;
+        q->bottom++;
+        ret = 1;
+    }
+    SDL_UnlockMutex(q->mutex);
+
+    return ret;
+}
+
+
+static int Jobs_Pop(job_queue_p q, job_p job)
+{
+    int ret = 0;
+
+    SDL_LockMutex(q->mutex);
+    if(q->bottom != q->top)
+    {
+        q->bottom--;
+        *job = q->jobs[q->bottom & (JOBS_QUEUE_SIZE - 1)];
+        ret = 1;
+    }
+    SDL_UnlockMutex(q->mutex);
+
+    return ret;
+}
+
+
+static int Jobs_Steal(job_queue_p q, job_p job)
+{
+    int ret = 0;
+
+    SDL_LockMutex(q->mutex);
+    if(q->bottom != q->top)
+    {
+        *job = q->jobs[q->top & (JOBS_QUEUE_SIZE - 1)];
+        q->top++;
+        ret = 1;
+    }
+    SDL_UnlockMutex(q->mutex);
+
+    return ret;
+}
+
+
+static int Jobs_Find(int index, job_p job)
+{
+    if(Jobs_Pop(jobs_queues + index, job))
+    {
+        SDL_AtomicAdd(&jobs_queued, -1);
+        return 1;
+    }
+
+    for(int i = 1; i < jobs_workers_count; i++)
+    {
+        if(Jobs_Steal(jobs_queues + (index + i) % jobs_workers_count, job))
+        {
+            SDL_AtomicAdd(&jobs_queued, -1);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static void Jobs_Run(job_p job)
+{
+    job->func(job->data, job->first, job->last);
+    SDL_AtomicAdd(job->pending, -1);
+}
+
+
+static int Jobs_Worker(void *data)
+{
+    int index = (int)(intptr_t)data;
+    job_t job;
+
+    while(!SDL_AtomicGet(&jobs_stop))
+    {
+        if(Jobs_Find(index, &job))
+        {
+            Jobs_Run(&job);
+        }
+        else
+        {
+            SDL_LockMutex(jobs_sleep_mutex);
+            while((SDL_AtomicGet(&jobs_queued) <= 0) && !SDL_AtomicGet(&jobs_stop))
+            {
+                SDL_CondWait(jobs_sleep_cond, jobs_sleep_mutex);
+            }
+            SDL_UnlockMutex(jobs_sleep_mutex);
+        }
+    }
+
+    return 0;
+}
+
+
+void Jobs_Init(int workers_count)
+{
+    if(workers_count <= 0)
+    {
+        workers_count = SDL_GetCPUCount();
+    }
+    workers_count = (workers_count < 1) ? (1) : (workers_count);
+    workers_count = (workers_count > JOBS_MAX_WORKERS) ? (JOBS_MAX_WORKERS) : (workers_count);
+
+    SDL_AtomicSet(&jobs_stop, 0);
+    SDL_AtomicSet(&jobs_queued, 0);
+    jobs_sleep_mutex = SDL_CreateMutex();
+    jobs_sleep_cond = SDL_CreateCond();
+    for(int i = 0; i < workers_count; i++)
+    {
+        jobs_queues[i].mutex = SDL_CreateMutex();
+        jobs_queues[i].top = 0;
+        jobs_queues[i].bottom = 0;
+    }
+
+    // Queue 0 belongs to caller thread; queue of a thread which failed to
+    // start is still emptied by thieves.
+    jobs_workers_count = workers_count;
+    for(int i = 1; i < workers_count; i++)
+    {
+        jobs_threads[i] = SDL_CreateThread(Jobs_Worker, "jobs", (void*)(intptr_t)i);
+    }
+}
+
+
+void Jobs_Destroy()
+{
+    SDL_AtomicSet(&jobs_stop, 1);
+    if(jobs_sleep_mutex)
+    {
+        SDL_LockMutex(jobs_sleep_mutex);
+        SDL_CondBroadcast(jobs_sleep_cond);
+        SDL_UnlockMutex(jobs_sleep_mutex);
+    }
+
+    for(int i = 0; i < jobs_workers_count; i++)
+    {
+        if(jobs_threads[i])
+        {
+            SDL_WaitThread(jobs_threads[i], NULL);
+            jobs_threads[i] = NULL;
+        }
+        SDL_DestroyMutex(jobs_queues[i].mutex);
+        jobs_queues[i].mutex = NULL;
+    }
+    jobs_workers_count = 0;
+
+    if(jobs_sleep_cond)
+    {
+        SDL_DestroyCond(jobs_sleep_cond);
+        jobs_sleep_cond = NULL;
+    }
+    if(jobs_sleep_mutex)
+    {
+        SDL_DestroyMutex(jobs_sleep_mutex);
+        jobs_sleep_mutex = NULL;
+    }
+}
+
+
+int Jobs_GetWorkersCount()
+{
+    return jobs_workers_count;
+}
+
+
+/*
+ * Must be called from main thread only: it owns queue 0.
+ */
+void Jobs_ParallelFor(job_func_t func, void *data, uint32_t count, uint32_t batch)
+{
+    SDL_atomic_t pending;
+    job_t job;
+    uint32_t queued = 0;
+    int worker = 0;
+
+    if(count == 0)
+    {
+        return;
+    }
+
+    if(batch == 0)
+    {
+        batch = (jobs_workers_count > 0) ? (count / (4 * jobs_workers_count) + 1) : (count);
+    }
+
+    if((jobs_workers_count <= 1) || (batch >= count))
+    {
+        func(data, 0, count);
+        return;
+    }
+
+    SDL_AtomicSet(&pending, 0);
+    job.func = func;
+    job.data = data;
+    job.pending = &pending;
+    for(uint32_t first = 0; first < count; first += batch)
+    {
+        job.first = first;
+        job.last = (first + batch < count) ? (first + batch) : (count);
+        SDL_AtomicAdd(&pending, 1);
+        if(Jobs_Push(jobs_queues + worker, &job))
+        {
+            queued++;
+        }
+        else
+        {
+            Jobs_Run(&job);                                                     // queue is full: do it right here
+        }
+        worker = (worker + 1) % jobs_workers_count;
+    }
+
+    SDL_AtomicAdd(&jobs_queued, queued);
+    SDL_LockMutex(jobs_sleep_mutex);
+    SDL_CondBroadcast(jobs_sleep_cond);
+    SDL_UnlockMutex(jobs_sleep_mutex);
+
+    while(SDL_AtomicGet(&pending) > 0)
+    {
+        if(Jobs_Find(0, &job))
+        {
+            Jobs_Run(&job);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Fork / join job system: every worker owns a deque of jobs; it pops own
+ * jobs from the bottom and steals from the top of others when empty.
+ * Caller thread of Jobs_ParallelFor works as worker 0 until all of its
+ * jobs are done, so there is no idle wait on the main thread.
+ * Jobs must not touch shared engine state (temp memory, scripts, physics).
+ */
+#define JOBS_MAX_WORKERS            (32)
+#define JOBS_QUEUE_SIZE             (256)           // per worker, power of two
+
+typedef void (*job_func_t)(void *data, uint32_t first, uint32_t last);  // [first, last)
+
+void Jobs_Init(int workers_count);                 // <= 0: by CPU cores count
+void Jobs_Destroy();
+int  Jobs_GetWorkersCount();                       // with caller thread
+
+/*
+ * Runs func over [0, count) split by batch items per job and returns when
+ * all jobs are done; batch 0 means automatic split.
+ */
+void Jobs_ParallelFor(job_func_t func, void *data, uint32_t count, uint32_t batch);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
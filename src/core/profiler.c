@@ -0,0 +1,235 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_timer.h>
+
+#include "profiler.h"
+#include "system.h"
+
+#if defined(_MSC_VER)
+#define PROF_THREAD_LOCAL __declspec(thread)
+#else
+#define PROF_THREAD_LOCAL __thread
+#endif
+
+typedef struct prof_thread_s
+{
+    prof_zone_t             zones[PROF_RING_SIZE];
+    uint32_t                stack[PROF_MAX_DEPTH];
+    volatile uint32_t       head;                   // written by owner thread only
+    uint32_t                depth;
+    uint32_t                id;
+}prof_thread_t, *prof_thread_p;
+
+static prof_thread_p                    prof_threads[PROF_MAX_THREADS] = {NULL};
+static SDL_atomic_t                     prof_threads_count = {0};
+static PROF_THREAD_LOCAL prof_thread_p  prof_thread = NULL;
+static PROF_THREAD_LOCAL int            prof_thread_failed = 0;
+
+static prof_thread_p                    prof_main_thread = NULL;
+static volatile uint32_t                prof_frame = 0;
+static uint64_t                         prof_frame_begin[PROF_FRAMES_COUNT] = {0};
+
+
+static prof_thread_p Prof_GetThread()
+{
+    if(!prof_thread && !prof_thread_failed)
+    {
+        int id = SDL_AtomicAdd(&prof_threads_count, 1);
+        if(id < PROF_MAX_THREADS)
+        {
+            prof_thread = (prof_thread_p)calloc(1, sizeof(prof_thread_t));
+            prof_thread->id = id;
+            prof_threads[id] = prof_thread;
+        }
+        else
+        {
+            SDL_AtomicAdd(&prof_threads_count, -1);
+            prof_thread_failed = 1;
+        }
+    }
+
+    return prof_thread;
+}
+
+
+void Prof_ZoneBegin(const char *name)
+{
+    prof_thread_p th = Prof_GetThread();
+    if(th)
+    {
+        if(th->depth < PROF_MAX_DEPTH)
+        {
+            prof_zone_p zone = th->zones + (th->head & (PROF_RING_SIZE - 1));
+            zone->name = name;
+            zone->end = 0;
+            zone->frame = prof_frame;
+            zone->depth = th->depth;
+            th->stack[th->depth] = th->head;
+            zone->begin = SDL_GetPerformanceCounter();
+            th->head++;
+        }
+        th->depth++;
+    }
+}
+
+
+void Prof_ZoneEnd()
+{
+    prof_thread_p th = prof_thread;
+    if(th && th->depth)
+    {
+        th->depth--;
+        if(th->depth < PROF_MAX_DEPTH)
+        {
+            uint32_t index = th->stack[th->depth];
+            if(th->head - index <= PROF_RING_SIZE)                              // not overwritten yet
+            {
+                th->zones[index & (PROF_RING_SIZE - 1)].end = SDL_GetPerformanceCounter();
+            }
+        }
+    }
+}
+
+
+void Prof_FrameMark()
+{
+    prof_main_thread = Prof_GetThread();
+    prof_frame++;
+    prof_frame_begin[prof_frame % PROF_FRAMES_COUNT] = SDL_GetPerformanceCounter();
+}
+
+
+/*
+ * Aggregates main thread zones of the last finished frame by name and depth,
+ * returns stats in order of the first zone occurrence.
+ */
+uint32_t Prof_GetLastFrameStats(prof_zone_stat_p stats, uint32_t max_stats, float *frame_ms)
+{
+    prof_thread_p th = prof_main_thread;
+    uint32_t frame = prof_frame - 1;
+    uint32_t ret = 0;
+    double to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    if(frame_ms)
+    {
+        uint64_t t0 = prof_frame_begin[frame % PROF_FRAMES_COUNT];
+        uint64_t t1 = prof_frame_begin[prof_frame % PROF_FRAMES_COUNT];
+        *frame_ms = (t1 > t0) ? ((float)((t1 - t0) * to_ms)) : (0.0f);
+    }
+
+    if(th && (prof_frame > 1))
+    {
+        uint32_t head = th->head;
+        uint32_t i = (head > PROF_RING_SIZE) ? (head - PROF_RING_SIZE) : (0);
+        for(; i < head; ++i)
+        {
+            prof_zone_p zone = th->zones + (i & (PROF_RING_SIZE - 1));
+            if((zone->frame == frame) && (zone->end >= zone->begin))
+            {
+                uint32_t j = 0;
+                for(; j < ret; ++j)
+                {
+                    if((stats[j].name == zone->name) && (stats[j].depth == zone->depth))
+                    {
+                        break;
+                    }
+                }
+                if(j == ret)
+                {
+                    if(ret >= max_stats)
+                    {
+                        continue;
+                    }
+                    stats[j].name = zone->name;
+                    stats[j].depth = zone->depth;
+                    stats[j].count = 0;
+                    stats[j].time_ms = 0.0f;
+                    ret++;
+                }
+                stats[j].count++;
+                stats[j].time_ms += (float)((zone->end - zone->begin) * to_ms);
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/*
+ * Writes zones of the last finished frames in chrome://tracing JSON format.
+ * Rings of working threads are read without locks, so zones that are
+ * written at the moment of dump may be lost. Frames count is clamped to the
+ * frames kept in ring; returns the count of written frames, 0 on error.
+ */
+uint32_t Prof_DumpChromeTrace(const char *file_name, uint32_t frames)
+{
+    FILE *f;
+    uint32_t last_frame = prof_frame;
+    uint32_t first_frame;
+    uint64_t base;
+    double to_us = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    int threads_count = SDL_AtomicGet(&prof_threads_count);
+    int first_event = 1;
+
+    if(frames >= PROF_FRAMES_COUNT)
+    {
+        frames = PROF_FRAMES_COUNT - 1;
+    }
+    if(frames > last_frame)
+    {
+        frames = last_frame;
+    }
+    if(frames == 0)
+    {
+        return 0;
+    }
+
+    f = fopen(file_name, "w");
+    if(!f)
+    {
+        Sys_Warn("Can not open \"%s\" for profiler dump", file_name);
+        return 0;
+    }
+
+    first_frame = last_frame - frames;
+    base = prof_frame_begin[first_frame % PROF_FRAMES_COUNT];
+    fprintf(f, "{\"traceEvents\":[\n");
+    for(uint32_t fr = first_frame; fr < last_frame; ++fr)
+    {
+        uint64_t t0 = prof_frame_begin[fr % PROF_FRAMES_COUNT];
+        uint64_t t1 = prof_frame_begin[(fr + 1) % PROF_FRAMES_COUNT];
+        fprintf(f, "%s{\"name\":\"frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                (first_event) ? ("") : (",\n"), fr, (prof_main_thread) ? (prof_main_thread->id) : (0),
+                (double)(t0 - base) * to_us, (double)(t1 - t0) * to_us);
+        first_event = 0;
+    }
+
+    for(int t = 0; (t < threads_count) && (t < PROF_MAX_THREADS); ++t)
+    {
+        prof_thread_p th = prof_threads[t];
+        if(th)
+        {
+            uint32_t head = th->head;
+            uint32_t i = (head > PROF_RING_SIZE) ? (head - PROF_RING_SIZE) : (0);
+            for(; i < head; ++i)
+            {
+                prof_zone_p zone = th->zones + (i & (PROF_RING_SIZE - 1));
+                if((zone->frame >= first_frame) && (zone->frame < last_frame) &&
+                   (zone->end >= zone->begin) && (zone->begin >= base))
+                {
+                    fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                            zone->name, th->id, (double)(zone->begin - base) * to_us, (double)(zone->end - zone->begin) * to_us);
+                }
+            }
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    return frames;
+}
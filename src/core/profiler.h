@@ -0,0 +1,75 @@
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Hot path instrumentation: every thread writes own zones into own ring
+ * buffer (single writer, no locks), main thread marks frames borders.
+ * Zone names must be static strings, they are stored by pointer.
+ */
+#define PROF_RING_SIZE              (1 << 14)       // zones per thread, power of two
+#define PROF_MAX_DEPTH              (32)
+#define PROF_MAX_THREADS            (16)
+#define PROF_FRAMES_COUNT           (256)           // frames borders history
+
+typedef struct prof_zone_s
+{
+    const char     *name;
+    uint64_t        begin;
+    uint64_t        end;
+    uint32_t        frame;
+    uint32_t        depth;
+}prof_zone_t, *prof_zone_p;
+
+typedef struct prof_zone_stat_s
+{
+    const char     *name;
+    uint32_t        depth;
+    uint32_t        count;
+    float           time_ms;
+}prof_zone_stat_t, *prof_zone_stat_p;
+
+void Prof_ZoneBegin(const char *name);
+void Prof_ZoneEnd();
+void Prof_FrameMark();
+
+uint32_t Prof_GetLastFrameStats(prof_zone_stat_p stats, uint32_t max_stats, float *frame_ms);
+uint32_t Prof_DumpChromeTrace(const char *file_name, uint32_t frames);     // returns frames written
+
+#ifdef PROFILER_DISABLE
+#define PROF_ZONE_BEGIN(name)
+#define PROF_ZONE_END()
+#define PROF_FRAME_MARK()
+#else
+#define PROF_ZONE_BEGIN(name)       Prof_ZoneBegin(name)
+#define PROF_ZONE_END()             Prof_ZoneEnd()
+#define PROF_FRAME_MARK()           Prof_FrameMark()
+#endif
+
+#ifdef	__cplusplus
+}
+
+struct prof_scoped_zone_s
+{
+    prof_scoped_zone_s(const char *name)
+    {
+        PROF_ZONE_BEGIN(name);
+    }
+    ~prof_scoped_zone_s()
+    {
+        PROF_ZONE_END();
+    }
+};
+
+#define PROF_CONCAT_IMPL(a, b)      a##b
+#define PROF_CONCAT(a, b)           PROF_CONCAT_IMPL(a, b)
+#define PROF_SCOPED_ZONE(name)      prof_scoped_zone_s PROF_CONCAT(prof_zone_, __LINE__)(name)
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef SIMD_VF4_H
+#define SIMD_VF4_H
+
+#include <math.h>
+#include <stdint.h>
+
+/*
+ * vf4_t: four floats lane vector; vm4_t: per lane mask from comparisons.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+
+#include <emmintrin.h>
+
+#define SIMD_NAME "SSE2"
+
+typedef __m128 vf4_t;
+typedef __m128 vm4_t;
+
+static inline vf4_t vf4_set1(float x)                   { return _mm_set1_ps(x); }
+static inline vf4_t vf4_load(const float *p)            { return _mm_loadu_ps(p); }
+static inline void  vf4_store(float *p, vf4_t v)        { _mm_storeu_ps(p, v); }
+static inline vf4_t vf4_add(vf4_t a, vf4_t b)           { return _mm_add_ps(a, b); }
+static inline vf4_t vf4_sub(vf4_t a, vf4_t b)           { return _mm_sub_ps(a, b); }
+static inline vf4_t vf4_mul(vf4_t a, vf4_t b)           { return _mm_mul_ps(a, b); }
+static inline vf4_t vf4_div(vf4_t a, vf4_t b)           { return _mm_div_ps(a, b); }
+static inline vf4_t vf4_sqrt(vf4_t a)                   { return _mm_sqrt_ps(a); }
+static inline vf4_t vf4_min(vf4_t a, vf4_t b)           { return _mm_min_ps(a, b); }
+static inline vf4_t vf4_max(vf4_t a, vf4_t b)           { return _mm_max_ps(a, b); }
+static inline vm4_t vf4_lt(vf4_t a, vf4_t b)            { return _mm_cmplt_ps(a, b); }
+static inline vm4_t vm4_and(vm4_t a, vm4_t b)           { return _mm_and_ps(a, b); }
+static inline vf4_t vf4_select(vm4_t m, vf4_t a, vf4_t b)
+{
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline int   vm4_any(vm4_t m)                    { return _mm_movemask_ps(m) != 0; }
+
+#define vf4_transpose(r0, r1, r2, r3) _MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define SIMD_NAME "NEON"
+
+typedef float32x4_t vf4_t;
+typedef uint32x4_t  vm4_t;
+
+static inline vf4_t vf4_set1(float x)                   { return vdupq_n_f32(x); }
+static inline vf4_t vf4_load(const float *p)            { return vld1q_f32(p); }
+static inline void  vf4_store(float *p, vf4_t v)        { vst1q_f32(p, v); }
+static inline vf4_t vf4_add(vf4_t a, vf4_t b)           { return vaddq_f32(a, b); }
+static inline vf4_t vf4_sub(vf4_t a, vf4_t b)           { return vsubq_f32(a, b); }
+static inline vf4_t vf4_mul(vf4_t a, vf4_t b)           { return vmulq_f32(a, b); }
+static inline vf4_t vf4_div(vf4_t a, vf4_t b)           { return vdivq_f32(a, b); }
+static inline vf4_t vf4_sqrt(vf4_t a)                   { return vsqrtq_f32(a); }
+static inline vf4_t vf4_min(vf4_t a, vf4_t b)           { return vminq_f32(a, b); }
+static inline vf4_t vf4_max(vf4_t a, vf4_t b)           { return vmaxq_f32(a, b); }
+static inline vm4_t vf4_lt(vf4_t a, vf4_t b)            { return vcltq_f32(a, b); }
+static inline vm4_t vm4_and(vm4_t a, vm4_t b)           { return vandq_u32(a, b); }
+static inline vf4_t vf4_select(vm4_t m, vf4_t a, vf4_t b)
+{
+    return vbslq_f32(m, a, b);
+}
+static inline int   vm4_any(vm4_t m)                    { return vmaxvq_u32(m) != 0; }
+
+#define vf4_transpose(r0, r1, r2, r3)\
+{\
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);\
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);\
+    (r0) = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));\
+    (r1) = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));\
+    (r2) = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));\
+    (r3) = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));\
+}
+
+#else
+
+#define SIMD_NAME "none"
+
+typedef struct vf4_s
+{
+    float v[4];
+}vf4_t;
+
+typedef struct vm4_s
+{
+    uint32_t v[4];
+}vm4_t;
+
+#define VF4_OP(expr) { vf4_t r; for(int i = 0; i < 4; i++) { r.v[i] = (expr); } return r; }
+
+static inline vf4_t vf4_set1(float x)                   VF4_OP(x)
+static inline vf4_t vf4_load(const float *p)            VF4_OP(p[i])
+static inline void  vf4_store(float *p, vf4_t v)        { for(int i = 0; i < 4; i++) { p[i] = v.v[i]; } }
+static inline vf4_t vf4_add(vf4_t a, vf4_t b)           VF4_OP(a.v[i] + b.v[i])
+static inline vf4_t vf4_sub(vf4_t a, vf4_t b)           VF4_OP(a.v[i] - b.v[i])
+static inline vf4_t vf4_mul(vf4_t a, vf4_t b)           VF4_OP(a.v[i] * b.v[i])
+static inline vf4_t vf4_div(vf4_t a, vf4_t b)           VF4_OP(a.v[i] / b.v[i])
+static inline vf4_t vf4_sqrt(vf4_t a)                   VF4_OP(sqrtf(a.v[i]))
+static inline vf4_t vf4_min(vf4_t a, vf4_t b)           VF4_OP((a.v[i] < b.v[i]) ? (a.v[i]) : (b.v[i]))
+static inline vf4_t vf4_max(vf4_t a, vf4_t b)           VF4_OP((a.v[i] > b.v[i]) ? (a.v[i]) : (b.v[i]))
+static inline vm4_t vf4_lt(vf4_t a, vf4_t b)
+{
+    vm4_t r;
+    for(int i = 0; i < 4; i++) { r.v[i] = (a.v[i] < b.v[i]) ? (0xFFFFFFFF) : (0); }
+    return r;
+}
+static inline vm4_t vm4_and(vm4_t a, vm4_t b)
+{
+    vm4_t r;
+    for(int i = 0; i < 4; i++) { r.v[i] = a.v[i] & b.v[i]; }
+    return r;
+}
+static inline vf4_t vf4_select(vm4_t m, vf4_t a, vf4_t b) VF4_OP((m.v[i]) ? (a.v[i]) : (b.v[i]))
+static inline int   vm4_any(vm4_t m)                    { return (m.v[0] | m.v[1] | m.v[2] | m.v[3]) != 0; }
+
+#define vf4_transpose(r0, r1, r2, r3)\
+{\
+    float m[4][4];\
+    vf4_store(m[0], r0);\
+    vf4_store(m[1], r1);\
+    vf4_store(m[2], r2);\
+    vf4_store(m[3], r3);\
+    for(int i = 0; i < 4; i++)\
+    {\
+        (r0).v[i] = m[i][0];\
+        (r1).v[i] = m[i][1];\
+        (r2).v[i] = m[i][2];\
+        (r3).v[i] = m[i][3];\
+    }\
+}
+
+#endif
+
+#define vf4_madd(a, b, c) vf4_add(vf4_mul(a, b), c)
+
+#endif
@@ -3,6 +3,10 @@
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_platform.h>
 #include <SDL2/SDL_rwops.h>
@@ -122,6 +126,23 @@ float Sys_FloatTime (void)
 }
 
 
+/*
+ * High resolution monotonic time, for profiling / benchmarks.
+ */
+double Sys_DoubleTime(void)
+{
+    static Uint64       base = 0;
+    Uint64              now = SDL_GetPerformanceCounter();
+
+    if(!base)
+    {
+        base = now;
+    }
+
+    return (double)(now - base) / (double)SDL_GetPerformanceFrequency();
+}
+
+
 void Sys_Strtime(char *buf, size_t buf_size)
 {
     struct tm *tm_;
@@ -310,3 +331,13 @@ int Sys_FileFound(const char *name, int checkWrite)
     }
     return 0;
 }
+
+
+int Sys_MakeDir(const char *name)
+{
+#ifdef _WIN32
+    return _mkdir(name) == 0;
+#else
+    return mkdir(name, 0755) == 0;
+#endif
+}
@@ -39,6 +39,7 @@ void Sys_ReturnTempMem(size_t size);
 void Sys_ResetTempMem();
 
 float Sys_FloatTime(void);
+double Sys_DoubleTime(void);
 void Sys_Strtime(char *buf, size_t buf_size);
 
 void Sys_Init(void);
@@ -50,6 +51,7 @@ void Sys_WriteTGAfile(const char *filename, const uint8_t *data, const int width
 void Sys_TakeScreenShot();
 
 int Sys_FileFound(const char *name, int checkWrite);
+int Sys_MakeDir(const char *name);
 
 #define Sys_LogCurrPlace Sys_DebugLog(SYS_LOG_FILENAME, "\"%s\" str = %d\n", __FILE__, __LINE__);
 #define Sys_extError(...) {Sys_LogCurrPlace Sys_Error(__VA_ARGS__);}
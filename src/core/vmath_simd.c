@@ -0,0 +1,182 @@
+
+#include <math.h>
+#include <stdint.h>
+#include "vmath_simd.h"
+#include "simd_vf4.h"
+
+
+/*
+ * acos(x), 0 <= x <= 1, Abramowitz & Stegun 4.4.46: |error| <= 2e-8.
+ */
+static inline vf4_t vf4_acos01(vf4_t x)
+{
+    vf4_t p = vf4_set1(-0.0012624911f);
+    p = vf4_madd(p, x, vf4_set1( 0.0066700901f));
+    p = vf4_madd(p, x, vf4_set1(-0.0170881256f));
+    p = vf4_madd(p, x, vf4_set1( 0.0308918810f));
+    p = vf4_madd(p, x, vf4_set1(-0.0501743046f));
+    p = vf4_madd(p, x, vf4_set1( 0.0889789874f));
+    p = vf4_madd(p, x, vf4_set1(-0.2145988016f));
+    p = vf4_madd(p, x, vf4_set1( 1.5707963050f));
+    return vf4_mul(p, vf4_sqrt(vf4_max(vf4_sub(vf4_set1(1.0f), x), vf4_set1(0.0f))));
+}
+
+
+/*
+ * sin(x), 0 <= x <= pi / 2, Taylor series up to x^11: |error| < 6e-8.
+ */
+static inline vf4_t vf4_sin_pi2(vf4_t x)
+{
+    vf4_t x2 = vf4_mul(x, x);
+    vf4_t p = vf4_set1(-2.5052108e-8f);
+    p = vf4_madd(p, x2, vf4_set1( 2.7557319e-6f));
+    p = vf4_madd(p, x2, vf4_set1(-1.9841270e-4f));
+    p = vf4_madd(p, x2, vf4_set1( 8.3333333e-3f));
+    p = vf4_madd(p, x2, vf4_set1(-1.6666667e-1f));
+    p = vf4_madd(p, x2, vf4_set1(1.0f));
+    return vf4_mul(p, x);
+}
+
+
+static inline void vf4_load_quats(float *q[4], vf4_t *x, vf4_t *y, vf4_t *z, vf4_t *w)
+{
+    *x = vf4_load(q[0]);
+    *y = vf4_load(q[1]);
+    *z = vf4_load(q[2]);
+    *w = vf4_load(q[3]);
+    vf4_transpose(*x, *y, *z, *w);
+}
+
+
+static inline void vf4_store_quats(float *q[4], vf4_t x, vf4_t y, vf4_t z, vf4_t w)
+{
+    vf4_t n = vf4_madd(x, x, vf4_madd(y, y, vf4_madd(z, z, vf4_mul(w, w))));
+    n = vf4_div(vf4_set1(1.0f), vf4_sqrt(n));
+    x = vf4_mul(x, n);
+    y = vf4_mul(y, n);
+    z = vf4_mul(z, n);
+    w = vf4_mul(w, n);
+    vf4_transpose(x, y, z, w);
+    vf4_store(q[0], x);
+    vf4_store(q[1], y);
+    vf4_store(q[2], z);
+    vf4_store(q[3], w);
+}
+
+
+const char *SIMD_GetInstructionSet()
+{
+    return SIMD_NAME;
+}
+
+
+void vec4_slerp_x4(float *ret[4], float *q1[4], float *q2[4], const float t[4])
+{
+    vf4_t ax, ay, az, aw, bx, by, bz, bw;
+    vf4_t one = vf4_set1(1.0f);
+    vf4_t vt = vf4_load(t);
+
+    vf4_load_quats(q1, &ax, &ay, &az, &aw);
+    vf4_load_quats(q2, &bx, &by, &bz, &bw);
+
+    vf4_t cos_fi = vf4_madd(ax, bx, vf4_madd(ay, by, vf4_madd(az, bz, vf4_mul(aw, bw))));
+    vf4_t sign = vf4_select(vf4_lt(cos_fi, vf4_set1(0.0f)), vf4_set1(-1.0f), one);
+    cos_fi = vf4_min(vf4_mul(cos_fi, sign), one);
+    vf4_t fi = vf4_acos01(cos_fi);
+    vf4_t sin_fi = vf4_sqrt(vf4_max(vf4_sub(one, vf4_mul(cos_fi, cos_fi)), vf4_set1(0.0f)));
+
+    // the same conditions as scalar vec4_slerp; lerp lanes may have inf / nan k1, k2 here
+    vm4_t use_slerp = vm4_and(vm4_and(vf4_lt(vf4_set1(0.00001f), sin_fi), vf4_lt(vf4_set1(0.0001f), vt)), vf4_lt(vt, one));
+    vf4_t inv_sin = vf4_div(one, sin_fi);
+    vf4_t k1 = vf4_mul(vf4_sin_pi2(vf4_mul(fi, vf4_sub(one, vt))), inv_sin);
+    vf4_t k2 = vf4_mul(vf4_mul(vf4_sin_pi2(vf4_mul(fi, vt)), inv_sin), sign);
+    k1 = vf4_select(use_slerp, k1, vf4_sub(one, vt));
+    k2 = vf4_select(use_slerp, k2, vt);
+
+    vf4_store_quats(ret, vf4_madd(k1, ax, vf4_mul(k2, bx)), vf4_madd(k1, ay, vf4_mul(k2, by)),
+                         vf4_madd(k1, az, vf4_mul(k2, bz)), vf4_madd(k1, aw, vf4_mul(k2, bw)));
+}
+
+
+void vec4_nlerp_x4(float *ret[4], float *q1[4], float *q2[4], const float t[4])
+{
+    vf4_t ax, ay, az, aw, bx, by, bz, bw;
+    vf4_t vt = vf4_load(t);
+
+    vf4_load_quats(q1, &ax, &ay, &az, &aw);
+    vf4_load_quats(q2, &bx, &by, &bz, &bw);
+
+    vf4_t cos_fi = vf4_madd(ax, bx, vf4_madd(ay, by, vf4_madd(az, bz, vf4_mul(aw, bw))));
+    vf4_t k1 = vf4_sub(vf4_set1(1.0f), vt);
+    vf4_t k2 = vf4_select(vf4_lt(cos_fi, vf4_set1(0.0f)), vf4_sub(vf4_set1(0.0f), vt), vt);
+
+    vf4_store_quats(ret, vf4_madd(k1, ax, vf4_mul(k2, bx)), vf4_madd(k1, ay, vf4_mul(k2, by)),
+                         vf4_madd(k1, az, vf4_mul(k2, bz)), vf4_madd(k1, aw, vf4_mul(k2, bw)));
+}
+
+
+void Mat4_set_qrotation_x4(float *mat[4], float *q[4])
+{
+    vf4_t x, y, z, w;
+    vf4_t one = vf4_set1(1.0f);
+    vf4_t two = vf4_set1(2.0f);
+
+    vf4_load_quats(q, &x, &y, &z, &w);
+
+    vf4_t xx = vf4_mul(x, x), yy = vf4_mul(y, y), zz = vf4_mul(z, z);
+    vf4_t xy = vf4_mul(x, y), xz = vf4_mul(x, z), yz = vf4_mul(y, z);
+    vf4_t wx = vf4_mul(w, x), wy = vf4_mul(w, y), wz = vf4_mul(w, z);
+
+    // columns of four matrices: lane i goes to mat[i], translation is not touched
+    vf4_t c0 = vf4_sub(one, vf4_mul(two, vf4_add(yy, zz)));
+    vf4_t c1 = vf4_mul(two, vf4_add(xy, wz));
+    vf4_t c2 = vf4_mul(two, vf4_sub(xz, wy));
+    vf4_t c3 = vf4_set1(0.0f);
+    vf4_transpose(c0, c1, c2, c3);
+    vf4_store(mat[0] + 0, c0);
+    vf4_store(mat[1] + 0, c1);
+    vf4_store(mat[2] + 0, c2);
+    vf4_store(mat[3] + 0, c3);
+
+    c0 = vf4_mul(two, vf4_sub(xy, wz));
+    c1 = vf4_sub(one, vf4_mul(two, vf4_add(xx, zz)));
+    c2 = vf4_mul(two, vf4_add(yz, wx));
+    c3 = vf4_set1(0.0f);
+    vf4_transpose(c0, c1, c2, c3);
+    vf4_store(mat[0] + 4, c0);
+    vf4_store(mat[1] + 4, c1);
+    vf4_store(mat[2] + 4, c2);
+    vf4_store(mat[3] + 4, c3);
+
+    c0 = vf4_mul(two, vf4_add(xz, wy));
+    c1 = vf4_mul(two, vf4_sub(yz, wx));
+    c2 = vf4_sub(one, vf4_mul(two, vf4_add(xx, yy)));
+    c3 = vf4_set1(0.0f);
+    vf4_transpose(c0, c1, c2, c3);
+    vf4_store(mat[0] + 8, c0);
+    vf4_store(mat[1] + 8, c1);
+    vf4_store(mat[2] + 8, c2);
+    vf4_store(mat[3] + 8, c3);
+}
+
+
+void Mat4_Mat4_mul_simd(float result[16], const float src1[16], const float src2[16])
+{
+    // all loads are done before stores, so result may alias sources
+    vf4_t a0 = vf4_load(src1 + 0);
+    vf4_t a1 = vf4_load(src1 + 4);
+    vf4_t a2 = vf4_load(src1 + 8);
+    vf4_t a3 = vf4_load(src1 + 12);
+    vf4_t r[4];
+
+    for(int j = 0; j < 4; j++)
+    {
+        const float *b = src2 + 4 * j;
+        r[j] = vf4_madd(a0, vf4_set1(b[0]), vf4_madd(a1, vf4_set1(b[1]), vf4_madd(a2, vf4_set1(b[2]), vf4_mul(a3, vf4_set1(b[3])))));
+    }
+
+    vf4_store(result + 0, r[0]);
+    vf4_store(result + 4, r[1]);
+    vf4_store(result + 8, r[2]);
+    vf4_store(result + 12, r[3]);
+}
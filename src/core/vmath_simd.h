@@ -0,0 +1,28 @@
+
+#ifndef VMATH_SIMD_H
+#define VMATH_SIMD_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Four lanes kernels for skeletal animation. Every call processes four
+ * independent quaternions / matrices given by pointers: data is transposed
+ * to structure of arrays form in registers, so lanes never depend on each
+ * other. SSE2 or AArch64 NEON is used if compiler targets it, else plain C.
+ * Quaternions are {x, y, z, w}, matrices are OpenGL column major.
+ */
+
+const char *SIMD_GetInstructionSet();
+
+void vec4_slerp_x4(float *ret[4], float *q1[4], float *q2[4], const float t[4]);      // the same results as vec4_slerp
+void vec4_nlerp_x4(float *ret[4], float *q1[4], float *q2[4], const float t[4]);      // shortest way, normalized lerp
+void Mat4_set_qrotation_x4(float *mat[4], float *q[4]);                                // as Mat4_set_qrotation
+void Mat4_Mat4_mul_simd(float result[16], const float src1[16], const float src2[16]); // as Mat4_Mat4_mul
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif
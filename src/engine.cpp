@@ -21,6 +21,8 @@ extern "C" {
 #include "core/vmath.h"
 #include "core/polygon.h"
 #include "core/gl_text.h"
+#include "core/profiler.h"
+#include "core/jobs.h"
 #include "render/camera.h"
 #include "render/render.h"
 #include "script/script.h"
@@ -45,6 +47,9 @@ extern "C" {
 #include "trigger.h"
 #include "character_controller.h"
 #include "render/bsp_tree.h"
+#include "render/draw_packets.h"
+#include "render/stream_buffer.h"
+#include "render/occlusion.h"
 #include "render/shader_manager.h"
 #include "image.h"
 
@@ -60,6 +65,7 @@ static stream_codec_t           engine_video;
 static char                     base_path[1024] = {0};
 static volatile int             engine_done   = 0;
 static int                      engine_set_zero_time = 0;
+static int                      engine_headless = 0;
 float time_scale = 1.0f;
 
 engine_container_p      last_cont = NULL;
@@ -83,7 +89,9 @@ enum debug_view_state_e
     sector_info,
     room_objects,
     ai_boxes,
+    render_list_info,
     bsp_info,
+    profiler_info,
     model_view,
     debug_states_count
 };
@@ -108,20 +116,15 @@ void SetTestModel(int index);
 void ShowModelView(float time);
 void ShowDebugInfo();
 
-void Engine_Start(int argc, char **argv)
+static void Engine_ParseArgs(int argc, char **argv, char **config_name, char **autoexec_name)
 {
-    char *config_name = NULL;
-    char *autoexec_name = NULL;
-
-    Engine_InitDefaultGlobals();
-
     for(int i = 1; i < argc; ++i)
     {
         if(0 == strncmp(argv[i], "-config", 7))
         {
             if((i + 1 < argc) && (Sys_FileFound(argv[i + 1], 0)))
             {
-                config_name = argv[i + 1];
+                *config_name = argv[i + 1];
             }
             ++i;
         }
@@ -129,7 +132,7 @@ void Engine_Start(int argc, char **argv)
         {
             if((i + 1 < argc) && (Sys_FileFound(argv[i + 1], 0)))
             {
-                autoexec_name = argv[i + 1];
+                *autoexec_name = argv[i + 1];
             }
             ++i;
         }
@@ -167,6 +170,16 @@ void Engine_Start(int argc, char **argv)
             exit(0);
         }
     }
+}
+
+
+void Engine_Start(int argc, char **argv)
+{
+    char *config_name = NULL;
+    char *autoexec_name = NULL;
+
+    Engine_InitDefaultGlobals();
+    Engine_ParseArgs(argc, argv, &config_name, &autoexec_name);
 
     // Primary initialization.
     Engine_Init_Pre();
@@ -203,6 +216,41 @@ void Engine_Start(int argc, char **argv)
 }
 
 
+/*
+ * Engine without window, input devices and GL context: all GL calls go to the
+ * null driver, so world may be loaded and simulated on headless build boxes.
+ */
+void Engine_StartHeadless(int argc, char **argv)
+{
+    char *config_name = NULL;
+    char *autoexec_name = NULL;
+
+    engine_headless = 1;
+    Engine_InitDefaultGlobals();
+    Engine_ParseArgs(argc, argv, &config_name, &autoexec_name);
+
+    // Primary initialization.
+    Engine_Init_Pre();
+
+    Engine_LoadConfig(config_name ? config_name : "config.lua");
+
+    SDL_Init(SDL_INIT_TIMER);
+    Audio_CoreInit();
+
+    Engine_InitGL();
+    renderer.DoShaders();
+
+    // Secondary (deferred) initialization.
+    Engine_Init_Post();
+    Engine_Resize(screen_info.w, screen_info.h, screen_info.w, screen_info.h);
+
+    // Clearing up memory for initial level loading.
+    World_Prepare();
+
+    luaL_dofile(engine_lua, autoexec_name ? autoexec_name : "autoexec.lua");
+}
+
+
 void Engine_Shutdown(int val)
 {
     renderer.ResetWorld(NULL, 0, NULL, 0);
@@ -218,6 +266,7 @@ void Engine_Shutdown(int val)
     }
 
     Physics_Destroy();
+    Jobs_Destroy();
     Gui_Destroy();
     Con_Destroy();
     GLText_Destroy();
@@ -286,6 +335,7 @@ void Engine_Init_Pre()
     stream_codec_init(&engine_video);
 
     Sys_Init();
+    Jobs_Init(0);
     glf_init();
     GLText_Init();
     Con_Init();
@@ -320,7 +370,14 @@ void Engine_Init_Post()
 
 void Engine_InitGL()
 {
-    InitGLExtFuncs();
+    if(engine_headless)
+    {
+        InitGLNullFuncs();
+    }
+    else
+    {
+        InitGLExtFuncs();
+    }
     qglClearColor(0.0, 0.0, 0.0, 1.0);
 
     qglEnable(GL_DEPTH_TEST);
@@ -519,6 +576,7 @@ void Engine_Display(float time)
     if(!engine_done)
     {
         qglClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);//| GL_ACCUM_BUFFER_BIT);
+        renderer.BeginFrame();
 
         Cam_Apply(&engine_camera);
         Cam_RecalcClipPlanes(&engine_camera);
@@ -558,14 +616,19 @@ void Engine_Display(float time)
 
         renderer.DrawListDebugLines();
 
+        PROF_ZONE_BEGIN("SDL_GL_SwapWindow");
         SDL_GL_SwapWindow(sdl_window);
+        PROF_ZONE_END();
     }
 }
 
 
 void Engine_GLSwapWindow()
 {
-    SDL_GL_SwapWindow(sdl_window);
+    if(sdl_window)
+    {
+        SDL_GL_SwapWindow(sdl_window);
+    }
 }
 
 
@@ -789,6 +852,7 @@ void Engine_MainLoop()
 
     while(!engine_done)
     {
+        PROF_FRAME_MARK();
         newtime = Sys_FloatTime();
         time = newtime - oldtime;
         oldtime = newtime;
@@ -820,7 +884,9 @@ void Engine_MainLoop()
         }
 
         Sys_ResetTempMem();
+        PROF_ZONE_BEGIN("Engine_PollSDLEvents");
         Engine_PollSDLEvents();
+        PROF_ZONE_END();
 
         gl_text_line_p fps = GLText_OutTextXY(10.0f, 10.0f, fps_str);
         if(fps)
@@ -842,10 +908,16 @@ void Engine_MainLoop()
             if(screen_info.debug_view_state != debug_view_state_e::model_view)
             {
                 Game_Frame(time);
+                PROF_ZONE_BEGIN("Gameflow_ProcessCommands");
                 Gameflow_ProcessCommands();
+                PROF_ZONE_END();
             }
+            PROF_ZONE_BEGIN("Audio_Update");
             Audio_Update(time);
+            PROF_ZONE_END();
+            PROF_ZONE_BEGIN("Engine_Display");
             Engine_Display(time);
+            PROF_ZONE_END();
         }
         else
         {
@@ -1301,6 +1373,29 @@ void ShowDebugInfo()
             }
             break;
 
+        case debug_view_state_e::render_list_info:
+            GLText_OutTextXY(30.0f, y += dy, "VIEW: Render list info");
+            if(renderer.drawPackets)
+            {
+                GLText_OutTextXY(30.0f, y += dy, "opaque packets = %07d", renderer.drawPackets->GetPacketsCount());
+                GLText_OutTextXY(30.0f, y += dy, "draw calls = %07d", renderer.drawPackets->m_draw_calls);
+                GLText_OutTextXY(30.0f, y += dy, "program binds = %07d", renderer.drawPackets->m_program_binds);
+                GLText_OutTextXY(30.0f, y += dy, "texture binds = %07d", renderer.drawPackets->m_texture_binds);
+                GLText_OutTextXY(30.0f, y += dy, "buffer binds = %07d", renderer.drawPackets->m_buffer_binds);
+            }
+            if(renderer.streamBuffer)
+            {
+                GLText_OutTextXY(30.0f, y += dy, "stream mode = %d, bytes = %07d, overflows = %d", renderer.streamBuffer->GetMode(), renderer.streamBuffer->m_used, renderer.streamBuffer->m_overflows);
+            }
+            if(renderer.occlusionBuffer)
+            {
+                COcclusionBuffer *occ = renderer.occlusionBuffer;
+                GLText_OutTextXY(30.0f, y += dy, "occluder polygons = %07d", occ->m_occluders);
+                GLText_OutTextXY(30.0f, y += dy, "occluded statics = %d of %d", occ->m_culled[OCCLUSION_OBJECT_STATIC], occ->m_tested[OCCLUSION_OBJECT_STATIC]);
+                GLText_OutTextXY(30.0f, y += dy, "occluded entities = %d of %d", occ->m_culled[OCCLUSION_OBJECT_ENTITY], occ->m_tested[OCCLUSION_OBJECT_ENTITY]);
+            }
+            break;
+
         case debug_view_state_e::bsp_info:
             GLText_OutTextXY(30.0f, y += dy, "VIEW: BSP tree info");
             if(renderer.dynamicBSP)
@@ -1310,6 +1405,19 @@ void ShowDebugInfo()
             }
             break;
 
+        case debug_view_state_e::profiler_info:
+            {
+                prof_zone_stat_t stats[32];
+                float frame_ms = 0.0f;
+                uint32_t stats_count = Prof_GetLastFrameStats(stats, 32, &frame_ms);
+                GLText_OutTextXY(30.0f, y += dy, "VIEW: Profiler (frame = %.2f ms)", frame_ms);
+                for(uint32_t i = 0; i < stats_count; ++i)
+                {
+                    GLText_OutTextXY(30.0f, y += dy, "%*s%s: %.3f ms (%d)", 2 * stats[i].depth, "", stats[i].name, stats[i].time_ms, stats[i].count);
+                }
+            }
+            break;
+
         case debug_view_state_e::model_view:
             GLText_OutTextXY(30.0f, y += dy, "VIEW: MODELS ANIM (use o, p, [, ], w, s, space, v and arrows)");
             break;
@@ -1577,6 +1685,7 @@ extern "C" int Engine_ExecCmd(char *ch)
             Con_AddLine("cam_distance - camera distance to actor\0", FONTSTYLE_CONSOLE_NOTIFY);
             Con_AddLine("r_wireframe, r_portals, r_frustums, r_room_boxes, r_boxes, r_normals, r_skip_room, r_flyby, r_cinematics, r_triggers, r_ai_boxes, r_cameras - render modes, r_path - show character path\0", FONTSTYLE_CONSOLE_NOTIFY);
             Con_AddLine("playsound(id) - play specified sound\0", FONTSTYLE_CONSOLE_NOTIFY);
+            Con_AddLine("prof_dump [frames] [file_name] - write last frames profiler zones as chrome trace json\0", FONTSTYLE_CONSOLE_NOTIFY);
             Con_AddLine("stopsound(id) - stop specified sound\0", FONTSTYLE_CONSOLE_NOTIFY);
             Con_AddLine("Watch out for case sensitive commands!\0", FONTSTYLE_CONSOLE_WARNING);
         }
@@ -1731,6 +1840,27 @@ extern "C" int Engine_ExecCmd(char *ch)
             renderer.r_flags ^= R_DRAW_AI_PATH;
             return 1;
         }
+        else if(!strcmp(token, "prof_dump"))
+        {
+            uint32_t frames = 60;
+            char file_name[1024] = "profile.json";
+            ch = SC_ParseToken(ch, token, sizeof(token));
+            if(NULL != ch)
+            {
+                frames = atoi(token);
+                ch = SC_ParseToken(ch, token, sizeof(token));
+                if(NULL != ch)
+                {
+                    strncpy(file_name, token, sizeof(file_name) - 1);
+                }
+            }
+            frames = Prof_DumpChromeTrace(file_name, frames);
+            if(frames)
+            {
+                Con_Notify("profiler: %d frames written to \"%s\"", frames, file_name);
+            }
+            return 1;
+        }
         else if(!strcmp(token, "r_crosshair"))
         {
             screen_info.crosshair = !screen_info.crosshair;
@@ -74,6 +74,7 @@ extern struct camera_s                       engine_camera;
 extern struct camera_state_s                 engine_camera_state;
 
 void Engine_Start(int argc, char **argv);
+void Engine_StartHeadless(int argc, char **argv);
 void Engine_Shutdown(int val) __attribute__((noreturn));
 const char *Engine_GetBasePath();
 void Engine_SetDone();
@@ -1151,7 +1151,12 @@ void Entity_MoveToSink(entity_p entity, struct static_camera_sink_s *sink)
 }
 
 
-void Entity_Frame(entity_p entity, float time)
+/**
+ * Animation state step: frames switching, anim commands and callbacks.
+ * Returns 1 if bone frame must be rebuilt then by SSBoneFrame_Update; that
+ * touches entity's own bone frame only, so may run outside of main thread.
+ */
+int Entity_FrameAnimations(entity_p entity, float time)
 {
     if(entity && !(entity->type_flags & ENTITY_TYPE_DYNAMIC) && (entity->state_flags & ENTITY_STATE_ACTIVE)  && (entity->state_flags & ENTITY_STATE_ENABLED))
     {
@@ -1214,6 +1219,17 @@ void Entity_Frame(entity_p entity, float time)
             ss_anim = ss_anim->next;
         }
 
+        return 1;
+    }
+
+    return 0;
+}
+
+
+void Entity_Frame(entity_p entity, float time)
+{
+    if(Entity_FrameAnimations(entity, time))
+    {
         SSBoneFrame_Update(entity->bf, time);
     }
 }
@@ -1325,10 +1341,11 @@ void Entity_CheckActivators(struct entity_s *ent)
 {
     if(ent && ent->self->room)
     {
-        for(int room_index = -1; room_index < ent->self->room->content->near_room_list_size; ++room_index)
+        room_p rooms[ENTITY_NEAR_ROOMS_MAX];
+        uint32_t rooms_count = World_GetRoomsNearPos(rooms, ENTITY_NEAR_ROOMS_MAX, ent->transform.M4x4 + 12, ENTITY_ACTIVATION_RANGE);
+        for(uint32_t room_index = 0; room_index < rooms_count; ++room_index)
         {
-            room_p room = (room_index >= 0) ? (ent->self->room->content->near_room_list[room_index]) : (ent->self->room);
-            engine_container_p cont = room->containers;
+            engine_container_p cont = rooms[room_index]->containers;
             for(; cont; cont = cont->next)
             {
                 if((cont->object_type == OBJECT_ENTITY) && cont->object && (cont->object != ent) && ((entity_p)cont->object)->activation_point)
@@ -36,6 +36,9 @@ struct inventory_node_s;
 
 #define ENTITY_TYPE_SPAWNED                         (0x8000)    // Was spawned.
 
+#define ENTITY_ACTIVATION_RANGE                     (3072.0)    // Max reach of activation point (offset + radius) from trigger.
+#define ENTITY_NEAR_ROOMS_MAX                       (64)        // Rooms per neighbourhood query.
+
 /*
  * SURFACE MOVEMENT DIRECTIONS
  */
@@ -180,6 +183,7 @@ void Entity_DisableCollision(entity_p ent);
 void Entity_UpdateRoomPos(entity_p ent);
 void Entity_MoveToRoom(entity_p entity, struct room_s *new_room);
 
+int  Entity_FrameAnimations(entity_p entity, float time);  // Entity_Frame without bone frame update
 void Entity_Frame(entity_p entity, float time);  // process frame + trying to change state
 
 void Entity_RebuildBV(entity_p ent);
@@ -10,6 +10,8 @@ extern "C" {
 
 #include "core/system.h"
 #include "core/console.h"
+#include "core/jobs.h"
+#include "core/profiler.h"
 #include "core/vmath.h"
 #include "core/polygon.h"
 #include "core/obb.h"
@@ -35,6 +37,37 @@ extern "C" {
 
 extern lua_State *engine_lua;
 
+static game_frame_stats_t game_frame_stats = {0};
+
+// phase timers are compiled into the headless benchmark only
+#ifdef OPENTOMB_BENCH
+#define GAME_STATS_BEGIN(t)         double t = Sys_DoubleTime()
+#define GAME_STATS_END(t, phase)    game_frame_stats.phase += Sys_DoubleTime() - (t)
+#define GAME_STATS_FRAME()          game_frame_stats.frames++
+#else
+#define GAME_STATS_BEGIN(t)
+#define GAME_STATS_END(t, phase)
+#define GAME_STATS_FRAME()
+#endif
+
+/*
+ * Entities update is split: main thread runs AI, scripts and animation
+ * state in world order, then bone frames are rebuilt by jobs, then results
+ * are committed to physics and rooms on main thread again. Scripts may
+ * delete entities (freed at once) after they were queued, so the queue is
+ * checked by ids before the jobs.
+ */
+typedef struct game_entity_update_s
+{
+    struct entity_s    *entity;
+    uint32_t            id;
+    int                 update_bones;
+}game_entity_update_t, *game_entity_update_p;
+
+static game_entity_update_p game_entity_updates = NULL;
+static uint32_t             game_entity_updates_size = 0;
+static uint32_t             game_entity_updates_count = 0;
+
 int Save_Entity(entity_p ent, void *data);
 
 int lua_mlook(lua_State * lua)
@@ -566,24 +599,101 @@ int Game_UpdateEntity(entity_p ent, void *data)
     {
         if(ent->character)
         {
+            GAME_STATS_BEGIN(t_character);
             Character_Update(ent);
+            GAME_STATS_END(t_character, character);
         }
         if(ent->state_flags & ENTITY_STATE_ENABLED)
         {
             Entity_ProcessSector(ent);
+            GAME_STATS_BEGIN(t_scripts);
             Script_LoopEntity(engine_lua, ent);
+            GAME_STATS_END(t_scripts, scripts);
         }
-        Entity_Frame(ent, engine_frame_time);
-        Entity_UpdateRigidBody(ent, ent->character != NULL);
-        Entity_UpdateRoomPos(ent);
+        GAME_STATS_BEGIN(t_frame);
+        if(game_entity_updates_count >= game_entity_updates_size)
+        {
+            game_entity_updates_size = (game_entity_updates_size > 0) ? (2 * game_entity_updates_size) : (256);
+            game_entity_updates = (game_entity_update_p)realloc(game_entity_updates, game_entity_updates_size * sizeof(game_entity_update_t));
+        }
+        game_entity_update_p u = game_entity_updates + game_entity_updates_count++;
+        u->entity = ent;
+        u->id = ent->id;
+        u->update_bones = Entity_FrameAnimations(ent, engine_frame_time);
+        GAME_STATS_END(t_frame, entity_frame);
     }
 
     return 0;
 }
 
 
+static void Game_UpdateEntitiesBones(void *data, uint32_t first, uint32_t last)
+{
+    PROF_SCOPED_ZONE("Game_UpdateEntitiesBones");
+    game_entity_update_p u = (game_entity_update_p)data + first;
+    struct ss_bone_frame_s *frames[16];
+    uint32_t frames_count = 0;
+    for(uint32_t i = first; i < last; i++, u++)
+    {
+        if(u->update_bones)
+        {
+            frames[frames_count++] = u->entity->bf;
+            if(frames_count == 16)
+            {
+                SSBoneFrame_UpdateBatch(frames, frames_count, engine_frame_time);
+                frames_count = 0;
+            }
+        }
+    }
+    if(frames_count > 0)
+    {
+        SSBoneFrame_UpdateBatch(frames, frames_count, engine_frame_time);
+    }
+}
+
+
+/*
+ * Drops queued entities that were deleted by scripts later in the same pass;
+ * the queued pointer is only compared, never dereferenced, before that.
+ */
+static void Game_RemoveDeletedEntityUpdates()
+{
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < game_entity_updates_count; i++)
+    {
+        game_entity_update_p u = game_entity_updates + i;
+        if(World_GetEntityByID(u->id) == u->entity)
+        {
+            game_entity_updates[count++] = *u;
+        }
+    }
+    game_entity_updates_count = count;
+}
+
+
+static void Game_UpdateEntities()
+{
+    game_entity_updates_count = 0;
+    World_IterateAllEntities(Game_UpdateEntity, NULL);
+    // bones and commit passes below run no scripts, so nothing is deleted after this check
+    Game_RemoveDeletedEntityUpdates();
+
+    GAME_STATS_BEGIN(t_bones);
+    Jobs_ParallelFor(Game_UpdateEntitiesBones, game_entity_updates, game_entity_updates_count, 4);
+    GAME_STATS_END(t_bones, entity_frame);
+
+    game_entity_update_p u = game_entity_updates;
+    for(uint32_t i = 0; i < game_entity_updates_count; i++, u++)
+    {
+        Entity_UpdateRigidBody(u->entity, u->entity->character != NULL);
+        Entity_UpdateRoomPos(u->entity);
+    }
+}
+
+
 void Game_Frame(float time)
 {
+    PROF_SCOPED_ZONE("Game_Frame");
     entity_p player = World_GetPlayer();
 
     // GUI and controls should be updated at all times!
@@ -608,7 +718,10 @@ void Game_Frame(float time)
     }
 
     // In game mode
+    GAME_STATS_FRAME();
+    GAME_STATS_BEGIN(t_tasks);
     Script_DoTasks(engine_lua, time);
+    GAME_STATS_END(t_tasks, scripts);
 
     // This must be called EVERY frame to max out smoothness.
     // Includes animations, camera movement, and so on.
@@ -625,8 +738,12 @@ void Game_Frame(float time)
 
         if(!control_states.noclip)
         {
+            GAME_STATS_BEGIN(t_character);
             Character_Update(player);
+            GAME_STATS_END(t_character, character);
+            GAME_STATS_BEGIN(t_scripts);
             Script_LoopEntity(engine_lua, player);   ///@TODO: fix that hack (refactoring)
+            GAME_STATS_END(t_scripts, scripts);
             if(player->character->target_id == ENTITY_ID_NONE)
             {
                 entity_p target = Character_FindTarget(player);
@@ -644,7 +761,9 @@ void Game_Frame(float time)
                 }
             }
         }
+        GAME_STATS_BEGIN(t_frame);
         Entity_Frame(player, time);
+        GAME_STATS_END(t_frame, entity_frame);
         Entity_UpdateRigidBody(player, 1);
         Entity_UpdateRoomPos(player);
     }
@@ -731,15 +850,29 @@ void Game_Frame(float time)
         }
     }
 
-    World_IterateAllEntities(Game_UpdateEntity, NULL);
+    Game_UpdateEntities();
 
+    GAME_STATS_BEGIN(t_physics);
     Physics_StepSimulation(time);
+    GAME_STATS_END(t_physics, physics);
 
     Controls_RefreshStates();
     renderer.UpdateAnimTextures();
 }
 
 
+void Game_GetFrameStats(game_frame_stats_p stats)
+{
+    *stats = game_frame_stats;
+}
+
+
+void Game_ResetFrameStats()
+{
+    memset(&game_frame_stats, 0x00, sizeof(game_frame_stats));
+}
+
+
 void Game_Prepare()
 {
     entity_p player = World_GetPlayer();
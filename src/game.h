@@ -13,12 +13,25 @@
 struct camera_s;
 struct entity_s;
 
+// Accumulated wall time (seconds) of Game_Frame phases, filled in opentomb_bench
+// builds only (OPENTOMB_BENCH), stays zeroed in the game.
+typedef struct game_frame_stats_s
+{
+    double      scripts;                // Script_DoTasks + Script_LoopEntity
+    double      character;              // Character_Update
+    double      entity_frame;           // Entity_Frame
+    double      physics;                // Physics_StepSimulation
+    uint32_t    frames;
+}game_frame_stats_t, *game_frame_stats_p;
+
 void Game_InitGlobals();
 void Game_RegisterLuaFunctions(struct lua_State *lua);
 int Game_Load(const char* name);
 int Game_Save(const char* name);
 
 void Game_Frame(float time);
+void Game_GetFrameStats(game_frame_stats_p stats);
+void Game_ResetFrameStats();
 
 void Game_Prepare();
 
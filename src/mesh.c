@@ -7,7 +7,6 @@
 #include "mesh.h"
 
 
-void BaseMesh_GenVBO(struct base_mesh_s *mesh);
 void BaseMesh_AddPolygonToFaces(base_mesh_p mesh, struct polygon_s *p);
 void BaseMesh_AddAnimatedPolygonToFaces(base_mesh_p mesh, uint32_t *vertex_index, struct polygon_s *p);
 
@@ -24,12 +23,14 @@ void BaseMesh_Clear(base_mesh_p mesh)
         qglDeleteBuffersARB(1, &mesh->vbo_animated_vertex_array);
         mesh->vbo_animated_vertex_array = 0;
     }
-    
-    if(qglIsBufferARB(mesh->vbo_animated_texcoord_array))
+
+    if(qglIsBufferARB(mesh->vbo_animated_params_array))
     {
-        qglDeleteBuffersARB(1, &mesh->vbo_animated_texcoord_array);
-        mesh->vbo_animated_texcoord_array = 0;
+        qglDeleteBuffersARB(1, &mesh->vbo_animated_params_array);
+        mesh->vbo_animated_params_array = 0;
     }
+    mesh->animated_texcoord_buffer = 0;
+    mesh->animated_texcoord_offset = 0;
 
     mesh->transparency_polygons = NULL;
     mesh->animated_polygons = NULL;
@@ -144,11 +145,13 @@ void BaseMesh_FindBB(base_mesh_p mesh)
 }
 
 
-void BaseMesh_GenVBO(struct base_mesh_s *mesh)
+void BaseMesh_GenVBO(base_mesh_p mesh)
 {
     mesh->vbo_vertex_array = 0;
     mesh->vbo_animated_vertex_array = 0;
-    mesh->vbo_animated_texcoord_array = 0;
+    mesh->vbo_animated_params_array = 0;
+    mesh->animated_texcoord_buffer = 0;
+    mesh->animated_texcoord_offset = 0;
     
     /// now, begin VBO filling!
     qglGenBuffersARB(1, &mesh->vbo_vertex_array);
@@ -169,10 +172,24 @@ void BaseMesh_GenVBO(struct base_mesh_s *mesh)
         qglBufferDataARB(GL_ARRAY_BUFFER, mesh->animated_vertex_count * sizeof(vertex_t), mesh->animated_vertices, GL_STATIC_DRAW);
         free(mesh->animated_vertices);
         mesh->animated_vertices = NULL;
-        // Prepare empty buffer for tex coords
-        qglGenBuffersARB(1, &mesh->vbo_animated_texcoord_array);
-        qglBindBufferARB(GL_ARRAY_BUFFER, mesh->vbo_animated_texcoord_array);
-        qglBufferDataARB(GL_ARRAY_BUFFER, mesh->animated_vertex_count * sizeof(GLfloat [2]), 0, GL_STREAM_DRAW);
+
+        // Static animation parameters for shader side tex coords evaluation;
+        // vertices follow animated_polygons order, as in animated_vertices.
+        GLfloat *params = (GLfloat*)malloc(mesh->animated_vertex_count * sizeof(GLfloat [2]));
+        GLfloat *param = params;
+        for(polygon_p p = mesh->animated_polygons; p; p = p->next)
+        {
+            for(uint16_t i = 0; i < p->vertex_count; i++, param += 2)
+            {
+                param[0] = p->anim_id - 1;
+                param[1] = p->frame_offset;
+            }
+        }
+        qglGenBuffersARB(1, &mesh->vbo_animated_params_array);
+        qglBindBufferARB(GL_ARRAY_BUFFER, mesh->vbo_animated_params_array);
+        qglBufferDataARB(GL_ARRAY_BUFFER, mesh->animated_vertex_count * sizeof(GLfloat [2]), params, GL_STATIC_DRAW);
+        free(params);
+        // without GPU evaluation tex coords are written by renderer into its stream buffer every frame
     }
     qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
     qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
@@ -397,6 +414,4 @@ void BaseMesh_GenFaces(base_mesh_p mesh)
             BaseMesh_AddAnimatedPolygonToFaces(mesh, &vertex_index, p);
         }
     }
-    
-    BaseMesh_GenVBO(mesh);
 }
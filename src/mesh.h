@@ -53,7 +53,9 @@ typedef struct base_mesh_s
 
     GLuint                  vbo_vertex_array;
     GLuint                  vbo_animated_vertex_array;
-    GLuint                  vbo_animated_texcoord_array;
+    GLuint                  vbo_animated_params_array;                          // sequence index, frame offset per animated vertex
+    GLuint                  animated_texcoord_buffer;                           // renderer stream buffer of this frame tex coords
+    GLuint                  animated_texcoord_offset;                           // in renderer stream buffer, updated every frame
 }base_mesh_t, *base_mesh_p;
 
 
@@ -111,6 +113,7 @@ void BaseMesh_FindBB(base_mesh_p mesh);
 uint32_t BaseMesh_AddVertex(base_mesh_p mesh, struct vertex_s *vertex);
 uint32_t BaseMesh_FindVertexIndex(base_mesh_p mesh, float v[3]);
 void     BaseMesh_GenFaces(base_mesh_p mesh);
+void     BaseMesh_GenVBO(base_mesh_p mesh);                // GL thread only; after BaseMesh_GenFaces
 
 
 #ifdef	__cplusplus
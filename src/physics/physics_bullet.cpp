@@ -16,6 +16,7 @@
 #include "../core/gl_font.h"
 #include "../core/gl_text.h"
 #include "../core/console.h"
+#include "../core/profiler.h"
 #include "../core/vmath.h"
 #include "../core/obb.h"
 #include "../render/render.h"
@@ -391,6 +392,7 @@ void Physics_Destroy()
 
 void Physics_StepSimulation(float time)
 {
+    PROF_SCOPED_ZONE("Physics_StepSimulation");
     time = (time < 0.1f) ? (time) : (0.0f);
     bt_engine_dynamicsWorld->stepSimulation(time, 0);
 }
@@ -0,0 +1,349 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bc_encoder.h"
+
+#define BC_ALPHA_THRESHOLD  (128)
+
+
+int BC_SelectFormat(const uint8_t *rgba, uint32_t pixels_count)
+{
+    int ret = BC_FORMAT_BC1;
+    for(uint32_t i = 0; i < pixels_count; i++, rgba += 4)
+    {
+        if(rgba[3] == 0)
+        {
+            ret = BC_FORMAT_BC1A;
+        }
+        else if(rgba[3] != 255)
+        {
+            return BC_FORMAT_BC3;
+        }
+    }
+    return ret;
+}
+
+
+uint32_t BC_GetEncodedSize(int format, uint32_t width, uint32_t height)
+{
+    uint32_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * ((format == BC_FORMAT_BC3) ? (16) : (8));
+}
+
+
+uint32_t BC_GetMipChainSize(int format, uint32_t width, uint32_t height, uint32_t *levels)
+{
+    uint32_t ret = BC_GetEncodedSize(format, width, height);
+    *levels = 1;
+    while((width > 1) || (height > 1))
+    {
+        width = (width > 1) ? (width / 2) : (1);
+        height = (height > 1) ? (height / 2) : (1);
+        ret += BC_GetEncodedSize(format, width, height);
+        (*levels)++;
+    }
+    return ret;
+}
+
+
+/*
+ * Gets 4x4 pixels at block (bx, by); small mip levels repeat edge pixels.
+ */
+static void BC_ReadBlock(uint8_t block[16][4], const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by)
+{
+    for(uint32_t y = 0; y < 4; y++)
+    {
+        uint32_t py = by * 4 + y;
+        py = (py < height) ? (py) : (height - 1);
+        for(uint32_t x = 0; x < 4; x++)
+        {
+            uint32_t px = bx * 4 + x;
+            px = (px < width) ? (px) : (width - 1);
+            memcpy(block[y * 4 + x], rgba + (py * width + px) * 4, 4);
+        }
+    }
+}
+
+
+static uint16_t BC_To565(const float c[3])
+{
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    r = (r < 0) ? (0) : ((r > 31) ? (31) : (r));
+    g = (g < 0) ? (0) : ((g > 63) ? (63) : (g));
+    b = (b < 0) ? (0) : ((b > 31) ? (31) : (b));
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+
+static void BC_From565(int c[3], uint16_t v)
+{
+    int r = (v >> 11) & 31;
+    int g = (v >> 5) & 63;
+    int b = v & 31;
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+}
+
+
+/*
+ * Colour endpoints are the extreme pixels along the principal axis of the
+ * block colours (few power iterations over their covariance).
+ */
+static void BC_FindEndpoints(uint8_t block[16][4], const uint8_t *use, float c0[3], float c1[3])
+{
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    float min_t = 1.0e10f, max_t = -1.0e10f;
+    int n = 0, min_i = 0, max_i = 0;
+
+    for(int i = 0; i < 16; i++)
+    {
+        if(use[i])
+        {
+            mean[0] += block[i][0];
+            mean[1] += block[i][1];
+            mean[2] += block[i][2];
+            n++;
+        }
+    }
+    mean[0] /= n;
+    mean[1] /= n;
+    mean[2] /= n;
+
+    for(int i = 0; i < 16; i++)
+    {
+        if(use[i])
+        {
+            float r = block[i][0] - mean[0];
+            float g = block[i][1] - mean[1];
+            float b = block[i][2] - mean[2];
+            cov[0] += r * r;
+            cov[1] += r * g;
+            cov[2] += r * b;
+            cov[3] += g * g;
+            cov[4] += g * b;
+            cov[5] += b * b;
+        }
+    }
+
+    for(int it = 0; it < 4; it++)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float m = (x > 0.0f) ? (x) : (-x);
+        m = (m > ((y > 0.0f) ? (y) : (-y))) ? (m) : ((y > 0.0f) ? (y) : (-y));
+        m = (m > ((z > 0.0f) ? (z) : (-z))) ? (m) : ((z > 0.0f) ? (z) : (-z));
+        if(m < 1.0e-6f)
+        {
+            break;                                                              // flat block
+        }
+        axis[0] = x / m;
+        axis[1] = y / m;
+        axis[2] = z / m;
+    }
+
+    for(int i = 0; i < 16; i++)
+    {
+        if(use[i])
+        {
+            float t = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+            if(t < min_t)
+            {
+                min_t = t;
+                min_i = i;
+            }
+            if(t > max_t)
+            {
+                max_t = t;
+                max_i = i;
+            }
+        }
+    }
+
+    c0[0] = block[max_i][0];
+    c0[1] = block[max_i][1];
+    c0[2] = block[max_i][2];
+    c1[0] = block[min_i][0];
+    c1[1] = block[min_i][1];
+    c1[2] = block[min_i][2];
+}
+
+
+static void BC_EncodeColorBlock(uint8_t *dst, uint8_t block[16][4], int punch_through)
+{
+    uint8_t use[16];
+    int palette[4][3];
+    int colors_count = 4;
+    int opaque = 0;
+    uint16_t v0 = 0, v1 = 0;
+    uint32_t indices = 0;
+
+    for(int i = 0; i < 16; i++)
+    {
+        use[i] = !punch_through || (block[i][3] >= BC_ALPHA_THRESHOLD);
+        opaque += use[i];
+    }
+
+    if(opaque > 0)
+    {
+        float c0[3], c1[3];
+        BC_FindEndpoints(block, use, c0, c1);
+        v0 = BC_To565(c0);
+        v1 = BC_To565(c1);
+    }
+
+    // 4 colours mode needs v0 > v1; in 3 colours mode (v0 <= v1) index 3 is transparent black.
+    colors_count = (opaque < 16) ? (3) : (4);
+    if(((colors_count == 4) && (v0 < v1)) || ((colors_count == 3) && (v0 > v1)))
+    {
+        uint16_t t = v0;
+        v0 = v1;
+        v1 = t;
+    }
+
+    BC_From565(palette[0], v0);
+    BC_From565(palette[1], v1);
+    for(int k = 0; k < 3; k++)
+    {
+        if(colors_count == 4)
+        {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+        else
+        {
+            palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+            palette[3][k] = 0;
+        }
+    }
+
+    for(int i = 0; i < 16; i++)
+    {
+        uint32_t index = 3;
+        if(use[i])
+        {
+            int best = 0x7FFFFFFF;
+            for(int j = 0; j < colors_count; j++)
+            {
+                int dr = block[i][0] - palette[j][0];
+                int dg = block[i][1] - palette[j][1];
+                int db = block[i][2] - palette[j][2];
+                int d = dr * dr + dg * dg + db * db;
+                if(d < best)
+                {
+                    best = d;
+                    index = j;
+                }
+            }
+        }
+        indices |= index << (2 * i);
+    }
+
+    dst[0] = v0 & 0xFF;
+    dst[1] = v0 >> 8;
+    dst[2] = v1 & 0xFF;
+    dst[3] = v1 >> 8;
+    dst[4] = indices & 0xFF;
+    dst[5] = (indices >> 8) & 0xFF;
+    dst[6] = (indices >> 16) & 0xFF;
+    dst[7] = indices >> 24;
+}
+
+
+static void BC_EncodeAlphaBlock(uint8_t *dst, uint8_t block[16][4])
+{
+    int a0 = 0, a1 = 255;
+    int palette[8];
+    uint64_t indices = 0;
+
+    for(int i = 0; i < 16; i++)
+    {
+        a0 = (block[i][3] > a0) ? (block[i][3]) : (a0);
+        a1 = (block[i][3] < a1) ? (block[i][3]) : (a1);
+    }
+
+    // 8 alpha mode (a0 > a1); equal values give palette of one alpha.
+    palette[0] = a0;
+    palette[1] = a1;
+    for(int j = 1; j < 7; j++)
+    {
+        palette[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+    }
+
+    for(int i = 0; i < 16; i++)
+    {
+        int best = 0x7FFFFFFF;
+        uint64_t index = 0;
+        for(int j = 0; (j < 8) && (a0 > a1); j++)
+        {
+            int d = block[i][3] - palette[j];
+            d = (d < 0) ? (-d) : (d);
+            if(d < best)
+            {
+                best = d;
+                index = j;
+            }
+        }
+        indices |= index << (3 * i);
+    }
+
+    dst[0] = a0;
+    dst[1] = a1;
+    for(int i = 0; i < 6; i++)
+    {
+        dst[2 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+}
+
+
+void BC_EncodeRows(int format, uint8_t *dst, const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t first_row, uint32_t last_row)
+{
+    uint32_t blocks_x = (width + 3) / 4;
+    uint32_t block_size = (format == BC_FORMAT_BC3) ? (16) : (8);
+    uint8_t block[16][4];
+
+    dst += first_row * blocks_x * block_size;
+    for(uint32_t by = first_row; by < last_row; by++)
+    {
+        for(uint32_t bx = 0; bx < blocks_x; bx++, dst += block_size)
+        {
+            BC_ReadBlock(block, rgba, width, height, bx, by);
+            if(format == BC_FORMAT_BC3)
+            {
+                BC_EncodeAlphaBlock(dst, block);
+                BC_EncodeColorBlock(dst + 8, block, 0);
+            }
+            else
+            {
+                BC_EncodeColorBlock(dst, block, format == BC_FORMAT_BC1A);
+            }
+        }
+    }
+}
+
+
+void BC_Downsample(uint8_t *dst, const uint8_t *rgba, uint32_t width, uint32_t height)
+{
+    uint32_t w = (width > 1) ? (width / 2) : (1);
+    uint32_t h = (height > 1) ? (height / 2) : (1);
+    uint32_t dx = (width > 1) ? (4) : (0);
+    uint32_t dy = (height > 1) ? (width * 4) : (0);
+
+    for(uint32_t y = 0; y < h; y++)
+    {
+        const uint8_t *src = rgba + (2 * y * ((height > 1) ? (width) : (0))) * 4;
+        for(uint32_t x = 0; x < w; x++, src += 2 * dx, dst += 4)
+        {
+            for(int k = 0; k < 4; k++)
+            {
+                dst[k] = (src[k] + src[dx + k] + src[dy + k] + src[dy + dx + k] + 2) / 4;
+            }
+        }
+    }
+}
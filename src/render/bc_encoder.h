@@ -0,0 +1,43 @@
+#ifndef BC_ENCODER_H
+#define BC_ENCODER_H
+
+/*
+ * CPU encoder of S3TC block compressed textures (BC1 / DXT1 and BC3 / DXT5).
+ * Images are RGBA8 byte arrays; they are encoded by 4x4 pixel blocks, rows of
+ * blocks are independent, so an image may be split by block rows over jobs.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define BC_FORMAT_BC1       (0)         // RGB, 8 bytes per block
+#define BC_FORMAT_BC1A      (1)         // RGB + 1-bit alpha, 8 bytes per block
+#define BC_FORMAT_BC3       (2)         // RGB + interpolated alpha, 16 bytes per block
+
+/*
+ * Picks the smallest format that keeps image alpha: BC1 for opaque images,
+ * BC1A if alpha is only 0 or 255 (TR colour keyed textures), else BC3.
+ */
+int      BC_SelectFormat(const uint8_t *rgba, uint32_t pixels_count);
+uint32_t BC_GetEncodedSize(int format, uint32_t width, uint32_t height);
+uint32_t BC_GetMipChainSize(int format, uint32_t width, uint32_t height, uint32_t *levels);     // down to 1x1
+
+/*
+ * Encodes block rows [first_row, last_row) of the image into dst, which
+ * points to the whole encoded image (BC_GetEncodedSize bytes).
+ */
+void     BC_EncodeRows(int format, uint8_t *dst, const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t first_row, uint32_t last_row);
+
+/*
+ * Box filtered half size image (at least 1x1) for the next mip level.
+ */
+void     BC_Downsample(uint8_t *dst, const uint8_t *rgba, uint32_t width, uint32_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
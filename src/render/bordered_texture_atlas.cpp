@@ -14,26 +14,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <SDL2/SDL_rwops.h>
 
 #include "../core/gl_util.h"
 #include "../core/polygon.h"
-#include "bsp_tree_2d.h"
+#include "../core/jobs.h"
+#include "bc_encoder.h"
+#include "skyline_2d.h"
 #include "../vt/vt_level.h"
 
-#ifndef __APPLE__
-/*!
- * Fills an area of memory with a four-byte pattern pointed to.
- * This is a standard library function on Mac OS X, but sadly not anywhere else, so I'm redefining it here. Because I know where it will be called, I can add additional requirements: len must be a multiple of four, and pattern and b both must be four-byte aligned.
- */
-static void memset_pattern4(void *b, const void *pattern, const size_t len)
-{
-    uint32_t *intb = (uint32_t *) b;
-    uint32_t patternValue = *((uint32_t *) pattern);
-    for (size_t i = 0; i < len/4; i++)
-        intb[i] = patternValue;
-}
-#endif
-
 static __inline GLuint NextPowerOf2(GLuint in)
 {
      in -= 1;
@@ -86,7 +75,7 @@ int bordered_texture_atlas::compareCanonicalTextureSizes(const void *parameter1,
 
 /*!
  * Lays out the texture data and switches the atlas to laid out mode. This makes
- * use of a bsp_tree_2d to handle all the really annoying stuff.
+ * use of a skyline_2d per result page to handle all the really annoying stuff.
  */
 void bordered_texture_atlas::layOutTextures()
 {
@@ -102,7 +91,7 @@ void bordered_texture_atlas::layOutTextures()
     // Find positions for the canonical textures
     number_result_pages = 0;
     result_page_height = NULL;
-    bsp_tree_2d_p *result_pages = NULL;
+    skyline_2d_p *result_pages = NULL;
 
     for (unsigned long texture = 0; texture < number_canonical_object_textures; texture++)
     {
@@ -112,7 +101,7 @@ void bordered_texture_atlas::layOutTextures()
         bool found_place = 0;
         for (unsigned long page = 0; page < number_result_pages; page++)
         {
-            found_place = BSPTree2D_FindSpaceFor(result_pages[page],
+            found_place = Skyline2D_FindSpaceFor(result_pages[page],
                                                  canonical.width + 2*border_width,
                                                  canonical.height + 2*border_width,
                                                  &(canonical.new_x_with_border),
@@ -120,11 +109,6 @@ void bordered_texture_atlas::layOutTextures()
             if (found_place)
             {
                 canonical.new_page = page;
-
-                unsigned highest_y = canonical.new_y_with_border + canonical.height + border_width * 2;
-                if (highest_y + 1 > result_page_height[page])
-                    result_page_height[page] = highest_y;
-
                 break;
             }
         }
@@ -133,32 +117,46 @@ void bordered_texture_atlas::layOutTextures()
         if (!found_place)
         {
             number_result_pages += 1;
-            result_pages = (bsp_tree_2d_p *) realloc(result_pages, sizeof(bsp_tree_2d_p) * number_result_pages);
-            result_pages[number_result_pages - 1] = BSPTree2D_Create(result_page_width, result_page_width);
-            result_page_height = (unsigned *) realloc(result_page_height, sizeof(unsigned) * number_result_pages);
+            result_pages = (skyline_2d_p *) realloc(result_pages, sizeof(skyline_2d_p) * number_result_pages);
+            result_pages[number_result_pages - 1] = Skyline2D_Create(result_page_width, result_page_width);
 
-            BSPTree2D_FindSpaceFor(result_pages[number_result_pages - 1],
+            Skyline2D_FindSpaceFor(result_pages[number_result_pages - 1],
                                    canonical.width + 2*border_width,
                                    canonical.height + 2*border_width,
                                    &(canonical.new_x_with_border),
                                    &(canonical.new_y_with_border));
             canonical.new_page = number_result_pages - 1;
-
-            unsigned highest_y = canonical.new_y_with_border + canonical.height + border_width * 2;
-            result_page_height[number_result_pages - 1] = highest_y;
         }
     }
 
-    // Fix up heights if necessary
+    // Pages are only as high as needed
+    result_page_height = (unsigned *) malloc(sizeof(unsigned) * number_result_pages);
     for (unsigned page = 0; page < number_result_pages; page++)
     {
-        result_page_height[page] = NextPowerOf2(result_page_height[page]);
+        result_page_height[page] = NextPowerOf2(Skyline2D_GetUsedHeight(result_pages[page]));
     }
 
+    // Group textures by result page for the page assembly
+    result_page_first_texture = new unsigned long[number_result_pages + 1];
+    result_page_textures = new unsigned long[number_canonical_object_textures];
+    memset(result_page_first_texture, 0, sizeof(unsigned long) * (number_result_pages + 1));
+    for (unsigned long texture = 0; texture < number_canonical_object_textures; texture++)
+        result_page_first_texture[canonical_object_textures[texture].new_page + 1]++;
+    for (unsigned long page = 0; page < number_result_pages; page++)
+        result_page_first_texture[page + 1] += result_page_first_texture[page];
+    for (unsigned long texture = 0; texture < number_canonical_object_textures; texture++)
+    {
+        unsigned long page = canonical_object_textures[sorted_indices[texture]].new_page;
+        result_page_textures[result_page_first_texture[page]++] = sorted_indices[texture];
+    }
+    for (unsigned long page = number_result_pages; page > 0; page--)
+        result_page_first_texture[page] = result_page_first_texture[page - 1];
+    result_page_first_texture[0] = 0;
+
     // Cleanup
     delete [] sorted_indices;
     for (unsigned long i = 0; i < number_result_pages; i++)
-        BSPTree2D_Destroy(result_pages[i]);
+        Skyline2D_Destroy(result_pages[i]);
     free(result_pages);
 }
 
@@ -173,6 +171,8 @@ bordered_texture_atlas::bordered_texture_atlas(int border,
 number_result_pages(0),
 result_page_width(0),
 result_page_height(NULL),
+result_page_first_texture(NULL),
+result_page_textures(NULL),
 number_original_pages(page_count),
 original_pages(pages),
 number_file_object_textures(0),
@@ -220,6 +220,8 @@ bordered_texture_atlas::~bordered_texture_atlas()
     delete [] file_object_textures;
     delete [] canonical_textures_for_sprite_textures;
     delete [] canonical_object_textures;
+    delete [] result_page_first_texture;
+    delete [] result_page_textures;
     original_pages = NULL;
     free(result_page_height);
 }
@@ -493,146 +495,90 @@ unsigned long bordered_texture_atlas::getNumAtlasPages() const
     return number_result_pages;
 }
 
-void bordered_texture_atlas::createTextures(GLuint *textureNames)
+/*!
+ * Copies one canonical texture with its border into the page data. Border
+ * pixels repeat the edge of the tile; tiles do not overlap, so it is safe to
+ * run this for several textures of the same page at once.
+ */
+void bordered_texture_atlas::copyCanonicalTexture(GLubyte *data, const canonical_object_texture &canonical) const
 {
-    GLubyte *data = (GLubyte *) malloc(4 * result_page_width * result_page_width);
+    uint32_t white_pixels[256 + 1];
+    const uint32_t *src_page;
+    unsigned src_x;
+    unsigned src_y;
+    unsigned src_pitch;
 
-    qglGenTextures((GLsizei) number_result_pages, textureNames);
+    if(canonical.original_page == WHITE_TEXTURE_INDEX)
+    {
+        for (unsigned i = 0; i <= canonical.width; i++)
+            white_pixels[i] = 0xFFFFFFFFU;
+        src_page = white_pixels;
+        src_x = 0;
+        src_y = 0;
+        src_pitch = 0;
+    }
+    else
+    {
+        src_page = &original_pages[canonical.original_page].pixels[0][0];
+        src_x = canonical.original_x;
+        src_y = canonical.original_y;
+        src_pitch = 256;
+    }
 
-    textures_indexes = textureNames;
+    unsigned rows = canonical.height + 2 * border_width;
+    for (unsigned row = 0; row < rows; row++)
+    {
+        // Top border repeats the first line, bottom border the line under the tile.
+        unsigned line = (row < (unsigned)border_width) ? (0) : (row - border_width);
+        line = (line > canonical.height) ? (canonical.height) : (line);
+        const uint32_t *src = src_page + (src_y + line) * src_pitch + src_x;
+        uint32_t *dst = (uint32_t *) data + (canonical.new_y_with_border + row) * result_page_width + canonical.new_x_with_border;
+
+        for (int i = 0; i < border_width; i++)
+            *dst++ = src[0];
+        memcpy(dst, src, canonical.width * 4);
+        dst += canonical.width;
+        for (int i = 0; i < border_width; i++)
+            *dst++ = src[canonical.width];
+    }
+}
 
-    for (unsigned long page = 0; page < number_result_pages; page++)
+void bordered_texture_atlas::copyCanonicalTexturesJob(void *data, uint32_t first, uint32_t last)
+{
+    page_assembly_t *assembly = (page_assembly_t *) data;
+    const bordered_texture_atlas *atlas = assembly->atlas;
+    const unsigned long *textures = atlas->result_page_textures + atlas->result_page_first_texture[assembly->page];
+
+    for (uint32_t i = first; i < last; i++)
     {
-        for (unsigned long texture = 0; texture < number_canonical_object_textures; texture++)
-        {
-            const canonical_object_texture &canonical = canonical_object_textures[texture];
-            if (canonical.new_page != page)
-                continue;
+        atlas->copyCanonicalTexture(assembly->data, atlas->canonical_object_textures[textures[i]]);
+    }
+}
 
-            if(canonical.original_page == WHITE_TEXTURE_INDEX)
-            {
-                uint32_t white_pixels[1] = {0xFFFFFFFFU};
-                // Add top border
-                for (int border = 0; border < border_width; border++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + border;
-
-                    // expand top-left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           white_pixels, 4 * border_width);
-                    // copy top line
-                    memset_pattern4(&data[(y*result_page_width + x + border_width) * 4],
-                           white_pixels, canonical.width * 4);
-                    // expand top-right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           white_pixels, 4 * border_width);
-                }
+void bordered_texture_atlas::assemblePage(unsigned long page, GLubyte *data) const
+{
+    page_assembly_t assembly;
+    unsigned long textures_count = result_page_first_texture[page + 1] - result_page_first_texture[page];
+
+    // Only this page's textures, split over job workers.
+    memset(data, 0, 4 * result_page_width * result_page_height[page]);
+    assembly.atlas = this;
+    assembly.page = page;
+    assembly.data = data;
+    Jobs_ParallelFor(copyCanonicalTexturesJob, &assembly, textures_count, 64);
+}
 
-                // Copy main content
-                for (int line = 0; line < canonical.height; line++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + border_width + line;
-
-                    // expand left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           white_pixels, 4 * border_width);
-                    // copy line
-                    memset_pattern4(&data[(y*result_page_width + x + border_width) * 4],
-                           white_pixels, canonical.width * 4);
-                    // expand right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           white_pixels, 4 * border_width);
-                }
+void bordered_texture_atlas::createTextures(GLuint *textureNames)
+{
+    GLubyte *data = (GLubyte *) malloc(4 * result_page_width * result_page_width);
 
-                // Add bottom border
-                for (int border = 0; border < border_width; border++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + canonical.height + border_width + border;
-
-                    // expand bottom-left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           white_pixels, 4 * border_width);
-                    // copy bottom line
-                    memset_pattern4(&data[(y*result_page_width + x + border_width) * 4],
-                           white_pixels, canonical.width * 4);
-                    // expand bottom-right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           white_pixels, 4 * border_width);
-                }
-            }
-            else
-            {
-                const char *original = (char *) original_pages[canonical.original_page].pixels;
-                // Add top border
-                for (int border = 0; border < border_width; border++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + border;
-                    unsigned old_x = canonical.original_x;
-                    unsigned old_y = canonical.original_y;
-
-                    // expand top-left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           &(original[(old_y * 256 + old_x) * 4]),
-                           4 * border_width);
-                    // copy top line
-                    memcpy(&data[(y*result_page_width + x + border_width) * 4],
-                           &original[(old_y * 256 + old_x) * 4],
-                           canonical.width * 4);
-                    // expand top-right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           &(original[(old_y * 256 + old_x + canonical.width) * 4]),
-                           4 * border_width);
-                }
+    qglGenTextures((GLsizei) number_result_pages, textureNames);
 
-                // Copy main content
-                for (int line = 0; line < canonical.height; line++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + border_width + line;
-                    unsigned old_x = canonical.original_x;
-                    unsigned old_y = canonical.original_y + line;
-
-                    // expand left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           &(original[(old_y * 256 + old_x) * 4]),
-                           4 * border_width);
-                    // copy line
-                    memcpy(&data[(y*result_page_width + x + border_width) * 4],
-                           &original[(old_y * 256 + old_x) * 4],
-                           canonical.width * 4);
-                    // expand right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           &(original[(old_y * 256 + old_x + canonical.width) * 4]),
-                           4 * border_width);
-                }
+    textures_indexes = textureNames;
 
-                // Add bottom border
-                for (int border = 0; border < border_width; border++)
-                {
-                    unsigned x = canonical.new_x_with_border;
-                    unsigned y = canonical.new_y_with_border + canonical.height + border_width + border;
-                    unsigned old_x = canonical.original_x;
-                    unsigned old_y = canonical.original_y + canonical.height;
-
-                    // expand bottom-left pixel
-                    memset_pattern4(&data[(y*result_page_width + x) * 4],
-                           &(original[(old_y * 256 + old_x) * 4]),
-                           4 * border_width);
-                    // copy bottom line
-                    memcpy(&data[(y*result_page_width + x + border_width) * 4],
-                           &original[(old_y * 256 + old_x) * 4],
-                           canonical.width * 4);
-                    // expand bottom-right pixel
-                    memset_pattern4(&data[(y*result_page_width + x + border_width + canonical.width) * 4],
-                           &(original[(old_y * 256 + old_x + canonical.width) * 4]),
-                           4 * border_width);
-                }
-            }
-        }
+    for (unsigned long page = 0; page < number_result_pages; page++)
+    {
+        assemblePage(page, data);
 
         qglBindTexture(GL_TEXTURE_2D, textureNames[page]);
         qglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)result_page_width, (GLsizei) result_page_height[page], 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
@@ -692,3 +638,202 @@ void bordered_texture_atlas::createTextures(GLuint *textureNames)
 
     free(data);
 }
+
+/*
+ * Compressed pages cache: header, then for every page its height, format,
+ * mip levels count, data size and all mip levels data. It is valid only for
+ * the same level file and the same pages layout.
+ */
+#define TEX_CACHE_MAGIC     (0x43545254)            // "TRTC"
+#define TEX_CACHE_VERSION   (1)
+
+typedef struct tex_cache_header_s
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    page_width;
+    uint32_t    pages_count;
+    uint64_t    level_hash;
+    uint64_t    layout_hash;
+}tex_cache_header_t;
+
+typedef struct tex_cache_page_s
+{
+    uint32_t    height;
+    uint32_t    format;
+    uint32_t    levels;
+    uint32_t    data_size;
+}tex_cache_page_t;
+
+typedef struct bc_encoding_s
+{
+    int             format;
+    uint8_t        *dst;
+    const uint8_t  *rgba;
+    uint32_t        width;
+    uint32_t        height;
+}bc_encoding_t;
+
+static void BC_EncodeRowsJob(void *data, uint32_t first, uint32_t last)
+{
+    bc_encoding_t *enc = (bc_encoding_t*)data;
+    BC_EncodeRows(enc->format, enc->dst, enc->rgba, enc->width, enc->height, first, last);
+}
+
+uint64_t bordered_texture_atlas::getLayoutHash() const
+{
+    uint64_t ret = 14695981039346656037ULL;
+    uint32_t values[4];
+    values[3] = border_width;
+    for (unsigned long i = 0; i < number_canonical_object_textures; i++)
+    {
+        const canonical_object_texture &canonical = canonical_object_textures[i];
+        values[0] = canonical.new_page;
+        values[1] = canonical.new_x_with_border;
+        values[2] = canonical.new_y_with_border;
+        for (size_t j = 0; j < sizeof(values); j++)
+        {
+            ret = (ret ^ ((const uint8_t *) values)[j]) * 1099511628211ULL;
+        }
+    }
+    return ret;
+}
+
+/*!
+ * Encodes assembled page with all its mip levels (box filtered) into data;
+ * rgba is the page, mip_rgba a buffer of the same size for smaller levels.
+ */
+void bordered_texture_atlas::encodePage(unsigned long page, int format, uint8_t *data, GLubyte *rgba, GLubyte *mip_rgba) const
+{
+    bc_encoding_t enc;
+    enc.format = format;
+    enc.width = result_page_width;
+    enc.height = result_page_height[page];
+    enc.rgba = rgba;
+    enc.dst = data;
+
+    for (;;)
+    {
+        Jobs_ParallelFor(BC_EncodeRowsJob, &enc, (enc.height + 3) / 4, 16);
+        enc.dst += BC_GetEncodedSize(format, enc.width, enc.height);
+        if ((enc.width == 1) && (enc.height == 1))
+        {
+            break;
+        }
+
+        // Level 0 buffer is free after the first level, so buffers swap.
+        GLubyte *src = (GLubyte *) enc.rgba;
+        BC_Downsample(mip_rgba, src, enc.width, enc.height);
+        enc.width = (enc.width > 1) ? (enc.width / 2) : (1);
+        enc.height = (enc.height > 1) ? (enc.height / 2) : (1);
+        enc.rgba = mip_rgba;
+        mip_rgba = src;
+    }
+}
+
+bool bordered_texture_atlas::createCompressedTextures(GLuint *textureNames, const char *cache_name, uint64_t level_hash)
+{
+    tex_cache_header_t header;
+    tex_cache_page_t *pages;
+    uint8_t **pages_data;
+    SDL_RWops *cache;
+    bool cache_ok = false;
+
+    if (qglCompressedTexImage2DARB == NULL)
+    {
+        return false;
+    }
+
+    pages = (tex_cache_page_t *) calloc(number_result_pages, sizeof(tex_cache_page_t));
+    pages_data = (uint8_t **) calloc(number_result_pages, sizeof(uint8_t *));
+    header.magic = TEX_CACHE_MAGIC;
+    header.version = TEX_CACHE_VERSION;
+    header.page_width = result_page_width;
+    header.pages_count = number_result_pages;
+    header.level_hash = level_hash;
+    header.layout_hash = getLayoutHash();
+
+    cache = (cache_name) ? (SDL_RWFromFile(cache_name, "rb")) : (NULL);
+    if (cache)
+    {
+        tex_cache_header_t file_header;
+        cache_ok = (SDL_RWread(cache, &file_header, sizeof(file_header), 1) == 1) &&
+                   (memcmp(&file_header, &header, sizeof(header)) == 0);
+        for (unsigned long page = 0; cache_ok && (page < number_result_pages); page++)
+        {
+            uint32_t levels = 0;
+            cache_ok = (SDL_RWread(cache, pages + page, sizeof(tex_cache_page_t), 1) == 1) &&
+                       (pages[page].height == result_page_height[page]) && (pages[page].format <= BC_FORMAT_BC3) &&
+                       (pages[page].data_size == BC_GetMipChainSize(pages[page].format, result_page_width, pages[page].height, &levels)) &&
+                       (pages[page].levels == levels);
+            if (cache_ok)
+            {
+                pages_data[page] = (uint8_t *) malloc(pages[page].data_size);
+                cache_ok = (SDL_RWread(cache, pages_data[page], pages[page].data_size, 1) == 1);
+            }
+        }
+        SDL_RWclose(cache);
+    }
+
+    if (!cache_ok)
+    {
+        // Two page buffers: level 0 and ping-pong buffer for smaller mip levels.
+        GLubyte *rgba = (GLubyte *) malloc(2 * 4 * result_page_width * result_page_width);
+        cache = (cache_name) ? (SDL_RWFromFile(cache_name, "wb")) : (NULL);
+        cache_ok = (cache != NULL) && (SDL_RWwrite(cache, &header, sizeof(header), 1) == 1);
+        for (unsigned long page = 0; page < number_result_pages; page++)
+        {
+            assemblePage(page, rgba);
+            pages[page].height = result_page_height[page];
+            pages[page].format = BC_SelectFormat(rgba, result_page_width * result_page_height[page]);
+            pages[page].data_size = BC_GetMipChainSize(pages[page].format, result_page_width, pages[page].height, &pages[page].levels);
+            free(pages_data[page]);
+            pages_data[page] = (uint8_t *) malloc(pages[page].data_size);
+            encodePage(page, pages[page].format, pages_data[page], rgba, rgba + 4 * result_page_width * result_page_width);
+            cache_ok = cache_ok && (SDL_RWwrite(cache, pages + page, sizeof(tex_cache_page_t), 1) == 1) &&
+                       (SDL_RWwrite(cache, pages_data[page], pages[page].data_size, 1) == 1);
+        }
+        free(rgba);
+        if (cache)
+        {
+            SDL_RWclose(cache);
+            if (!cache_ok)
+            {
+                remove(cache_name);
+            }
+        }
+    }
+
+    qglGenTextures((GLsizei) number_result_pages, textureNames);
+    textures_indexes = textureNames;
+    for (unsigned long page = 0; page < number_result_pages; page++)
+    {
+        const uint8_t *data = pages_data[page];
+        GLenum gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        GLsizei w = result_page_width;
+        GLsizei h = result_page_height[page];
+
+        if (pages[page].format == BC_FORMAT_BC1)
+            gl_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        else if (pages[page].format == BC_FORMAT_BC1A)
+            gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+
+        qglBindTexture(GL_TEXTURE_2D, textureNames[page]);
+        for (uint32_t level = 0; level < pages[page].levels; level++)
+        {
+            GLsizei size = BC_GetEncodedSize(pages[page].format, w, h);
+            qglCompressedTexImage2DARB(GL_TEXTURE_2D, level, gl_format, w, h, 0, size, data);
+            data += size;
+            w = (w > 1) ? (w / 2) : (1);
+            h = (h > 1) ? (h / 2) : (1);
+        }
+        qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        free(pages_data[page]);
+    }
+
+    free(pages_data);
+    free(pages);
+
+    return true;
+}
@@ -84,6 +84,11 @@ class bordered_texture_atlas
     unsigned result_page_width;
     unsigned *result_page_height;
     
+    // Canonical textures grouped by result page: textures of page N are
+    // result_page_textures[result_page_first_texture[N] .. result_page_first_texture[N + 1])
+    unsigned long *result_page_first_texture;
+    unsigned long *result_page_textures;
+    
     // Original data
     unsigned long number_original_pages;
     const tr4_textile32_t *original_pages;
@@ -106,6 +111,29 @@ class bordered_texture_atlas
     /*! Lays out the texture data and switches the atlas to laid out mode. */
     void layOutTextures();
     
+    /*! Page being assembled by copyCanonicalTexturesJob. */
+    typedef struct page_assembly_s
+    {
+        const bordered_texture_atlas *atlas;
+        unsigned long page;
+        GLubyte *data;
+    } page_assembly_t;
+    
+    /*! Copies one canonical texture with its border into the result page data. */
+    void copyCanonicalTexture(GLubyte *data, const canonical_object_texture &canonical) const;
+    
+    /*! Job function for Jobs_ParallelFor over textures of one result page. */
+    static void copyCanonicalTexturesJob(void *data, uint32_t first, uint32_t last);
+    
+    /*! Builds RGBA data of a result page; data must hold a full width x width page. */
+    void assemblePage(unsigned long page, GLubyte *data) const;
+    
+    /*! Block compresses an assembled page with all its mip levels. */
+    void encodePage(unsigned long page, int format, uint8_t *data, GLubyte *rgba, GLubyte *mip_rgba) const;
+    
+    /*! Hash of the tiles placement; compressed pages cache is valid only for the same one. */
+    uint64_t getLayoutHash() const;
+    
     /*! For sorting: Compares two different textures and sorts them by size. */
     static int compareCanonicalTextureSizes(const void *parameter1, const void *parameter2);
     
@@ -181,6 +209,15 @@ public:
      * @param additionalTextureNames How many texture names to create in addition to the needed ones.
      */
     void createTextures(GLuint *textureNames);
+    
+    /*!
+     * Same as createTextures, but pages are uploaded block compressed (BC1 or
+     * BC3, by page alpha) with all mip levels made on CPU. Compressed pages
+     * are read from cache_name file if it was made for the same level_hash
+     * and layout, otherwise they are encoded and written there.
+     * @result false if driver has no S3TC support; nothing is created then.
+     */
+    bool createCompressedTextures(GLuint *textureNames, const char *cache_name, uint64_t level_hash);
 
 };
 
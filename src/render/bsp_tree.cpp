@@ -52,6 +52,10 @@ void CDynamicBSP::AddBSPPolygon(struct bsp_node_s *leaf, struct polygon_s *p)
     bp->texture_index  = p->texture_index;
     bp->transparency   = p->transparency;
     bp->vertex_count   = p->vertex_count;
+    bp->anim_id        = (m_anim_seq) ? (0) : (p->anim_id);
+    bp->frame_offset   = p->frame_offset;
+    bp->owner          = m_owner;
+    m_anim_polygons_count += (bp->anim_id > 0) ? (1) : (0);
 
     bp->indexes        = (GLuint*)(m_tree_buffer + m_tree_allocated);
     m_tree_allocated  += p->vertex_count * sizeof(GLint);
@@ -192,8 +196,11 @@ CDynamicBSP::CDynamicBSP(uint32_t size)
     m_input_polygons = 0;
     m_added_polygons = 0;
 
-    m_vbo = 0;
     m_anim_seq = NULL;
+    m_owner = 0;
+    m_anim_polygons = NULL;
+    m_anim_tex_coords = NULL;
+    m_anim_polygons_count = 0;
     m_realloc_state = 0;
     m_root = this->CreateBSPNode();
 }
@@ -201,12 +208,6 @@ CDynamicBSP::CDynamicBSP(uint32_t size)
 
 CDynamicBSP::~CDynamicBSP()
 {
-    if(m_vbo != 0)
-    {
-        qglDeleteBuffersARB(1, &m_vbo);
-        m_vbo = 0;
-    }
-
     if(m_tree_buffer)
     {
         free(m_tree_buffer);
@@ -228,14 +229,27 @@ CDynamicBSP::~CDynamicBSP()
     }
     m_vertex_buffer_size = 0;
 
+    if(m_anim_polygons)
+    {
+        free(m_anim_polygons);
+        m_anim_polygons = NULL;
+    }
+    if(m_anim_tex_coords)
+    {
+        free(m_anim_tex_coords);
+        m_anim_tex_coords = NULL;
+    }
+    m_anim_polygons_count = 0;
+
     m_realloc_state = 0;
     m_anim_seq = NULL;
     m_root = NULL;
 }
 
 
-void CDynamicBSP::AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f)
+void CDynamicBSP::AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f, uint16_t owner)
 {
+    m_owner = owner;
     for( ; p && (!m_realloc_state); p = p->next)
     {
         m_temp_allocated = 0;
@@ -269,7 +283,7 @@ void CDynamicBSP::AddNewPolygonList(struct polygon_s *p, float transform[16], st
 
         if(visible)
         {
-            if(p->anim_id > 0)
+            if((p->anim_id > 0) && m_anim_seq)
             {
                 anim_seq_p seq = m_anim_seq + p->anim_id - 1;
                 uint16_t frame = (seq->current_frame + p->frame_offset) % seq->frames_count;
@@ -307,11 +321,6 @@ void CDynamicBSP::AddNewPolygonList(struct polygon_s *p, float transform[16], st
 
 void CDynamicBSP::Reset(struct anim_seq_s *seq)
 {
-    if(m_vbo == 0)
-    {
-        qglGenBuffersARB(1, &m_vbo);
-    }
-
     switch(m_realloc_state)
     {
         case NEED_REALLOC_TREE_BUFF:
@@ -355,6 +364,7 @@ void CDynamicBSP::Reset(struct anim_seq_s *seq)
     };
 
     m_anim_seq = seq;
+    m_anim_polygons_count = 0;
     m_temp_allocated = 0;
     m_tree_allocated = 0;
     m_vertex_allocated = 0;
@@ -363,3 +373,294 @@ void CDynamicBSP::Reset(struct anim_seq_s *seq)
     m_added_polygons = 0;
     m_root = this->CreateBSPNode();
 }
+
+
+static void BSP_CollectAnimPolygons(struct bsp_node_s *root, bsp_polygon_p **out)
+{
+    for(bsp_polygon_p p = root->polygons_front; p; p = p->next)
+    {
+        if(p->anim_id > 0)
+        {
+            *((*out)++) = p;
+        }
+    }
+    for(bsp_polygon_p p = root->polygons_back; p; p = p->next)
+    {
+        if(p->anim_id > 0)
+        {
+            *((*out)++) = p;
+        }
+    }
+    if(root->front)
+    {
+        BSP_CollectAnimPolygons(root->front, out);
+    }
+    if(root->back)
+    {
+        BSP_CollectAnimPolygons(root->back, out);
+    }
+}
+
+
+void CDynamicBSP::Freeze()
+{
+    if(m_temp_buffer)
+    {
+        free(m_temp_buffer);
+        m_temp_buffer = NULL;
+    }
+    m_temp_buffer_size = 0;
+    m_temp_allocated = 0;
+
+    if(m_vertex_allocated > 0)
+    {
+        vertex_p new_buffer = (vertex_p)realloc(m_vertex_buffer, m_vertex_allocated * sizeof(vertex_t));
+        if(new_buffer != NULL)
+        {
+            m_vertex_buffer = new_buffer;
+            m_vertex_buffer_size = m_vertex_allocated;
+        }
+    }
+
+    if(m_anim_polygons_count > 0)
+    {
+        bsp_polygon_p *out;
+        uint32_t coords_count = 0;
+        m_anim_polygons = (bsp_polygon_p*)malloc(m_anim_polygons_count * sizeof(bsp_polygon_p));
+        out = m_anim_polygons;
+        BSP_CollectAnimPolygons(m_root, &out);
+        for(uint32_t i = 0; i < m_anim_polygons_count; i++)
+        {
+            coords_count += m_anim_polygons[i]->vertex_count;
+        }
+
+        GLfloat *uv = m_anim_tex_coords = (GLfloat*)malloc(coords_count * sizeof(GLfloat [2]));
+        for(uint32_t i = 0; i < m_anim_polygons_count; i++)
+        {
+            bsp_polygon_p p = m_anim_polygons[i];
+            for(uint16_t j = 0; j < p->vertex_count; j++, uv += 2)
+            {
+                uv[0] = m_vertex_buffer[p->indexes[j]].tex_coord[0];
+                uv[1] = m_vertex_buffer[p->indexes[j]].tex_coord[1];
+            }
+        }
+    }
+}
+
+
+void CDynamicBSP::UpdateAnimTextures(struct anim_seq_s *seq)
+{
+    GLfloat *uv = m_anim_tex_coords;
+    for(uint32_t i = 0; i < m_anim_polygons_count; i++)
+    {
+        bsp_polygon_p p = m_anim_polygons[i];
+        anim_seq_p s = seq + p->anim_id - 1;
+        uint16_t frame = (s->current_frame + p->frame_offset) % s->frames_count;
+        tex_frame_p tf = s->frames + frame;
+        p->texture_index = tf->texture_index;
+        for(uint16_t j = 0; j < p->vertex_count; j++, uv += 2)
+        {
+            ApplyAnimTextureTransformation(m_vertex_buffer[p->indexes[j]].tex_coord, uv, tf);
+        }
+    }
+}
+
+
+CSortedPolygonList::CSortedPolygonList(uint32_t size)
+{
+    size = (size < 256)?(256):(size);
+
+    m_vertex_buffer = (vertex_p)malloc(4 * size * sizeof(vertex_t));
+    m_indexes = (GLuint*)malloc(4 * size * sizeof(GLuint));
+    m_vertex_buffer_size = 4 * size;
+    m_vertex_allocated = 0;
+    for(uint32_t i = 0; i < m_vertex_buffer_size; i++)
+    {
+        m_indexes[i] = i;
+    }
+
+    m_polygons = (bsp_polygon_p)malloc(size * sizeof(bsp_polygon_t));
+    m_dist = (float*)malloc(size * sizeof(float));
+    m_sort[0] = (uint64_t*)malloc(size * sizeof(uint64_t));
+    m_sort[1] = (uint64_t*)malloc(size * sizeof(uint64_t));
+    m_polygons_size = size;
+    m_polygons_count = 0;
+
+    m_anim_seq = NULL;
+    vec3_set_zero(m_view_pos);
+}
+
+
+CSortedPolygonList::~CSortedPolygonList()
+{
+    free(m_vertex_buffer);
+    m_vertex_buffer = NULL;
+    free(m_indexes);
+    m_indexes = NULL;
+    m_vertex_buffer_size = 0;
+    m_vertex_allocated = 0;
+
+    free(m_polygons);
+    m_polygons = NULL;
+    free(m_dist);
+    m_dist = NULL;
+    free(m_sort[0]);
+    m_sort[0] = NULL;
+    free(m_sort[1]);
+    m_sort[1] = NULL;
+    m_polygons_size = 0;
+    m_polygons_count = 0;
+}
+
+
+void CSortedPolygonList::Grow(uint32_t vertex_count)
+{
+    if(m_vertex_allocated + vertex_count > m_vertex_buffer_size)
+    {
+        uint32_t new_size = m_vertex_buffer_size * 3 / 2 + vertex_count;
+        m_vertex_buffer = (vertex_p)realloc(m_vertex_buffer, new_size * sizeof(vertex_t));
+        m_indexes = (GLuint*)realloc(m_indexes, new_size * sizeof(GLuint));
+        for(uint32_t i = m_vertex_buffer_size; i < new_size; i++)
+        {
+            m_indexes[i] = i;
+        }
+        m_vertex_buffer_size = new_size;
+    }
+
+    if(m_polygons_count >= m_polygons_size)
+    {
+        uint32_t new_size = m_polygons_size * 3 / 2;
+        m_polygons = (bsp_polygon_p)realloc(m_polygons, new_size * sizeof(bsp_polygon_t));
+        m_dist = (float*)realloc(m_dist, new_size * sizeof(float));
+        m_sort[0] = (uint64_t*)realloc(m_sort[0], new_size * sizeof(uint64_t));
+        m_sort[1] = (uint64_t*)realloc(m_sort[1], new_size * sizeof(uint64_t));
+        m_polygons_size = new_size;
+    }
+}
+
+
+void CSortedPolygonList::Reset(struct anim_seq_s *seq, const float view_pos[3])
+{
+    m_anim_seq = seq;
+    vec3_copy(m_view_pos, view_pos);
+    m_vertex_allocated = 0;
+    m_polygons_count = 0;
+}
+
+
+void CSortedPolygonList::AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f)
+{
+    for( ; p; p = p->next)
+    {
+        polygon_t np;
+        vertex_p src_v, dst_v;
+        bool visible = (f == NULL);
+
+        this->Grow(p->vertex_count);
+        np.vertices = m_vertex_buffer + m_vertex_allocated;
+        np.vertex_count = p->vertex_count;
+        Mat4_vec3_rot_macro(np.plane, transform, p->plane);
+        for(uint16_t i = 0; i < p->vertex_count; i++)
+        {
+            Mat4_vec3_mul_macro(np.vertices[i].position, transform, p->vertices[i].position);
+        }
+        np.plane[3] = -vec3_dot(np.plane, np.vertices[0].position);
+
+        for(frustum_p ff = f; (!visible) && ff; ff = ff->next)
+        {
+            visible = Frustum_IsPolyVisible(&np, ff, false);
+        }
+
+        if(visible)
+        {
+            bsp_polygon_p bp = m_polygons + m_polygons_count;
+            float centre[3] = {0.0f, 0.0f, 0.0f};
+            tex_frame_p tf = NULL;
+
+            bp->vertex_count  = p->vertex_count;
+            bp->indexes       = NULL;                                           // set by Sort(): buffers may move
+            bp->texture_index = p->texture_index;
+            bp->transparency  = p->transparency;
+            bp->anim_id       = 0;
+            bp->frame_offset  = 0;
+            bp->owner         = 0;
+            bp->next          = NULL;
+            if((p->anim_id > 0) && m_anim_seq)
+            {
+                anim_seq_p seq = m_anim_seq + p->anim_id - 1;
+                uint16_t frame = (seq->current_frame + p->frame_offset) % seq->frames_count;
+                tf = seq->frames + frame;
+                bp->texture_index = tf->texture_index;
+            }
+
+            for(uint16_t i = 0; i < p->vertex_count; i++)
+            {
+                src_v = p->vertices + i;
+                dst_v = np.vertices + i;
+                Mat4_vec3_rot_macro(dst_v->normal, transform, src_v->normal);
+                vec4_copy(dst_v->color, src_v->color);
+                if(tf)
+                {
+                    ApplyAnimTextureTransformation(dst_v->tex_coord, src_v->tex_coord, tf);
+                }
+                else
+                {
+                    dst_v->tex_coord[0] = src_v->tex_coord[0];
+                    dst_v->tex_coord[1] = src_v->tex_coord[1];
+                }
+                vec3_add(centre, centre, dst_v->position);
+            }
+            vec3_mul_scalar(centre, centre, 1.0f / (float)p->vertex_count);
+            m_dist[m_polygons_count] = vec3_dist_sq(centre, m_view_pos);
+            m_vertex_allocated += p->vertex_count;
+            m_polygons_count++;
+        }
+    }
+}
+
+
+void CSortedPolygonList::Sort()
+{
+    uint32_t histogram[4][256];
+    uint32_t first = 0;
+
+    memset(histogram, 0x00, sizeof(histogram));
+    for(uint32_t i = 0; i < m_polygons_count; i++)
+    {
+        uint32_t key;
+        m_polygons[i].indexes = m_indexes + first;
+        first += m_polygons[i].vertex_count;
+
+        memcpy(&key, m_dist + i, sizeof(key));
+        key = ~key;                                                             // farthest first
+        m_sort[0][i] = ((uint64_t)key << 32) | i;
+        for(int d = 0; d < 4; d++)
+        {
+            histogram[d][(key >> (8 * d)) & 0xFF]++;
+        }
+    }
+
+    for(int d = 0; d < 4; d++)
+    {
+        uint32_t *h = histogram[d];
+        uint32_t offset = 0;
+        if(h[(uint32_t)(m_sort[0][0] >> (32 + 8 * d)) & 0xFF] == m_polygons_count)
+        {
+            continue;                                                           // all keys have the same digit
+        }
+        for(int i = 0; i < 256; i++)
+        {
+            uint32_t count = h[i];
+            h[i] = offset;
+            offset += count;
+        }
+        for(uint32_t i = 0; i < m_polygons_count; i++)
+        {
+            uint64_t v = m_sort[0][i];
+            m_sort[1][h[(uint32_t)(v >> (32 + 8 * d)) & 0xFF]++] = v;
+        }
+        uint64_t *t = m_sort[0];
+        m_sort[0] = m_sort[1];
+        m_sort[1] = t;
+    }
+}
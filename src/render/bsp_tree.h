@@ -16,6 +16,9 @@ typedef struct bsp_polygon_s
     GLuint                 *indexes;                                            // vertices indexes
     uint16_t                texture_index;                                      // texture index
     uint16_t                transparency;                                       // transparency information
+    uint16_t                anim_id;                                            // cached trees only: animated at draw time
+    uint16_t                frame_offset;                                       // anim texture frame offset
+    uint16_t                owner;                                              // static mesh index + 1, 0 for room mesh
     
     struct bsp_polygon_s   *next;                                               // polygon list (for BSP using)
 } bsp_polygon_t, *bsp_polygon_p;
@@ -33,6 +36,11 @@ typedef struct bsp_node_s
 } bsp_node_t, *bsp_node_p;
 
 
+/*
+ * Tree is rebuilt each frame from visible polygons, or built once (cached):
+ * Reset(NULL) keeps texture animation of polygons for UpdateAnimTextures()
+ * and Freeze() drops build time buffers.
+ */
 class CDynamicBSP
 {
     uint8_t             *m_tree_buffer;
@@ -49,6 +57,11 @@ class CDynamicBSP
     
     uint32_t             m_realloc_state;
     struct anim_seq_s   *m_anim_seq;
+    uint16_t             m_owner;
+
+    struct bsp_polygon_s **m_anim_polygons;
+    GLfloat             *m_anim_tex_coords;                                     // source coords of animated polygons vertices
+    uint32_t             m_anim_polygons_count;
     
     uint32_t             m_input_polygons;
     uint32_t             m_added_polygons;
@@ -60,13 +73,19 @@ class CDynamicBSP
     
 public:
     struct bsp_node_s   *m_root;
-    GLuint m_vbo;
     
     CDynamicBSP(uint32_t size);
    ~CDynamicBSP();
    
-    void AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f);
+    void AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f, uint16_t owner = 0);
     void Reset(struct anim_seq_s *seq);
+    void Freeze();
+    void UpdateAnimTextures(struct anim_seq_s *seq);
+
+    bool IsCompleted()
+    {
+        return m_realloc_state == 0;
+    }
     
     struct vertex_s *GetVertexArray()
     {
@@ -90,4 +109,63 @@ public:
 };
 
 
+/*
+ * Transparency polygons of moving objects, sorted back to front by squared
+ * distance of polygon centre to the view point; polygons are not split.
+ * Positive floats keep order as unsigned integers, so keys are sorted by
+ * LSD radix sort in four 8 bit passes (trivial passes are skipped).
+ */
+class CSortedPolygonList
+{
+    struct vertex_s     *m_vertex_buffer;
+    GLuint              *m_indexes;                                             // identity: polygons vertices are sequential
+    uint32_t             m_vertex_buffer_size;
+    uint32_t             m_vertex_allocated;
+
+    struct bsp_polygon_s *m_polygons;
+    float               *m_dist;
+    uint64_t            *m_sort[2];                                             // key << 32 | polygon index
+    uint32_t             m_polygons_size;
+    uint32_t             m_polygons_count;
+
+    struct anim_seq_s   *m_anim_seq;
+    float                m_view_pos[3];
+
+    void Grow(uint32_t vertex_count);
+
+public:
+    CSortedPolygonList(uint32_t size);
+   ~CSortedPolygonList();
+
+    void Reset(struct anim_seq_s *seq, const float view_pos[3]);
+    void AddNewPolygonList(struct polygon_s *p, float transform[16], struct frustum_s *f);
+    void Sort();
+
+    uint32_t GetCount()
+    {
+        return m_polygons_count;
+    }
+
+    struct bsp_polygon_s *GetPolygon(uint32_t i)                                // after Sort(), farthest first
+    {
+        return m_polygons + (uint32_t)m_sort[0][i];
+    }
+
+    float GetDistance(uint32_t i)                                               // squared
+    {
+        return m_dist[(uint32_t)m_sort[0][i]];
+    }
+
+    struct vertex_s *GetVertexArray()
+    {
+        return m_vertex_buffer;
+    }
+
+    uint32_t GetActiveVertexCount()
+    {
+        return m_vertex_allocated;
+    }
+};
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "../core/gl_util.h"
+#include "../core/vmath.h"
+#include "../mesh.h"
+#include "../room.h"
+#include "shader_description.h"
+#include "draw_packets.h"
+
+#define DRAW_PACKETS_DEFAULT_SIZE       (4096)
+#define DRAW_MATRICES_DEFAULT_SIZE      (1024)
+#define DRAW_PARAMS_DEFAULT_SIZE        (256)
+#define DRAW_SKIN_POOL_DEFAULT_SIZE     (16 * 1024)
+
+
+static void *Packets_Grow(void *buf, uint32_t *size, uint32_t need, size_t elem_size)
+{
+    if(need > *size)
+    {
+        uint32_t new_size = (*size > 0) ? (*size) : (1);
+        while(new_size < need)
+        {
+            new_size *= 2;
+        }
+        buf = realloc(buf, new_size * elem_size);
+        *size = new_size;
+    }
+    return buf;
+}
+
+
+CDrawPacketList::CDrawPacketList():
+m_packets(NULL),
+m_keys(NULL),
+m_keys_tmp(NULL),
+m_packets_size(0),
+m_packets_count(0),
+m_matrices(NULL),
+m_matrices_size(0),
+m_matrices_count(0),
+m_tints(NULL),
+m_tints_size(0),
+m_tints_count(0),
+m_lights(NULL),
+m_lights_size(0),
+m_lights_count(0),
+m_skin_pool(NULL),
+m_skin_pool_size(0),
+m_skin_pool_used(0),
+m_anim_meshes(NULL),
+m_anim_meshes_size(0),
+m_anim_meshes_count(0),
+m_anim_on_gpu(false),
+m_program_binds(0),
+m_texture_binds(0),
+m_buffer_binds(0),
+m_draw_calls(0)
+{
+    m_packets_size = DRAW_PACKETS_DEFAULT_SIZE;
+    m_packets  = (draw_packet_p)malloc(m_packets_size * sizeof(draw_packet_t));
+    m_keys     = (draw_packet_key_p)malloc(m_packets_size * sizeof(draw_packet_key_t));
+    m_keys_tmp = (draw_packet_key_p)malloc(m_packets_size * sizeof(draw_packet_key_t));
+
+    m_matrices_size = DRAW_MATRICES_DEFAULT_SIZE;
+    m_matrices = (GLfloat*)malloc(m_matrices_size * 16 * sizeof(GLfloat));
+
+    m_tints_size = DRAW_PARAMS_DEFAULT_SIZE;
+    m_tints = (GLfloat*)malloc(m_tints_size * 4 * sizeof(GLfloat));
+
+    m_lights_size = DRAW_PARAMS_DEFAULT_SIZE;
+    m_lights = (draw_light_block_p)malloc(m_lights_size * sizeof(draw_light_block_t));
+
+    m_skin_pool_size = DRAW_SKIN_POOL_DEFAULT_SIZE;
+    m_skin_pool = (GLfloat*)malloc(m_skin_pool_size * sizeof(GLfloat));
+
+    m_anim_meshes_size = DRAW_PARAMS_DEFAULT_SIZE;
+    m_anim_meshes = (base_mesh_p*)malloc(m_anim_meshes_size * sizeof(base_mesh_p));
+}
+
+
+CDrawPacketList::~CDrawPacketList()
+{
+    free(m_packets);
+    m_packets = NULL;
+    free(m_keys);
+    m_keys = NULL;
+    free(m_keys_tmp);
+    m_keys_tmp = NULL;
+    free(m_matrices);
+    m_matrices = NULL;
+    free(m_tints);
+    m_tints = NULL;
+    free(m_lights);
+    m_lights = NULL;
+    free(m_skin_pool);
+    m_skin_pool = NULL;
+    free(m_anim_meshes);
+    m_anim_meshes = NULL;
+}
+
+
+void CDrawPacketList::Reset()
+{
+    m_packets_count = 0;
+    m_matrices_count = 0;
+    m_tints_count = 0;
+    m_lights_count = 0;
+    m_skin_pool_used = 0;
+    m_anim_meshes_count = 0;
+    m_program_binds = 0;
+    m_texture_binds = 0;
+    m_buffer_binds = 0;
+    m_draw_calls = 0;
+}
+
+
+uint32_t CDrawPacketList::AddMatrix(const float matrix[16])
+{
+    m_matrices = (GLfloat*)Packets_Grow(m_matrices, &m_matrices_size, m_matrices_count + 1, 16 * sizeof(GLfloat));
+    memcpy(m_matrices + 16 * m_matrices_count, matrix, 16 * sizeof(GLfloat));
+    return m_matrices_count++;
+}
+
+
+uint32_t CDrawPacketList::AddMatrices(const float mv[16], const float mvp[16])
+{
+    uint32_t ret = this->AddMatrix(mv);
+    this->AddMatrix(mvp);
+    return ret;
+}
+
+
+uint32_t CDrawPacketList::AddSkinMatrices(const float mv[16], const float parent_mv[16], const float mvp[16], const float parent_mvp[16])
+{
+    uint32_t ret = this->AddMatrix(mv);
+    this->AddMatrix(parent_mv);
+    this->AddMatrix(mvp);
+    this->AddMatrix(parent_mvp);
+    return ret;
+}
+
+
+uint32_t CDrawPacketList::AddTint(const GLfloat tint[4])
+{
+    m_tints = (GLfloat*)Packets_Grow(m_tints, &m_tints_size, m_tints_count + 1, 4 * sizeof(GLfloat));
+    vec4_copy(m_tints + 4 * m_tints_count, tint);
+    return m_tints_count++;
+}
+
+
+draw_light_block_p CDrawPacketList::AddLightBlock(uint32_t *index)
+{
+    m_lights = (draw_light_block_p)Packets_Grow(m_lights, &m_lights_size, m_lights_count + 1, sizeof(draw_light_block_t));
+    *index = m_lights_count;
+    return m_lights + m_lights_count++;
+}
+
+
+static int Packets_LightBlocksEqual(const draw_light_block_t *a, const draw_light_block_t *b)
+{
+    uint32_t n = a->count;
+    return (n == b->count) &&
+           (0 == memcmp(a->ambient, b->ambient, sizeof(a->ambient))) &&
+           (0 == memcmp(a->positions, b->positions, 3 * n * sizeof(GLfloat))) &&
+           (0 == memcmp(a->colors, b->colors, 4 * n * sizeof(GLfloat))) &&
+           (0 == memcmp(a->inner_radiuses, b->inner_radiuses, n * sizeof(GLfloat))) &&
+           (0 == memcmp(a->outer_radiuses, b->outer_radiuses, n * sizeof(GLfloat)));
+}
+
+
+/*
+ * Drops the last added light block if a recent one is the same (entities
+ * in one room without own lights), so their packets share params index
+ * and can be drawn instanced. Returns index to use.
+ */
+uint32_t CDrawPacketList::MergeLightBlock(uint32_t index)
+{
+    if(index + 1 == m_lights_count)
+    {
+        uint32_t first = (index > 16) ? (index - 16) : (0);
+        for(uint32_t i = index; i > first; i--)
+        {
+            if(Packets_LightBlocksEqual(m_lights + index, m_lights + i - 1))
+            {
+                m_lights_count--;
+                return i - 1;
+            }
+        }
+    }
+    return index;
+}
+
+
+/*
+ * Returned pointer is valid up to the next allocation; packets keep offset.
+ */
+GLfloat *CDrawPacketList::AllocSkinVertices(uint32_t vertex_count, uint32_t *offset)
+{
+    uint32_t size = 2 * 3 * vertex_count;                                       // positions, then normals
+    m_skin_pool = (GLfloat*)Packets_Grow(m_skin_pool, &m_skin_pool_size, m_skin_pool_used + size, sizeof(GLfloat));
+    *offset = m_skin_pool_used;
+    m_skin_pool_used += size;
+    return m_skin_pool + *offset;
+}
+
+
+void CDrawPacketList::AddAnimMesh(struct base_mesh_s *mesh)
+{
+    for(uint32_t i = 0; i < m_anim_meshes_count; i++)
+    {
+        if(m_anim_meshes[i] == mesh)
+        {
+            return;
+        }
+    }
+    m_anim_meshes = (base_mesh_p*)Packets_Grow(m_anim_meshes, &m_anim_meshes_size, m_anim_meshes_count + 1, sizeof(base_mesh_p));
+    m_anim_meshes[m_anim_meshes_count++] = mesh;
+}
+
+
+draw_packet_p CDrawPacketList::AddPacket(const struct shader_description *shader, uint16_t shader_type, GLuint texture_index)
+{
+    if(m_packets_count >= m_packets_size)
+    {
+        uint32_t size = m_packets_size;
+        m_packets = (draw_packet_p)Packets_Grow(m_packets, &size, m_packets_count + 1, sizeof(draw_packet_t));
+        m_keys = (draw_packet_key_p)realloc(m_keys, size * sizeof(draw_packet_key_t));
+        m_keys_tmp = (draw_packet_key_p)realloc(m_keys_tmp, size * sizeof(draw_packet_key_t));
+        m_packets_size = size;
+    }
+
+    draw_packet_p p = m_packets + m_packets_count;
+    p->shader = shader;
+    p->shader_type = shader_type;
+    p->texture_index = texture_index;
+    m_keys[m_packets_count].index = m_packets_count;
+    m_packets_count++;
+
+    return p;
+}
+
+
+static inline uint64_t Packets_MakeKey(draw_packet_p p)
+{
+    return ((uint64_t)(p->shader->program & 0xFF) << 56) |
+           ((uint64_t)(p->texture_index & 0xFFFF) << 40) |
+           ((uint64_t)(p->vbo & 0xFFFF) << 24) |
+           ((uint64_t)(p->params_index & 0xFFF) << 12) |
+           ((uint64_t)(p->matrix_index & 0xFFF));
+}
+
+
+draw_packet_p CDrawPacketList::AddFace(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh, struct mesh_face_s *face,
+                                       uint16_t flags, uint32_t matrix_index, uint32_t params_index, uint32_t skin_offset)
+{
+    draw_packet_p p = this->AddPacket(shader, shader_type, face->texture_index);
+    p->mesh = mesh;
+    p->vbo = (flags & DRAW_PACKET_ANIMATED) ? (mesh->vbo_animated_vertex_array) : (mesh->vbo_vertex_array);
+    p->ibo = 0;
+    p->vbo_skin = 0;
+    p->elements_count = face->elements_count;
+    p->elements = face->elements;
+    p->matrix_index = matrix_index;
+    p->params_index = params_index;
+    p->skin_offset = skin_offset;
+    p->flags = flags;
+    m_keys[m_packets_count - 1].key = Packets_MakeKey(p);
+    return p;
+}
+
+
+void CDrawPacketList::AddAnimatedFaces(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh,
+                                       uint32_t matrix_index, uint32_t params_index)
+{
+    if(mesh->animated_vertex_count && mesh->vbo_animated_vertex_array)
+    {
+        const unlit_shader_description *anim_shader = ((const unlit_shader_description*)shader)->anim_variant;
+        mesh_face_p face = mesh->animated_faces;
+        uint16_t flags = DRAW_PACKET_ANIMATED;
+        if(m_anim_on_gpu && anim_shader && mesh->vbo_animated_params_array)
+        {
+            shader = anim_shader;
+            flags |= DRAW_PACKET_ANIMATED_GPU;
+        }
+        else
+        {
+            this->AddAnimMesh(mesh);
+        }
+        for(uint32_t i = 0; i < mesh->animated_faces_count; i++, face++)
+        {
+            this->AddFace(shader, shader_type, mesh, face, flags, matrix_index, params_index, DRAW_PACKET_NO_SKIN);
+        }
+    }
+}
+
+
+void CDrawPacketList::AddMesh(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh,
+                              uint32_t matrix_index, uint32_t params_index, uint32_t skin_offset)
+{
+    this->AddAnimatedFaces(shader, shader_type, mesh, matrix_index, params_index);
+
+    if((mesh->vertex_count > 0) && mesh->vbo_vertex_array)
+    {
+        mesh_face_p face = mesh->faces;
+        for(uint32_t i = 0; i < mesh->faces_count; i++, face++)
+        {
+            this->AddFace(shader, shader_type, mesh, face, 0x0000, matrix_index, params_index, skin_offset);
+        }
+    }
+}
+
+
+/*
+ * Skin mesh static faces, transformed by skinning shader; animated faces
+ * are not skinned and are added by AddAnimatedFaces with the bone matrices.
+ */
+void CDrawPacketList::AddSkinnedMesh(const struct shader_description *shader, struct base_mesh_s *mesh, GLuint vbo_skin,
+                                     uint32_t matrix_index, uint32_t params_index)
+{
+    if((mesh->vertex_count > 0) && mesh->vbo_vertex_array)
+    {
+        mesh_face_p face = mesh->faces;
+        for(uint32_t i = 0; i < mesh->faces_count; i++, face++)
+        {
+            draw_packet_p p = this->AddFace(shader, DRAW_PACKET_SHADER_LIT_SKINNED, mesh, face, 0x0000, matrix_index, params_index, DRAW_PACKET_NO_SKIN);
+            p->vbo_skin = vbo_skin;
+        }
+    }
+}
+
+
+void CDrawPacketList::AddBatchPages(const struct shader_description *shader, uint16_t shader_type, struct room_batch_s *batch,
+                                    uint16_t first, uint16_t count, uint32_t matrix_index, uint32_t params_index)
+{
+    room_batch_page_p page = batch->pages + first;
+    for(uint16_t i = 0; i < count; i++, page++)
+    {
+        draw_packet_p p = this->AddPacket(shader, shader_type, page->texture_index);
+        p->mesh = NULL;
+        p->vbo = batch->vbo_vertex_array;
+        p->ibo = batch->vbo_index_array;
+        p->vbo_skin = 0;
+        p->elements_count = page->elements_count;
+        p->elements = (const GLuint*)(uintptr_t)(page->elements_offset * sizeof(GLuint));    // offset in ibo
+        p->matrix_index = matrix_index;
+        p->params_index = params_index;
+        p->skin_offset = DRAW_PACKET_NO_SKIN;
+        p->flags = 0x0000;
+        m_keys[m_packets_count - 1].key = Packets_MakeKey(p);
+    }
+}
+
+
+/*
+ * Number of sorted packets from first on, which differ by matrix only
+ * (the same mesh face, shader and params): they may be drawn instanced.
+ */
+uint32_t CDrawPacketList::GetInstancesCount(uint32_t first)
+{
+    draw_packet_p p = m_packets + m_keys[first].index;
+    uint32_t i = first + 1;
+
+    for(; i < m_packets_count; i++)
+    {
+        draw_packet_p n = m_packets + m_keys[i].index;
+        if((n->shader != p->shader) || (n->mesh != p->mesh) || (n->vbo != p->vbo) || (n->ibo != p->ibo) ||
+           (n->vbo_skin != p->vbo_skin) || (n->texture_index != p->texture_index) || (n->elements != p->elements) ||
+           (n->elements_count != p->elements_count) || (n->params_index != p->params_index) ||
+           (n->skin_offset != p->skin_offset) || (n->shader_type != p->shader_type) || (n->flags != p->flags))
+        {
+            break;
+        }
+    }
+
+    return i - first;
+}
+
+
+/*
+ * LSD radix sort, 8 bits per pass; passes where all keys share the digit
+ * are skipped (typically high shader bits and unused param bits).
+ */
+void CDrawPacketList::Sort()
+{
+    uint32_t hist[8][256];
+    draw_packet_key_p src = m_keys;
+    draw_packet_key_p dst = m_keys_tmp;
+
+    if(m_packets_count < 2)
+    {
+        return;
+    }
+
+    memset(hist, 0, sizeof(hist));
+    for(uint32_t i = 0; i < m_packets_count; i++)
+    {
+        uint64_t key = src[i].key;
+        for(int pass = 0; pass < 8; pass++, key >>= 8)
+        {
+            hist[pass][key & 0xFF]++;
+        }
+    }
+
+    for(int pass = 0; pass < 8; pass++)
+    {
+        uint32_t *h = hist[pass];
+        const int shift = 8 * pass;
+        uint32_t sum = 0;
+
+        if(h[(src[0].key >> shift) & 0xFF] == m_packets_count)
+        {
+            continue;
+        }
+
+        for(int i = 0; i < 256; i++)
+        {
+            uint32_t t = h[i];
+            h[i] = sum;
+            sum += t;
+        }
+
+        for(uint32_t i = 0; i < m_packets_count; i++)
+        {
+            dst[h[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        draw_packet_key_p t = src;
+        src = dst;
+        dst = t;
+    }
+
+    m_keys = src;
+    m_keys_tmp = dst;
+}
@@ -0,0 +1,185 @@
+#ifndef DRAW_PACKETS_H
+#define DRAW_PACKETS_H
+
+#include <stdint.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "shader_manager.h"
+
+struct base_mesh_s;
+struct mesh_face_s;
+struct room_batch_s;
+struct shader_description;
+
+#define DRAW_PACKET_SHADER_TINTED       (0)                                     // unlit_tinted_shader_description: rooms, static meshes
+#define DRAW_PACKET_SHADER_LIT          (1)                                     // lit_shader_description: entities
+#define DRAW_PACKET_SHADER_LIT_SKINNED  (2)                                     // lit_skinned_shader_description: TR4+ skin meshes
+
+#define DRAW_PACKET_ANIMATED            (0x0001)                                // face from mesh->animated_faces
+#define DRAW_PACKET_ANIMATED_GPU        (0x0002)                                // tex coords are evaluated by shader anim_variant
+#define DRAW_PACKET_NO_SKIN             (0xFFFFFFFF)
+
+/*
+ * One opaque draw call: shader, texture page, vertex source and elements
+ * range. Matrices, tints and lights are stored by index in the list pools,
+ * so packet stays small and sorting moves only keys.
+ */
+typedef struct draw_packet_s
+{
+    const struct shader_description    *shader;
+    struct base_mesh_s                 *mesh;                                   // NULL for room batch pages
+    GLuint                              vbo;
+    GLuint                              ibo;                                    // 0: client side elements
+    GLuint                              vbo_skin;                               // skin_vertex_s positions, normals, bones
+    GLuint                              texture_index;
+    GLuint                              elements_count;
+    const GLuint                       *elements;                               // pointer or offset in ibo
+    uint32_t                            matrix_index;                           // TINTED: mvp; LIT: mv, mvp; SKINNED: mv[2], mvp[2]
+    uint32_t                            params_index;                           // TINTED: tint; LIT: light block
+    uint32_t                            skin_offset;                            // skinned vertices + normals in skin pool
+    uint16_t                            shader_type;
+    uint16_t                            flags;
+}draw_packet_t, *draw_packet_p;
+
+typedef struct draw_light_block_s
+{
+    GLfloat                             ambient[4];
+    GLfloat                             positions[3 * MAX_NUM_LIGHTS];
+    GLfloat                             colors[4 * MAX_NUM_LIGHTS];
+    GLfloat                             inner_radiuses[MAX_NUM_LIGHTS];
+    GLfloat                             outer_radiuses[MAX_NUM_LIGHTS];
+    uint32_t                            count;
+}draw_light_block_t, *draw_light_block_p;
+
+typedef struct draw_packet_key_s
+{
+    uint64_t                            key;
+    uint32_t                            index;
+}draw_packet_key_t, *draw_packet_key_p;
+
+
+/*
+ * Per frame opaque geometry list. Geometry is added in portal traversal
+ * order, then keys are radix sorted by state:
+ * shader | texture page | vertex buffer | params | matrix,
+ * so every shader and texture page is bound about once per frame.
+ * Key bits are used only for ordering, submission compares real states.
+ */
+class CDrawPacketList
+{
+    draw_packet_p        m_packets;
+    draw_packet_key_p    m_keys;
+    draw_packet_key_p    m_keys_tmp;
+    uint32_t             m_packets_size;
+    uint32_t             m_packets_count;
+
+    GLfloat             *m_matrices;                                            // float[16] each
+    uint32_t             m_matrices_size;
+    uint32_t             m_matrices_count;
+
+    GLfloat             *m_tints;                                               // float[4] each
+    uint32_t             m_tints_size;
+    uint32_t             m_tints_count;
+
+    draw_light_block_p   m_lights;
+    uint32_t             m_lights_size;
+    uint32_t             m_lights_count;
+
+    GLfloat             *m_skin_pool;
+    uint32_t             m_skin_pool_size;                                      // in floats
+    uint32_t             m_skin_pool_used;
+
+    struct base_mesh_s **m_anim_meshes;                                         // meshes with animated faces in the list
+    uint32_t             m_anim_meshes_size;
+    uint32_t             m_anim_meshes_count;
+    bool                 m_anim_on_gpu;
+
+    draw_packet_p AddPacket(const struct shader_description *shader, uint16_t shader_type, GLuint texture_index);
+    draw_packet_p AddFace(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh, struct mesh_face_s *face,
+                 uint16_t flags, uint32_t matrix_index, uint32_t params_index, uint32_t skin_offset);
+    void AddAnimMesh(struct base_mesh_s *mesh);
+
+public:
+    CDrawPacketList();
+   ~CDrawPacketList();
+
+    void Reset();
+    void Sort();
+
+    void SetAnimTexturesOnGPU(bool value)
+    {
+        m_anim_on_gpu = value;
+    }
+
+    uint32_t AddMatrix(const float matrix[16]);
+    uint32_t AddMatrices(const float mv[16], const float mvp[16]);
+    uint32_t AddSkinMatrices(const float mv[16], const float parent_mv[16], const float mvp[16], const float parent_mvp[16]);
+    uint32_t AddTint(const GLfloat tint[4]);
+    draw_light_block_p AddLightBlock(uint32_t *index);
+    uint32_t MergeLightBlock(uint32_t index);
+    GLfloat *AllocSkinVertices(uint32_t vertex_count, uint32_t *offset);
+    void AddMesh(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh,
+                 uint32_t matrix_index, uint32_t params_index, uint32_t skin_offset = DRAW_PACKET_NO_SKIN);
+    void AddSkinnedMesh(const struct shader_description *shader, struct base_mesh_s *mesh, GLuint vbo_skin,
+                        uint32_t matrix_index, uint32_t params_index);
+    void AddAnimatedFaces(const struct shader_description *shader, uint16_t shader_type, struct base_mesh_s *mesh,
+                          uint32_t matrix_index, uint32_t params_index);
+    void AddBatchPages(const struct shader_description *shader, uint16_t shader_type, struct room_batch_s *batch,
+                       uint16_t first, uint16_t count, uint32_t matrix_index, uint32_t params_index);
+
+    uint32_t GetPacketsCount()
+    {
+        return m_packets_count;
+    }
+
+    draw_packet_p GetSortedPacket(uint32_t i)
+    {
+        return m_packets + m_keys[i].index;
+    }
+
+    uint32_t GetInstancesCount(uint32_t first);
+
+    const GLfloat *GetMatrix(uint32_t index)
+    {
+        return m_matrices + 16 * index;
+    }
+
+    const GLfloat *GetTint(uint32_t index)
+    {
+        return m_tints + 4 * index;
+    }
+
+    const draw_light_block_t *GetLightBlock(uint32_t index)
+    {
+        return m_lights + index;
+    }
+
+    const GLfloat *GetSkinVertices(uint32_t offset)
+    {
+        return m_skin_pool + offset;
+    }
+
+    uint32_t GetSkinVerticesCount()                                             // in floats
+    {
+        return m_skin_pool_used;
+    }
+
+    uint32_t GetAnimMeshesCount()
+    {
+        return m_anim_meshes_count;
+    }
+
+    struct base_mesh_s *GetAnimMesh(uint32_t i)
+    {
+        return m_anim_meshes[i];
+    }
+
+    // submission statistics, filled by renderer
+    uint32_t             m_program_binds;
+    uint32_t             m_texture_binds;
+    uint32_t             m_buffer_binds;
+    uint32_t             m_draw_calls;
+};
+
+#endif
@@ -0,0 +1,335 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "../core/vmath.h"
+#include "../core/simd_vf4.h"
+#include "../core/polygon.h"
+#include "../core/obb.h"
+#include "../mesh.h"
+#include "render.h"
+#include "occlusion.h"
+
+
+#define OCCLUSION_MAX_VERTICES          (8)                                     // room polygons are quads and triangles
+#define OCCLUSION_MAX_CLIPPED           (OCCLUSION_MAX_VERTICES + 2)            // after near and far planes
+
+/*
+ * Clips polygon by GL near (z_sign = 1) or far (z_sign = -1) clip plane: GL
+ * doesn't draw clipped parts, so they must not occlude.
+ */
+static uint16_t Occlusion_ClipPolygon(float *out, const float *in, uint16_t vertex_count, float z_sign)
+{
+    uint16_t ret = 0;
+    for(uint16_t i = 0; i < vertex_count; i++)
+    {
+        const float *a = in + 4 * i;
+        const float *b = in + 4 * ((i + 1) % vertex_count);
+        float da = a[3] + z_sign * a[2];
+        float db = b[3] + z_sign * b[2];
+        if(da >= 0.0f)
+        {
+            vec4_copy(out + 4 * ret, a);
+            ret++;
+        }
+        if((da >= 0.0f) != (db >= 0.0f))
+        {
+            float t = da / (da - db);
+            float *r = out + 4 * ret;
+            r[0] = a[0] + t * (b[0] - a[0]);
+            r[1] = a[1] + t * (b[1] - a[1]);
+            r[2] = a[2] + t * (b[2] - a[2]);
+            r[3] = a[3] + t * (b[3] - a[3]);
+            ret++;
+        }
+    }
+    return ret;
+}
+
+
+COcclusionBuffer::COcclusionBuffer(uint32_t width, uint32_t height):
+m_width((width + 3) & ~3),
+m_height(height),
+m_depth(NULL),
+m_enabled(false),
+m_occluders(0)
+{
+    m_depth = (float*)calloc(m_width * m_height, sizeof(float));
+    Mat4_E_macro(m_view_proj);
+    m_tested[0] = m_tested[1] = 0;
+    m_culled[0] = m_culled[1] = 0;
+}
+
+
+COcclusionBuffer::~COcclusionBuffer()
+{
+    if(m_depth)
+    {
+        free(m_depth);
+        m_depth = NULL;
+    }
+}
+
+
+void COcclusionBuffer::Reset(const float view_proj[16], bool enabled)
+{
+    Mat4_Copy(m_view_proj, view_proj);
+    m_enabled = enabled && (m_depth != NULL);
+    m_occluders = 0;
+    m_tested[0] = m_tested[1] = 0;
+    m_culled[0] = m_culled[1] = 0;
+    if(m_enabled)
+    {
+        memset(m_depth, 0x00, m_width * m_height * sizeof(float));
+    }
+}
+
+
+void COcclusionBuffer::AddMesh(struct base_mesh_s *mesh, const float transform[16])
+{
+    float mvp[16];
+    float clip[2][4 * OCCLUSION_MAX_CLIPPED];
+    float screen[3 * OCCLUSION_MAX_CLIPPED];
+
+    if(!m_enabled || (mesh == NULL))
+    {
+        return;
+    }
+
+    Mat4_Mat4_mul(mvp, m_view_proj, transform);
+    polygon_p p = mesh->polygons;
+    for(uint32_t i = 0; i < mesh->polygons_count; i++, p++)
+    {
+        if((p->transparency != BM_OPAQUE) || (p->vertex_count < 3) || (p->vertex_count > OCCLUSION_MAX_VERTICES))
+        {
+            continue;
+        }
+
+        float *v = clip[0];
+        for(uint16_t j = 0; j < p->vertex_count; j++, v += 4)
+        {
+            const float *pos = p->vertices[j].position;
+            v[0] = mvp[0] * pos[0] + mvp[4] * pos[1] + mvp[8]  * pos[2] + mvp[12];
+            v[1] = mvp[1] * pos[0] + mvp[5] * pos[1] + mvp[9]  * pos[2] + mvp[13];
+            v[2] = mvp[2] * pos[0] + mvp[6] * pos[1] + mvp[10] * pos[2] + mvp[14];
+            v[3] = mvp[3] * pos[0] + mvp[7] * pos[1] + mvp[11] * pos[2] + mvp[15];
+        }
+
+        uint16_t n = Occlusion_ClipPolygon(clip[1], clip[0], p->vertex_count, 1.0f);
+        n = Occlusion_ClipPolygon(clip[0], clip[1], n, -1.0f);
+        if(n >= 3)
+        {
+            for(uint16_t j = 0; j < n; j++)
+            {
+                const float *c = clip[0] + 4 * j;
+                if(c[3] <= 0.0f)
+                {
+                    n = 0;
+                    break;
+                }
+                float iw = 1.0f / c[3];
+                screen[3 * j + 0] = (c[0] * iw * 0.5f + 0.5f) * (float)m_width;
+                screen[3 * j + 1] = (c[1] * iw * 0.5f + 0.5f) * (float)m_height;
+                screen[3 * j + 2] = iw;
+            }
+            if(n >= 3)
+            {
+                this->RasterizePolygon(screen, n);
+            }
+        }
+    }
+}
+
+
+/*
+ * Convex polygon, screen {x, y, 1 / w} vertices. Pixel is written only if
+ * all edge functions are positive in its whole square: the edge value in
+ * the centre minus its max change over half of pixel.
+ */
+void COcclusionBuffer::RasterizePolygon(const float *screen, uint16_t vertex_count)
+{
+    float edge_dx[OCCLUSION_MAX_CLIPPED], edge_dy[OCCLUSION_MAX_CLIPPED], edge_c[OCCLUSION_MAX_CLIPPED];
+    float area = 0.0f, nx = 0.0f, ny = 0.0f, nz = 0.0f;
+    float min_x = screen[0], max_x = screen[0], min_y = screen[1], max_y = screen[1];
+    float cx = 0.0f, cy = 0.0f, cz = 0.0f;
+
+    for(uint16_t i = 0; i < vertex_count; i++)
+    {
+        const float *a = screen + 3 * i;
+        const float *b = screen + 3 * ((i + 1) % vertex_count);
+        area += a[0] * b[1] - b[0] * a[1];
+        nx += (a[1] - b[1]) * (a[2] + b[2]);                                    // Newell's plane of (x, y, 1 / w)
+        ny += (a[2] - b[2]) * (a[0] + b[0]);
+        nz += (a[0] - b[0]) * (a[1] + b[1]);
+        min_x = (a[0] < min_x) ? (a[0]) : (min_x);
+        max_x = (a[0] > max_x) ? (a[0]) : (max_x);
+        min_y = (a[1] < min_y) ? (a[1]) : (min_y);
+        max_y = (a[1] > max_y) ? (a[1]) : (max_y);
+        cx += a[0];
+        cy += a[1];
+        cz += a[2];
+    }
+
+    // world is drawn with clockwise front faces and back faces culled; less than a pixel can't cover a pixel
+    float orient = (area > 0.0f) ? (1.0f) : (-1.0f);
+    if(area > -2.0f)
+    {
+        return;
+    }
+
+    int x0 = (min_x > 0.0f) ? ((int)min_x) : (0);
+    int x1 = (max_x < (float)m_width) ? ((int)ceilf(max_x)) : ((int)m_width);
+    int y0 = (min_y > 0.0f) ? ((int)min_y) : (0);
+    int y1 = (max_y < (float)m_height) ? ((int)ceilf(max_y)) : ((int)m_height);
+    x0 &= ~3;
+    if((x0 >= x1) || (y0 >= y1))
+    {
+        return;
+    }
+
+    cx /= vertex_count;
+    cy /= vertex_count;
+    cz /= vertex_count;
+    float dz_dx = -nx / nz;
+    float dz_dy = -ny / nz;
+    float z_bias = 0.5f * (fabsf(dz_dx) + fabsf(dz_dy));                        // farthest depth inside of pixel
+
+    // edge(x, y) = dx * x + dy * y + c, positive inside
+    for(uint16_t i = 0; i < vertex_count; i++)
+    {
+        const float *a = screen + 3 * i;
+        const float *b = screen + 3 * ((i + 1) % vertex_count);
+        edge_dx[i] = -orient * (b[1] - a[1]);
+        edge_dy[i] = orient * (b[0] - a[0]);
+        edge_c[i] = -edge_dx[i] * a[0] - edge_dy[i] * a[1] - 0.5f * (fabsf(edge_dx[i]) + fabsf(edge_dy[i]));
+    }
+
+    const float lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    vf4_t lane = vf4_load(lanes);
+    vf4_t zero = vf4_set1(0.0f);
+    vf4_t z_step = vf4_set1(4.0f * dz_dx);
+    for(int y = y0; y < y1; y++)
+    {
+        // row span from edges, only a superset is needed: masks are exact
+        float py = (float)y + 0.5f;
+        float lo = (float)x0, hi = (float)x1;
+        for(uint16_t i = 0; i < vertex_count; i++)
+        {
+            float k = edge_dy[i] * py + edge_c[i];
+            if(edge_dx[i] > 0.0f)
+            {
+                float t = -k / edge_dx[i] - 0.5f;
+                lo = (t > lo) ? (t) : (lo);
+            }
+            else if(edge_dx[i] < 0.0f)
+            {
+                float t = -k / edge_dx[i] + 0.5f;
+                hi = (t < hi) ? (t) : (hi);
+            }
+            else if(k <= 0.0f)
+            {
+                hi = lo;
+            }
+        }
+        if(lo >= hi)
+        {
+            continue;
+        }
+        int rx0 = ((int)lo) & ~3;
+        int rx1 = (int)ceilf(hi);
+        rx1 = (rx1 < x1) ? (rx1) : (x1);
+
+        float px = (float)rx0 + 0.5f;
+        float *row = m_depth + y * m_width;
+        vf4_t e[OCCLUSION_MAX_CLIPPED], e_step[OCCLUSION_MAX_CLIPPED];
+        for(uint16_t i = 0; i < vertex_count; i++)
+        {
+            e[i] = vf4_madd(lane, vf4_set1(edge_dx[i]), vf4_set1(edge_dx[i] * px + edge_dy[i] * py + edge_c[i]));
+            e_step[i] = vf4_set1(4.0f * edge_dx[i]);
+        }
+        vf4_t z = vf4_madd(lane, vf4_set1(dz_dx), vf4_set1(cz + dz_dx * (px - cx) + dz_dy * (py - cy) - z_bias));
+
+        for(int x = rx0; x < rx1; x += 4)
+        {
+            vm4_t inside = vf4_lt(zero, e[0]);
+            e[0] = vf4_add(e[0], e_step[0]);
+            for(uint16_t i = 1; i < vertex_count; i++)
+            {
+                inside = vm4_and(inside, vf4_lt(zero, e[i]));
+                e[i] = vf4_add(e[i], e_step[i]);
+            }
+            if(vm4_any(inside))
+            {
+                vf4_t d = vf4_load(row + x);
+                vf4_store(row + x, vf4_select(inside, vf4_max(d, z), d));
+            }
+            z = vf4_add(z, z_step);
+        }
+    }
+    m_occluders++;
+}
+
+
+bool COcclusionBuffer::IsOBBVisible(struct obb_s *obb, int object_type)
+{
+    float min_x = (float)m_width, max_x = 0.0f, min_y = (float)m_height, max_y = 0.0f, max_z = 0.0f;
+
+    if(!m_enabled || (obb == NULL))
+    {
+        return true;
+    }
+
+    m_tested[object_type]++;
+    for(int i = 0; i < 6; i++)
+    {
+        polygon_p p = obb->polygons + i;
+        for(uint16_t j = 0; j < p->vertex_count; j++)
+        {
+            const float *pos = p->vertices[j].position;
+            float w = m_view_proj[3] * pos[0] + m_view_proj[7] * pos[1] + m_view_proj[11] * pos[2] + m_view_proj[15];
+            float z = m_view_proj[2] * pos[0] + m_view_proj[6] * pos[1] + m_view_proj[10] * pos[2] + m_view_proj[14];
+            if((w <= 0.0f) || (z + w < 0.0f))
+            {
+                return true;                                                    // crosses near plane
+            }
+            float iw = 1.0f / w;
+            float x = ((m_view_proj[0] * pos[0] + m_view_proj[4] * pos[1] + m_view_proj[8] * pos[2] + m_view_proj[12]) * iw * 0.5f + 0.5f) * (float)m_width;
+            float y = ((m_view_proj[1] * pos[0] + m_view_proj[5] * pos[1] + m_view_proj[9] * pos[2] + m_view_proj[13]) * iw * 0.5f + 0.5f) * (float)m_height;
+            min_x = (x < min_x) ? (x) : (min_x);
+            max_x = (x > max_x) ? (x) : (max_x);
+            min_y = (y < min_y) ? (y) : (min_y);
+            max_y = (y > max_y) ? (y) : (max_y);
+            max_z = (iw > max_z) ? (iw) : (max_z);
+        }
+    }
+
+    int x0 = (min_x > 0.0f) ? ((int)min_x) : (0);
+    int x1 = (max_x < (float)m_width) ? ((int)ceilf(max_x)) : ((int)m_width);
+    int y0 = (min_y > 0.0f) ? ((int)min_y) : (0);
+    int y1 = (max_y < (float)m_height) ? ((int)ceilf(max_y)) : ((int)m_height);
+    if((x0 >= x1) || (y0 >= y1))
+    {
+        return true;                                                            // out of screen: frustum decides
+    }
+
+    // nearest point of the box against farthest occluder depth in each pixel
+    vf4_t z = vf4_set1(max_z);
+    x0 &= ~3;
+    for(int y = y0; y < y1; y++)
+    {
+        const float *row = m_depth + y * m_width;
+        for(int x = x0; x < x1; x += 4)
+        {
+            if(vm4_any(vf4_lt(vf4_load(row + x), z)))
+            {
+                return true;
+            }
+        }
+    }
+
+    m_culled[object_type]++;
+    return false;
+}
@@ -0,0 +1,44 @@
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <stdint.h>
+
+struct polygon_s;
+struct base_mesh_s;
+struct obb_s;
+
+#define OCCLUSION_OBJECT_STATIC         (0)
+#define OCCLUSION_OBJECT_ENTITY         (1)
+
+/*
+ * Low resolution software depth buffer of room geometry. Stores 1 / w
+ * (bigger is nearer) and is filled conservatively: only pixels covered by
+ * polygon entirely are written, with the farthest depth of polygon inside
+ * the pixel. So an object is culled only if it is really hidden by opaque
+ * front faces drawn this frame. Rows are processed by four pixels.
+ */
+class COcclusionBuffer
+{
+    uint32_t             m_width;                                               // multiple of 4
+    uint32_t             m_height;
+    float               *m_depth;
+    float                m_view_proj[16];
+    bool                 m_enabled;
+
+    void RasterizePolygon(const float *screen, uint16_t vertex_count);
+
+public:
+    COcclusionBuffer(uint32_t width, uint32_t height);
+   ~COcclusionBuffer();
+
+    void Reset(const float view_proj[16], bool enabled);
+    void AddMesh(struct base_mesh_s *mesh, const float transform[16]);
+    bool IsOBBVisible(struct obb_s *obb, int object_type);
+
+    uint32_t             m_occluders;                                           // rasterized polygons
+    uint32_t             m_tested[2];                                           // by OCCLUSION_OBJECT_...
+    uint32_t             m_culled[2];
+};
+
+#endif
@@ -0,0 +1,255 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "../core/vmath.h"
+#include "../room.h"
+#include "frustum.h"
+#include "pvs.h"
+
+
+#define PVS_EPSILON         (1.0f)
+
+typedef struct pvs_gen_s
+{
+    room_pvs_p          pvs;
+    struct room_s      *rooms;
+    uint32_t           *group_first;                    // first room of room's alternate group
+    uint32_t           *group_next;                     // next room of the same group, rooms_count for the last
+    uint8_t            *flooded;
+    uint32_t           *flood_stack;
+    uint32_t           *source_row;
+    uint32_t            steps;
+    portal_p            chain[PVS_MAX_DEPTH];
+}pvs_gen_t, *pvs_gen_p;
+
+
+static struct room_content_s *PVS_RoomContent(struct room_s *room)
+{
+    return (room->original_content) ? (room->original_content) : (room->content);
+}
+
+
+static uint32_t PVS_GroupRoot(uint32_t *parent, uint32_t i)
+{
+    while(parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+
+static void PVS_MarkGroup(pvs_gen_p gen, uint32_t room)
+{
+    for(uint32_t i = gen->group_first[room]; i < gen->pvs->rooms_count; i = gen->group_next[i])
+    {
+        gen->source_row[i / 32] |= 1U << (i % 32);
+    }
+}
+
+
+static bool PVS_HaveVertexBehind(portal_p p, const float plane[4])
+{
+    float *v = p->vertex;
+    for(uint16_t i = 0; i < p->vertex_count; i++, v += 3)
+    {
+        if(vec3_plane_dist(plane, v) < -PVS_EPSILON)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static bool PVS_HaveVertexInFront(portal_p p, const float plane[4])
+{
+    float *v = p->vertex;
+    for(uint16_t i = 0; i < p->vertex_count; i++, v += 3)
+    {
+        if(vec3_plane_dist(plane, v) > PVS_EPSILON)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*
+ * Portal normals look into owner room, so a line goes through the portal
+ * from its front side to its back side.
+ */
+static bool PVS_CanContinueChain(pvs_gen_p gen, portal_p p, uint32_t depth)
+{
+    for(uint32_t i = 0; i < depth; i++)
+    {
+        portal_p prev = gen->chain[i];
+        if(!PVS_HaveVertexBehind(p, prev->norm) || !PVS_HaveVertexInFront(prev, p->norm))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void PVS_Flood(pvs_gen_p gen, uint32_t room)
+{
+    uint32_t stack_size = 0;
+
+    if(!gen->flooded[room])
+    {
+        gen->flooded[room] = 0x01;
+        gen->flood_stack[stack_size++] = room;
+    }
+
+    while(stack_size > 0)
+    {
+        uint32_t r = gen->flood_stack[--stack_size];
+        PVS_MarkGroup(gen, r);
+        for(uint32_t i = gen->group_first[r]; i < gen->pvs->rooms_count; i = gen->group_next[i])
+        {
+            struct room_content_s *content = PVS_RoomContent(gen->rooms + i);
+            for(uint32_t j = 0; j < content->portals_count; j++)
+            {
+                uint32_t dest = content->portals[j].dest_room->id;
+                if((dest < gen->pvs->rooms_count) && !gen->flooded[dest])
+                {
+                    gen->flooded[dest] = 0x01;
+                    gen->flood_stack[stack_size++] = dest;
+                }
+            }
+        }
+    }
+}
+
+
+static void PVS_Traverse(pvs_gen_p gen, uint32_t room, uint32_t depth)
+{
+    PVS_MarkGroup(gen, room);
+    if((depth >= PVS_MAX_DEPTH) || (gen->steps >= PVS_MAX_STEPS))
+    {
+        PVS_Flood(gen, room);
+        return;
+    }
+
+    for(uint32_t i = gen->group_first[room]; i < gen->pvs->rooms_count; i = gen->group_next[i])
+    {
+        struct room_content_s *content = PVS_RoomContent(gen->rooms + i);
+        for(uint32_t j = 0; j < content->portals_count; j++)
+        {
+            portal_p p = content->portals + j;
+            uint32_t dest = p->dest_room->id;
+            gen->steps++;
+            if((dest < gen->pvs->rooms_count) && PVS_CanContinueChain(gen, p, depth))
+            {
+                gen->chain[depth] = p;
+                PVS_Traverse(gen, dest, depth + 1);
+            }
+        }
+    }
+}
+
+
+void PVS_Generate(room_pvs_p pvs, struct room_s *rooms, uint32_t rooms_count)
+{
+    pvs_gen_t gen;
+    uint32_t *parent;
+
+    PVS_Clear(pvs);
+    if((rooms == NULL) || (rooms_count == 0))
+    {
+        return;
+    }
+
+    pvs->rooms_count = rooms_count;
+    pvs->row_size = (rooms_count + 31) / 32;
+    pvs->bits = (uint32_t*)calloc(rooms_count * pvs->row_size, sizeof(uint32_t));
+
+    gen.pvs = pvs;
+    gen.rooms = rooms;
+    gen.group_first = (uint32_t*)malloc(rooms_count * sizeof(uint32_t));
+    gen.group_next = (uint32_t*)malloc(rooms_count * sizeof(uint32_t));
+    gen.flooded = (uint8_t*)malloc(rooms_count * sizeof(uint8_t));
+    gen.flood_stack = (uint32_t*)malloc(rooms_count * sizeof(uint32_t));
+    parent = (uint32_t*)malloc(rooms_count * sizeof(uint32_t));
+
+    /*
+     * alternate groups: rooms swap contents on flip, so any content of the
+     * group may be seen in any room of it.
+     */
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        parent[i] = i;
+    }
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        struct room_s *alt[2] = {rooms[i].alternate_room_next, rooms[i].alternate_room_prev};
+        for(int k = 0; k < 2; k++)
+        {
+            if(alt[k] && (alt[k]->id < rooms_count))
+            {
+                uint32_t a = PVS_GroupRoot(parent, i);
+                uint32_t b = PVS_GroupRoot(parent, alt[k]->id);
+                parent[(a > b) ? a : b] = (a > b) ? b : a;
+            }
+        }
+    }
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        gen.group_first[i] = rooms_count;
+        gen.group_next[i] = rooms_count;
+    }
+    for(uint32_t i = rooms_count; i-- > 0;)
+    {
+        uint32_t root = PVS_GroupRoot(parent, i);
+        gen.group_next[i] = gen.group_first[root];
+        gen.group_first[root] = i;
+    }
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        gen.group_first[i] = gen.group_first[PVS_GroupRoot(parent, i)];
+    }
+    free(parent);
+
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        if(gen.group_first[i] == i)
+        {
+            gen.source_row = pvs->bits + i * pvs->row_size;
+            gen.steps = 0;
+            memset(gen.flooded, 0x00, rooms_count * sizeof(uint8_t));
+            PVS_Traverse(&gen, i, 0);
+        }
+    }
+
+    for(uint32_t i = 0; i < rooms_count; i++)
+    {
+        if(gen.group_first[i] != i)
+        {
+            memcpy(pvs->bits + i * pvs->row_size, pvs->bits + gen.group_first[i] * pvs->row_size, pvs->row_size * sizeof(uint32_t));
+        }
+    }
+
+    free(gen.group_first);
+    free(gen.group_next);
+    free(gen.flooded);
+    free(gen.flood_stack);
+}
+
+
+void PVS_Clear(room_pvs_p pvs)
+{
+    if(pvs->bits)
+    {
+        free(pvs->bits);
+    }
+    pvs->bits = NULL;
+    pvs->rooms_count = 0;
+    pvs->row_size = 0;
+}
@@ -0,0 +1,38 @@
+
+#ifndef PVS_H
+#define PVS_H
+
+#include <stdint.h>
+
+struct room_s;
+
+/*
+ * Room to room potentially visible sets: bit (from, to) is set if any line
+ * from room "from" may reach room "to" through a chain of portals. A line
+ * crosses every portal plane once, so each next portal of the chain must
+ * lie partly behind all previous portals planes (and they in front of it).
+ * Rooms of one alternate (flip) group share one set and all of their
+ * contents portals are used, so sets stay valid after flips.
+ * Too deep or too long searches fall back to portal graph flood fill:
+ * result may only be wider than exact one, never narrower.
+ */
+#define PVS_MAX_DEPTH               (48)                // portals chain length
+#define PVS_MAX_STEPS               (8192)              // traversed portals per source room
+
+typedef struct room_pvs_s
+{
+    uint32_t            rooms_count;
+    uint32_t            row_size;                       // in 32 bit words
+    uint32_t           *bits;
+}room_pvs_t, *room_pvs_p;
+
+void PVS_Generate(room_pvs_p pvs, struct room_s *rooms, uint32_t rooms_count);
+void PVS_Clear(room_pvs_p pvs);
+
+inline bool PVS_IsVisible(const room_pvs_s *pvs, uint32_t from, uint32_t to)
+{
+    return (pvs->bits == NULL) || (from >= pvs->rooms_count) || (to >= pvs->rooms_count) ||
+           (pvs->bits[from * pvs->row_size + to / 32] & (1U << (to % 32)));
+}
+
+#endif
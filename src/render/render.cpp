@@ -8,6 +8,7 @@
 #include "../core/gl_text.h"
 #include "../core/system.h"
 #include "../core/console.h"
+#include "../core/profiler.h"
 #include "../core/vmath.h"
 #include "../core/polygon.h"
 #include "../core/obb.h"
@@ -17,7 +18,11 @@
 #include "camera.h"
 #include "render.h"
 #include "bsp_tree.h"
+#include "draw_packets.h"
+#include "stream_buffer.h"
+#include "occlusion.h"
 #include "frustum.h"
+#include "pvs.h"
 #include "shader_description.h"
 #include "shader_manager.h"
 #include "../room.h"
@@ -44,6 +49,10 @@ m_rooms(NULL),
 m_rooms_count(0),
 m_anim_sequences(NULL),
 m_anim_sequences_count(0),
+m_anim_seq_state(NULL),
+m_rooms_bsp(NULL),
+m_rooms_bsp_count(0),
+m_occlusion_ready(false),
 m_active_transparency(0),
 m_active_texture(0),
 r_list_size(0),
@@ -53,17 +62,30 @@ frustumManager(NULL),
 shaderManager(NULL),
 debugDrawer(NULL),
 dynamicBSP(NULL),
+sortedPolygons(NULL),
+occlusionBuffer(NULL),
+drawPackets(NULL),
+streamBuffer(NULL),
 r_flags(0x00)
 {
+    m_pvs.rooms_count = 0;
+    m_pvs.row_size = 0;
+    m_pvs.bits = NULL;
     this->InitSettings();
     frustumManager = new CFrustumManager(32768);
     debugDrawer    = new CRenderDebugDrawer();
     dynamicBSP     = new CDynamicBSP(512 * 1024);
+    sortedPolygons = new CSortedPolygonList(1024);
+    occlusionBuffer = new COcclusionBuffer(256, 144);
+    drawPackets    = new CDrawPacketList();
+    streamBuffer   = new CStreamBuffer(8 * 1024 * 1024);
 }
 
 CRender::~CRender()
 {
     m_camera = NULL;
+    PVS_Clear(&m_pvs);
+    this->ClearRoomsBSP();
 
     if(r_list)
     {
@@ -91,11 +113,41 @@ CRender::~CRender()
         dynamicBSP = NULL;
     }
 
+    if(sortedPolygons)
+    {
+        delete sortedPolygons;
+        sortedPolygons = NULL;
+    }
+
+    if(occlusionBuffer)
+    {
+        delete occlusionBuffer;
+        occlusionBuffer = NULL;
+    }
+
+    if(drawPackets)
+    {
+        delete drawPackets;
+        drawPackets = NULL;
+    }
+
+    if(streamBuffer)
+    {
+        delete streamBuffer;
+        streamBuffer = NULL;
+    }
+
     if(shaderManager)
     {
         delete shaderManager;
         shaderManager = NULL;
     }
+
+    if(m_anim_seq_state)
+    {
+        free(m_anim_seq_state);
+        m_anim_seq_state = NULL;
+    }
 }
 
 void CRender::InitSettings()
@@ -107,8 +159,10 @@ void CRender::InitSettings()
     settings.mipmaps = 3;
     settings.mipmap_mode = 3;
     settings.texture_border = 8;
+    settings.texture_compression = 0;
     settings.z_depth = 16;
     settings.fog_enabled = 1;
+    settings.transparency_mode = TRANSPARENCY_DYNAMIC_BSP;
     settings.fog_color[0] = 0.0f;
     settings.fog_color[1] = 0.0f;
     settings.fog_color[2] = 0.0f;
@@ -116,6 +170,14 @@ void CRender::InitSettings()
     settings.fog_end_depth = 16000.0f;
 }
 
+/**
+ * Must be called once per displayed frame, before any drawing.
+ */
+void CRender::BeginFrame()
+{
+    streamBuffer->BeginFrame();
+}
+
 void CRender::DoShaders()
 {
     if(shaderManager == NULL)
@@ -133,6 +195,51 @@ void CRender::ResetWorld(struct room_s *rooms, uint32_t rooms_count, struct anim
     m_rooms_count = rooms_count;
     m_anim_sequences = anim_sequences;
     m_anim_sequences_count = anim_sequences_count;
+    PVS_Generate(&m_pvs, rooms, rooms_count);
+    this->GenRoomsBSP();
+
+    /*
+     * Animated textures are evaluated by shaders if frame table fits into
+     * uniforms: it is set once here, only sequences state changes per frame.
+     */
+    if(m_anim_seq_state)
+    {
+        free(m_anim_seq_state);
+        m_anim_seq_state = NULL;
+    }
+    drawPackets->SetAnimTexturesOnGPU(false);
+    if(shaderManager && m_anim_sequences_count && (m_anim_sequences_count <= ANIM_TEX_MAX_SEQUENCES))
+    {
+        uint32_t frames_count = 0;
+        for(uint32_t i = 0; i < m_anim_sequences_count; i++)
+        {
+            frames_count += m_anim_sequences[i].frames_count;
+        }
+
+        if(frames_count <= ANIM_TEX_MAX_FRAMES)
+        {
+            GLfloat frames[8 * ANIM_TEX_MAX_FRAMES];                            // mat[4], move[2], pad[2]
+            GLfloat *f = frames;
+            anim_seq_p seq = m_anim_sequences;
+            for(uint32_t i = 0; i < m_anim_sequences_count; i++, seq++)
+            {
+                for(uint16_t j = 0; j < seq->frames_count; j++, f += 8)
+                {
+                    vec4_copy(f, seq->frames[j].mat);
+                    f[4] = seq->frames[j].move[0];
+                    f[5] = seq->frames[j].move[1];
+                    f[6] = 0.0f;
+                    f[7] = 0.0f;
+                }
+            }
+
+            if(shaderManager->setAnimFrames(frames, frames_count))
+            {
+                m_anim_seq_state = (GLfloat*)malloc(m_anim_sequences_count * sizeof(GLfloat [4]));
+                drawPackets->SetAnimTexturesOnGPU(true);
+            }
+        }
+    }
 
     if(m_rooms)
     {
@@ -230,8 +337,10 @@ void CRender::UpdateAnimTextures()
  */
 void CRender::GenWorldList(struct camera_s *cam)
 {
+    PROF_SCOPED_ZONE("CRender::GenWorldList");
     this->CleanList();
     this->dynamicBSP->Reset(m_anim_sequences);
+    this->drawPackets->Reset();
     this->frustumManager->Reset();
     cam->frustum->next = NULL;
     m_camera = cam;
@@ -258,7 +367,7 @@ void CRender::GenWorldList(struct camera_s *cam)
             {
                 this->AddRoom(dest_room);                                       // portal destination room
                 last_frus->parents_count = 1;                                   // created by camera
-                this->ProcessRoom(p, last_frus);                                // next start reccursion algorithm
+                this->ProcessRoom(p, last_frus, curr_room, 1);                  // next start reccursion algorithm
             }
             else if((cam_pos[0] <= dest_room->bb_max[0] + eps) && (cam_pos[0] >= dest_room->bb_min[0] - eps) &&
                     (cam_pos[1] <= dest_room->bb_max[1] + eps) && (cam_pos[1] >= dest_room->bb_min[1] - eps) &&
@@ -277,7 +386,7 @@ void CRender::GenWorldList(struct camera_s *cam)
                         {
                             this->AddRoom(ndest_room);                          // portal destination room
                             last_frus->parents_count = 1;                       // created by camera
-                            this->ProcessRoom(np, last_frus);                   // next start reccursion algorithm
+                            this->ProcessRoom(np, last_frus, dest_room, 1);     // next start reccursion algorithm
                         }
                     }
                 }
@@ -286,15 +395,93 @@ void CRender::GenWorldList(struct camera_s *cam)
     }
     else                                                                        // camera is out of all rooms
     {
-        curr_room = m_rooms;                                                    // draw full level. Yes - it is slow, but it is not gameplay - it is debug.
-        for(uint32_t i = 0; i < m_rooms_count; i++, curr_room++)
+        this->AddRoomsOutside(cam);
+    }
+}
+
+/**
+ * Camera is out of all rooms: if it is just behind some room wall, rooms
+ * from PVS of the nearest room are tested, else full level is (debug fly).
+ */
+void CRender::AddRoomsOutside(struct camera_s *cam)
+{
+    const float max_dist = TR_METERING_SECTORSIZE;
+    GLfloat *cam_pos = cam->transform.M4x4 + 12;
+    room_p near_room = NULL;
+    float near_dist = max_dist * max_dist;
+    room_p r = m_rooms;
+
+    for(uint32_t i = 0; i < m_rooms_count; i++, r++)
+    {
+        if(r == r->real_room)
         {
-            if(Frustum_IsAABBVisible(curr_room->bb_min, curr_room->bb_max, cam->frustum))
+            float d[3], dist;
+            for(int j = 0; j < 3; j++)
+            {
+                d[j] = (cam_pos[j] < r->bb_min[j]) ? (r->bb_min[j] - cam_pos[j]) : ((cam_pos[j] > r->bb_max[j]) ? (cam_pos[j] - r->bb_max[j]) : (0.0f));
+            }
+            dist = vec3_dot(d, d);
+            if(dist < near_dist)
             {
-                this->AddRoom(curr_room->real_room);
+                near_dist = dist;
+                near_room = r;
             }
         }
     }
+
+    r = m_rooms;
+    for(uint32_t i = 0; i < m_rooms_count; i++, r++)
+    {
+        if(((near_room == NULL) || PVS_IsVisible(&m_pvs, near_room->id, r->real_room->id)) &&
+           Frustum_IsAABBVisible(r->bb_min, r->bb_max, cam->frustum))
+        {
+            this->AddRoom(r->real_room);
+        }
+    }
+}
+
+/**
+ * Opaque room meshes of the render list are rasterized into the software
+ * depth buffer; rooms clipped by stencil are drawn partially, so they are
+ * skipped as occluders. It is done by the first occlusion test of frame,
+ * frames without objects to test don't pay for it.
+ */
+void CRender::GenOcclusionBuffer()
+{
+    PROF_SCOPED_ZONE("CRender::GenOcclusionBuffer");
+    occlusionBuffer->Reset(m_camera->gl_view_proj_mat, !(r_flags & (R_SKIP_ROOM | R_DRAW_WIRE | R_DRAW_POINTS)));
+    for(uint32_t i = 0; i < r_list_active_count; i++)
+    {
+        room_p r = r_list[i].room;
+        bool stencil_clipped = false;
+#if STENCIL_FRUSTUM
+        if(r->frustum != NULL)
+        {
+            for(uint16_t j = 0; j < r->content->overlapped_room_list_size; j++)
+            {
+                if(r->content->overlapped_room_list[j]->real_room->is_in_r_list)
+                {
+                    stencil_clipped = true;
+                    break;
+                }
+            }
+        }
+#endif
+        if(!stencil_clipped)
+        {
+            occlusionBuffer->AddMesh(r->content->mesh, r->transform);
+        }
+    }
+}
+
+bool CRender::IsOBBNotOccluded(struct obb_s *obb, int object_type)
+{
+    if(!m_occlusion_ready)
+    {
+        this->GenOcclusionBuffer();
+        m_occlusion_ready = true;
+    }
+    return occlusionBuffer->IsOBBVisible(obb, object_type);
 }
 
 /**
@@ -302,6 +489,7 @@ void CRender::GenWorldList(struct camera_s *cam)
  */
 void CRender::DrawList()
 {
+    PROF_SCOPED_ZONE("CRender::DrawList");
     if(m_camera)
     {
         if(r_flags & R_DRAW_WIRE)
@@ -325,6 +513,8 @@ void CRender::DrawList()
 
         m_active_texture = 0;
         this->DrawSkyBox(m_camera->gl_view_proj_mat);
+        occlusionBuffer->Reset(m_camera->gl_view_proj_mat, false);             // filled by the first test of the frame
+        m_occlusion_ready = false;
 
         /*
          * room rendering
@@ -333,6 +523,7 @@ void CRender::DrawList()
         {
             this->DrawRoom(r_list[i].room, m_camera->gl_view_mat, m_camera->gl_view_proj_mat);
         }
+        this->DrawPackets();
 
         qglDisable(GL_CULL_FACE);
         for(uint32_t i = 0; i < r_list_active_count; i++)
@@ -343,79 +534,386 @@ void CRender::DrawList()
         /*
          * NOW render transparency polygons
          */
-        /*First generate BSP from base room mesh - it has good for start splitter polygons*/
-        for(uint32_t i = 0; i < r_list_active_count; i++)
+        if((settings.transparency_mode == TRANSPARENCY_CACHED_BSP) && m_rooms_bsp)
         {
-            room_p r = r_list[i].room;
-            if((r->content->mesh != NULL) && (r->content->mesh->transparency_polygons != NULL))
+            this->DrawTransparencyCachedBSP();
+        }
+        else
+        {
+            this->DrawTransparencyDynamicBSP();
+        }
+
+        //Reset polygon draw mode
+        qglPolygonMode(GL_FRONT, GL_FILL);
+        m_active_texture = 0;
+    }
+}
+/*
+ * One tree of all visible transparency polygons, rebuilt every frame.
+ */
+void CRender::DrawTransparencyDynamicBSP()
+{
+    PROF_ZONE_BEGIN("DynamicBSP build");
+    /*First generate BSP from base room mesh - it has good for start splitter polygons*/
+    for(uint32_t i = 0; i < r_list_active_count; i++)
+    {
+        room_p r = r_list[i].room;
+        if((r->content->mesh != NULL) && (r->content->mesh->transparency_polygons != NULL))
+        {
+            dynamicBSP->AddNewPolygonList(r->content->mesh->transparency_polygons, r->transform, m_camera->frustum);
+        }
+    }
+
+    for(uint32_t i = 0; i < r_list_active_count; i++)
+    {
+        room_p r = r_list[i].room;
+        // Add transparency polygons from static meshes (if they exists)
+        for(uint16_t j = 0; j < r->content->static_mesh_count; j++)
+        {
+            if((r->content->static_mesh[j].mesh->transparency_polygons != NULL) && Frustum_IsOBBVisibleInFrustumList(r->content->static_mesh[j].obb, (r->frustum) ? (r->frustum) : (m_camera->frustum)) &&
+               this->IsOBBNotOccluded(r->content->static_mesh[j].obb, OCCLUSION_OBJECT_STATIC))
             {
-                dynamicBSP->AddNewPolygonList(r->content->mesh->transparency_polygons, r->transform, m_camera->frustum);
+                dynamicBSP->AddNewPolygonList(r->content->static_mesh[j].mesh->transparency_polygons, r->content->static_mesh[j].transform, m_camera->frustum);
             }
         }
 
-        for(uint32_t i = 0; i < r_list_active_count; i++)
+        // Add transparency polygons from all entities (if they exists) // yes, entities may be animated and intersects with each others;
+        for(engine_container_p cont = r->containers; cont; cont = cont->next)
+        {
+            if(cont->object_type == OBJECT_ENTITY)
+            {
+                entity_p ent = (entity_p)cont->object;
+                if((ent->state_flags & ENTITY_STATE_VISIBLE) && ent->bf->animations.model && (ent->bf->animations.model->transparency_flags == MESH_HAS_TRANSPARENCY) && Frustum_IsOBBVisibleInFrustumList(ent->obb, (r->frustum) ? (r->frustum) : (m_camera->frustum)) &&
+                   this->IsOBBNotOccluded(ent->obb, OCCLUSION_OBJECT_ENTITY))
+                {
+                    float tr[16];
+                    for(uint16_t j = 0; j < ent->bf->bone_tag_count; j++)
+                    {
+                        if(ent->bf->bone_tags[j].mesh_base->transparency_polygons != NULL)
+                        {
+                            Mat4_Mat4_mul(tr, ent->transform.M4x4, ent->bf->bone_tags[j].full_transform);
+                            dynamicBSP->AddNewPolygonList(ent->bf->bone_tags[j].mesh_base->transparency_polygons, tr, m_camera->frustum);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    PROF_ZONE_END();
+
+    if(dynamicBSP->m_root->polygons_front)
+    {
+        PROF_SCOPED_ZONE("DynamicBSP draw");
+        const unlit_tinted_shader_description *shader = shaderManager->getRoomShader(false, false);
+        qglUseProgramObjectARB(shader->program);
+        qglUniform1iARB(shader->sampler, 0);
+        qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, m_camera->gl_view_proj_mat);
+        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
+        qglDepthMask(GL_FALSE);
+        qglDisable(GL_ALPHA_TEST);
+        qglEnable(GL_BLEND);
+        m_active_transparency = 0;
+        qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+        uint8_t *base = (uint8_t*)(uintptr_t)streamBuffer->Upload(dynamicBSP->GetVertexArray(), dynamicBSP->GetActiveVertexCount() * sizeof(vertex_t));
+        qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, position));
+        qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, color));
+        qglNormalPointer(GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, normal));
+        qglTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, tex_coord));
+        this->DrawBSPBackToFront(dynamicBSP->m_root);
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        qglDepthMask(GL_TRUE);
+        qglDisable(GL_BLEND);
+    }
+}
+
+/*
+ * State of back to front merge of cached rooms trees with depth sorted
+ * polygons of entities: before a tree polygon all farther entities polygons
+ * are drawn.
+ */
+typedef struct transparency_merge_s
+{
+    class CSortedPolygonList   *list;
+    uint32_t                    next;                                           // first not drawn polygon of the list
+    uint8_t                    *list_base;                                      // vertex arrays in stream buffer
+    uint8_t                    *tree_base;
+    uint8_t                    *bound_base;
+    struct vertex_s            *tree_vertices;
+    const uint8_t              *statics_visible;
+    const float                *view_pos;
+}transparency_merge_t, *transparency_merge_p;
+
+typedef struct transparency_room_s
+{
+    class CDynamicBSP          *bsp;
+    struct room_s              *room;
+    uint8_t                    *base;
+    float                       dist;
+}transparency_room_t, *transparency_room_p;
+
+
+static void Render_SetVertexArray(transparency_merge_p merge, uint8_t *base)
+{
+    if(merge->bound_base != base)
+    {
+        merge->bound_base = base;
+        qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, position));
+        qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, color));
+        qglNormalPointer(GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, normal));
+        qglTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), base + offsetof(vertex_t, tex_coord));
+    }
+}
+
+
+static CDynamicBSP *Render_FindRoomBSP(CDynamicBSP **rooms_bsp, uint32_t rooms_bsp_count, struct room_s *room)
+{
+    // contents are swapped by flips: tree is kept by the room that owns the content
+    struct room_s *owners[3] = {room, room->alternate_room_next, room->alternate_room_prev};
+    for(int i = 0; i < 3; i++)
+    {
+        struct room_s *r = owners[i];
+        if(r && (r->id < rooms_bsp_count) && (((r->original_content) ? (r->original_content) : (r->content)) == room->content))
+        {
+            return rooms_bsp[r->id];
+        }
+    }
+    return NULL;
+}
+
+
+/*
+ * Rooms and static meshes polygons are taken from trees built on load, only
+ * entities polygons are processed every frame. Rooms are drawn from the
+ * farthest one (by distance to the room box).
+ */
+void CRender::DrawTransparencyCachedBSP()
+{
+    const float *view_pos = m_camera->transform.M4x4 + 12;
+    transparency_room_p rooms = (transparency_room_p)Sys_GetTempMem(r_list_active_count * sizeof(transparency_room_t));
+    uint32_t rooms_count = 0;
+    uint32_t vertex_count = 0;
+
+    PROF_ZONE_BEGIN("Transparency sort");
+    sortedPolygons->Reset(m_anim_sequences, view_pos);
+    for(uint32_t i = 0; i < r_list_active_count; i++)
+    {
+        room_p r = r_list[i].room;
+        frustum_p frus = (r->frustum) ? (r->frustum) : (m_camera->frustum);
+        CDynamicBSP *bsp = Render_FindRoomBSP(m_rooms_bsp, m_rooms_bsp_count, r);
+        if(bsp)
         {
-            room_p r = r_list[i].room;
-            // Add transparency polygons from static meshes (if they exists)
+            if(bsp->m_root->polygons_front)
+            {
+                transparency_room_p tr = rooms + rooms_count++;
+                float d[3];
+                for(int k = 0; k < 3; k++)
+                {
+                    d[k] = (view_pos[k] < r->bb_min[k]) ? (r->bb_min[k] - view_pos[k]) : ((view_pos[k] > r->bb_max[k]) ? (view_pos[k] - r->bb_max[k]) : (0.0f));
+                }
+                tr->bsp = bsp;
+                tr->room = r;
+                tr->dist = vec3_dot(d, d);
+                if(m_anim_sequences)
+                {
+                    bsp->UpdateAnimTextures(m_anim_sequences);
+                }
+                vertex_count += bsp->GetActiveVertexCount();
+            }
+        }
+        else
+        {
+            // content without tree (unexpected flip chain): sort its polygons as entities ones
+            if((r->content->mesh != NULL) && (r->content->mesh->transparency_polygons != NULL))
+            {
+                sortedPolygons->AddNewPolygonList(r->content->mesh->transparency_polygons, r->transform, m_camera->frustum);
+            }
             for(uint16_t j = 0; j < r->content->static_mesh_count; j++)
             {
-                if((r->content->static_mesh[j].mesh->transparency_polygons != NULL) && Frustum_IsOBBVisibleInFrustumList(r->content->static_mesh[j].obb, (r->frustum) ? (r->frustum) : (m_camera->frustum)))
+                if((r->content->static_mesh[j].mesh->transparency_polygons != NULL) && Frustum_IsOBBVisibleInFrustumList(r->content->static_mesh[j].obb, frus) &&
+                   this->IsOBBNotOccluded(r->content->static_mesh[j].obb, OCCLUSION_OBJECT_STATIC))
                 {
-                    dynamicBSP->AddNewPolygonList(r->content->static_mesh[j].mesh->transparency_polygons, r->content->static_mesh[j].transform, m_camera->frustum);
+                    sortedPolygons->AddNewPolygonList(r->content->static_mesh[j].mesh->transparency_polygons, r->content->static_mesh[j].transform, m_camera->frustum);
                 }
             }
+        }
 
-            // Add transparency polygons from all entities (if they exists) // yes, entities may be animated and intersects with each others;
-            for(engine_container_p cont = r->containers; cont; cont = cont->next)
+        for(engine_container_p cont = r->containers; cont; cont = cont->next)
+        {
+            if(cont->object_type == OBJECT_ENTITY)
             {
-                if(cont->object_type == OBJECT_ENTITY)
+                entity_p ent = (entity_p)cont->object;
+                if((ent->state_flags & ENTITY_STATE_VISIBLE) && ent->bf->animations.model && (ent->bf->animations.model->transparency_flags == MESH_HAS_TRANSPARENCY) && Frustum_IsOBBVisibleInFrustumList(ent->obb, frus) &&
+                   this->IsOBBNotOccluded(ent->obb, OCCLUSION_OBJECT_ENTITY))
                 {
-                    entity_p ent = (entity_p)cont->object;
-                    if((ent->state_flags & ENTITY_STATE_VISIBLE) && ent->bf->animations.model && (ent->bf->animations.model->transparency_flags == MESH_HAS_TRANSPARENCY) && Frustum_IsOBBVisibleInFrustumList(ent->obb, (r->frustum) ? (r->frustum) : (m_camera->frustum)))
+                    float tr[16];
+                    for(uint16_t j = 0; j < ent->bf->bone_tag_count; j++)
                     {
-                        float tr[16];
-                        for(uint16_t j = 0; j < ent->bf->bone_tag_count; j++)
+                        if(ent->bf->bone_tags[j].mesh_base->transparency_polygons != NULL)
                         {
-                            if(ent->bf->bone_tags[j].mesh_base->transparency_polygons != NULL)
-                            {
-                                Mat4_Mat4_mul(tr, ent->transform.M4x4, ent->bf->bone_tags[j].full_transform);
-                                dynamicBSP->AddNewPolygonList(ent->bf->bone_tags[j].mesh_base->transparency_polygons, tr, m_camera->frustum);
-                            }
+                            Mat4_Mat4_mul(tr, ent->transform.M4x4, ent->bf->bone_tags[j].full_transform);
+                            sortedPolygons->AddNewPolygonList(ent->bf->bone_tags[j].mesh_base->transparency_polygons, tr, m_camera->frustum);
                         }
                     }
                 }
             }
         }
+    }
+    sortedPolygons->Sort();
 
-        if(dynamicBSP->m_root->polygons_front && (dynamicBSP->m_vbo != 0))
+    for(uint32_t i = 1; i < rooms_count; i++)                                  // few rooms: insertion sort, farthest first
+    {
+        transparency_room_t t = rooms[i];
+        uint32_t j = i;
+        for( ; (j > 0) && (rooms[j - 1].dist < t.dist); j--)
         {
-            const unlit_tinted_shader_description *shader = shaderManager->getRoomShader(false, false);
-            qglUseProgramObjectARB(shader->program);
-            qglUniform1iARB(shader->sampler, 0);
-            qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, m_camera->gl_view_proj_mat);
-            qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
-            qglDepthMask(GL_FALSE);
-            qglDisable(GL_ALPHA_TEST);
-            qglEnable(GL_BLEND);
-            m_active_transparency = 0;
-            qglBindBufferARB(GL_ARRAY_BUFFER_ARB, dynamicBSP->m_vbo);
-            qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
-            qglBufferDataARB(GL_ARRAY_BUFFER_ARB, dynamicBSP->GetActiveVertexCount() * sizeof(vertex_t), dynamicBSP->GetVertexArray(), GL_DYNAMIC_DRAW);
-            qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, position));
-            qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, color));
-            qglNormalPointer(GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, normal));
-            qglTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, tex_coord));
-            this->DrawBSPBackToFront(dynamicBSP->m_root);
-            qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
-            qglDepthMask(GL_TRUE);
-            qglDisable(GL_BLEND);
+            rooms[j] = rooms[j - 1];
+        }
+        rooms[j] = t;
+    }
+    PROF_ZONE_END();
+
+    if((rooms_count > 0) || (sortedPolygons->GetCount() > 0))
+    {
+        PROF_SCOPED_ZONE("Transparency draw");
+        const unlit_tinted_shader_description *shader = shaderManager->getRoomShader(false, false);
+        transparency_merge_t merge;
+        GLsizeiptr offset;
+        uint8_t *data;
+
+        vertex_count += sortedPolygons->GetActiveVertexCount();
+        data = (uint8_t*)streamBuffer->Map(vertex_count * sizeof(vertex_t), &offset);
+        for(uint32_t i = 0; i < rooms_count; i++)
+        {
+            rooms[i].base = (uint8_t*)(uintptr_t)offset;
+            memcpy(data, rooms[i].bsp->GetVertexArray(), rooms[i].bsp->GetActiveVertexCount() * sizeof(vertex_t));
+            data += rooms[i].bsp->GetActiveVertexCount() * sizeof(vertex_t);
+            offset += rooms[i].bsp->GetActiveVertexCount() * sizeof(vertex_t);
+        }
+        merge.list_base = (uint8_t*)(uintptr_t)offset;
+        memcpy(data, sortedPolygons->GetVertexArray(), sortedPolygons->GetActiveVertexCount() * sizeof(vertex_t));
+        streamBuffer->Unmap();
+
+        qglUseProgramObjectARB(shader->program);
+        qglUniform1iARB(shader->sampler, 0);
+        qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, m_camera->gl_view_proj_mat);
+        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
+        qglDepthMask(GL_FALSE);
+        qglDisable(GL_ALPHA_TEST);
+        qglEnable(GL_BLEND);
+        m_active_transparency = 0;
+        qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+
+        merge.list = sortedPolygons;
+        merge.next = 0;
+        merge.bound_base = NULL;
+        merge.view_pos = view_pos;
+        for(uint32_t i = 0; i < rooms_count; i++)
+        {
+            room_p r = rooms[i].room;
+            frustum_p frus = (r->frustum) ? (r->frustum) : (m_camera->frustum);
+            uint8_t *statics_visible = (uint8_t*)Sys_GetTempMem(r->content->static_mesh_count + 1);
+            for(uint16_t j = 0; j < r->content->static_mesh_count; j++)
+            {
+                statics_visible[j] = (r->content->static_mesh[j].mesh->transparency_polygons != NULL) && Frustum_IsOBBVisibleInFrustumList(r->content->static_mesh[j].obb, frus) &&
+                                     this->IsOBBNotOccluded(r->content->static_mesh[j].obb, OCCLUSION_OBJECT_STATIC);
+            }
+            merge.tree_base = rooms[i].base;
+            merge.tree_vertices = rooms[i].bsp->GetVertexArray();
+            merge.statics_visible = statics_visible;
+            this->DrawBSPMerged(rooms[i].bsp->m_root, &merge);
+            Sys_ReturnTempMem(r->content->static_mesh_count + 1);
+        }
+
+        Render_SetVertexArray(&merge, merge.list_base);
+        for( ; merge.next < sortedPolygons->GetCount(); merge.next++)
+        {
+            this->DrawBSPPolygon(sortedPolygons->GetPolygon(merge.next));
+        }
+
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        qglDepthMask(GL_TRUE);
+        qglDisable(GL_BLEND);
+    }
+    Sys_ReturnTempMem(r_list_active_count * sizeof(transparency_room_t));
+}
+
+
+void CRender::GenRoomsBSP()
+{
+    this->ClearRoomsBSP();
+    if((m_rooms == NULL) || (settings.transparency_mode != TRANSPARENCY_CACHED_BSP))
+    {
+        return;
+    }
+
+    m_rooms_bsp = (CDynamicBSP**)calloc(m_rooms_count, sizeof(CDynamicBSP*));
+    m_rooms_bsp_count = m_rooms_count;
+    for(uint32_t i = 0; i < m_rooms_count; i++)
+    {
+        room_p r = m_rooms + i;
+        room_content_p content = (r->original_content) ? (r->original_content) : (r->content);
+        uint32_t vertex_count = 0;
+
+        if(content->mesh)
+        {
+            for(polygon_p p = content->mesh->transparency_polygons; p; p = p->next)
+            {
+                vertex_count += p->vertex_count;
+            }
+        }
+        for(uint16_t j = 0; j < content->static_mesh_count; j++)
+        {
+            for(polygon_p p = content->static_mesh[j].mesh->transparency_polygons; p; p = p->next)
+            {
+                vertex_count += p->vertex_count;
+            }
+        }
+
+        if(vertex_count > 0)
+        {
+            // static meshes polygons are marked by owner to be skipped if static is culled
+            CDynamicBSP *bsp = new CDynamicBSP(vertex_count * 256);
+            do
+            {
+                bsp->Reset(NULL);
+                if(content->mesh && content->mesh->transparency_polygons)
+                {
+                    bsp->AddNewPolygonList(content->mesh->transparency_polygons, r->transform, NULL);
+                }
+                for(uint16_t j = 0; j < content->static_mesh_count; j++)
+                {
+                    if(content->static_mesh[j].mesh->transparency_polygons)
+                    {
+                        bsp->AddNewPolygonList(content->static_mesh[j].mesh->transparency_polygons, content->static_mesh[j].transform, NULL, j + 1);
+                    }
+                }
+            }
+            while(!bsp->IsCompleted());
+            bsp->Freeze();
+            m_rooms_bsp[i] = bsp;
         }
-        //Reset polygon draw mode
-        qglPolygonMode(GL_FRONT, GL_FILL);
-        m_active_texture = 0;
     }
 }
 
+
+void CRender::ClearRoomsBSP()
+{
+    if(m_rooms_bsp)
+    {
+        for(uint32_t i = 0; i < m_rooms_bsp_count; i++)
+        {
+            if(m_rooms_bsp[i])
+            {
+                delete m_rooms_bsp[i];
+            }
+        }
+        free(m_rooms_bsp);
+        m_rooms_bsp = NULL;
+    }
+    m_rooms_bsp_count = 0;
+}
+
 void CRender::DrawListDebugLines()
 {
     if(r_flags && m_camera)
@@ -531,7 +1029,7 @@ void CRender::DrawListDebugLines()
         qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
         qglPointSize( 6.0f );
         qglLineWidth( 3.0f );
-        debugDrawer->Render();
+        debugDrawer->Render(streamBuffer);
     }
     debugDrawer->Reset();
 }
@@ -701,31 +1199,113 @@ void CRender::DrawBSPBackToFront(struct bsp_node_s *root)
     }
 }
 
-void CRender::DrawMesh(struct base_mesh_s *mesh, const float *overrideVertices, const float *overrideNormals)
+void CRender::DrawMergedPolygon(struct bsp_polygon_s *p, struct transparency_merge_s *merge)
 {
-    if(mesh->animated_vertex_count)
+    float centre[3] = {0.0f, 0.0f, 0.0f};
+    float dist;
+
+    if(p->owner && !merge->statics_visible[p->owner - 1])
     {
-        // Respecify the tex coord buffer
-        qglBindBufferARB(GL_ARRAY_BUFFER, mesh->vbo_animated_texcoord_array);
-        // Tell OpenGL to discard the old values
-        qglBufferDataARB(GL_ARRAY_BUFFER, mesh->animated_vertex_count * sizeof(GLfloat [2]), 0, GL_STREAM_DRAW);
-        // Get writable data (to avoid copy)
-        GLfloat *data = (GLfloat *) qglMapBufferARB(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+        return;
+    }
+
+    for(uint16_t i = 0; i < p->vertex_count; i++)
+    {
+        vec3_add(centre, centre, merge->tree_vertices[p->indexes[i]].position);
+    }
+    vec3_mul_scalar(centre, centre, 1.0f / (float)p->vertex_count);
+    dist = vec3_dist_sq(centre, merge->view_pos);
 
-        for(polygon_p p = mesh->animated_polygons; p; p = p->next)
+    if((merge->next < merge->list->GetCount()) && (merge->list->GetDistance(merge->next) >= dist))
+    {
+        Render_SetVertexArray(merge, merge->list_base);
+        for( ; (merge->next < merge->list->GetCount()) && (merge->list->GetDistance(merge->next) >= dist); merge->next++)
         {
-            anim_seq_p seq = m_anim_sequences + p->anim_id - 1;
-            uint16_t frame = (seq->current_frame + p->frame_offset) % seq->frames_count;
-            tex_frame_p tf = seq->frames + frame;
-            for(uint16_t i = 0; i < p->vertex_count; i++, data += 2)
-            {
-                ApplyAnimTextureTransformation(data, p->vertices[i].tex_coord, tf);
-            }
+            this->DrawBSPPolygon(merge->list->GetPolygon(merge->next));
+        }
+    }
+
+    Render_SetVertexArray(merge, merge->tree_base);
+    this->DrawBSPPolygon(p);
+}
+
+void CRender::DrawBSPMerged(struct bsp_node_s *root, struct transparency_merge_s *merge)
+{
+    float d = vec3_plane_dist(root->plane, merge->view_pos);
+
+    if(d >= 0)
+    {
+        if(root->back != NULL)
+        {
+            this->DrawBSPMerged(root->back, merge);
+        }
+
+        for(bsp_polygon_p p = root->polygons_back; p; p = p->next)
+        {
+            this->DrawMergedPolygon(p, merge);
+        }
+        for(bsp_polygon_p p = root->polygons_front; p; p = p->next)
+        {
+            this->DrawMergedPolygon(p, merge);
         }
-        qglUnmapBufferARB(GL_ARRAY_BUFFER);
 
-        // Setup altered buffer
-        qglTexCoordPointer(2, GL_FLOAT, sizeof(GLfloat [2]), 0);
+        if(root->front != NULL)
+        {
+            this->DrawBSPMerged(root->front, merge);
+        }
+    }
+    else
+    {
+        if(root->front != NULL)
+        {
+            this->DrawBSPMerged(root->front, merge);
+        }
+
+        for(bsp_polygon_p p = root->polygons_front; p; p = p->next)
+        {
+            this->DrawMergedPolygon(p, merge);
+        }
+        for(bsp_polygon_p p = root->polygons_back; p; p = p->next)
+        {
+            this->DrawMergedPolygon(p, merge);
+        }
+
+        if(root->back != NULL)
+        {
+            this->DrawBSPMerged(root->back, merge);
+        }
+    }
+}
+
+void CRender::UpdateMeshAnimTexCoords(struct base_mesh_s *mesh)
+{
+    // Write tex coords of this frame straight into stream buffer
+    GLsizeiptr offset;
+    GLfloat *data = (GLfloat*)streamBuffer->Map(mesh->animated_vertex_count * sizeof(GLfloat [2]), &offset);
+    mesh->animated_texcoord_buffer = streamBuffer->GetBuffer();
+    mesh->animated_texcoord_offset = offset;
+
+    for(polygon_p p = mesh->animated_polygons; p; p = p->next)
+    {
+        anim_seq_p seq = m_anim_sequences + p->anim_id - 1;
+        uint16_t frame = (seq->current_frame + p->frame_offset) % seq->frames_count;
+        tex_frame_p tf = seq->frames + frame;
+        for(uint16_t i = 0; i < p->vertex_count; i++, data += 2)
+        {
+            ApplyAnimTextureTransformation(data, p->vertices[i].tex_coord, tf);
+        }
+    }
+    streamBuffer->Unmap();
+}
+
+void CRender::DrawMesh(struct base_mesh_s *mesh, const float *overrideVertices, const float *overrideNormals)
+{
+    if(mesh->animated_vertex_count)
+    {
+        this->UpdateMeshAnimTexCoords(mesh);
+
+        // Setup altered buffer (stream buffer is bound)
+        qglTexCoordPointer(2, GL_FLOAT, sizeof(GLfloat [2]), (void*)(uintptr_t)mesh->animated_texcoord_offset);
         // Setup static data
         qglBindBufferARB(GL_ARRAY_BUFFER, mesh->vbo_animated_vertex_array);
         qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, position));
@@ -780,20 +1360,13 @@ void CRender::DrawMesh(struct base_mesh_s *mesh, const float *overrideVertices,
     }
 }
 
-void CRender::DrawSkinMesh(struct base_mesh_s *mesh, struct base_mesh_s *parent_mesh, uint32_t *map, float transform[16])
+static void SkinMeshVertices(struct base_mesh_s *mesh, struct base_mesh_s *parent_mesh, uint32_t *map, float transform[16], GLfloat *dst_v, GLfloat *dst_n)
 {
-    uint32_t i;
-    vertex_p v;
-    float *p_vertex, *src_v, *dst_v;
-    GLfloat *p_normale, *src_n, *dst_n;
-    size_t buf_size = mesh->vertex_count * 3 * sizeof(GLfloat);
+    vertex_p v = mesh->vertices;
+    float *src_v;
+    GLfloat *src_n;
 
-    p_vertex  = (GLfloat*)Sys_GetTempMem(buf_size);
-    p_normale = (GLfloat*)Sys_GetTempMem(buf_size);
-    dst_v = p_vertex;
-    dst_n = p_normale;
-    v = mesh->vertices;
-    for(i = 0; i < mesh->vertex_count; i++, v++, map++)
+    for(uint32_t i = 0; i < mesh->vertex_count; i++, v++, map++)
     {
         src_v = v->position;
         src_n = v->normal;
@@ -812,7 +1385,15 @@ void CRender::DrawSkinMesh(struct base_mesh_s *mesh, struct base_mesh_s *parent_
         dst_v += 3;
         dst_n += 3;
     }
+}
+
+void CRender::DrawSkinMesh(struct base_mesh_s *mesh, struct base_mesh_s *parent_mesh, uint32_t *map, float transform[16])
+{
+    size_t buf_size = mesh->vertex_count * 3 * sizeof(GLfloat);
+    GLfloat *p_vertex  = (GLfloat*)Sys_GetTempMem(buf_size);
+    GLfloat *p_normale = (GLfloat*)Sys_GetTempMem(buf_size);
 
+    SkinMeshVertices(mesh, parent_mesh, map, transform, p_vertex, p_normale);
     this->DrawMesh(mesh, p_vertex, p_normale);
     Sys_ReturnTempMem(2 * buf_size);
 }
@@ -880,18 +1461,73 @@ void CRender::DrawSkeletalModel(const lit_shader_description *shader, struct ss_
     }
 }
 
-void CRender::DrawEntity(struct entity_s *entity, const float modelViewMatrix[16], const float modelViewProjectionMatrix[16])
+/**
+ * Adds skeletal model opaque meshes to the draw packets list
+ */
+void CRender::QueueSkeletalModel(const lit_shader_description *shader, struct ss_bone_frame_s *bframe, const float mvMatrix[16], const float mvpMatrix[16], uint32_t light_index)
+{
+    ss_bone_tag_p btag = bframe->bone_tags;
+    float mvTransform[16];
+    float mvpTransform[16];
+
+    for(uint16_t i = 0; i < bframe->bone_tag_count; i++, btag++)
+    {
+        if(!btag->is_hidden)
+        {
+            Mat4_Mat4_mul(mvTransform, mvMatrix, btag->full_transform);
+            Mat4_Mat4_mul(mvpTransform, mvpMatrix, btag->full_transform);
+            uint32_t matrix_index = drawPackets->AddMatrices(mvTransform, mvpTransform);
+
+            drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_LIT, (btag->mesh_replace) ? (btag->mesh_replace) : (btag->mesh_base), matrix_index, light_index);
+            if(btag->mesh_slot)
+            {
+                drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_LIT, btag->mesh_slot, matrix_index, light_index);
+            }
+            if(btag->mesh_skin && btag->parent && btag->mesh_skin->vertex_count)
+            {
+                const lit_skinned_shader_description *skinned_shader = NULL;
+                if(btag->skin_vbo)
+                {
+                    skinned_shader = shaderManager->getEntitySkinnedShader(drawPackets->GetLightBlock(light_index)->count);
+                }
+                if(skinned_shader)
+                {
+                    float parentMvTransform[16];
+                    float parentMvpTransform[16];
+                    Mat4_Mat4_mul(parentMvTransform, mvMatrix, btag->parent->full_transform);
+                    Mat4_Mat4_mul(parentMvpTransform, mvpMatrix, btag->parent->full_transform);
+                    uint32_t skin_matrix_index = drawPackets->AddSkinMatrices(mvTransform, parentMvTransform, mvpTransform, parentMvpTransform);
+                    drawPackets->AddSkinnedMesh(skinned_shader, btag->mesh_skin, btag->skin_vbo, skin_matrix_index, light_index);
+                    drawPackets->AddAnimatedFaces(shader, DRAW_PACKET_SHADER_LIT, btag->mesh_skin, matrix_index, light_index);
+                    continue;
+                }
+
+                uint32_t skin_offset;
+                uint32_t vertex_count = btag->mesh_skin->vertex_count;
+                GLfloat *v = drawPackets->AllocSkinVertices(vertex_count, &skin_offset);
+                SkinMeshVertices(btag->mesh_skin, btag->parent->mesh_base, btag->skin_map, btag->transform, v, v + 3 * vertex_count);
+                drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_LIT, btag->mesh_skin, matrix_index, light_index, skin_offset);
+            }
+        }
+    }
+}
+
+void CRender::QueueEntity(struct entity_s *entity, const float modelViewMatrix[16], const float modelViewProjectionMatrix[16])
 {
     if(!(entity->state_flags & ENTITY_STATE_VISIBLE) || (entity->bf->animations.model->hide && !(r_flags & R_DRAW_NULLMESHES)))
     {
         return;
     }
 
-    // Calculate lighting
-    const lit_shader_description *shader = this->SetupEntityLight(entity, modelViewMatrix);
-
     if(entity->bf->animations.model && entity->bf->animations.model->animations)
     {
+        // Calculate lighting
+        uint32_t light_index;
+        draw_light_block_p light = drawPackets->AddLightBlock(&light_index);
+        this->CalculateEntityLight(entity, modelViewMatrix, light);
+        const lit_shader_description *shader = shaderManager->getEntityShader(light->count);
+        light_index = drawPackets->MergeLightBlock(light_index);
+
         float subModelView[16];
         float subModelViewProjection[16];
         if(entity->bf->bone_tag_count == 1)
@@ -908,7 +1544,7 @@ void CRender::DrawEntity(struct entity_s *entity, const float modelViewMatrix[16
             Mat4_Mat4_mul(subModelViewProjection, modelViewProjectionMatrix, entity->transform.M4x4);
         }
 
-        this->DrawSkeletalModel(shader, entity->bf, subModelView, subModelViewProjection);
+        this->QueueSkeletalModel(shader, entity->bf, subModelView, subModelViewProjection, light_index);
 
         if(entity->character && entity->character->hair_count)
         {
@@ -922,15 +1558,12 @@ void CRender::DrawEntity(struct entity_s *entity, const float modelViewMatrix[16
                     Hair_GetElementInfo(entity->character->hairs[h], i, &mesh, transform);
                     Mat4_Mat4_mul(subModelView, modelViewMatrix, transform);
                     Mat4_Mat4_mul(subModelViewProjection, modelViewProjectionMatrix, transform);
-
-                    qglUniformMatrix4fvARB(shader->model_view, 1, GL_FALSE, subModelView);
-                    qglUniformMatrix4fvARB(shader->model_view_projection, 1, GL_FALSE, subModelViewProjection);
-                    this->DrawMesh(mesh, NULL, NULL);
+                    drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_LIT, mesh, drawPackets->AddMatrices(subModelView, subModelViewProjection), light_index);
                 }
             }
         }
     }
-    
+
     if((this->r_flags & R_DRAW_AI_PATH) && entity->character && entity->character->path_dist)
     {
         GLfloat red[3] = {1.0f, 0.0f, 0.0f};
@@ -955,12 +1588,11 @@ void CRender::DrawEntity(struct entity_s *entity, const float modelViewMatrix[16
 
 void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], const float modelViewProjectionMatrix[16])
 {
+    PROF_SCOPED_ZONE("CRender::DrawRoom");
     float transform[16];
     engine_container_p cont;
     entity_p ent;
 
-    const shader_description *lastShader = 0;
-
 #if STENCIL_FRUSTUM
     ////start test stencil test code
     bool need_stencil = false;
@@ -1018,31 +1650,45 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
     }
 #endif
 
+    room_batch_p batch = room->content->batch;
+    float roomModelViewProjection[16];
+    Mat4_Mat4_mul(roomModelViewProjection, modelViewProjectionMatrix, room->transform);
+
     if(!(r_flags & R_SKIP_ROOM) && room->content->mesh)
     {
-        float modelViewProjectionTransform[16];
-        Mat4_Mat4_mul(modelViewProjectionTransform, modelViewProjectionMatrix, room->transform);
-
         const unlit_tinted_shader_description *shader = shaderManager->getRoomShader(room->content->light_mode == 1, room->content->room_flags & 1);
 
         GLfloat tint[4];
         CalculateWaterTint(tint, 1);
-        if (shader != lastShader)
+#if STENCIL_FRUSTUM
+        if(need_stencil)
         {
+            // stencil clipped room mesh can't be reordered with other rooms
             qglUseProgramObjectARB(shader->program);
+            qglUniform4fvARB(shader->tint_mult, 1, tint);
+            qglUniform1fARB(shader->current_tick, (GLfloat) SDL_GetTicks());
+            qglUniform1iARB(shader->sampler, 0);
+            qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, roomModelViewProjection);
+            qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
+            this->DrawMesh(room->content->mesh, NULL, NULL);
+            qglDisable(GL_STENCIL_TEST);
+        }
+        else
+#endif
+        if(batch)
+        {
+            uint32_t matrix_index = drawPackets->AddMatrix(roomModelViewProjection);
+            uint32_t tint_index = drawPackets->AddTint(tint);
+            drawPackets->AddBatchPages(shader, DRAW_PACKET_SHADER_TINTED, batch, 0, batch->room_pages_count, matrix_index, tint_index);
+            drawPackets->AddAnimatedFaces(shader, DRAW_PACKET_SHADER_TINTED, room->content->mesh, matrix_index, tint_index);
+        }
+        else
+        {
+            drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_TINTED, room->content->mesh, drawPackets->AddMatrix(roomModelViewProjection), drawPackets->AddTint(tint));
         }
-
-        lastShader = shader;
-        qglUniform4fvARB(shader->tint_mult, 1, tint);
-        qglUniform1fARB(shader->current_tick, (GLfloat) SDL_GetTicks());
-        qglUniform1iARB(shader->sampler, 0);
-        qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, modelViewProjectionTransform);
-        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
-        this->DrawMesh(room->content->mesh, NULL, NULL);
     }
-
 #if STENCIL_FRUSTUM
-    if(need_stencil)
+    else if(need_stencil)
     {
         qglDisable(GL_STENCIL_TEST);
     }
@@ -1051,27 +1697,45 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
     if (room->content->static_mesh_count > 0)
     {
         const unlit_tinted_shader_description *shader = shaderManager->getStaticMeshShader();
-        qglUseProgramObjectARB(shader->program);
+        if(batch && batch->static_pages_count)
+        {
+            // pre-transformed and tinted static meshes, visible together with room
+            GLfloat tint[4];
+            vec4_set_one(tint);
+            if(room->content->room_flags & TR_ROOM_FLAG_WATER)
+            {
+                CalculateWaterTint(tint, 0);
+            }
+            drawPackets->AddBatchPages(shader, DRAW_PACKET_SHADER_TINTED, batch, batch->room_pages_count, batch->static_pages_count,
+                                       drawPackets->AddMatrix(roomModelViewProjection), drawPackets->AddTint(tint));
+        }
+
         for(uint32_t i = 0; i < room->content->static_mesh_count; i++)
         {
-            if(Frustum_IsOBBVisibleInFrustumList(room->content->static_mesh[i].obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)) &&
-               (!room->content->static_mesh[i].hide || (r_flags & R_DRAW_DUMMY_STATICS)))
+            static_mesh_p st = room->content->static_mesh + i;
+            if((!st->batched || st->mesh->animated_vertex_count) &&
+               Frustum_IsOBBVisibleInFrustumList(st->obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)) &&
+               (!st->hide || (r_flags & R_DRAW_DUMMY_STATICS)) &&
+               this->IsOBBNotOccluded(st->obb, OCCLUSION_OBJECT_STATIC))
             {
-                Mat4_Mat4_mul(transform, modelViewProjectionMatrix, room->content->static_mesh[i].transform);
-                qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, transform);
-                qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
-                base_mesh_s *mesh = room->content->static_mesh[i].mesh;
+                Mat4_Mat4_mul(transform, modelViewProjectionMatrix, st->transform);
                 GLfloat tint[4];
 
-                vec4_copy(tint, room->content->static_mesh[i].tint);
+                vec4_copy(tint, st->tint);
 
                 //If this static mesh is in a water room
                 if(room->content->room_flags & TR_ROOM_FLAG_WATER)
                 {
                     CalculateWaterTint(tint, 0);
                 }
-                qglUniform4fvARB(shader->tint_mult, 1, tint);
-                this->DrawMesh(mesh, NULL, NULL);
+                if(st->batched)
+                {
+                    drawPackets->AddAnimatedFaces(shader, DRAW_PACKET_SHADER_TINTED, st->mesh, drawPackets->AddMatrix(transform), drawPackets->AddTint(tint));
+                }
+                else
+                {
+                    drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_TINTED, st->mesh, drawPackets->AddMatrix(transform), drawPackets->AddTint(tint));
+                }
             }
         }
     }
@@ -1082,9 +1746,10 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
         {
         case OBJECT_ENTITY:
             ent = (entity_p)cont->object;
-            if(Frustum_IsOBBVisibleInFrustumList(ent->obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)))
+            if(Frustum_IsOBBVisibleInFrustumList(ent->obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)) &&
+               this->IsOBBNotOccluded(ent->obb, OCCLUSION_OBJECT_ENTITY))
             {
-                this->DrawEntity(ent, modelViewMatrix, modelViewProjectionMatrix);
+                this->QueueEntity(ent, modelViewMatrix, modelViewProjectionMatrix);
             }
             break;
         };
@@ -1102,12 +1767,10 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
                 {
                     if(OBB_OBB_Test(near_room->content->static_mesh[si].obb, room->obb, 0.0f) &&
                        Frustum_IsOBBVisibleInFrustumList(near_room->content->static_mesh[si].obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)) &&
-                       (!near_room->content->static_mesh[si].hide || (r_flags & R_DRAW_DUMMY_STATICS)))
+                       (!near_room->content->static_mesh[si].hide || (r_flags & R_DRAW_DUMMY_STATICS)) &&
+                       this->IsOBBNotOccluded(near_room->content->static_mesh[si].obb, OCCLUSION_OBJECT_STATIC))
                     {
-                        qglUseProgramObjectARB(shader->program);
                         Mat4_Mat4_mul(transform, modelViewProjectionMatrix, near_room->content->static_mesh[si].transform);
-                        qglUniformMatrix4fvARB(shader->model_view_projection, 1, false, transform);
-                        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
                         base_mesh_s *mesh = near_room->content->static_mesh[si].mesh;
                         GLfloat tint[4];
 
@@ -1118,8 +1781,7 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
                         {
                             CalculateWaterTint(tint, 0);
                         }
-                        qglUniform4fvARB(shader->tint_mult, 1, tint);
-                        this->DrawMesh(mesh, NULL, NULL);
+                        drawPackets->AddMesh(shader, DRAW_PACKET_SHADER_TINTED, mesh, drawPackets->AddMatrix(transform), drawPackets->AddTint(tint));
                     }
                 }
             }
@@ -1131,9 +1793,10 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
                 case OBJECT_ENTITY:
                     ent = (entity_p)cont->object;
                     if(OBB_OBB_Test(ent->obb, room->obb, 0.0f) &&
-                       Frustum_IsOBBVisibleInFrustumList(ent->obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)))
+                       Frustum_IsOBBVisibleInFrustumList(ent->obb, (room->frustum) ? (room->frustum) : (m_camera->frustum)) &&
+                       this->IsOBBNotOccluded(ent->obb, OCCLUSION_OBJECT_ENTITY))
                     {
-                        this->DrawEntity(ent, modelViewMatrix, modelViewProjectionMatrix);
+                        this->QueueEntity(ent, modelViewMatrix, modelViewProjectionMatrix);
                     }
                     break;
                 };
@@ -1143,6 +1806,276 @@ void CRender::DrawRoom(struct room_s *room, const float modelViewMatrix[16], con
 }
 
 
+/**
+ * Sorts and draws all queued opaque geometry; state is changed only when
+ * the next packet really needs other one.
+ */
+void CRender::DrawPackets()
+{
+    PROF_SCOPED_ZONE("CRender::DrawPackets");
+    const shader_description *shader = NULL;
+    base_mesh_p mesh = NULL;
+    uint32_t params_index = 0xFFFFFFFF;
+    uint32_t matrix_index = 0xFFFFFFFF;
+    uint32_t skin_offset = DRAW_PACKET_NO_SKIN;
+    uint16_t flags = 0x0000;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+    GLuint vbo_skin = 0;
+    GLint vertex_attrib = -1;                                                   // bone index or animated texture params
+
+    for(uint32_t i = 0; i < drawPackets->GetAnimMeshesCount(); i++)
+    {
+        this->UpdateMeshAnimTexCoords(drawPackets->GetAnimMesh(i));
+    }
+
+    // Sequences state for shader side animated textures: first frame, frames count, current frame, uvrotate
+    if(m_anim_seq_state)
+    {
+        GLfloat *st = m_anim_seq_state;
+        GLfloat first_frame = 0.0f;
+        anim_seq_p seq = m_anim_sequences;
+        for(uint32_t i = 0; i < m_anim_sequences_count; i++, seq++, st += 4)
+        {
+            st[0] = first_frame;
+            st[1] = seq->frames_count;
+            st[2] = seq->current_frame;
+            st[3] = seq->frames[seq->current_frame].current_uvrotate;
+            first_frame += seq->frames_count;
+        }
+    }
+
+    // CPU skinned vertices of all packets by one upload; used as offsets in stream buffer
+    const uint8_t *skin_pool = NULL;
+    GLuint skin_pool_vbo = 0;
+    if(drawPackets->GetSkinVerticesCount() > 0)
+    {
+        skin_pool = (const uint8_t*)(uintptr_t)streamBuffer->Upload(drawPackets->GetSkinVertices(0), drawPackets->GetSkinVerticesCount() * sizeof(GLfloat));
+        skin_pool_vbo = streamBuffer->GetBuffer();
+    }
+
+    drawPackets->Sort();
+    for(uint32_t i = 0; i < drawPackets->GetPacketsCount(); i++)
+    {
+        draw_packet_p p = drawPackets->GetSortedPacket(i);
+        const shader_description *packet_shader = p->shader;
+        uint32_t instances = 1;
+
+        if((p->shader_type == DRAW_PACKET_SHADER_LIT) && (p->skin_offset == DRAW_PACKET_NO_SKIN) && !(p->flags & DRAW_PACKET_ANIMATED_GPU) &&
+           ((instances = drawPackets->GetInstancesCount(i)) > 1))
+        {
+            const lit_instanced_shader_description *instanced_shader = shaderManager->getEntityInstancedShader(drawPackets->GetLightBlock(p->params_index)->count);
+            if(instanced_shader)
+            {
+                packet_shader = instanced_shader;
+            }
+            else
+            {
+                instances = 1;
+            }
+        }
+
+        if(shader != packet_shader)
+        {
+            const unlit_shader_description *s = (const unlit_shader_description*)packet_shader;
+            shader = packet_shader;
+            qglUseProgramObjectARB(s->program);
+            qglUniform1iARB(s->sampler, 0);
+            qglUniform1fARB(s->dist_fog, m_camera->dist_far);
+            if(p->shader_type == DRAW_PACKET_SHADER_TINTED)
+            {
+                qglUniform1fARB(((const unlit_tinted_shader_description*)s)->current_tick, (GLfloat) SDL_GetTicks());
+            }
+            if((s->anim_sequences >= 0) && m_anim_seq_state)
+            {
+                qglUniform4fvARB(s->anim_sequences, m_anim_sequences_count, m_anim_seq_state);
+            }
+            params_index = 0xFFFFFFFF;                                          // uniforms are per program state
+            matrix_index = 0xFFFFFFFF;
+            if(vertex_attrib >= 0)
+            {
+                vbo = 0;                                                        // attribute location is per program too
+            }
+            drawPackets->m_program_binds++;
+        }
+
+        if(params_index != p->params_index)
+        {
+            params_index = p->params_index;
+            if(p->shader_type == DRAW_PACKET_SHADER_TINTED)
+            {
+                qglUniform4fvARB(((const unlit_tinted_shader_description*)shader)->tint_mult, 1, drawPackets->GetTint(params_index));
+            }
+            else
+            {
+                const lit_shader_description *s = (const lit_shader_description*)shader;
+                const draw_light_block_t *light = drawPackets->GetLightBlock(params_index);
+                qglUniform4fvARB(s->light_ambient, 1, light->ambient);
+                if(light->count > 0)
+                {
+                    qglUniform4fvARB(s->light_color, light->count, light->colors);
+                    qglUniform3fvARB(s->light_position, light->count, light->positions);
+                    qglUniform1fvARB(s->light_inner_radius, light->count, light->inner_radiuses);
+                    qglUniform1fvARB(s->light_outer_radius, light->count, light->outer_radiuses);
+                }
+            }
+        }
+
+        if((instances == 1) && (matrix_index != p->matrix_index))
+        {
+            matrix_index = p->matrix_index;
+            if(p->shader_type == DRAW_PACKET_SHADER_TINTED)
+            {
+                qglUniformMatrix4fvARB(((const unlit_shader_description*)shader)->model_view_projection, 1, false, drawPackets->GetMatrix(matrix_index));
+            }
+            else if(p->shader_type == DRAW_PACKET_SHADER_LIT)
+            {
+                qglUniformMatrix4fvARB(((const lit_shader_description*)shader)->model_view, 1, false, drawPackets->GetMatrix(matrix_index));
+                qglUniformMatrix4fvARB(((const lit_shader_description*)shader)->model_view_projection, 1, false, drawPackets->GetMatrix(matrix_index + 1));
+            }
+            else
+            {
+                qglUniformMatrix4fvARB(((const lit_shader_description*)shader)->model_view, 2, false, drawPackets->GetMatrix(matrix_index));
+                qglUniformMatrix4fvARB(((const lit_shader_description*)shader)->model_view_projection, 2, false, drawPackets->GetMatrix(matrix_index + 2));
+            }
+        }
+
+        if((vbo != p->vbo) || (vbo_skin != p->vbo_skin) || (mesh != p->mesh) || (flags != p->flags) || (skin_offset != p->skin_offset))
+        {
+            if(vertex_attrib >= 0)
+            {
+                qglDisableVertexAttribArrayARB(vertex_attrib);
+                vertex_attrib = -1;
+            }
+            vbo = p->vbo;
+            vbo_skin = p->vbo_skin;
+            mesh = p->mesh;
+            flags = p->flags;
+            skin_offset = p->skin_offset;
+            if(flags & DRAW_PACKET_ANIMATED_GPU)
+            {
+                vertex_attrib = ((const unlit_shader_description*)shader)->anim_params;
+                qglBindBufferARB(GL_ARRAY_BUFFER_ARB, mesh->vbo_animated_params_array);
+                qglEnableVertexAttribArrayARB(vertex_attrib);
+                qglVertexAttribPointerARB(vertex_attrib, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat [2]), (void*)0);
+                qglBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
+                qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, position));
+                qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, color));
+                qglNormalPointer(GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, normal));
+                qglTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, tex_coord));
+            }
+            else if(flags & DRAW_PACKET_ANIMATED)
+            {
+                qglBindBufferARB(GL_ARRAY_BUFFER_ARB, mesh->animated_texcoord_buffer);
+                qglTexCoordPointer(2, GL_FLOAT, sizeof(GLfloat [2]), (void*)(uintptr_t)mesh->animated_texcoord_offset);
+                qglBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
+                qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, position));
+                qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, color));
+                qglNormalPointer(GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, normal));
+            }
+            else
+            {
+                qglBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo);
+                qglVertexPointer(3, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, position));
+                qglColorPointer(4, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, color));
+                qglNormalPointer(GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, normal));
+                qglTexCoordPointer(2, GL_FLOAT, sizeof(vertex_t), (void*)offsetof(vertex_t, tex_coord));
+                if(skin_offset != DRAW_PACKET_NO_SKIN)
+                {
+                    const GLfloat *v = (const GLfloat*)skin_pool + skin_offset;
+                    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, skin_pool_vbo);
+                    qglVertexPointer(3, GL_FLOAT, 0, v);
+                    qglNormalPointer(GL_FLOAT, 0, v + 3 * mesh->vertex_count);
+                }
+                else if(vbo_skin)
+                {
+                    vertex_attrib = ((const lit_skinned_shader_description*)shader)->bone_index;
+                    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo_skin);
+                    qglVertexPointer(3, GL_FLOAT, sizeof(skin_vertex_t), (void*)offsetof(skin_vertex_t, position));
+                    qglNormalPointer(GL_FLOAT, sizeof(skin_vertex_t), (void*)offsetof(skin_vertex_t, normal));
+                    qglEnableVertexAttribArrayARB(vertex_attrib);
+                    qglVertexAttribPointerARB(vertex_attrib, 1, GL_FLOAT, GL_FALSE, sizeof(skin_vertex_t), (void*)offsetof(skin_vertex_t, bone));
+                }
+            }
+            drawPackets->m_buffer_binds++;
+        }
+
+        if(ibo != p->ibo)
+        {
+            ibo = p->ibo;
+            qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, ibo);
+        }
+
+        if(m_active_texture != p->texture_index)
+        {
+            m_active_texture = p->texture_index;
+            qglBindTexture(GL_TEXTURE_2D, m_active_texture);
+            drawPackets->m_texture_binds++;
+        }
+        if(instances > 1)
+        {
+            this->DrawPacketInstances((const lit_instanced_shader_description*)shader, i, instances);
+            i += instances - 1;
+        }
+        else
+        {
+            qglDrawElements(GL_TRIANGLES, p->elements_count, GL_UNSIGNED_INT, p->elements);
+        }
+        drawPackets->m_draw_calls++;
+    }
+
+    if(ibo != 0)
+    {
+        qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+    }
+    if(vertex_attrib >= 0)
+    {
+        qglDisableVertexAttribArrayARB(vertex_attrib);
+    }
+}
+
+
+/**
+ * Draws sorted packets [first, first + count) of the same mesh face by one
+ * instanced call; mv and mvp matrices are streamed as instance attributes.
+ */
+void CRender::DrawPacketInstances(const lit_instanced_shader_description *shader, uint32_t first, uint32_t count)
+{
+    const size_t instance_size = 2 * 16 * sizeof(GLfloat);
+    GLsizeiptr base;
+    GLfloat *buf = (GLfloat*)streamBuffer->Map(count * instance_size, &base);
+    draw_packet_p p = drawPackets->GetSortedPacket(first);
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        memcpy(buf + 32 * i, drawPackets->GetMatrix(drawPackets->GetSortedPacket(first + i)->matrix_index), instance_size);
+    }
+    streamBuffer->Unmap();
+
+    for(GLuint c = 0; c < 4; c++)
+    {
+        GLuint mv = shader->instance_model_view + c;
+        GLuint mvp = shader->instance_model_view_projection + c;
+        qglEnableVertexAttribArrayARB(mv);
+        qglVertexAttribPointerARB(mv, 4, GL_FLOAT, GL_FALSE, instance_size, (void*)(base + c * 4 * sizeof(GLfloat)));
+        qglVertexAttribDivisorARB(mv, 1);
+        qglEnableVertexAttribArrayARB(mvp);
+        qglVertexAttribPointerARB(mvp, 4, GL_FLOAT, GL_FALSE, instance_size, (void*)(base + (16 + c * 4) * sizeof(GLfloat)));
+        qglVertexAttribDivisorARB(mvp, 1);
+    }
+
+    qglDrawElementsInstancedARB(GL_TRIANGLES, p->elements_count, GL_UNSIGNED_INT, p->elements, count);
+
+    for(GLuint c = 0; c < 4; c++)
+    {
+        qglVertexAttribDivisorARB(shader->instance_model_view + c, 0);
+        qglDisableVertexAttribArrayARB(shader->instance_model_view + c);
+        qglVertexAttribDivisorARB(shader->instance_model_view_projection + c, 0);
+        qglDisableVertexAttribArrayARB(shader->instance_model_view_projection + c);
+    }
+}
+
+
 void CRender::DrawRoomSprites(struct room_s *room)
 {
     if (room->content->sprites_count > 0)
@@ -1255,14 +2188,16 @@ int  CRender::AddRoom(struct room_s *room)
  * The reccursion algorithm: go through the rooms with portal - frustum occlusion test
  * @portal - we entered to the room through that portal
  * @frus - frustum that intersects the portal
+ * @pvs_room - room with camera, its PVS limits the search
+ * @depth - portals count from camera
  * @return number of added rooms
  */
-int CRender::ProcessRoom(struct portal_s *portal, struct frustum_s *frus)
+int CRender::ProcessRoom(struct portal_s *portal, struct frustum_s *frus, struct room_s *pvs_room, uint32_t depth)
 {
     int ret = 0;
     room_p room = portal->dest_room->real_room;
 
-    if(room->is_in_r_list && (room->frustum == NULL))
+    if((room->is_in_r_list && (room->frustum == NULL)) || (depth >= R_MAX_PORTALS_DEPTH))
     {
         return 0;
     }
@@ -1271,12 +2206,16 @@ int CRender::ProcessRoom(struct portal_s *portal, struct frustum_s *frus)
     {
         portal_p p = room->content->portals + i;
         room_p dest_room = p->dest_room->real_room;
+        if(!PVS_IsVisible(&m_pvs, pvs_room->id, dest_room->id))
+        {
+            continue;                                                           // no line from camera room reaches it
+        }
         frustum_p gen_frus = frustumManager->PortalFrustumIntersect(p, frus, m_camera);  // backface portals are filtered here
         if(gen_frus)
         {
             ret++;
             this->AddRoom(dest_room);
-            this->ProcessRoom(p, gen_frus);
+            this->ProcessRoom(p, gen_frus, pvs_room, depth + 1);
         }
     }
 
@@ -1287,15 +2226,12 @@ int CRender::ProcessRoom(struct portal_s *portal, struct frustum_s *frus)
  * Sets up the light calculations for the given entity based on its current
  * room. Returns the used shader, which will have been made current already.
  */
-const lit_shader_description *CRender::SetupEntityLight(struct entity_s *entity, const float modelViewMatrix[16])
+void CRender::CalculateEntityLight(struct entity_s *entity, const float modelViewMatrix[16], struct draw_light_block_s *light)
 {
-    // Calculate lighting
-    const lit_shader_description *shader;
-
     room_s *room = entity->self->room;
     if(room != NULL)
     {
-        GLfloat ambient_component[4];
+        GLfloat *ambient_component = light->ambient;
 
         ambient_component[0] = room->content->ambient_lighting[0];
         ambient_component[1] = room->content->ambient_lighting[1];
@@ -1310,14 +2246,14 @@ const lit_shader_description *CRender::SetupEntityLight(struct entity_s *entity,
         GLenum current_light_number = 0;
         light_s *current_light = NULL;
 
-        GLfloat positions[3*MAX_NUM_LIGHTS];
-        GLfloat colors[4*MAX_NUM_LIGHTS];
-        GLfloat innerRadiuses[1*MAX_NUM_LIGHTS];
-        GLfloat outerRadiuses[1*MAX_NUM_LIGHTS];
-        memset(positions, 0, sizeof(positions));
-        memset(colors, 0, sizeof(colors));
-        memset(innerRadiuses, 0, sizeof(innerRadiuses));
-        memset(outerRadiuses, 0, sizeof(outerRadiuses));
+        GLfloat *positions = light->positions;
+        GLfloat *colors = light->colors;
+        GLfloat *innerRadiuses = light->inner_radiuses;
+        GLfloat *outerRadiuses = light->outer_radiuses;
+        memset(positions, 0, sizeof(light->positions));
+        memset(colors, 0, sizeof(light->colors));
+        memset(innerRadiuses, 0, sizeof(light->inner_radiuses));
+        memset(outerRadiuses, 0, sizeof(light->outer_radiuses));
 
         float *entity_pos = entity->transform.M4x4 + 12;
 
@@ -1392,22 +2328,13 @@ const lit_shader_description *CRender::SetupEntityLight(struct entity_s *entity,
             }
         }
 
-        shader = shaderManager->getEntityShader(current_light_number);
-        qglUseProgramObjectARB(shader->program);
-        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
-        qglUniform4fvARB(shader->light_ambient, 1, ambient_component);
-        qglUniform4fvARB(shader->light_color, current_light_number, colors);
-        qglUniform3fvARB(shader->light_position, current_light_number, positions);
-        qglUniform1fvARB(shader->light_inner_radius, current_light_number, innerRadiuses);
-        qglUniform1fvARB(shader->light_outer_radius, current_light_number, outerRadiuses);
+        light->count = current_light_number;
     }
     else
     {
-        shader = shaderManager->getEntityShader(0);
-        qglUseProgramObjectARB(shader->program);
-        qglUniform1fARB(shader->dist_fog, m_camera->dist_far);
+        vec4_set_one(light->ambient);
+        light->count = 0;
     }
-    return shader;
 }
 
 /**
@@ -1418,7 +2345,6 @@ m_drawFlags(0x00000000),
 m_max_lines(DEBUG_DRAWER_DEFAULT_BUFFER_SIZE),
 m_lines(0),
 m_need_realloc(false),
-m_gl_vbo(0),
 m_buffer(NULL),
 m_obb(NULL)
 {
@@ -1431,11 +2357,6 @@ CRenderDebugDrawer::~CRenderDebugDrawer()
 {
     free(m_buffer);
     m_buffer = NULL;
-    if(m_gl_vbo != 0)
-    {
-        qglDeleteBuffersARB(1, &m_gl_vbo);
-        m_gl_vbo = 0;
-    }
     OBB_Delete(m_obb);
     m_obb = NULL;
 }
@@ -1454,21 +2375,16 @@ void CRenderDebugDrawer::Reset()
         }
         m_need_realloc = false;
     }
-    if(m_gl_vbo == 0)
-    {
-        qglGenBuffersARB(1, &m_gl_vbo);
-    }
     m_lines = 0;
 }
 
-void CRenderDebugDrawer::Render()
+void CRenderDebugDrawer::Render(class CStreamBuffer *stream)
 {
-    if((m_lines > 0) && (m_gl_vbo != 0))
+    if(m_lines > 0)
     {
-        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_gl_vbo);
-        qglBufferDataARB(GL_ARRAY_BUFFER_ARB, m_lines * 12 * sizeof(GLfloat), m_buffer, GL_STREAM_DRAW);
-        qglVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), (void*)0);
-        qglColorPointer(3, GL_FLOAT, 6 * sizeof(GLfloat),  (void*)(3 * sizeof(GLfloat)));
+        uint8_t *base = (uint8_t*)(uintptr_t)stream->Upload(m_buffer, m_lines * 12 * sizeof(GLfloat));
+        qglVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), base);
+        qglColorPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), base + 3 * sizeof(GLfloat));
         qglDrawArrays(GL_LINES, 0, 2 * m_lines);
         qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
     }
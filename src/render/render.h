@@ -7,6 +7,7 @@
 #include <SDL2/SDL_opengl.h>
 
 #include "../core/vmath.h"
+#include "pvs.h"
 
 #define R_DRAW_WIRE             0x00000001      // Wireframe rendering
 #define R_DRAW_ROOMBOXES        0x00000002      // Show room bounds
@@ -32,6 +33,7 @@
 #define R_DRAW_AI_PATH          0x00200000      // AI character target path drawing
 
 #define STENCIL_FRUSTUM 1
+#define R_MAX_PORTALS_DEPTH     (48)            // portal recursion limit per frame
 
 struct portal_s;
 struct frustum_s;
@@ -43,6 +45,10 @@ struct sprite_s;
 struct base_mesh_s;
 struct obb_s;
 struct lit_shader_description;
+struct draw_light_block_s;
+struct bsp_node_s;
+struct bsp_polygon_s;
+struct transparency_merge_s;
 
 // Native TR blending modes.
 
@@ -68,6 +74,11 @@ enum BlendingMode
 #define TR_ANIMTEXTURE_BACKWARD          1
 #define TR_ANIMTEXTURE_REVERSE           2
 
+// Transparency sorting modes
+
+#define TRANSPARENCY_DYNAMIC_BSP         0      // whole BSP tree is rebuilt every frame
+#define TRANSPARENCY_CACHED_BSP          1      // rooms trees are built on load, entities are depth sorted; opt-in, not validated yet
+
 
 typedef struct render_settings_s
 {
@@ -78,8 +89,10 @@ typedef struct render_settings_s
     int8_t    antialias;
     int8_t    antialias_samples;
     int8_t    texture_border;
+    int8_t    texture_compression;
     int8_t    z_depth;
     int8_t    fog_enabled;
+    int8_t    transparency_mode;
     GLfloat   fog_color[4];
     float     fog_start_depth;
     float     fog_end_depth;
@@ -97,7 +110,7 @@ class CRenderDebugDrawer
             return m_lines == 0;
         }
         void Reset();
-        void Render();
+        void Render(class CStreamBuffer *stream);
         void SetColor(GLfloat r, GLfloat g, GLfloat b)
         {
             m_color[0] = r;
@@ -127,7 +140,6 @@ class CRenderDebugDrawer
         uint32_t m_lines;
         bool     m_need_realloc;
 
-        GLuint   m_gl_vbo;
         GLfloat  m_color[3];
         GLfloat *m_buffer;
 
@@ -141,6 +153,7 @@ class CRender
         CRender();
        ~CRender();
         void DoShaders();
+        void BeginFrame();
         void ResetWorld(struct room_s *rooms, uint32_t rooms_count, struct anim_seq_s *anim_sequences, uint32_t anim_sequences_count);
         void UpdateAnimTextures();
 
@@ -152,13 +165,15 @@ class CRender
         void DrawBSPPolygon(struct bsp_polygon_s *p);
         void DrawBSPFrontToBack(struct bsp_node_s *root);
         void DrawBSPBackToFront(struct bsp_node_s *root);
+        void DrawBSPMerged(struct bsp_node_s *root, struct transparency_merge_s *merge);
 
         void DrawMesh(struct base_mesh_s *mesh, const float *overrideVertices, const float *overrideNormals);
         void DrawSkinMesh(struct base_mesh_s *mesh, struct base_mesh_s *parent_mesh, uint32_t *map, float transform[16]);
         void DrawSkyBox(const float matrix[16]);
 
         void DrawSkeletalModel(const struct lit_shader_description *shader, struct ss_bone_frame_s *bframe, const float mvMatrix[16], const float mvpMatrix[16]);
-        void DrawEntity(struct entity_s *entity, const float modelViewMatrix[16], const float modelViewProjectionMatrix[16]);
+        void QueueSkeletalModel(const struct lit_shader_description *shader, struct ss_bone_frame_s *bframe, const float mvMatrix[16], const float mvpMatrix[16], uint32_t light_index);
+        void QueueEntity(struct entity_s *entity, const float modelViewMatrix[16], const float modelViewProjectionMatrix[16]);
 
         void DrawRoom(struct room_s *room, const float matrix[16], const float modelViewProjectionMatrix[16]);
         void DrawRoomSprites(struct room_s *room);
@@ -175,8 +190,19 @@ class CRender
 
         void InitSettings();
         int  AddRoom(struct room_s *room);
-        int  ProcessRoom(struct portal_s *portal, struct frustum_s *frus);
-        const lit_shader_description *SetupEntityLight(struct entity_s *entity, const float modelViewMatrix[16]);
+        int  ProcessRoom(struct portal_s *portal, struct frustum_s *frus, struct room_s *pvs_room, uint32_t depth);
+        void AddRoomsOutside(struct camera_s *cam);
+        void GenRoomsBSP();
+        void ClearRoomsBSP();
+        void DrawTransparencyDynamicBSP();
+        void DrawTransparencyCachedBSP();
+        void DrawMergedPolygon(struct bsp_polygon_s *p, struct transparency_merge_s *merge);
+        void GenOcclusionBuffer();
+        bool IsOBBNotOccluded(struct obb_s *obb, int object_type);
+        void CalculateEntityLight(struct entity_s *entity, const float modelViewMatrix[16], struct draw_light_block_s *light);
+        void UpdateMeshAnimTexCoords(struct base_mesh_s *mesh);
+        void DrawPackets();
+        void DrawPacketInstances(const struct lit_instanced_shader_description *shader, uint32_t first, uint32_t count);
 
         struct camera_s            *m_camera;
 
@@ -184,6 +210,11 @@ class CRender
         uint32_t                    m_rooms_count;
         struct anim_seq_s          *m_anim_sequences;
         uint32_t                    m_anim_sequences_count;
+        GLfloat                    *m_anim_seq_state;                           // NULL if animated textures are evaluated on CPU
+        struct room_pvs_s           m_pvs;
+        class CDynamicBSP         **m_rooms_bsp;                                // cached trees by room id, of original contents
+        uint32_t                    m_rooms_bsp_count;
+        bool                        m_occlusion_ready;
 
         uint16_t                    m_active_transparency;
         GLuint                      m_active_texture;
@@ -198,6 +229,10 @@ class CRender
         class shader_manager       *shaderManager;
         class CRenderDebugDrawer   *debugDrawer;
         class CDynamicBSP          *dynamicBSP;
+        class CSortedPolygonList   *sortedPolygons;
+        class COcclusionBuffer     *occlusionBuffer;
+        class CDrawPacketList      *drawPackets;
+        class CStreamBuffer        *streamBuffer;
         uint32_t                    r_flags;
 };
 
@@ -11,7 +11,7 @@
 
 #include <stdlib.h>
 
-shader_stage::shader_stage(GLenum type, const char *filename, const char *additionalDefines)
+shader_stage::shader_stage(GLenum type, const char *filename, const char *additionalDefines, bool required)
 {
     char shader_path[1024];
     size_t shader_path_base_len = sizeof(shader_path) - 1;
@@ -19,7 +19,8 @@ shader_stage::shader_stage(GLenum type, const char *filename, const char *additi
     shader_path[shader_path_base_len] = 0;
     strncat(shader_path, filename, shader_path_base_len - strlen(shader_path));
     shader = qglCreateShaderObjectARB(type);
-    if (!loadShaderFromFile(shader, shader_path, additionalDefines))
+    compiled = loadShaderFromFile(shader, shader_path, additionalDefines) != 0;
+    if (!compiled && required)
         abort();
 }
 
@@ -35,6 +36,8 @@ shader_description::shader_description(const shader_stage &vertex, const shader_
     qglAttachObjectARB(program, fragment.shader);
     qglLinkProgramARB(program);
     //printInfoLog(program);
+    linked = 0;
+    qglGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &linked);
 
     sampler = qglGetUniformLocationARB(program, "color_map");
 }
@@ -56,6 +59,10 @@ unlit_shader_description::unlit_shader_description(const shader_stage &vertex, c
 {
     model_view_projection = qglGetUniformLocationARB(program, "modelViewProjection");
     dist_fog = qglGetUniformLocationARB(program, "distFog");
+    anim_frames = qglGetUniformLocationARB(program, "animFrames");
+    anim_sequences = qglGetUniformLocationARB(program, "animSequences");
+    anim_params = qglGetAttribLocationARB(program, "animParams");
+    anim_variant = NULL;
 }
 
 lit_shader_description::lit_shader_description(const shader_stage &vertex, const shader_stage &fragment)
@@ -70,6 +77,19 @@ lit_shader_description::lit_shader_description(const shader_stage &vertex, const
     light_ambient = qglGetUniformLocationARB(program, "light_ambient");
 }
 
+lit_skinned_shader_description::lit_skinned_shader_description(const shader_stage &vertex, const shader_stage &fragment)
+: lit_shader_description(vertex, fragment)
+{
+    bone_index = qglGetAttribLocationARB(program, "boneIndex");
+}
+
+lit_instanced_shader_description::lit_instanced_shader_description(const shader_stage &vertex, const shader_stage &fragment)
+: lit_shader_description(vertex, fragment)
+{
+    instance_model_view = qglGetAttribLocationARB(program, "instanceModelView");
+    instance_model_view_projection = qglGetAttribLocationARB(program, "instanceModelViewProjection");
+}
+
 unlit_tinted_shader_description::unlit_tinted_shader_description(const shader_stage &vertex, const shader_stage &fragment)
 : unlit_shader_description(vertex, fragment)
 {
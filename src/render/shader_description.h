@@ -8,8 +8,9 @@
 struct shader_stage
 {
     GLhandleARB shader;
+    bool compiled;
     
-    shader_stage(GLenum type, const char *filename, const char *additionalDefines = 0);
+    shader_stage(GLenum type, const char *filename, const char *additionalDefines = 0, bool required = true);
     ~shader_stage();
 };
 
@@ -24,6 +25,7 @@ struct shader_description
 {
     GLhandleARB program;
     GLint sampler;
+    GLint linked;
     
     shader_description(const shader_stage &vertex, const shader_stage &fragment);
     ~shader_description();
@@ -42,11 +44,17 @@ struct text_shader_description : public shader_description
 
 /*!
  * A shader description type that contains transform information. This comes in the form of a model view projection matrix.
+ * Animated texture variant (IS_ANIMATED) evaluates texture coordinates from frame table
+ * and per sequence state; anim_* locations are -1 for other shaders.
  */
 struct unlit_shader_description : public shader_description
 {
     GLint model_view_projection;
     GLint dist_fog;
+    GLint anim_frames;
+    GLint anim_sequences;
+    GLint anim_params;
+    const unlit_shader_description *anim_variant;       // NULL if animated textures are not evaluated on GPU
 
     unlit_shader_description(const shader_stage &vertex, const shader_stage &fragment);
 };
@@ -69,6 +77,30 @@ struct lit_shader_description : public unlit_shader_description
     lit_shader_description(const shader_stage &vertex, const shader_stage &fragment);
 };
 
+/*!
+ * Lit shader with bone palette for GPU skinning: model view (projection)
+ * uniforms are arrays of two matrices (own bone, parent bone), per vertex
+ * bone index is taken from boneIndex attribute.
+ */
+struct lit_skinned_shader_description : public lit_shader_description
+{
+    GLint bone_index;
+
+    lit_skinned_shader_description(const shader_stage &vertex, const shader_stage &fragment);
+};
+
+/*!
+ * Lit shader for instanced drawing: model view (projection) matrices are
+ * per instance vertex attributes (mat4: four attribute locations each).
+ */
+struct lit_instanced_shader_description : public lit_shader_description
+{
+    GLint instance_model_view;
+    GLint instance_model_view_projection;
+
+    lit_instanced_shader_description(const shader_stage &vertex, const shader_stage &fragment);
+};
+
 struct unlit_tinted_shader_description : public unlit_shader_description
 {
     GLint current_tick;
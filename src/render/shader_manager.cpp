@@ -3,10 +3,64 @@
 
 #include "shader_manager.h"
 
+/*
+ * Shared by all animated texture vertex shader variants (static mesh, room, entity):
+ * frame table (mat, move) is set once per level, sequence state (first frame,
+ * frames count, current frame, uvrotate) every frame.
+ */
+static std::string animVariantPreamble()
+{
+    std::ostringstream stream;
+    stream << "#define IS_ANIMATED 1" << std::endl;
+    stream << "#define ANIM_TEX_MAX_FRAMES " << ANIM_TEX_MAX_FRAMES << std::endl;
+    stream << "#define ANIM_TEX_MAX_SEQUENCES " << ANIM_TEX_MAX_SEQUENCES << std::endl;
+    stream << "attribute vec2 animParams;                      // sequence index, frame offset\n"
+              "uniform vec4 animFrames[2 * ANIM_TEX_MAX_FRAMES];\n"
+              "uniform vec4 animSequences[ANIM_TEX_MAX_SEQUENCES];\n"
+              "\n"
+              "vec2 animTexCoord(vec2 uv)\n"
+              "{\n"
+              "    vec4 seq = animSequences[int(animParams.x + 0.5)];\n"
+              "    float frame = seq.z + animParams.y;\n"
+              "    if(frame >= seq.y)\n"
+              "    {\n"
+              "        frame -= seq.y;\n"
+              "    }\n"
+              "    int i = 2 * int(seq.x + frame + 0.5);\n"
+              "    vec4 mat = animFrames[i];\n"
+              "    vec2 ret = vec2(mat.x * uv.x + mat.z * uv.y, mat.y * uv.x + mat.w * uv.y) + animFrames[i + 1].xy;\n"
+              "    if(frame == seq.z)\n"
+              "    {\n"
+              "        ret.y -= seq.w;                         // uvrotate shifts current frame only\n"
+              "    }\n"
+              "    return ret;\n"
+              "}\n";
+    return stream.str();
+}
+
+// Animated texture variants are optional: frame table may not fit into vertex uniforms
+template <class description>
+static description *linkAnimVariant(const shader_stage &vertex, const shader_stage &fragment)
+{
+    if (!vertex.compiled)
+        return NULL;
+
+    description *variant = new description(vertex, fragment);
+    if (!variant->linked || (variant->anim_frames < 0) || (variant->anim_sequences < 0) || (variant->anim_params < 0)) {
+        delete variant;
+        return NULL;
+    }
+    return variant;
+}
+
 shader_manager::shader_manager()
 {
+    anim_variants_count = 0;
+
     //Color mult prog
-    static_mesh_shader = new unlit_tinted_shader_description(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/static_mesh.vsh"), shader_stage(GL_FRAGMENT_SHADER_ARB, "shaders/static_mesh.fsh"));
+    shader_stage staticMeshFragmentShader(GL_FRAGMENT_SHADER_ARB, "shaders/static_mesh.fsh");
+    static_mesh_shader = new unlit_tinted_shader_description(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/static_mesh.vsh"), staticMeshFragmentShader);
+    addAnimVariant(static_mesh_shader, linkAnimVariant<unlit_tinted_shader_description>(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/static_mesh.vsh", animVariantPreamble().c_str(), false), staticMeshFragmentShader));
 
     //Room prog
     shader_stage roomFragmentShader(GL_FRAGMENT_SHADER_ARB, "shaders/room.fsh");
@@ -19,16 +73,55 @@ shader_manager::shader_manager()
             stream << "#define IS_FLICKER " << isFlicker << std::endl;
 
             room_shaders[isWater][isFlicker] = new unlit_tinted_shader_description(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/room.vsh", stream.str().c_str()), roomFragmentShader);
+
+            stream << animVariantPreamble();
+            addAnimVariant(room_shaders[isWater][isFlicker], linkAnimVariant<unlit_tinted_shader_description>(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/room.vsh", stream.str().c_str(), false), roomFragmentShader));
         }
     }
 
     // Entity prog
     shader_stage entityVertexShader(GL_VERTEX_SHADER_ARB, "shaders/entity.vsh");
+    shader_stage entityAnimVertexShader(GL_VERTEX_SHADER_ARB, "shaders/entity.vsh", animVariantPreamble().c_str(), false);
     for (int i = 0; i <= MAX_NUM_LIGHTS; i++) {
         std::ostringstream stream;
         stream << "#define NUMBER_OF_LIGHTS " << i << std::endl;
 
-        entity_shader[i] = new lit_shader_description(entityVertexShader, shader_stage(GL_FRAGMENT_SHADER_ARB, "shaders/entity.fsh", stream.str().c_str()));
+        shader_stage entityFragmentShader(GL_FRAGMENT_SHADER_ARB, "shaders/entity.fsh", stream.str().c_str());
+        entity_shader[i] = new lit_shader_description(entityVertexShader, entityFragmentShader);
+        addAnimVariant(entity_shader[i], linkAnimVariant<lit_shader_description>(entityAnimVertexShader, entityFragmentShader));
+    }
+
+    // Skinned entity prog; optional, not all drivers may handle it
+    shader_stage entitySkinnedVertexShader(GL_VERTEX_SHADER_ARB, "shaders/entity_skinned.vsh", 0, false);
+    for (int i = 0; i <= MAX_NUM_LIGHTS; i++) {
+        entity_skinned_shader[i] = NULL;
+        if (entitySkinnedVertexShader.compiled) {
+            std::ostringstream stream;
+            stream << "#define NUMBER_OF_LIGHTS " << i << std::endl;
+
+            entity_skinned_shader[i] = new lit_skinned_shader_description(entitySkinnedVertexShader, shader_stage(GL_FRAGMENT_SHADER_ARB, "shaders/entity.fsh", stream.str().c_str()));
+            if (!entity_skinned_shader[i]->linked || (entity_skinned_shader[i]->bone_index < 0)) {
+                delete entity_skinned_shader[i];
+                entity_skinned_shader[i] = NULL;
+            }
+        }
+    }
+
+    // Instanced entity prog; optional, needs ARB_draw_instanced + ARB_instanced_arrays
+    bool instancing = (qglDrawElementsInstancedARB != NULL) && (qglVertexAttribDivisorARB != NULL);
+    shader_stage entityInstancedVertexShader(GL_VERTEX_SHADER_ARB, "shaders/entity_instanced.vsh", 0, false);
+    for (int i = 0; i <= MAX_NUM_LIGHTS; i++) {
+        entity_instanced_shader[i] = NULL;
+        if (instancing && entityInstancedVertexShader.compiled) {
+            std::ostringstream stream;
+            stream << "#define NUMBER_OF_LIGHTS " << i << std::endl;
+
+            entity_instanced_shader[i] = new lit_instanced_shader_description(entityInstancedVertexShader, shader_stage(GL_FRAGMENT_SHADER_ARB, "shaders/entity.fsh", stream.str().c_str()));
+            if (!entity_instanced_shader[i]->linked || (entity_instanced_shader[i]->instance_model_view < 0) || (entity_instanced_shader[i]->instance_model_view_projection < 0)) {
+                delete entity_instanced_shader[i];
+                entity_instanced_shader[i] = NULL;
+            }
+        }
     }
 
     text = new text_shader_description(shader_stage(GL_VERTEX_SHADER_ARB, "shaders/text.vsh"), shader_stage(GL_FRAGMENT_SHADER_ARB, "shaders/text.fsh"));
@@ -39,12 +132,45 @@ shader_manager::~shader_manager()
     // Do nothing. All shaders are released by OpenGL anyway.
 }
 
+void shader_manager::addAnimVariant(unlit_shader_description *shader, unlit_shader_description *variant)
+{
+    shader->anim_variant = variant;
+    if (variant) {
+        anim_variants[anim_variants_count++] = variant;
+    }
+}
+
+bool shader_manager::setAnimFrames(const GLfloat *frames, unsigned framesCount) const
+{
+    assert(framesCount <= ANIM_TEX_MAX_FRAMES);
+
+    for (unsigned i = 0; i < anim_variants_count; i++) {
+        qglUseProgramObjectARB(anim_variants[i]->program);
+        qglUniform4fvARB(anim_variants[i]->anim_frames, 2 * framesCount, frames);
+    }
+    qglUseProgramObjectARB(0);
+
+    return anim_variants_count > 0;
+}
+
 const lit_shader_description *shader_manager::getEntityShader(unsigned numberOfLights) const {
     assert(numberOfLights <= MAX_NUM_LIGHTS);
 
     return entity_shader[numberOfLights];
 }
 
+const lit_skinned_shader_description *shader_manager::getEntitySkinnedShader(unsigned numberOfLights) const {
+    assert(numberOfLights <= MAX_NUM_LIGHTS);
+
+    return entity_skinned_shader[numberOfLights];
+}
+
+const lit_instanced_shader_description *shader_manager::getEntityInstancedShader(unsigned numberOfLights) const {
+    assert(numberOfLights <= MAX_NUM_LIGHTS);
+
+    return entity_instanced_shader[numberOfLights];
+}
+
 const unlit_tinted_shader_description *shader_manager::getRoomShader(bool isFlickering, bool isWater) const
 {
     return room_shaders[isWater ? 1 : 0][isFlickering ? 1 : 0];
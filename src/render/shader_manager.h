@@ -6,23 +6,43 @@
 // Highest number of lights that will show up in the entity shader.
 #define MAX_NUM_LIGHTS 8
 
+// Animated texture tables must fit into vertex shader uniforms (two vec4 per
+// frame, one per sequence); levels with more are animated on CPU.
+#define ANIM_TEX_MAX_FRAMES 96
+#define ANIM_TEX_MAX_SEQUENCES 32
+
 class shader_manager {
     unlit_tinted_shader_description *room_shaders[2][2];
     unlit_tinted_shader_description *static_mesh_shader;
     lit_shader_description *entity_shader[MAX_NUM_LIGHTS+1];
+    lit_skinned_shader_description *entity_skinned_shader[MAX_NUM_LIGHTS+1];
+    lit_instanced_shader_description *entity_instanced_shader[MAX_NUM_LIGHTS+1];
     text_shader_description *text;
+    unlit_shader_description *anim_variants[1 + 4 + MAX_NUM_LIGHTS + 1];
+    unsigned anim_variants_count;
+
+    void addAnimVariant(unlit_shader_description *shader, unlit_shader_description *variant);
 
 public:
     shader_manager();
     ~shader_manager();
     
     const lit_shader_description *getEntityShader(unsigned numberOfLights) const;
+
+    // NULL if skinning shader is not supported: skin meshes are transformed on CPU then
+    const lit_skinned_shader_description *getEntitySkinnedShader(unsigned numberOfLights) const;
+
+    // NULL if instancing is not supported: every instance is drawn by own call then
+    const lit_instanced_shader_description *getEntityInstancedShader(unsigned numberOfLights) const;
     
     const unlit_tinted_shader_description *getStaticMeshShader() const { return static_mesh_shader; }
     
     const unlit_tinted_shader_description *getRoomShader(bool isFlickering, bool isWater) const;
     
     const text_shader_description *getTextShader() const { return text; }
+
+    // Sets frame table of all animated texture variants; false if there are none
+    bool setAnimFrames(const GLfloat *frames, unsigned framesCount) const;
 };
 
 #endif /* defined(__OpenTomb__shader_manager__) */
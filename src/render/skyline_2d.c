@@ -0,0 +1,195 @@
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "skyline_2d.h"
+
+/*!
+ * One horizontal segment of the skyline: area below y in [x, x + width) is taken.
+ */
+typedef struct skyline_2d_node_s
+{
+    unsigned x;
+    unsigned y;
+    unsigned width;
+} skyline_2d_node_t, *skyline_2d_node_p;
+
+/*!
+ * Segments are kept sorted by x and cover the whole width without gaps.
+ */
+struct skyline_2d_s
+{
+    skyline_2d_node_p nodes;
+    unsigned nodes_count;
+    unsigned nodes_capacity;
+
+    unsigned width;
+    unsigned height;
+};
+
+#define SKYLINE_CAPACITY_GROWTH (64)
+
+
+skyline_2d_p Skyline2D_Create(unsigned width, unsigned height)
+{
+    skyline_2d_p skyline = (skyline_2d_p)malloc(sizeof(struct skyline_2d_s));
+    skyline->width = width;
+    skyline->height = height;
+    skyline->nodes_capacity = SKYLINE_CAPACITY_GROWTH;
+    skyline->nodes = (skyline_2d_node_p)malloc(skyline->nodes_capacity * sizeof(skyline_2d_node_t));
+    skyline->nodes_count = 1;
+    skyline->nodes[0].x = 0;
+    skyline->nodes[0].y = 0;
+    skyline->nodes[0].width = width;
+
+    return skyline;
+}
+
+
+void Skyline2D_Destroy(skyline_2d_p skyline)
+{
+    if(skyline)
+    {
+        free(skyline->nodes);
+        free(skyline);
+    }
+}
+
+
+/*
+ * Returns 1 if rectangle fits with its left edge at node index; *y is its
+ * lowest possible position and *waste the free area left under it.
+ */
+static int Skyline2D_Fit(skyline_2d_p skyline, unsigned index, unsigned width, unsigned height, unsigned *y, unsigned long *waste)
+{
+    skyline_2d_node_p node = skyline->nodes + index;
+    unsigned x = node->x;
+    unsigned top = 0;
+    unsigned left = width;
+
+    if(x + width > skyline->width)
+    {
+        return 0;
+    }
+
+    for(unsigned i = index; left > 0; i++, node++)
+    {
+        assert(i < skyline->nodes_count);
+        top = (node->y > top) ? (node->y) : (top);
+        if(top + height > skyline->height)
+        {
+            return 0;
+        }
+        left -= (node->width < left) ? (node->width) : (left);
+    }
+
+    *waste = 0;
+    left = width;
+    node = skyline->nodes + index;
+    for(unsigned i = index; left > 0; i++, node++)
+    {
+        unsigned w = (node->width < left) ? (node->width) : (left);
+        *waste += (unsigned long)(top - node->y) * w;
+        left -= w;
+    }
+    *y = top;
+
+    return 1;
+}
+
+
+int Skyline2D_FindSpaceFor(skyline_2d_p skyline, unsigned width, unsigned height, unsigned *x, unsigned *y)
+{
+    unsigned best_index = skyline->nodes_count;
+    unsigned best_top = skyline->height + 1;
+    unsigned long best_waste = 0;
+
+    if((width == 0) || (height == 0) || (width > skyline->width) || (height > skyline->height))
+    {
+        return 0;
+    }
+
+    for(unsigned i = 0; i < skyline->nodes_count; i++)
+    {
+        unsigned fit_y;
+        unsigned long waste;
+        if(skyline->nodes[i].x + width > skyline->width)
+        {
+            break;
+        }
+        if(Skyline2D_Fit(skyline, i, width, height, &fit_y, &waste) &&
+           ((fit_y + height < best_top) || ((fit_y + height == best_top) && (waste < best_waste))))
+        {
+            best_index = i;
+            best_top = fit_y + height;
+            best_waste = waste;
+        }
+    }
+
+    if(best_index >= skyline->nodes_count)
+    {
+        return 0;
+    }
+
+    *x = skyline->nodes[best_index].x;
+    *y = best_top - height;
+
+    // Insert new segment over the placed rectangle.
+    if(skyline->nodes_count + 1 > skyline->nodes_capacity)
+    {
+        skyline->nodes_capacity += SKYLINE_CAPACITY_GROWTH;
+        skyline->nodes = (skyline_2d_node_p)realloc(skyline->nodes, skyline->nodes_capacity * sizeof(skyline_2d_node_t));
+    }
+    memmove(skyline->nodes + best_index + 1, skyline->nodes + best_index, (skyline->nodes_count - best_index) * sizeof(skyline_2d_node_t));
+    skyline->nodes_count++;
+    skyline->nodes[best_index].x = *x;
+    skyline->nodes[best_index].y = best_top;
+    skyline->nodes[best_index].width = width;
+
+    // Cut segments that are now under it.
+    unsigned right = *x + width;
+    unsigned i = best_index + 1;
+    while((i < skyline->nodes_count) && (skyline->nodes[i].x < right))
+    {
+        skyline_2d_node_p node = skyline->nodes + i;
+        unsigned shrink = right - node->x;
+        if(shrink < node->width)
+        {
+            node->x += shrink;
+            node->width -= shrink;
+            break;
+        }
+        memmove(node, node + 1, (skyline->nodes_count - i - 1) * sizeof(skyline_2d_node_t));
+        skyline->nodes_count--;
+    }
+
+    // Merge neighbours of the same height.
+    for(i = 0; i + 1 < skyline->nodes_count;)
+    {
+        skyline_2d_node_p node = skyline->nodes + i;
+        if(node->y == node[1].y)
+        {
+            node->width += node[1].width;
+            memmove(node + 1, node + 2, (skyline->nodes_count - i - 2) * sizeof(skyline_2d_node_t));
+            skyline->nodes_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return 1;
+}
+
+
+unsigned Skyline2D_GetUsedHeight(skyline_2d_p skyline)
+{
+    unsigned ret = 0;
+    for(unsigned i = 0; i < skyline->nodes_count; i++)
+    {
+        ret = (skyline->nodes[i].y > ret) ? (skyline->nodes[i].y) : (ret);
+    }
+    return ret;
+}
@@ -0,0 +1,53 @@
+#ifndef SKYLINE_2D_H
+#define SKYLINE_2D_H
+
+/*!
+ * @header skyline_2d
+ * @abstract Manage the fill state of a 2D rectangle where new rectangles may be added at any time.
+ * @discussion This is used internally by the bordered texture atlas for laying out texture tiles in the big texture atlas pages.
+ *
+ * Internally, the filled area is described by its upper contour (the skyline): a list of horizontal segments, each with the lowest free y coordinate above it. New rectangles are placed by the bottom-left rule: at the position where their top edge ends up lowest, ties broken by less wasted area under the rectangle. For tiles sorted by height this gives noticeably denser pages than splitting the free space into a tree, and the used height of a page stays as small as possible.
+ * @see bordered_textured_atlas_t
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * The struct that defines this type. Its contents are not relevant for or accessible to clients.
+ */
+typedef struct skyline_2d_s *skyline_2d_p;
+
+/*!
+ * Creates a new skyline for an empty area with the given dimensions.
+ */
+skyline_2d_p Skyline2D_Create(unsigned width, unsigned height);
+
+/*!
+ * Destroys a skyline and releases all allocated resources.
+ */
+void Skyline2D_Destroy(skyline_2d_p skyline);
+
+/*!
+ * @abstract Find space for a given rectangle within the skyline's area.
+ * @discussion Produces the start of an area that has the passed in size, and does not overlap any area returned by previous calls to this method. If no such area can be found, it returns 0 and leaves the internal state untouched.
+ * @param skyline The skyline.
+ * @param width The width of the area.
+ * @param height The height of the area.
+ * @param x On return, the x coordinate of the found area. Must never be NULL.
+ * @param y On return, the y coordinate of the found area. Must never be NULL.
+ * @result 1 if such an area was found, or 0 if no area was found.
+ */
+int Skyline2D_FindSpaceFor(skyline_2d_p skyline, unsigned width, unsigned height, unsigned *x, unsigned *y);
+
+/*!
+ * Returns the lowest y coordinate that is free over the whole width, i.e. the used height of the area.
+ */
+unsigned Skyline2D_GetUsedHeight(skyline_2d_p skyline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKYLINE_2D_H */
@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "../core/gl_util.h"
+#include "stream_buffer.h"
+
+#define STREAM_BUFFER_ALIGN             (64)
+#define STREAM_BUFFER_WAIT_TIMEOUT      (1000000000)                            // ns
+
+
+CStreamBuffer::CStreamBuffer(GLsizeiptr size):
+m_vbo(0),
+m_size(size),
+m_begin(0),
+m_end(size),
+m_offset(0),
+m_mode(STREAM_BUFFER_MODE_SUB_DATA),
+m_frame(0),
+m_persistent(NULL),
+m_overflow(NULL),
+m_overflow_count(0),
+m_overflow_size(0),
+m_overflow_offset(0),
+m_last_vbo(0),
+m_staging(NULL),
+m_staging_size(0),
+m_map_offset(0),
+m_map_size(0),
+m_map_gl(false),
+m_used(0),
+m_overflows(0)
+{
+    for(int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+    {
+        m_fences[i] = NULL;
+    }
+}
+
+
+CStreamBuffer::~CStreamBuffer()
+{
+    this->Deinit();
+    this->DeleteOverflow();
+    free(m_overflow);
+    m_overflow = NULL;
+    free(m_staging);
+    m_staging = NULL;
+    m_staging_size = 0;
+}
+
+
+/*
+ * Needs GL context, so it is called on the first frame, not in constructor.
+ */
+void CStreamBuffer::Init(GLsizeiptr size)
+{
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    m_size = size;
+    m_frame = 0;
+    qglGenBuffersARB(1, &m_vbo);
+    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_vbo);
+    if(qglBufferStorage && qglMapBufferRange && qglFenceSync)
+    {
+        qglBufferStorage(GL_ARRAY_BUFFER_ARB, m_size, NULL, flags);
+        m_persistent = (uint8_t*)qglMapBufferRange(GL_ARRAY_BUFFER_ARB, 0, m_size, flags);
+        if(!m_persistent)
+        {
+            // immutable storage can not be respecified: take a new buffer
+            qglDeleteBuffersARB(1, &m_vbo);
+            qglGenBuffersARB(1, &m_vbo);
+            qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_vbo);
+        }
+    }
+
+    if(m_persistent)
+    {
+        m_mode = STREAM_BUFFER_MODE_PERSISTENT;
+        m_begin = 0;
+        m_end = m_size / STREAM_BUFFER_FRAMES / STREAM_BUFFER_ALIGN * STREAM_BUFFER_ALIGN;
+    }
+    else
+    {
+        qglBufferDataARB(GL_ARRAY_BUFFER_ARB, m_size, NULL, GL_STREAM_DRAW_ARB);
+        m_mode = (qglMapBufferRange) ? (STREAM_BUFFER_MODE_MAP_RANGE) : (STREAM_BUFFER_MODE_SUB_DATA);
+        m_begin = 0;
+        m_end = m_size;
+    }
+    m_offset = m_begin;
+    m_last_vbo = m_vbo;
+}
+
+
+void CStreamBuffer::Deinit()
+{
+    for(int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+    {
+        if(m_fences[i])
+        {
+            qglDeleteSync(m_fences[i]);
+            m_fences[i] = NULL;
+        }
+    }
+
+    if(m_vbo != 0)
+    {
+        if(m_persistent)
+        {
+            qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_vbo);
+            qglUnmapBufferARB(GL_ARRAY_BUFFER_ARB);
+            m_persistent = NULL;
+        }
+        qglDeleteBuffersARB(1, &m_vbo);                                         // GL keeps storage while GPU uses it
+        m_vbo = 0;
+    }
+}
+
+
+void CStreamBuffer::DeleteOverflow()
+{
+    if(m_overflow_count > 0)
+    {
+        qglDeleteBuffersARB(m_overflow_count, m_overflow);
+        m_overflow_count = 0;
+    }
+    m_overflow_size = 0;
+    m_overflow_offset = 0;
+}
+
+
+void CStreamBuffer::BeginFrame()
+{
+    // previous frame used (m_used) is the estimate of this frame
+    GLsizeiptr frame_size = (GLsizeiptr)m_used + STREAM_BUFFER_ALIGN;
+
+    if(m_vbo == 0)
+    {
+        this->Init(m_size);
+    }
+    else if(frame_size > m_end - m_begin)
+    {
+        // previous frame overflowed: grow storage to fit the whole frame
+        GLsizeiptr new_size = m_size;
+        GLsizeiptr parts = (m_mode == STREAM_BUFFER_MODE_PERSISTENT) ? (STREAM_BUFFER_FRAMES) : (1);
+        while(new_size / parts < frame_size + STREAM_BUFFER_ALIGN)
+        {
+            new_size *= 2;
+        }
+        this->Deinit();
+        this->Init(new_size);
+    }
+    else if(m_mode == STREAM_BUFFER_MODE_PERSISTENT)
+    {
+        GLsizeiptr part = m_end - m_begin;
+        m_fences[m_frame] = qglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_frame = (m_frame + 1) % STREAM_BUFFER_FRAMES;
+        if(m_fences[m_frame])
+        {
+            qglClientWaitSync(m_fences[m_frame], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_WAIT_TIMEOUT);
+            qglDeleteSync(m_fences[m_frame]);
+            m_fences[m_frame] = NULL;
+        }
+        m_begin = m_frame * part;
+        m_end = m_begin + part;
+        m_offset = m_begin;
+    }
+    else if(m_offset + frame_size > m_end)
+    {
+        // orphan between frames only: offsets of previous frame stay valid for GPU
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_vbo);
+        qglBufferDataARB(GL_ARRAY_BUFFER_ARB, m_size, NULL, GL_STREAM_DRAW_ARB);
+        m_offset = m_begin;
+    }
+
+    this->DeleteOverflow();
+    m_last_vbo = m_vbo;
+    m_used = 0;
+    m_overflows = 0;
+}
+
+
+GLsizeiptr CStreamBuffer::Alloc(GLsizeiptr size)
+{
+    GLsizeiptr offset = (m_offset + STREAM_BUFFER_ALIGN - 1) / STREAM_BUFFER_ALIGN * STREAM_BUFFER_ALIGN;
+
+    m_used += (size + STREAM_BUFFER_ALIGN - 1) / STREAM_BUFFER_ALIGN * STREAM_BUFFER_ALIGN;
+    if(offset + size <= m_end)
+    {
+        m_offset = offset + size;
+        m_last_vbo = m_vbo;
+    }
+    else
+    {
+        // storage is full: never wrap in the middle of a frame, data already
+        // given out is still going to be drawn; use temporary buffer instead
+        m_overflows++;
+        offset = (m_overflow_offset + STREAM_BUFFER_ALIGN - 1) / STREAM_BUFFER_ALIGN * STREAM_BUFFER_ALIGN;
+        if((m_overflow_count == 0) || (offset + size > m_overflow_size))
+        {
+            GLsizeiptr new_size = m_end - m_begin;
+            while(new_size < size)
+            {
+                new_size *= 2;
+            }
+            m_overflow = (GLuint*)realloc(m_overflow, (m_overflow_count + 1) * sizeof(GLuint));
+            qglGenBuffersARB(1, m_overflow + m_overflow_count);
+            qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_overflow[m_overflow_count]);
+            qglBufferDataARB(GL_ARRAY_BUFFER_ARB, new_size, NULL, GL_STREAM_DRAW_ARB);
+            m_overflow_size = new_size;
+            m_overflow_count++;
+            offset = 0;
+        }
+        m_overflow_offset = offset + size;
+        m_last_vbo = m_overflow[m_overflow_count - 1];
+    }
+    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, m_last_vbo);
+
+    return offset;
+}
+
+
+void *CStreamBuffer::Map(GLsizeiptr size, GLsizeiptr *offset)
+{
+    *offset = this->Alloc(size);
+
+    if((m_mode == STREAM_BUFFER_MODE_PERSISTENT) && (m_last_vbo == m_vbo))
+    {
+        return m_persistent + *offset;
+    }
+    else if(m_mode != STREAM_BUFFER_MODE_SUB_DATA)
+    {
+        void *ret = qglMapBufferRange(GL_ARRAY_BUFFER_ARB, *offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if(ret)
+        {
+            m_map_gl = true;
+            return ret;
+        }
+    }
+
+    if(size > m_staging_size)
+    {
+        m_staging_size = size;
+        m_staging = (uint8_t*)realloc(m_staging, m_staging_size);
+    }
+    m_map_offset = *offset;
+    m_map_size = size;
+
+    return m_staging;
+}
+
+
+void CStreamBuffer::Unmap()
+{
+    if(m_map_gl)
+    {
+        qglUnmapBufferARB(GL_ARRAY_BUFFER_ARB);
+        m_map_gl = false;
+    }
+    else if(m_map_size > 0)
+    {
+        qglBufferSubDataARB(GL_ARRAY_BUFFER_ARB, m_map_offset, m_map_size, m_staging);
+        m_map_size = 0;
+    }
+}
+
+
+GLsizeiptr CStreamBuffer::Upload(const void *data, GLsizeiptr size)
+{
+    GLsizeiptr offset;
+
+    if(m_mode == STREAM_BUFFER_MODE_SUB_DATA)
+    {
+        offset = this->Alloc(size);
+        qglBufferSubDataARB(GL_ARRAY_BUFFER_ARB, offset, size, data);
+    }
+    else
+    {
+        memcpy(this->Map(size, &offset), data, size);
+        this->Unmap();
+    }
+
+    return offset;
+}
@@ -0,0 +1,84 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <stdint.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
+
+#define STREAM_BUFFER_FRAMES            (3)
+
+#define STREAM_BUFFER_MODE_SUB_DATA     (0)                                     // glBufferSubData, orphaning between frames
+#define STREAM_BUFFER_MODE_MAP_RANGE    (1)                                     // unsynchronized glMapBufferRange, orphaning between frames
+#define STREAM_BUFFER_MODE_PERSISTENT   (2)                                     // persistent mapping, fenced frame partitions
+
+/*
+ * One vertex buffer for all per frame dynamic data: transparent polygons,
+ * animated texture coords, skinned vertices, instance matrices, debug lines.
+ * Data is sub allocated linearly, and an offset given out stays valid until
+ * the end of the frame; a region is never rewritten while GPU may read it:
+ * - persistent mode: storage is split into STREAM_BUFFER_FRAMES partitions,
+ *   frame writes into own partition only, after the fence of the frame that
+ *   used it before is signaled;
+ * - other modes: if the rest of storage is less than the previous frame
+ *   used, the whole storage is orphaned in BeginFrame().
+ * Frame data that does not fit goes to temporary overflow buffers, which
+ * are dropped by the next BeginFrame(); then the storage grows to fit the
+ * whole frame. So data may be in different buffers: GetBuffer() gives the
+ * buffer of the last allocation, keep it with the offset if it is used
+ * later. Allocations leave that buffer bound to GL_ARRAY_BUFFER; don't bind
+ * other array buffer between Map() and Unmap().
+ */
+class CStreamBuffer
+{
+    GLuint               m_vbo;
+    GLsizeiptr           m_size;                                                // whole storage
+    GLsizeiptr           m_begin;                                               // current partition
+    GLsizeiptr           m_end;
+    GLsizeiptr           m_offset;                                              // first free byte
+    uint32_t             m_mode;
+    uint32_t             m_frame;
+    GLsync               m_fences[STREAM_BUFFER_FRAMES];
+    uint8_t             *m_persistent;
+
+    GLuint              *m_overflow;                                            // buffers of this frame only
+    uint32_t             m_overflow_count;
+    GLsizeiptr           m_overflow_size;                                       // of the last one
+    GLsizeiptr           m_overflow_offset;
+    GLuint               m_last_vbo;                                            // of the last allocation
+
+    uint8_t             *m_staging;                                             // Map() without GL mapping
+    GLsizeiptr           m_staging_size;
+    GLsizeiptr           m_map_offset;
+    GLsizeiptr           m_map_size;
+    bool                 m_map_gl;
+
+    void Init(GLsizeiptr size);
+    void Deinit();
+    void DeleteOverflow();
+    GLsizeiptr Alloc(GLsizeiptr size);
+
+public:
+    CStreamBuffer(GLsizeiptr size);
+   ~CStreamBuffer();
+
+    void BeginFrame();
+    void *Map(GLsizeiptr size, GLsizeiptr *offset);
+    void Unmap();
+    GLsizeiptr Upload(const void *data, GLsizeiptr size);
+
+    GLuint GetBuffer()
+    {
+        return m_last_vbo;
+    }
+
+    uint32_t GetMode()
+    {
+        return m_mode;
+    }
+
+    // statistics of the current frame
+    uint32_t             m_used;                                                // bytes, with alignment
+    uint32_t             m_overflows;                                           // allocations out of storage
+};
+
+#endif
@@ -1617,6 +1617,8 @@ void TR_GenSkeletalModel(struct skeletal_model_s *model, size_t model_id, struct
     }
 
     model->animations = (animation_frame_p)calloc(model->animation_count, sizeof(animation_frame_t));
+    // heap instead of temp memory: models are generated by job workers
+    rotations = (tr5_vertex_t*)malloc(model->mesh_count * sizeof(tr5_vertex_t));
     anim = model->animations;
     for(uint16_t i = 0; i < model->animation_count; i++, anim++)
     {
@@ -1697,7 +1699,6 @@ void TR_GenSkeletalModel(struct skeletal_model_s *model, size_t model_id, struct
          * let us begin to load animations
          */
         bone_frame = anim->frames;
-        rotations = (tr5_vertex_t*)Sys_GetTempMem(model->mesh_count * sizeof(tr5_vertex_t));
         for(uint16_t frame_index = 0; frame_index < anim->frames_count; frame_index++, bone_frame++)
         {
             bone_frame->bone_tag_count = model->mesh_count;
@@ -1732,7 +1733,7 @@ void TR_GenSkeletalModel(struct skeletal_model_s *model, size_t model_id, struct
             }
         }
     }
-    Sys_ReturnTempMem(model->mesh_count * sizeof(tr5_vertex_t));
+    free(rotations);
     /*
      * Animations interpolation to 1/30 sec like in original. Needed for correct state change works.
      */
@@ -55,6 +55,15 @@ void Room_Clear(struct room_s *room)
             content->mesh = NULL;
         }
 
+        if(content->batch)
+        {
+            qglDeleteBuffersARB(1, &content->batch->vbo_vertex_array);
+            qglDeleteBuffersARB(1, &content->batch->vbo_index_array);
+            free(content->batch->pages);
+            free(content->batch);
+            content->batch = NULL;
+        }
+
         if(content->static_mesh_count)
         {
             for(uint32_t i = 0; i < content->static_mesh_count; i++)
@@ -643,6 +652,177 @@ void Room_GenSpritesBuffer(struct room_s *room)
 }
 
 
+static uint32_t Room_BatchAddFaces(GLuint *elements, struct mesh_face_s *faces, uint32_t faces_count, GLuint texture_index, uint32_t vertex_offset)
+{
+    uint32_t ret = 0;
+    for(uint32_t i = 0; i < faces_count; i++)
+    {
+        if(faces[i].texture_index == texture_index)
+        {
+            for(uint32_t j = 0; j < faces[i].elements_count; j++)
+            {
+                *elements++ = faces[i].elements[j] + vertex_offset;
+            }
+            ret += faces[i].elements_count;
+        }
+    }
+    return ret;
+}
+
+
+static int Room_BatchHasPage(struct room_batch_s *batch, uint16_t first, GLuint texture_index)
+{
+    for(uint16_t i = first; i < batch->room_pages_count + batch->static_pages_count; i++)
+    {
+        if(batch->pages[i].texture_index == texture_index)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+void Room_GenBatch(struct room_s *room)
+{
+    room_content_p content = room->content;
+    base_mesh_p room_mesh = content->mesh;
+    uint32_t vertex_count = 0;
+    uint32_t elements_count = 0;
+    uint32_t max_pages = 0;
+
+    content->batch = NULL;
+    if(room_mesh && (room_mesh->vertex_count > 0))
+    {
+        vertex_count += room_mesh->vertex_count;
+        max_pages += room_mesh->faces_count;
+        for(uint32_t i = 0; i < room_mesh->faces_count; i++)
+        {
+            elements_count += room_mesh->faces[i].elements_count;
+        }
+    }
+
+    for(uint32_t i = 0; i < content->static_mesh_count; i++)
+    {
+        static_mesh_p st = content->static_mesh + i;
+        st->batched = !st->hide && (st->mesh->vertex_count > 0) && (st->mesh->faces_count > 0);
+        if(st->batched)
+        {
+            vertex_count += st->mesh->vertex_count;
+            max_pages += st->mesh->faces_count;
+            for(uint32_t j = 0; j < st->mesh->faces_count; j++)
+            {
+                elements_count += st->mesh->faces[j].elements_count;
+            }
+        }
+    }
+
+    if(elements_count == 0)
+    {
+        for(uint32_t i = 0; i < content->static_mesh_count; i++)
+        {
+            content->static_mesh[i].batched = 0;
+        }
+        return;
+    }
+
+    room_batch_p batch = (room_batch_p)malloc(sizeof(room_batch_t));
+    vertex_p vertices = (vertex_p)malloc(vertex_count * sizeof(vertex_t));
+    GLuint *elements = (GLuint*)malloc(elements_count * sizeof(GLuint));
+    uint32_t *static_offsets = (uint32_t*)malloc((content->static_mesh_count + 1) * sizeof(uint32_t));
+    uint32_t vertex_offset = 0;
+    uint32_t elements_offset = 0;
+
+    batch->pages = (room_batch_page_p)malloc(max_pages * sizeof(room_batch_page_t));
+    batch->room_pages_count = 0;
+    batch->static_pages_count = 0;
+
+    // room geometry is already in room space
+    if(room_mesh && (room_mesh->vertex_count > 0))
+    {
+        memcpy(vertices, room_mesh->vertices, room_mesh->vertex_count * sizeof(vertex_t));
+        vertex_offset = room_mesh->vertex_count;
+        for(uint32_t i = 0; i < room_mesh->faces_count; i++)
+        {
+            GLuint texture_index = room_mesh->faces[i].texture_index;
+            if(!Room_BatchHasPage(batch, 0, texture_index))
+            {
+                room_batch_page_p page = batch->pages + batch->room_pages_count++;
+                page->texture_index = texture_index;
+                page->elements_offset = elements_offset;
+                page->elements_count = Room_BatchAddFaces(elements + elements_offset, room_mesh->faces, room_mesh->faces_count, texture_index, 0);
+                elements_offset += page->elements_count;
+            }
+        }
+    }
+
+    // static meshes: room space positions and normals, tint goes to colour
+    for(uint32_t i = 0; i < content->static_mesh_count; i++)
+    {
+        static_mesh_p st = content->static_mesh + i;
+        static_offsets[i] = vertex_offset;
+        if(st->batched)
+        {
+            float tr[16];
+            vertex_p src = st->mesh->vertices;
+            vertex_p dst = vertices + vertex_offset;
+            Mat4_inv_Mat4_affine_mul(tr, room->transform, st->transform);
+            for(uint32_t j = 0; j < st->mesh->vertex_count; j++, src++, dst++)
+            {
+                *dst = *src;
+                Mat4_vec3_mul_macro(dst->position, tr, src->position);
+                Mat4_vec3_rot_macro(dst->normal, tr, src->normal);
+                dst->color[0] = src->color[0] * st->tint[0];
+                dst->color[1] = src->color[1] * st->tint[1];
+                dst->color[2] = src->color[2] * st->tint[2];
+                dst->color[3] = src->color[3] * st->tint[3];
+            }
+            vertex_offset += st->mesh->vertex_count;
+        }
+    }
+
+    for(uint32_t i = 0; i < content->static_mesh_count; i++)
+    {
+        static_mesh_p st = content->static_mesh + i;
+        for(uint32_t j = 0; st->batched && (j < st->mesh->faces_count); j++)
+        {
+            GLuint texture_index = st->mesh->faces[j].texture_index;
+            if(!Room_BatchHasPage(batch, batch->room_pages_count, texture_index))
+            {
+                room_batch_page_p page = batch->pages + batch->room_pages_count + batch->static_pages_count++;
+                page->texture_index = texture_index;
+                page->elements_offset = elements_offset;
+                page->elements_count = 0;
+                for(uint32_t k = i; k < content->static_mesh_count; k++)
+                {
+                    static_mesh_p st2 = content->static_mesh + k;
+                    if(st2->batched)
+                    {
+                        page->elements_count += Room_BatchAddFaces(elements + elements_offset + page->elements_count,
+                                                                   st2->mesh->faces, st2->mesh->faces_count, texture_index, static_offsets[k]);
+                    }
+                }
+                elements_offset += page->elements_count;
+            }
+        }
+    }
+
+    qglGenBuffersARB(1, &batch->vbo_vertex_array);
+    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, batch->vbo_vertex_array);
+    qglBufferDataARB(GL_ARRAY_BUFFER_ARB, vertex_count * sizeof(vertex_t), vertices, GL_STATIC_DRAW_ARB);
+    qglGenBuffersARB(1, &batch->vbo_index_array);
+    qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, batch->vbo_index_array);
+    qglBufferDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, elements_count * sizeof(GLuint), elements, GL_STATIC_DRAW_ARB);
+    qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    qglBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+
+    free(static_offsets);
+    free(elements);
+    free(vertices);
+    content->batch = batch;
+}
+
+
 /*
  *   Sectors functionality
  */
@@ -824,110 +1004,829 @@ int  Room_IsInBox(room_box_p box, float pos[3])
 }
 
 
-int  Room_FindPath(room_box_p *path_buf, uint32_t max_boxes, room_sector_p from, room_sector_p to, box_validition_options_p op)
+/*
+ * A* over boxes overlaps. Box node cost is Manhattan length of the way through
+ * overlaps centres, heuristic is Manhattan distance to the target box (never
+ * bigger than the rest of the way, so the first popped target is the best).
+ * Search arrays live between queries: a box state is valid only if its stamp
+ * is equal to the current query one, so nothing is cleared per query.
+ */
+#define PATH_NO_BOX             (0xFFFF)
+#define PATH_CACHE_SIZE         (32)
+#define PATH_CACHE_MAX_BOXES    (16)
+
+typedef struct path_search_s
+{
+    uint32_t                boxes_count;
+    uint32_t                stamp;
+    uint32_t               *stamps;
+    uint16_t               *parents;
+    uint16_t               *heap;
+    uint32_t               *heap_pos;                                           // heap index + 1, 0 if box is closed
+    float                  *costs;                                              // from start
+    float                  *scores;                                             // cost + heuristic
+    float                  *points;                                             // box entry point, x and y
+    uint32_t                heap_size;
+}path_search_t, *path_search_p;
+
+typedef struct path_cache_entry_s
 {
-    int ret = 0;
-    if(from->box && to->box)
+    uint16_t                from;
+    uint16_t                to;
+    uint16_t                step_up;
+    uint16_t                step_down;
+    uint16_t                zone_type : 15;
+    uint16_t                zone_alt : 1;
+    uint16_t                boxes_count;                                        // 0 - unused entry
+    uint32_t                path_length;                                        // 0 - no path
+    uint32_t                last_use;
+    uint16_t                boxes[PATH_CACHE_MAX_BOXES];                        // from the start box
+}path_cache_entry_t, *path_cache_entry_p;
+
+static path_search_t            path_search = {0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0};
+static path_cache_entry_t       path_cache[PATH_CACHE_SIZE];
+static uint32_t                 path_cache_time = 0;
+
+
+void Room_ResetPathCache()
+{
+    for(int i = 0; i < PATH_CACHE_SIZE; i++)
     {
-        if(from->box->id != to->box->id)
+        path_cache[i].boxes_count = 0;
+        path_cache[i].last_use = 0;
+    }
+    path_cache_time = 0;
+}
+
+
+void Room_ClearPathSearch()
+{
+    path_search_p ps = &path_search;
+    if(ps->stamps)
+    {
+        free(ps->stamps);
+        free(ps->parents);
+        free(ps->heap);
+        free(ps->heap_pos);
+        free(ps->costs);
+        free(ps->scores);
+        free(ps->points);
+    }
+    ps->stamps = NULL;
+    ps->parents = NULL;
+    ps->heap = NULL;
+    ps->heap_pos = NULL;
+    ps->costs = NULL;
+    ps->scores = NULL;
+    ps->points = NULL;
+    ps->boxes_count = 0;
+    ps->stamp = 0;
+    ps->heap_size = 0;
+    Room_ResetPathCache();
+}
+
+
+static bool Room_PathHeapLess(path_search_p ps, uint16_t b1, uint16_t b2)
+{
+    // equal scores: the nearer to target first, it saves expansions on plateaus
+    return (ps->scores[b1] < ps->scores[b2]) || ((ps->scores[b1] == ps->scores[b2]) && (ps->costs[b1] > ps->costs[b2]));
+}
+
+
+static void Room_PathHeapUp(path_search_p ps, uint32_t i)
+{
+    uint16_t box = ps->heap[i];
+    while(i > 0)
+    {
+        uint32_t parent = (i - 1) / 2;
+        if(!Room_PathHeapLess(ps, box, ps->heap[parent]))
         {
-            float pt_from[3], pt_to[3];
-            const int buf_size = sizeof(room_box_p) * max_boxes;
-            room_box_p *current_front = (room_box_p*)Sys_GetTempMem(3 * buf_size);
-            room_box_p *next_front = current_front + max_boxes;
-            room_box_p *parents = next_front + max_boxes;
-            int32_t *weights = (int32_t*)Sys_GetTempMem(max_boxes * sizeof(int32_t));
-            size_t current_front_size = 1;
-            size_t next_front_size = 0;
+            break;
+        }
+        ps->heap[i] = ps->heap[parent];
+        ps->heap_pos[ps->heap[i]] = i + 1;
+        i = parent;
+    }
+    ps->heap[i] = box;
+    ps->heap_pos[box] = i + 1;
+}
 
-            current_front[0] = from->box;
-            weights[current_front[0]->id] = 0;
-            memset(parents, 0x00, buf_size);
 
-            while(current_front_size > 0)
+static uint16_t Room_PathHeapPop(path_search_p ps)
+{
+    uint16_t ret = ps->heap[0];
+    uint16_t box = ps->heap[--ps->heap_size];
+    uint32_t i = 0;
+
+    ps->heap_pos[ret] = 0;
+    if(ps->heap_size > 0)
+    {
+        for(uint32_t child = 1; child < ps->heap_size; child = 2 * i + 1)
+        {
+            if((child + 1 < ps->heap_size) && Room_PathHeapLess(ps, ps->heap[child + 1], ps->heap[child]))
+            {
+                child++;
+            }
+            if(!Room_PathHeapLess(ps, ps->heap[child], box))
             {
-                for(size_t i = 0; i < current_front_size; ++i)
+                break;
+            }
+            ps->heap[i] = ps->heap[child];
+            ps->heap_pos[ps->heap[i]] = i + 1;
+            i = child;
+        }
+        ps->heap[i] = box;
+        ps->heap_pos[box] = i + 1;
+    }
+
+    return ret;
+}
+
+
+static float Room_PathHeuristic(room_box_p to, const float pt[2])
+{
+    float dx = (pt[0] < to->bb_min[0]) ? (to->bb_min[0] - pt[0]) : ((pt[0] > to->bb_max[0]) ? (pt[0] - to->bb_max[0]) : (0.0f));
+    float dy = (pt[1] < to->bb_min[1]) ? (to->bb_min[1] - pt[1]) : ((pt[1] > to->bb_max[1]) ? (pt[1] - to->bb_max[1]) : (0.0f));
+    return dx + dy;
+}
+
+
+/*
+ * Hierarchical boxes graph: zones -> clusters -> boxes. Clusters are made on
+ * load of up to BOX_CLUSTER_MAX_BOXES overlapping boxes with the same zones
+ * ids (in all zone types and flip states), so a cluster never crosses a zone
+ * border. Validity of box to box move depends on the character step limits,
+ * so cluster links are made per path class (zone type, flip state, step
+ * limits) on the first query of the class, and routes from a cluster (a row
+ * of shortest routes tree) on the first query from it. Links are
+ * conservative: if clusters route does not exist, boxes path does not exist
+ * too. Box blocking changes only links of clusters around the box, and only
+ * rows with routes that reach these clusters are recomputed.
+ */
+#define BOX_CLUSTER_MAX_BOXES   (16)
+#define BOX_GRAPH_CLASSES       (8)
+#define BOX_GRAPH_NO_ROUTE      (-1.0f)
+
+typedef struct box_graph_class_s
+{
+    uint16_t                step_up;
+    uint16_t                step_down;
+    uint16_t                zone_type : 15;
+    uint16_t                zone_alt : 1;
+    uint16_t                is_used : 1;
+    uint16_t                 : 15;
+    uint32_t                last_use;
+    uint32_t                links_count;
+    uint32_t               *links;                                              // bit (from, to): a box of "from" leads to a box of "to"
+    uint8_t                *dirty;                                              // clusters with links to rebuild
+    uint8_t                *routes_dirty;                                       // rows of routes to rebuild
+    float                  *dist;                                               // route length, BOX_GRAPH_NO_ROUTE if none
+    uint16_t               *prev;                                               // cluster before the last one of route
+}box_graph_class_t, *box_graph_class_p;
+
+typedef struct box_graph_s
+{
+    uint32_t                boxes_count;
+    uint32_t                clusters_count;
+    uint32_t                row_size;                                           // links row in 32 bit words
+    uint16_t               *box_cluster;
+    uint32_t               *cluster_offset;                                     // cluster boxes: cluster_boxes[offset[c] .. offset[c + 1]]
+    uint16_t               *cluster_boxes;
+    float                  *cluster_centre;                                     // x and y
+    uint8_t                *corridor;                                           // clusters allowed for current search
+    struct route_heap_item_s *heap;                                             // for routes rows rebuild
+    uint32_t                heap_size;
+    uint32_t                time;
+    box_graph_class_t       classes[BOX_GRAPH_CLASSES];
+}box_graph_t, *box_graph_p;
+
+static box_graph_t              boxes_graph;
+
+
+static bool Room_IsSameZones(room_box_p b1, room_box_p b2)
+{
+    return (memcmp(b1->zone, b2->zone, sizeof(b1->zone)) == 0);
+}
+
+
+static void Room_ClearBoxGraphClass(box_graph_class_p cl)
+{
+    if(cl->links)
+    {
+        free(cl->links);
+        free(cl->dirty);
+        free(cl->routes_dirty);
+        free(cl->dist);
+        free(cl->prev);
+    }
+    cl->links = NULL;
+    cl->dirty = NULL;
+    cl->routes_dirty = NULL;
+    cl->dist = NULL;
+    cl->prev = NULL;
+    cl->is_used = 0;
+    cl->links_count = 0;
+    cl->last_use = 0;
+}
+
+
+void Room_ClearBoxesGraph()
+{
+    box_graph_p g = &boxes_graph;
+    for(int i = 0; i < BOX_GRAPH_CLASSES; i++)
+    {
+        Room_ClearBoxGraphClass(g->classes + i);
+    }
+    if(g->box_cluster)
+    {
+        free(g->box_cluster);
+        free(g->cluster_offset);
+        free(g->cluster_boxes);
+        free(g->cluster_centre);
+        free(g->corridor);
+    }
+    free(g->heap);
+    g->heap = NULL;
+    g->heap_size = 0;
+    g->box_cluster = NULL;
+    g->cluster_offset = NULL;
+    g->cluster_boxes = NULL;
+    g->cluster_centre = NULL;
+    g->corridor = NULL;
+    g->boxes_count = 0;
+    g->clusters_count = 0;
+    g->row_size = 0;
+    g->time = 0;
+}
+
+
+void Room_GenBoxesGraph()
+{
+    box_graph_p g = &boxes_graph;
+    uint32_t boxes_count = World_GetRoomBoxesCount();
+    uint16_t *queue;
+
+    Room_ClearBoxesGraph();
+    if((boxes_count == 0) || (boxes_count >= PATH_NO_BOX))
+    {
+        return;
+    }
+
+    g->boxes_count = boxes_count;
+    g->box_cluster = (uint16_t*)malloc(boxes_count * sizeof(uint16_t));
+    g->cluster_offset = (uint32_t*)malloc((boxes_count + 1) * sizeof(uint32_t));
+    g->cluster_boxes = (uint16_t*)malloc(boxes_count * sizeof(uint16_t));
+    queue = g->cluster_boxes;
+    for(uint32_t i = 0; i < boxes_count; i++)
+    {
+        g->box_cluster[i] = PATH_NO_BOX;
+    }
+
+    /*
+     * clusters are grown breadth first, so they are compact; boxes of a cluster go in a row.
+     * Only one click steps are joined: any creature walks them both ways, so
+     * a cluster may be crossed from any of its boxes to any other one.
+     * Blockable boxes (doors) are clusters by themselves, so blocking changes
+     * only links between clusters, never the clusters inside.
+     */
+    uint32_t used = 0;
+    for(uint32_t seed = 0; seed < boxes_count; seed++)
+    {
+        if(g->box_cluster[seed] == PATH_NO_BOX)
+        {
+            room_box_p seed_box = World_GetRoomBoxByID(seed);
+            uint16_t cluster = g->clusters_count++;
+            uint32_t head = used;
+            g->cluster_offset[cluster] = used;
+            g->box_cluster[seed] = cluster;
+            queue[used++] = seed;
+            while(!seed_box->is_blockable && (head < used) && (used - g->cluster_offset[cluster] < BOX_CLUSTER_MAX_BOXES))
+            {
+                room_box_p box = World_GetRoomBoxByID(queue[head++]);
+                for(box_overlap_p ov = box->overlaps; ov && (used - g->cluster_offset[cluster] < BOX_CLUSTER_MAX_BOXES); ov++)
                 {
-                    room_box_p current_box = current_front[i];
-                    box_overlap_p ov = current_box->overlaps;
-                    if(parents[current_box->id])
+                    room_box_p next_box = World_GetRoomBoxByID(ov->box);
+                    if(next_box && !next_box->is_blockable && (g->box_cluster[next_box->id] == PATH_NO_BOX) && Room_IsSameZones(box, next_box) &&
+                       (fabs(next_box->bb_min[2] - box->bb_min[2]) <= TR_METERING_STEP))
                     {
-                        Room_GetOverlapCenter(parents[current_box->id], current_box, pt_from);
+                        g->box_cluster[next_box->id] = cluster;
+                        queue[used++] = next_box->id;
                     }
-                    else
+                    if(ov->end)
                     {
-                        vec3_copy(pt_from, from->pos);
+                        break;
                     }
+                }
+            }
+        }
+    }
+    g->cluster_offset[g->clusters_count] = used;
+
+    g->row_size = (g->clusters_count + 31) / 32;
+    g->corridor = (uint8_t*)calloc(g->clusters_count, sizeof(uint8_t));
+    g->cluster_centre = (float*)malloc(2 * g->clusters_count * sizeof(float));
+    for(uint32_t c = 0; c < g->clusters_count; c++)
+    {
+        float *centre = g->cluster_centre + 2 * c;
+        uint32_t count = g->cluster_offset[c + 1] - g->cluster_offset[c];
+        centre[0] = 0.0f;
+        centre[1] = 0.0f;
+        for(uint32_t i = g->cluster_offset[c]; i < g->cluster_offset[c + 1]; i++)
+        {
+            room_box_p box = World_GetRoomBoxByID(g->cluster_boxes[i]);
+            centre[0] += 0.5f * (box->bb_min[0] + box->bb_max[0]);
+            centre[1] += 0.5f * (box->bb_min[1] + box->bb_max[1]);
+        }
+        centre[0] /= (float)count;
+        centre[1] /= (float)count;
+    }
+}
+
+
+/*
+ * Links from the cluster change: only routes from clusters that reach it may
+ * change (they may go on through it by other links now).
+ */
+static void Room_InvalidateBoxGraphCluster(box_graph_p g, box_graph_class_p cl, uint32_t cluster)
+{
+    uint32_t n = g->clusters_count;
+    if(!cl->dirty[cluster])
+    {
+        cl->dirty[cluster] = 0x01;
+        for(uint32_t from = 0; from < n; from++)
+        {
+            if(!cl->routes_dirty[from] && (cl->dist[from * n + cluster] >= 0.0f))
+            {
+                cl->routes_dirty[from] = 0x01;
+            }
+        }
+    }
+}
+
+
+void Room_InvalidateBoxesGraph(room_box_p box)
+{
+    box_graph_p g = &boxes_graph;
+    if(!box || (box->id >= g->boxes_count))
+    {
+        return;
+    }
+
+    // moves into the box change: links of clusters of its neighbours
+    for(int i = 0; i < BOX_GRAPH_CLASSES; i++)
+    {
+        box_graph_class_p cl = g->classes + i;
+        if(cl->is_used)
+        {
+            Room_InvalidateBoxGraphCluster(g, cl, g->box_cluster[box->id]);
+            for(box_overlap_p ov = box->overlaps; ov; ov++)
+            {
+                if(ov->box < g->boxes_count)
+                {
+                    Room_InvalidateBoxGraphCluster(g, cl, g->box_cluster[ov->box]);
+                }
+                if(ov->end)
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+static void Room_UpdateClusterLinks(box_graph_p g, box_graph_class_p cl, box_validition_options_p op, uint32_t cluster)
+{
+    uint32_t *row = cl->links + cluster * g->row_size;
+    for(uint32_t w = 0; w < g->row_size; w++)
+    {
+        cl->links_count -= __builtin_popcount(row[w]);
+    }
+    memset(row, 0x00, g->row_size * sizeof(uint32_t));
+    for(uint32_t i = g->cluster_offset[cluster]; i < g->cluster_offset[cluster + 1]; i++)
+    {
+        room_box_p box = World_GetRoomBoxByID(g->cluster_boxes[i]);
+        for(box_overlap_p ov = box->overlaps; ov; ov++)
+        {
+            room_box_p next_box = World_GetRoomBoxByID(ov->box);
+            if(next_box && (g->box_cluster[next_box->id] != cluster) && Room_IsBoxForPath(box, next_box, op))
+            {
+                uint32_t to = g->box_cluster[next_box->id];
+                row[to / 32] |= 1U << (to % 32);
+            }
+            if(ov->end)
+            {
+                break;
+            }
+        }
+    }
+    for(uint32_t w = 0; w < g->row_size; w++)
+    {
+        cl->links_count += __builtin_popcount(row[w]);
+    }
+    cl->dirty[cluster] = 0x00;
+}
+
+
+typedef struct route_heap_item_s
+{
+    float                   dist;
+    uint32_t                cluster;
+}route_heap_item_t, *route_heap_item_p;
+
+
+static void Room_RouteHeapPush(route_heap_item_p heap, uint32_t *size, float dist, uint32_t cluster)
+{
+    uint32_t i = (*size)++;
+    while(i > 0)
+    {
+        uint32_t parent = (i - 1) / 2;
+        if(heap[parent].dist <= dist)
+        {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i].dist = dist;
+    heap[i].cluster = cluster;
+}
+
+
+static route_heap_item_t Room_RouteHeapPop(route_heap_item_p heap, uint32_t *size)
+{
+    route_heap_item_t ret = heap[0];
+    route_heap_item_t last = heap[--(*size)];
+    uint32_t i = 0;
+    while(true)
+    {
+        uint32_t child = 2 * i + 1;
+        if(child >= *size)
+        {
+            break;
+        }
+        if((child + 1 < *size) && (heap[child + 1].dist < heap[child].dist))
+        {
+            child++;
+        }
+        if(last.dist <= heap[child].dist)
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if(*size > 0)
+    {
+        heap[i] = last;
+    }
+    return ret;
+}
+
+
+/*
+ * Dijkstra from one cluster; outdated heap items are skipped on pop, so heap
+ * never holds more items than links + 1. Links must be up to date.
+ */
+static void Room_UpdateClusterRoutes(box_graph_p g, box_graph_class_p cl, uint32_t from)
+{
+    uint32_t n = g->clusters_count;
+    float *dist = cl->dist + from * n;
+    uint16_t *prev = cl->prev + from * n;
+    route_heap_item_p heap;
+    uint32_t heap_size = 0;
+
+    if(g->heap_size < cl->links_count + 1)
+    {
+        g->heap_size = cl->links_count + 1;
+        g->heap = (route_heap_item_p)realloc(g->heap, g->heap_size * sizeof(route_heap_item_t));
+    }
+    heap = g->heap;
+
+    for(uint32_t i = 0; i < n; i++)
+    {
+        dist[i] = BOX_GRAPH_NO_ROUTE;
+        prev[i] = PATH_NO_BOX;
+    }
+    dist[from] = 0.0f;
+    prev[from] = from;
+    Room_RouteHeapPush(heap, &heap_size, 0.0f, from);
+
+    while(heap_size > 0)
+    {
+        route_heap_item_t item = Room_RouteHeapPop(heap, &heap_size);
+        uint32_t c = item.cluster;
+        if(item.dist > dist[c])
+        {
+            continue;
+        }
+
+        const uint32_t *row = cl->links + c * g->row_size;
+        const float *pc = g->cluster_centre + 2 * c;
+        for(uint32_t w = 0; w < g->row_size; w++)
+        {
+            for(uint32_t bits = row[w]; bits; bits &= bits - 1)
+            {
+                uint32_t to = 32 * w + __builtin_ctz(bits);
+                const float *pt = g->cluster_centre + 2 * to;
+                float d = dist[c] + fabs(pt[0] - pc[0]) + fabs(pt[1] - pc[1]);
+                if((dist[to] < 0.0f) || (d < dist[to]))
+                {
+                    dist[to] = d;
+                    prev[to] = c;
+                    Room_RouteHeapPush(heap, &heap_size, d, to);
+                }
+            }
+        }
+    }
+
+    cl->routes_dirty[from] = 0x00;
+}
+
 
-                    while(ov)
+/*
+ * Returns class of the path options with up to date routes from the cluster.
+ */
+static box_graph_class_p Room_GetBoxGraphClass(box_validition_options_p op, uint32_t from)
+{
+    box_graph_p g = &boxes_graph;
+    box_graph_class_p cl = NULL;
+    uint32_t n = g->clusters_count;
+
+    if((g->boxes_count == 0) || (g->boxes_count != World_GetRoomBoxesCount()))
+    {
+        return NULL;
+    }
+
+    g->time++;
+    for(int i = 0; i < BOX_GRAPH_CLASSES; i++)
+    {
+        box_graph_class_p c = g->classes + i;
+        if(c->is_used && (c->zone_type == op->zone_type) && (c->zone_alt == op->zone_alt) &&
+           (c->step_up == op->step_up) && (c->step_down == op->step_down))
+        {
+            cl = c;
+            break;
+        }
+    }
+
+    if(!cl)
+    {
+        for(int i = 0; i < BOX_GRAPH_CLASSES; i++)
+        {
+            box_graph_class_p c = g->classes + i;
+            if(!cl || (c->last_use < cl->last_use))
+            {
+                cl = c;                                                         // least recently used one is replaced
+            }
+        }
+        Room_ClearBoxGraphClass(cl);
+        cl->zone_type = op->zone_type;
+        cl->zone_alt = op->zone_alt;
+        cl->step_up = op->step_up;
+        cl->step_down = op->step_down;
+        cl->links = (uint32_t*)calloc(n * g->row_size, sizeof(uint32_t));
+        cl->dirty = (uint8_t*)malloc(n * sizeof(uint8_t));
+        cl->routes_dirty = (uint8_t*)malloc(n * sizeof(uint8_t));
+        cl->dist = (float*)malloc(n * n * sizeof(float));
+        cl->prev = (uint16_t*)malloc(n * n * sizeof(uint16_t));
+        memset(cl->dirty, 0x01, n * sizeof(uint8_t));
+        memset(cl->routes_dirty, 0x01, n * sizeof(uint8_t));
+        cl->links_count = 0;
+        cl->is_used = 1;
+    }
+    cl->last_use = g->time;
+
+    if(cl->routes_dirty[from])
+    {
+        for(uint32_t c = 0; c < n; c++)
+        {
+            if(cl->dirty[c])
+            {
+                Room_UpdateClusterLinks(g, cl, op, c);
+            }
+        }
+        Room_UpdateClusterRoutes(g, cl, from);
+    }
+
+    return cl;
+}
+
+
+/*
+ * Returns path length in boxes (0 if there is no path), path_buf gets first
+ * max_boxes boxes of it, starting with the start box. If corridor is set,
+ * only boxes of its clusters are used.
+ */
+static uint32_t Room_SearchPath(room_box_p *path_buf, uint32_t max_boxes, room_sector_p from, room_sector_p to, box_validition_options_p op, const uint8_t *corridor)
+{
+    path_search_p ps = &path_search;
+    uint32_t boxes_count = World_GetRoomBoxesCount();
+    uint16_t target = to->box->id;
+    uint32_t ret = 0;
+
+    if(ps->boxes_count != boxes_count)
+    {
+        Room_ClearPathSearch();
+        ps->boxes_count = boxes_count;
+        ps->stamps = (uint32_t*)calloc(boxes_count, sizeof(uint32_t));
+        ps->parents = (uint16_t*)malloc(boxes_count * sizeof(uint16_t));
+        ps->heap = (uint16_t*)malloc(boxes_count * sizeof(uint16_t));
+        ps->heap_pos = (uint32_t*)malloc(boxes_count * sizeof(uint32_t));
+        ps->costs = (float*)malloc(boxes_count * sizeof(float));
+        ps->scores = (float*)malloc(boxes_count * sizeof(float));
+        ps->points = (float*)malloc(2 * boxes_count * sizeof(float));
+    }
+
+    if(++ps->stamp == 0)
+    {
+        memset(ps->stamps, 0x00, boxes_count * sizeof(uint32_t));
+        ps->stamp = 1;
+    }
+
+    {
+        uint16_t start = from->box->id;
+        ps->stamps[start] = ps->stamp;
+        ps->parents[start] = PATH_NO_BOX;
+        ps->costs[start] = 0.0f;
+        ps->points[2 * start + 0] = from->pos[0];
+        ps->points[2 * start + 1] = from->pos[1];
+        ps->scores[start] = Room_PathHeuristic(to->box, from->pos);
+        ps->heap[0] = start;
+        ps->heap_pos[start] = 1;
+        ps->heap_size = 1;
+    }
+
+    while(ps->heap_size > 0)
+    {
+        uint16_t current = Room_PathHeapPop(ps);
+        room_box_p current_box = World_GetRoomBoxByID(current);
+        const float *pt_from = ps->points + 2 * current;
+        box_overlap_p ov = current_box->overlaps;
+
+        if(current == target)
+        {
+            for(uint16_t b = current; b != PATH_NO_BOX; b = ps->parents[b])
+            {
+                ret++;
+            }
+            for(uint16_t b = current, i = ret; b != PATH_NO_BOX; b = ps->parents[b])
+            {
+                if(--i < max_boxes)
+                {
+                    path_buf[i] = World_GetRoomBoxByID(b);
+                }
+            }
+            break;
+        }
+
+        while(ov)
+        {
+            room_box_p next_box = World_GetRoomBoxByID(ov->box);
+            if(next_box && (!corridor || corridor[boxes_graph.box_cluster[next_box->id]]) && Room_IsBoxForPath(current_box, next_box, op))
+            {
+                uint16_t next = next_box->id;
+                bool is_new = (ps->stamps[next] != ps->stamp);
+                if(is_new || ps->heap_pos[next])                                // closed boxes are final
+                {
+                    float pt_to[3];
+                    float cost;
+                    Room_GetOverlapCenter(current_box, next_box, pt_to);
+                    cost = ps->costs[current] + fabs(pt_to[0] - pt_from[0]) + fabs(pt_to[1] - pt_from[1]);
+                    if(is_new || (cost < ps->costs[next]))
                     {
-                        room_box_p next_box = World_GetRoomBoxByID(ov->box);
-                        Room_GetOverlapCenter(current_box, next_box, pt_to);
-                        int32_t weight = (fabs(pt_to[0] - pt_from[0]) + fabs(pt_to[1] - pt_from[1]) + 1.0f) / TR_METERING_STEP;
-                        if((next_box->id != from->box->id) && Room_IsBoxForPath(current_box, next_box, op) &&
-                           (!parents[to->box->id] || (weights[current_box->id] + weight < weights[to->box->id])))
+                        ps->stamps[next] = ps->stamp;
+                        ps->parents[next] = current;
+                        ps->costs[next] = cost;
+                        ps->points[2 * next + 0] = pt_to[0];
+                        ps->points[2 * next + 1] = pt_to[1];
+                        ps->scores[next] = cost + Room_PathHeuristic(to->box, pt_to);
+                        if(is_new)
                         {
-                            if(!parents[next_box->id])
-                            {
-                                next_front[next_front_size++] = next_box;
-                                parents[next_box->id] = current_box;
-                                weights[next_box->id] = weights[current_box->id] + weight;
-                            }
-                            else if(weights[next_box->id] > weights[current_box->id] + weight)
-                            {
-                                bool not_in_front = true;
-                                parents[next_box->id] = current_box;
-                                weights[next_box->id] = weights[current_box->id] + weight;
-                                for(size_t j = 0; j < next_front_size; ++j)
-                                {
-                                    if(next_front[j]->id == next_box->id)
-                                    {
-                                        not_in_front = false;
-                                        break;
-                                    }
-                                }
-
-                                if(not_in_front)
-                                {
-                                    next_front[next_front_size++] = next_box;
-                                }
-                            }
+                            ps->heap[ps->heap_size] = next;
+                            Room_PathHeapUp(ps, ps->heap_size++);
                         }
-
-                        if(ov->end)
+                        else
                         {
-                            break;
+                            Room_PathHeapUp(ps, ps->heap_pos[next] - 1);
                         }
-                        ov++;
                     }
                 }
+            }
+
+            if(ov->end)
+            {
+                break;
+            }
+            ov++;
+        }
+    }
+
+    return ret;
+}
+
+
+int  Room_FindPath(room_box_p *path_buf, uint32_t max_boxes, room_sector_p from, room_sector_p to, box_validition_options_p op)
+{
+    path_cache_entry_p entry = NULL;
+    uint32_t ret = 0;
+
+    if(!from->box || !to->box || (max_boxes == 0))
+    {
+        return 0;
+    }
+
+    if(from->box->id == to->box->id)
+    {
+        path_buf[0] = from->box;
+        return 1;
+    }
 
-                ///SWAP FRONTS HERE
+    path_cache_time++;
+    for(int i = 0; i < PATH_CACHE_SIZE; i++)
+    {
+        path_cache_entry_p e = path_cache + i;
+        if(e->boxes_count && (e->from == from->box->id) && (e->to == to->box->id) &&
+           (e->zone_type == op->zone_type) && (e->zone_alt == op->zone_alt) &&
+           (e->step_up == op->step_up) && (e->step_down == op->step_down))
+        {
+            e->last_use = path_cache_time;
+            if(e->path_length)
+            {
+                ret = (e->boxes_count < max_boxes) ? (e->boxes_count) : (max_boxes);
+                for(uint32_t j = 0; j < ret; j++)
                 {
-                    room_box_p *tn = current_front;
-                    current_front = next_front;
-                    current_front_size = next_front_size;
-                    next_front = tn;
-                    next_front_size = 0;
+                    path_buf[j] = World_GetRoomBoxByID(e->boxes[j]);
                 }
             }
+            return ret;
+        }
+        if(!entry || (e->last_use < entry->last_use))
+        {
+            entry = e;                                                          // least recently used one is replaced
+        }
+    }
+
+    {
+        room_box_p boxes[PATH_CACHE_MAX_BOXES];
+        uint16_t cf = (from->box->id < boxes_graph.boxes_count) ? (boxes_graph.box_cluster[from->box->id]) : (0);
+        box_graph_class_p cl = Room_GetBoxGraphClass(op, cf);
+        uint32_t length = 0;
+        uint32_t count;
 
-            if(parents[to->box->id])
+        if(cl)
+        {
+            // no clusters route - no path; long routes are searched in their clusters only
+            uint32_t n = boxes_graph.clusters_count;
+            uint16_t ct = boxes_graph.box_cluster[to->box->id];
+            const uint16_t *prev = cl->prev + cf * n;
+            if(cl->dist[cf * n + ct] >= 0.0f)
             {
-                room_box_p p = to->box;
-                while(p)
+                if((cf != ct) && (prev[ct] != cf))
+                {
+                    uint8_t *corridor = boxes_graph.corridor;
+                    for(uint16_t c = ct; c != cf; c = prev[c])
+                    {
+                        corridor[c] = 0x01;
+                    }
+                    corridor[cf] = 0x01;
+                    length = Room_SearchPath(boxes, PATH_CACHE_MAX_BOXES, from, to, op, corridor);
+                    for(uint16_t c = ct; c != cf; c = prev[c])
+                    {
+                        corridor[c] = 0x00;
+                    }
+                    corridor[cf] = 0x00;
+                }
+                if(length == 0)
                 {
-                    path_buf[ret++] = p;
-                    p = parents[p->id];
+                    length = Room_SearchPath(boxes, PATH_CACHE_MAX_BOXES, from, to, op, NULL);
                 }
             }
-
-            Sys_ReturnTempMem(3 * buf_size + max_boxes * sizeof(int32_t));
         }
         else
         {
-            path_buf[0] = from->box;
-            ret = 1;
+            length = Room_SearchPath(boxes, PATH_CACHE_MAX_BOXES, from, to, op, NULL);
+        }
+        count = (length < PATH_CACHE_MAX_BOXES) ? (length) : (PATH_CACHE_MAX_BOXES);
+
+        entry->from = from->box->id;
+        entry->to = to->box->id;
+        entry->zone_type = op->zone_type;
+        entry->zone_alt = op->zone_alt;
+        entry->step_up = op->step_up;
+        entry->step_down = op->step_down;
+        entry->path_length = length;
+        entry->boxes_count = (count > 0) ? (count) : (1);                       // failed searches are cached too
+        entry->last_use = path_cache_time;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            entry->boxes[i] = boxes[i]->id;
+        }
+
+        ret = (count < max_boxes) ? (count) : (max_boxes);
+        for(uint32_t i = 0; i < ret; i++)
+        {
+            path_buf[i] = boxes[i];
         }
     }
 
@@ -214,6 +214,7 @@ typedef struct static_mesh_s
 {
     uint32_t                    object_id;                                      //
     uint8_t                     hide;                                           // disable static mesh rendering
+    uint8_t                     batched;                                        // static faces are in room batch
     float                       pos[3];                                         // model position
     float                       rot[3];                                         // model angles
     GLfloat                     tint[4];                                        // model tint
@@ -232,6 +233,29 @@ typedef struct static_mesh_s
 }static_mesh_t, *static_mesh_p;
 
 
+/*
+ * Room static geometry merged at load time: room mesh and static meshes
+ * (pre-transformed to room space, tint baked into vertex colours) share
+ * one vertex buffer and one index buffer, each page is a contiguous
+ * elements range with one texture, drawn by one call.
+ */
+typedef struct room_batch_page_s
+{
+    GLuint                      texture_index;
+    GLuint                      elements_count;
+    GLuint                      elements_offset;                                // first element in index buffer
+}room_batch_page_t, *room_batch_page_p;
+
+typedef struct room_batch_s
+{
+    GLuint                      vbo_vertex_array;
+    GLuint                      vbo_index_array;
+    uint16_t                    room_pages_count;                               // room shader pages first,
+    uint16_t                    static_pages_count;                             // then static mesh shader pages
+    struct room_batch_page_s   *pages;
+}room_batch_t, *room_batch_p;
+
+
 typedef struct room_content_s
 {
     uint32_t                    original_room_id;
@@ -260,6 +284,7 @@ typedef struct room_content_s
 
     float                       ambient_lighting[3];
     struct base_mesh_s         *mesh;                                           // room's base mesh
+    struct room_batch_s        *batch;                                          // merged room + static meshes geometry
     struct physics_object_s    *physics_body;                                   // static physics data
     struct physics_object_s    *physics_alt_tween;                              // changable (alt room) tween physics data
 }room_content_t, *room_content_p;
@@ -311,6 +336,7 @@ int  Room_IsInOverlappedRoomsList(struct room_s *r0, struct room_s *r1);
 void Room_MoveActiveItems(struct room_s *room_to, struct room_s *room_from);
 
 void Room_GenSpritesBuffer(struct room_s *room);
+void Room_GenBatch(struct room_s *room);
 
 struct room_sector_s *Sector_GetNextSector(struct room_sector_s *rs, float dir[3]);
 struct room_sector_s *Sector_GetPortalSectorTargetRaw(struct room_sector_s *rs);
@@ -325,7 +351,18 @@ int Sectors_SimilarFloor(room_sector_p s1, room_sector_p s2, int ignore_doors);
 int Sectors_SimilarCeiling(room_sector_p s1, room_sector_p s2, int ignore_doors);
 
 int  Room_IsInBox(room_box_p box, float pos[3]);
+/*
+ * Fills path_buf with first max_boxes (up to 16) boxes of the path, starting
+ * with the "from" box; returns their count, 0 if there is no path.
+ * Results are cached: reset cache and invalidate boxes graph if box blocking
+ * changes.
+ */
 int  Room_FindPath(room_box_p *path_buf, uint32_t max_boxes, room_sector_p from, room_sector_p to, box_validition_options_p op);
+void Room_ResetPathCache();
+void Room_ClearPathSearch();
+void Room_GenBoxesGraph();
+void Room_ClearBoxesGraph();
+void Room_InvalidateBoxesGraph(room_box_p box);
 void Room_GetOverlapCenter(room_box_p b1, room_box_p b2, float pos[3]);
 
 #endif //ROOM_H
@@ -13,6 +13,7 @@ extern "C" {
 #include "../core/system.h"
 #include "../core/gl_text.h"
 #include "../core/console.h"
+#include "../core/profiler.h"
 #include "../core/vmath.h"
 #include "../render/camera.h"
 #include "../render/render.h"
@@ -208,6 +209,7 @@ int Script_UseItem(lua_State *lua, int item_id, int activator_id)
 
 int Script_DoTasks(lua_State *lua, float time)
 {
+    PROF_SCOPED_ZONE("Script_DoTasks");
     lua_pushnumber(lua, time);
     lua_setglobal(lua, "frame_time");
 
@@ -429,6 +431,10 @@ int Script_ParseRender(lua_State *lua, struct render_settings_s *rs)
         rs->texture_border = lua_tonumber(lua, -1);
         lua_pop(lua, 1);
 
+        lua_getfield(lua, -1, "texture_compression");
+        rs->texture_compression = lua_tonumber(lua, -1);
+        lua_pop(lua, 1);
+
         lua_getfield(lua, -1, "z_depth");
         rs->z_depth = lua_tonumber(lua, -1);
         lua_pop(lua, 1);
@@ -437,6 +443,10 @@ int Script_ParseRender(lua_State *lua, struct render_settings_s *rs)
         rs->fog_enabled = lua_tonumber(lua, -1);
         lua_pop(lua, 1);
 
+        lua_getfield(lua, -1, "transparency_mode");
+        rs->transparency_mode = lua_tonumber(lua, -1);
+        lua_pop(lua, 1);
+
         lua_getfield(lua, -1, "fog_start_depth");
         rs->fog_start_depth = lua_tonumber(lua, -1);
         lua_pop(lua, 1);
@@ -469,6 +479,11 @@ int Script_ParseRender(lua_State *lua, struct render_settings_s *rs)
             rs->z_depth = 24;
         }
 
+        if(rs->transparency_mode != TRANSPARENCY_DYNAMIC_BSP && rs->transparency_mode != TRANSPARENCY_CACHED_BSP)
+        {
+            rs->transparency_mode = TRANSPARENCY_DYNAMIC_BSP;
+        }
+
         lua_settop(lua, top);
         return 1;
     }
@@ -897,9 +897,11 @@ int lua_SetBoxBlocked(lua_State *lua)
     if(lua_gettop(lua) == 2)
     {
         room_box_p box = World_GetRoomBoxByID(lua_tointeger(lua, 1));
-        if(box && box->is_blockable)
+        if(box && box->is_blockable && (box->is_blocked != lua_toboolean(lua, 2)))
         {
             box->is_blocked = lua_toboolean(lua, 2);
+            Room_InvalidateBoxesGraph(box);
+            Room_ResetPathCache();
         }
     }
     else
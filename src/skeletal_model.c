@@ -5,6 +5,7 @@
 #include "core/system.h"
 #include "core/gl_util.h"
 #include "core/vmath.h"
+#include "core/vmath_simd.h"
 #include "core/polygon.h"
 #include "core/obb.h"
 #include "mesh.h"
@@ -236,6 +237,7 @@ void SSBoneFrame_CreateFromModel(ss_bone_frame_p bf, skeletal_model_p model)
             b_tag->mesh_skin = NULL;
             b_tag->mesh_slot = NULL;
             b_tag->skin_map = NULL;
+            b_tag->skin_vbo = 0;
             b_tag->alt_anim = NULL;
             b_tag->body_part = model->mesh_tree[i].body_part;
 
@@ -300,6 +302,10 @@ void SSBoneFrame_Clear(ss_bone_frame_p bf)
             {
                 free(bf->bone_tags[i].skin_map);
             }
+            if(bf->bone_tags[i].skin_vbo)
+            {
+                qglDeleteBuffersARB(1, &bf->bone_tags[i].skin_vbo);
+            }
         }
         
         free(bf->bone_tags);
@@ -358,38 +364,86 @@ void SSBoneFrame_Copy(struct ss_bone_frame_s *dst, struct ss_bone_frame_s *src)
 
 void SSBoneFrame_Update(struct ss_bone_frame_s *bf, float time)
 {
-    float t = 1.0f - bf->animations.lerp;
-    ss_bone_tag_p btag = bf->bone_tags;
-    bone_tag_p src_btag, next_btag;
-    skeletal_model_p model = bf->animations.model;
-    animation_frame_p curr_anim = model->animations + bf->animations.prev_animation;
-    animation_frame_p next_anim = model->animations + bf->animations.current_animation;
-    bone_frame_p curr_bf = curr_anim->frames + bf->animations.prev_frame;
-    bone_frame_p next_bf = next_anim->frames + bf->animations.current_frame;
-    
-    vec3_interpolate_macro(bf->bb_max, curr_bf->bb_max, next_bf->bb_max, bf->animations.lerp, t);
-    vec3_interpolate_macro(bf->bb_min, curr_bf->bb_min, next_bf->bb_min, bf->animations.lerp, t);
-    vec3_interpolate_macro(bf->centre, curr_bf->centre, next_bf->centre, bf->animations.lerp, t);
-    vec3_interpolate_macro(bf->pos, curr_bf->pos, next_bf->pos, bf->animations.lerp, t);
-    
-    next_btag = next_bf->bone_tags;
-    src_btag = curr_bf->bone_tags;
-    for(uint16_t k = 0; k < curr_bf->bone_tag_count; k++, btag++, src_btag++, next_btag++)
+    SSBoneFrame_UpdateBatch(&bf, 1, time);
+}
+
+
+/*
+ * Bones rotations of all frames are interpolated and converted to matrices
+ * by four at once, then absolute matrices are built per frame (by scalar
+ * Mat4_Mat4_mul: vmath bench shows SSE2 4x4 multiply slower than it).
+ */
+typedef struct ss_bone_lanes_s
+{
+    float      *ret[4];
+    float      *mat[4];
+    float      *q1[4];
+    float      *q2[4];
+    float       t[4];
+    uint32_t    count;
+}ss_bone_lanes_t, *ss_bone_lanes_p;
+
+
+static void SSBoneFrame_FlushLanes(ss_bone_lanes_p lanes)
+{
+    static const float q_e[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float scratch_q[4], scratch_mat[16];
+
+    if(lanes->count > 0)
     {
-        vec3_interpolate_macro(btag->offset, src_btag->offset, next_btag->offset, bf->animations.lerp, t);
-        vec3_copy(btag->transform + 12, btag->offset);
-        btag->transform[15] = 1.0f;
-        if(k == 0)
+        for(uint32_t i = lanes->count; i < 4; i++)
         {
-            vec3_add(btag->transform + 12, btag->transform + 12, bf->pos);
-            vec4_slerp(btag->qrotate, src_btag->qrotate, next_btag->qrotate, bf->animations.lerp);
+            lanes->ret[i] = scratch_q;
+            lanes->mat[i] = scratch_mat;
+            lanes->q1[i] = (float*)q_e;
+            lanes->q2[i] = (float*)q_e;
+            lanes->t[i] = 0.0f;
         }
-        else
+        vec4_slerp_x4(lanes->ret, lanes->q1, lanes->q2, lanes->t);
+        Mat4_set_qrotation_x4(lanes->mat, lanes->ret);
+        lanes->count = 0;
+    }
+}
+
+
+void SSBoneFrame_UpdateBatch(struct ss_bone_frame_s **frames, uint32_t count, float time)
+{
+    ss_bone_lanes_t lanes;
+
+    lanes.count = 0;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        struct ss_bone_frame_s *bf = frames[i];
+        float t = 1.0f - bf->animations.lerp;
+        ss_bone_tag_p btag = bf->bone_tags;
+        bone_tag_p src_btag, next_btag;
+        skeletal_model_p model = bf->animations.model;
+        animation_frame_p curr_anim = model->animations + bf->animations.prev_animation;
+        animation_frame_p next_anim = model->animations + bf->animations.current_animation;
+        bone_frame_p curr_bf = curr_anim->frames + bf->animations.prev_frame;
+        bone_frame_p next_bf = next_anim->frames + bf->animations.current_frame;
+
+        vec3_interpolate_macro(bf->bb_max, curr_bf->bb_max, next_bf->bb_max, bf->animations.lerp, t);
+        vec3_interpolate_macro(bf->bb_min, curr_bf->bb_min, next_bf->bb_min, bf->animations.lerp, t);
+        vec3_interpolate_macro(bf->centre, curr_bf->centre, next_bf->centre, bf->animations.lerp, t);
+        vec3_interpolate_macro(bf->pos, curr_bf->pos, next_bf->pos, bf->animations.lerp, t);
+
+        next_btag = next_bf->bone_tags;
+        src_btag = curr_bf->bone_tags;
+        for(uint16_t k = 0; k < curr_bf->bone_tag_count; k++, btag++, src_btag++, next_btag++)
         {
             bone_tag_p ov_src_btag = src_btag;
             bone_tag_p ov_next_btag = next_btag;
             float ov_lerp = bf->animations.lerp;
-            if(btag->alt_anim && btag->alt_anim->model && btag->alt_anim->enabled && (btag->alt_anim->model->mesh_tree[k].replace_anim != 0))
+
+            vec3_interpolate_macro(btag->offset, src_btag->offset, next_btag->offset, bf->animations.lerp, t);
+            vec3_copy(btag->transform + 12, btag->offset);
+            btag->transform[15] = 1.0f;
+            if(k == 0)
+            {
+                vec3_add(btag->transform + 12, btag->transform + 12, bf->pos);
+            }
+            else if(btag->alt_anim && btag->alt_anim->model && btag->alt_anim->enabled && (btag->alt_anim->model->mesh_tree[k].replace_anim != 0))
             {
                 curr_anim = btag->alt_anim->model->animations + btag->alt_anim->prev_animation;
                 next_anim = btag->alt_anim->model->animations + btag->alt_anim->current_animation;
@@ -399,23 +453,36 @@ void SSBoneFrame_Update(struct ss_bone_frame_s *bf, float time)
                 ov_src_btag = ov_curr_bf->bone_tags + k;
                 ov_next_btag = ov_next_bf->bone_tags + k;
             }
-            vec4_slerp(btag->qrotate, ov_src_btag->qrotate, ov_next_btag->qrotate, ov_lerp);
+
+            lanes.ret[lanes.count] = btag->qrotate;
+            lanes.mat[lanes.count] = btag->transform;
+            lanes.q1[lanes.count] = ov_src_btag->qrotate;
+            lanes.q2[lanes.count] = ov_next_btag->qrotate;
+            lanes.t[lanes.count] = ov_lerp;
+            if(++lanes.count == 4)
+            {
+                SSBoneFrame_FlushLanes(&lanes);
+            }
         }
-        Mat4_set_qrotation(btag->transform, btag->qrotate);
     }
+    SSBoneFrame_FlushLanes(&lanes);
 
     /*
      * build absolute coordinate matrix system
      */
-    btag = bf->bone_tags;
-    Mat4_Copy(btag->full_transform, btag->transform);
-    Mat4_Copy(btag->orig_transform, btag->transform);
-    btag++;
-    for(uint16_t k = 1; k < curr_bf->bone_tag_count; k++, btag++)
+    for(uint32_t i = 0; i < count; i++)
     {
-        Mat4_Mat4_mul(btag->full_transform, btag->parent->full_transform, btag->transform);
-        Mat4_Copy(btag->orig_transform, btag->full_transform);
-        SSBoneFrame_TargetBoneToSlerp(bf, btag, time);
+        struct ss_bone_frame_s *bf = frames[i];
+        ss_bone_tag_p btag = bf->bone_tags;
+        Mat4_Copy(btag->full_transform, btag->transform);
+        Mat4_Copy(btag->orig_transform, btag->transform);
+        btag++;
+        for(uint16_t k = 1; k < bf->bone_tag_count; k++, btag++)
+        {
+            Mat4_Mat4_mul(btag->full_transform, btag->parent->full_transform, btag->transform);
+            Mat4_Copy(btag->orig_transform, btag->full_transform);
+            SSBoneFrame_TargetBoneToSlerp(bf, btag, time);
+        }
     }
 }
 
@@ -1001,5 +1068,48 @@ void SSBoneFrame_FillSkinnedMeshMap(ss_bone_frame_p bf)
                 }
             }
         }
+        SSBoneFrame_GenSkinVBO(tree_tag);
+    }
+}
+
+
+void SSBoneFrame_GenSkinVBO(ss_bone_tag_p tag)
+{
+    if(tag->skin_vbo)
+    {
+        qglDeleteBuffersARB(1, &tag->skin_vbo);
+        tag->skin_vbo = 0;
+    }
+
+    if(tag->mesh_skin && tag->skin_map && tag->parent && tag->mesh_skin->vertex_count)
+    {
+        base_mesh_p mesh_skin = tag->mesh_skin;
+        base_mesh_p parent_mesh = tag->parent->mesh_base;
+        size_t buf_size = mesh_skin->vertex_count * sizeof(skin_vertex_t);
+        skin_vertex_p buf = (skin_vertex_p)Sys_GetTempMem(buf_size);
+        skin_vertex_p sv = buf;
+        vertex_p v = mesh_skin->vertices;
+        uint32_t *ch = tag->skin_map;
+
+        for(uint32_t i = 0; i < mesh_skin->vertex_count; i++, v++, ch++, sv++)
+        {
+            vec3_copy(sv->normal, v->normal);
+            if(*ch == 0xFFFFFFFF)
+            {
+                vec3_copy(sv->position, v->position);
+                sv->bone = 0.0f;
+            }
+            else
+            {
+                vec3_copy(sv->position, parent_mesh->vertices[*ch].position);
+                sv->bone = 1.0f;
+            }
+        }
+
+        qglGenBuffersARB(1, &tag->skin_vbo);
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, tag->skin_vbo);
+        qglBufferDataARB(GL_ARRAY_BUFFER_ARB, buf_size, buf, GL_STATIC_DRAW_ARB);
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        Sys_ReturnTempMem(buf_size);
     }
 }
\ No newline at end of file
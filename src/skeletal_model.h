@@ -36,6 +36,8 @@ extern "C" {
 #define ANIM_TYPE_MISK_4                (0x0103)
 
 #include <stdint.h>
+#include <SDL2/SDL_platform.h>
+#include <SDL2/SDL_opengl.h>
 
 #include "core/base_types.h"
     
@@ -47,6 +49,18 @@ struct base_mesh_s;
  * thanks to Terry 'Mongoose' Hendrix II
  */
 
+/*
+ * Skinned mesh vertex for GPU skinning. Vertices mapped to parent mesh
+ * take parent mesh position in parent bone space, bone: 0 - own bone,
+ * 1 - parent bone. Colors and texture coords are taken from mesh_skin VBO.
+ */
+typedef struct skin_vertex_s
+{
+    GLfloat                 position[3];
+    GLfloat                 normal[3];
+    GLfloat                 bone;
+}skin_vertex_t, *skin_vertex_p;
+
 /*
  * SMOOTHED ANIMATIONS STRUCTURES
  * stack matrices are needed for skinned mesh transformations.
@@ -72,6 +86,7 @@ typedef struct ss_bone_tag_s
     struct base_mesh_s     *mesh_slot;
     struct ss_animation_s  *alt_anim;
     uint32_t               *skin_map;                                           // vertices map for skin mesh
+    GLuint                  skin_vbo;                                           // skin_vertex_s array for GPU skinning
     float                   offset[3];                                          // model position offset
 
     float                   qrotate[4];                                         // quaternion rotation
@@ -257,6 +272,7 @@ void SSBoneFrame_CreateFromModel(ss_bone_frame_p bf, skeletal_model_p model);
 void SSBoneFrame_Clear(ss_bone_frame_p bf);
 void SSBoneFrame_Copy(struct ss_bone_frame_s *dst, struct ss_bone_frame_s *src);
 void SSBoneFrame_Update(struct ss_bone_frame_s *bf, float time);
+void SSBoneFrame_UpdateBatch(struct ss_bone_frame_s **frames, uint32_t count, float time);
 void SSBoneFrame_RotateBone(struct ss_bone_frame_s *bf, const float q_rotate[4], int bone);
 int  SSBoneFrame_CheckTargetBoneLimit(struct ss_bone_frame_s *bf, struct ss_bone_tag_s *b_tag, float target[3]);
 void SSBoneFrame_TargetBoneToSlerp(struct ss_bone_frame_s *bf, struct ss_bone_tag_s *b_tag, float time);
@@ -270,6 +286,7 @@ void SSBoneFrame_EnableOverrideAnim(struct ss_bone_frame_s *bf, struct ss_animat
 void SSBoneFrame_DisableOverrideAnimByType(struct ss_bone_frame_s *bf, uint16_t anim_type);
 void SSBoneFrame_DisableOverrideAnim(struct ss_bone_frame_s *bf, struct ss_animation_s *ss_anim);
 void SSBoneFrame_FillSkinnedMeshMap(ss_bone_frame_p model);
+void SSBoneFrame_GenSkinVBO(ss_bone_tag_p tag);
 
 void Anim_AddCommand(struct animation_frame_s *anim, const animation_command_p command);
 void Anim_AddEffect(struct animation_frame_s *anim, const animation_effect_p effect);
@@ -0,0 +1,497 @@
+/*
+ * Binary cache of read and prepared level data.
+ *
+ * Cache file is a header and all TR_Level tables in a fixed order, each
+ * table is its raw memory image (size + bytes), so a cached level is read
+ * by one file read and a memcpy per table instead of per field parsing and
+ * textiles conversion. Only 32-bit textiles are stored: 8 and 16-bit ones
+ * are not used after prepare_level(). Cache is valid only for the same
+ * level file (its hash and size), the same cache format, the same
+ * tables layout and the same build of the engine.
+ */
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#include "l_main.h"
+#include "../core/system.h"
+
+#define TR_CACHE_MAGIC      (0x434C5254)            // "TRLC"
+#define TR_CACHE_VERSION    (2)
+
+
+typedef struct tr_cache_header_s
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    layout;
+    uint32_t    build;
+    int32_t     game_version;
+    uint64_t    level_hash;
+    uint64_t    level_size;
+    uint64_t    data_size;
+}tr_cache_header_t;
+
+typedef struct tr_cache_reader_s
+{
+    const uint8_t  *data;
+    size_t          size;
+    size_t          pos;
+    bool            ok;
+}tr_cache_reader_t;
+
+
+static uint32_t TR_Cache_GetLayout()
+{
+    const uint32_t sizes[] = {
+        sizeof(void*), sizeof(tr5_room_t), sizeof(tr5_room_layer_t), sizeof(tr5_room_vertex_t),
+        sizeof(tr4_face4_t), sizeof(tr4_face3_t), sizeof(tr_room_sprite_t), sizeof(tr_room_portal_t),
+        sizeof(tr_room_sector_t), sizeof(tr5_room_light_t), sizeof(tr2_room_staticmesh_t), sizeof(tr4_mesh_t),
+        sizeof(tr5_vertex_t), sizeof(tr_animation_t), sizeof(tr_state_change_t), sizeof(tr_anim_dispatch_t),
+        sizeof(tr_moveable_t), sizeof(tr_staticmesh_t), sizeof(tr4_object_texture_t), sizeof(tr_sprite_texture_t),
+        sizeof(tr_sprite_sequence_t), sizeof(tr_camera_t), sizeof(tr4_flyby_camera_t), sizeof(tr_sound_source_t),
+        sizeof(tr_box_t), sizeof(tr2_zone_t), sizeof(tr2_item_t), sizeof(tr_lightmap_t), sizeof(tr2_palette_t),
+        sizeof(tr4_ai_object_t), sizeof(tr_cinematic_frame_t), sizeof(tr_sound_details_t), sizeof(tr4_textile32_t)
+    };
+    uint32_t ret = 2166136261U;
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        ret = (ret ^ sizes[i]) * 16777619U;
+    }
+    return ret;
+}
+
+
+/*
+ * Tables are raw memory images, so field order, packing and compiler ABI
+ * matter too, not only sizes: any change of the tables declarations rebuilds
+ * this file and changes its build time.
+ */
+static uint32_t TR_Cache_GetBuild()
+{
+    const char *build = __DATE__ " " __TIME__
+#ifdef __VERSION__
+                        " " __VERSION__
+#endif
+                        ;
+    const uint16_t byte_order = 0x0102;
+    uint32_t ret = 2166136261U;
+    for(const char *ch = build; *ch; ch++)
+    {
+        ret = (ret ^ (uint8_t)*ch) * 16777619U;
+    }
+    ret = (ret ^ *(const uint8_t*)&byte_order) * 16777619U;
+#ifdef _MSC_FULL_VER
+    ret = (ret ^ _MSC_FULL_VER) * 16777619U;
+#endif
+    return ret;
+}
+
+
+static uint32_t TR_Cache_GetSoundmapSize(int32_t game_version)
+{
+    switch(game_version)
+    {
+        case TR_I:
+        case TR_I_DEMO:
+        case TR_I_UB:
+            return TR_AUDIO_MAP_SIZE_TR1;
+
+        case TR_II:
+        case TR_II_DEMO:
+            return TR_AUDIO_MAP_SIZE_TR2;
+
+        case TR_III:
+            return TR_AUDIO_MAP_SIZE_TR3;
+
+        case TR_IV:
+        case TR_IV_DEMO:
+            return TR_AUDIO_MAP_SIZE_TR4;
+
+        case TR_V:
+            return TR_AUDIO_MAP_SIZE_TR5;
+    };
+    return 0;
+}
+
+
+static void TR_Cache_Write(SDL_RWops *dst, bool *ok, const void *data, size_t size)
+{
+    if(*ok && size && (SDL_RWwrite(dst, data, size, 1) != 1))
+    {
+        *ok = false;
+    }
+}
+
+
+static void TR_Cache_WriteArray(SDL_RWops *dst, bool *ok, const void *data, size_t size)
+{
+    uint64_t size64 = (data) ? (size) : (0);
+    TR_Cache_Write(dst, ok, &size64, sizeof(size64));
+    TR_Cache_Write(dst, ok, data, size64);
+}
+
+
+static void TR_Cache_Read(tr_cache_reader_t *src, void *data, size_t size)
+{
+    if(src->ok && (size <= src->size - src->pos))
+    {
+        memcpy(data, src->data + src->pos, size);
+        src->pos += size;
+    }
+    else
+    {
+        src->ok = false;
+        memset(data, 0x00, size);
+    }
+}
+
+
+/*
+ * Returns table copy or NULL for an empty one; size must be the same as
+ * the written one, else reading fails.
+ */
+static void *TR_Cache_ReadArray(tr_cache_reader_t *src, size_t size)
+{
+    uint64_t size64 = 0;
+    void *ret = NULL;
+    TR_Cache_Read(src, &size64, sizeof(size64));
+    if(src->ok && (size64 != size))
+    {
+        src->ok = false;
+    }
+    if(src->ok && size)
+    {
+        ret = malloc(size);
+        TR_Cache_Read(src, ret, size);
+    }
+    return ret;
+}
+
+
+uint64_t TR_Level::get_file_hash(const char *filename, uint64_t *file_size)
+{
+    uint64_t ret = 14695981039346656037ULL;
+    SDL_RWops *src = SDL_RWFromFile(filename, "rb");
+    *file_size = 0;
+
+    if(src)
+    {
+        const size_t block_size = 64 * 1024;
+        uint8_t *buf = (uint8_t*)malloc(block_size);
+        size_t size;
+        while((size = SDL_RWread(src, buf, 1, block_size)) > 0)
+        {
+            size_t i = 0;
+            *file_size += size;
+            for(; i + 8 <= size; i += 8)
+            {
+                uint64_t w;
+                memcpy(&w, buf + i, 8);
+                ret = (ret ^ w) * 1099511628211ULL;
+                ret ^= ret >> 29;
+            }
+            for(; i < size; i++)
+            {
+                ret = (ret ^ buf[i]) * 1099511628211ULL;
+            }
+        }
+        free(buf);
+        SDL_RWclose(src);
+    }
+
+    return ret;
+}
+
+
+bool TR_Level::write_cache(const char *cache_name, uint64_t level_hash, uint64_t level_size)
+{
+    tr_cache_header_t header;
+    SDL_RWops *dst = SDL_RWFromFile(cache_name, "wb");
+    bool ok = (dst != NULL);
+    uint32_t counts[] = {
+        (uint32_t)this->read_32bit_textiles, this->num_textiles, this->num_room_textiles, this->num_obj_textiles,
+        this->num_bump_textiles, this->num_misc_textiles, this->textile32_count, this->rooms_count,
+        this->floor_data_size, this->meshes_count, this->mesh_indices_count, this->animations_count,
+        this->state_changes_count, this->anim_dispatches_count, this->anim_commands_count, this->moveables_count,
+        this->static_meshes_count, this->object_textures_count, this->animated_textures_count, this->animated_textures_uv_count,
+        this->sprite_textures_count, this->sprite_sequences_count, this->cameras_count, this->flyby_cameras_count,
+        this->sound_sources_count, this->boxes_count, this->overlaps_count, this->items_count,
+        this->ai_objects_count, this->cinematic_frames_count, this->demo_data_count, this->sound_details_count,
+        this->samples_count, this->samples_data_size, this->sample_indices_count, this->frame_data_size,
+        this->mesh_tree_data_size, TR_Cache_GetSoundmapSize(this->game_version)
+    };
+
+    if(!dst)
+    {
+        return false;
+    }
+
+    memset(&header, 0x00, sizeof(header));
+    header.magic = TR_CACHE_MAGIC;
+    header.version = TR_CACHE_VERSION;
+    header.layout = TR_Cache_GetLayout();
+    header.build = TR_Cache_GetBuild();
+    header.game_version = this->game_version;
+    header.level_hash = level_hash;
+    header.level_size = level_size;
+    TR_Cache_Write(dst, &ok, &header, sizeof(header));                  // data_size is patched at the end
+
+    TR_Cache_Write(dst, &ok, counts, sizeof(counts));
+    TR_Cache_Write(dst, &ok, &this->lightmap, sizeof(this->lightmap));
+    TR_Cache_Write(dst, &ok, &this->palette, sizeof(this->palette));
+    TR_Cache_Write(dst, &ok, &this->palette16, sizeof(this->palette16));
+
+    TR_Cache_WriteArray(dst, &ok, this->textile32, this->textile32_count * sizeof(tr4_textile32_t));
+    TR_Cache_WriteArray(dst, &ok, this->rooms, this->rooms_count * sizeof(tr5_room_t));
+    for(uint32_t i = 0; i < this->rooms_count; i++)
+    {
+        tr5_room_t *r = this->rooms + i;
+        TR_Cache_WriteArray(dst, &ok, r->layers, r->num_layers * sizeof(tr5_room_layer_t));
+        TR_Cache_WriteArray(dst, &ok, r->vertices, r->num_vertices * sizeof(tr5_room_vertex_t));
+        TR_Cache_WriteArray(dst, &ok, r->rectangles, r->num_rectangles * sizeof(tr4_face4_t));
+        TR_Cache_WriteArray(dst, &ok, r->triangles, r->num_triangles * sizeof(tr4_face3_t));
+        TR_Cache_WriteArray(dst, &ok, r->sprites, r->num_sprites * sizeof(tr_room_sprite_t));
+        TR_Cache_WriteArray(dst, &ok, r->portals, r->num_portals * sizeof(tr_room_portal_t));
+        TR_Cache_WriteArray(dst, &ok, r->sector_list, r->num_xsectors * r->num_zsectors * sizeof(tr_room_sector_t));
+        TR_Cache_WriteArray(dst, &ok, r->lights, r->num_lights * sizeof(tr5_room_light_t));
+        TR_Cache_WriteArray(dst, &ok, r->static_meshes, r->num_static_meshes * sizeof(tr2_room_staticmesh_t));
+    }
+    TR_Cache_WriteArray(dst, &ok, this->floor_data, this->floor_data_size * sizeof(uint16_t));
+    TR_Cache_WriteArray(dst, &ok, this->meshes, this->meshes_count * sizeof(tr4_mesh_t));
+    for(uint32_t i = 0; i < this->meshes_count; i++)
+    {
+        tr4_mesh_t *m = this->meshes + i;
+        TR_Cache_WriteArray(dst, &ok, m->vertices, m->num_vertices * sizeof(tr5_vertex_t));
+        TR_Cache_WriteArray(dst, &ok, m->normals, m->num_normals * sizeof(tr5_vertex_t));
+        TR_Cache_WriteArray(dst, &ok, m->lights, m->num_lights * sizeof(int16_t));
+        TR_Cache_WriteArray(dst, &ok, m->textured_rectangles, m->num_textured_rectangles * sizeof(tr4_face4_t));
+        TR_Cache_WriteArray(dst, &ok, m->textured_triangles, m->num_textured_triangles * sizeof(tr4_face3_t));
+        TR_Cache_WriteArray(dst, &ok, m->coloured_rectangles, m->num_coloured_rectangles * sizeof(tr4_face4_t));
+        TR_Cache_WriteArray(dst, &ok, m->coloured_triangles, m->num_coloured_triangles * sizeof(tr4_face3_t));
+    }
+    TR_Cache_WriteArray(dst, &ok, this->mesh_indices, this->mesh_indices_count * sizeof(uint32_t));
+    TR_Cache_WriteArray(dst, &ok, this->animations, this->animations_count * sizeof(tr_animation_t));
+    TR_Cache_WriteArray(dst, &ok, this->state_changes, this->state_changes_count * sizeof(tr_state_change_t));
+    TR_Cache_WriteArray(dst, &ok, this->anim_dispatches, this->anim_dispatches_count * sizeof(tr_anim_dispatch_t));
+    TR_Cache_WriteArray(dst, &ok, this->anim_commands, this->anim_commands_count * sizeof(int16_t));
+    TR_Cache_WriteArray(dst, &ok, this->moveables, this->moveables_count * sizeof(tr_moveable_t));
+    TR_Cache_WriteArray(dst, &ok, this->static_meshes, this->static_meshes_count * sizeof(tr_staticmesh_t));
+    TR_Cache_WriteArray(dst, &ok, this->object_textures, this->object_textures_count * sizeof(tr4_object_texture_t));
+    TR_Cache_WriteArray(dst, &ok, this->animated_textures, this->animated_textures_count * sizeof(uint16_t));
+    TR_Cache_WriteArray(dst, &ok, this->sprite_textures, this->sprite_textures_count * sizeof(tr_sprite_texture_t));
+    TR_Cache_WriteArray(dst, &ok, this->sprite_sequences, this->sprite_sequences_count * sizeof(tr_sprite_sequence_t));
+    TR_Cache_WriteArray(dst, &ok, this->cameras, this->cameras_count * sizeof(tr_camera_t));
+    TR_Cache_WriteArray(dst, &ok, this->flyby_cameras, this->flyby_cameras_count * sizeof(tr4_flyby_camera_t));
+    TR_Cache_WriteArray(dst, &ok, this->sound_sources, this->sound_sources_count * sizeof(tr_sound_source_t));
+    TR_Cache_WriteArray(dst, &ok, this->boxes, this->boxes_count * sizeof(tr_box_t));
+    TR_Cache_WriteArray(dst, &ok, this->zones, this->boxes_count * sizeof(tr2_zone_t));
+    TR_Cache_WriteArray(dst, &ok, this->overlaps, this->overlaps_count * sizeof(uint16_t));
+    TR_Cache_WriteArray(dst, &ok, this->items, this->items_count * sizeof(tr2_item_t));
+    TR_Cache_WriteArray(dst, &ok, this->ai_objects, this->ai_objects_count * sizeof(tr4_ai_object_t));
+    TR_Cache_WriteArray(dst, &ok, this->cinematic_frames, this->cinematic_frames_count * sizeof(tr_cinematic_frame_t));
+    TR_Cache_WriteArray(dst, &ok, this->demo_data, this->demo_data_count * sizeof(uint8_t));
+    TR_Cache_WriteArray(dst, &ok, this->soundmap, TR_Cache_GetSoundmapSize(this->game_version) * sizeof(int16_t));
+    TR_Cache_WriteArray(dst, &ok, this->sound_details, this->sound_details_count * sizeof(tr_sound_details_t));
+    TR_Cache_WriteArray(dst, &ok, this->samples_data, this->samples_data_size * sizeof(uint8_t));
+    TR_Cache_WriteArray(dst, &ok, this->sample_indices, this->sample_indices_count * sizeof(uint32_t));
+    TR_Cache_WriteArray(dst, &ok, this->frame_data, this->frame_data_size * sizeof(uint16_t));
+    TR_Cache_WriteArray(dst, &ok, this->mesh_tree_data, this->mesh_tree_data_size * sizeof(uint32_t));
+
+    if(ok)
+    {
+        header.data_size = SDL_RWtell(dst) - sizeof(header);
+        ok = (SDL_RWseek(dst, 0, RW_SEEK_SET) == 0);
+        TR_Cache_Write(dst, &ok, &header, sizeof(header));
+    }
+    SDL_RWclose(dst);
+
+    return ok;
+}
+
+
+bool TR_Level::read_cache(const char *cache_name, uint64_t level_hash, uint64_t level_size)
+{
+    tr_cache_header_t header;
+    tr_cache_reader_t src;
+    uint32_t counts[38];
+    uint8_t *data;
+    SDL_RWops *file = SDL_RWFromFile(cache_name, "rb");
+
+    if(!file)
+    {
+        return false;
+    }
+
+    if((SDL_RWread(file, &header, sizeof(header), 1) != 1) ||
+       (header.magic != TR_CACHE_MAGIC) || (header.version != TR_CACHE_VERSION) ||
+       (header.layout != TR_Cache_GetLayout()) || (header.build != TR_Cache_GetBuild()) ||
+       (header.level_hash != level_hash) ||
+       (header.level_size != level_size) || (header.data_size > (uint64_t)SDL_RWsize(file)))
+    {
+        SDL_RWclose(file);
+        return false;
+    }
+
+    data = (uint8_t*)malloc(header.data_size);
+    if(!data || (SDL_RWread(file, data, header.data_size, 1) != 1))
+    {
+        free(data);
+        SDL_RWclose(file);
+        return false;
+    }
+    SDL_RWclose(file);
+
+    src.data = data;
+    src.size = header.data_size;
+    src.pos = 0;
+    src.ok = true;
+
+    this->game_version = header.game_version;
+    TR_Cache_Read(&src, counts, sizeof(counts));
+    TR_Cache_Read(&src, &this->lightmap, sizeof(this->lightmap));
+    TR_Cache_Read(&src, &this->palette, sizeof(this->palette));
+    TR_Cache_Read(&src, &this->palette16, sizeof(this->palette16));
+    if(!src.ok || (counts[37] != TR_Cache_GetSoundmapSize(this->game_version)))
+    {
+        free(data);
+        return false;
+    }
+
+    this->read_32bit_textiles       = counts[0];
+    this->num_textiles              = counts[1];
+    this->num_room_textiles         = counts[2];
+    this->num_obj_textiles          = counts[3];
+    this->num_bump_textiles         = counts[4];
+    this->num_misc_textiles         = counts[5];
+    this->textile32_count           = counts[6];
+    this->rooms_count               = counts[7];
+    this->floor_data_size           = counts[8];
+    this->meshes_count              = counts[9];
+    this->mesh_indices_count        = counts[10];
+    this->animations_count          = counts[11];
+    this->state_changes_count       = counts[12];
+    this->anim_dispatches_count     = counts[13];
+    this->anim_commands_count       = counts[14];
+    this->moveables_count           = counts[15];
+    this->static_meshes_count       = counts[16];
+    this->object_textures_count     = counts[17];
+    this->animated_textures_count   = counts[18];
+    this->animated_textures_uv_count = counts[19];
+    this->sprite_textures_count     = counts[20];
+    this->sprite_sequences_count    = counts[21];
+    this->cameras_count             = counts[22];
+    this->flyby_cameras_count       = counts[23];
+    this->sound_sources_count       = counts[24];
+    this->boxes_count               = counts[25];
+    this->overlaps_count            = counts[26];
+    this->items_count               = counts[27];
+    this->ai_objects_count          = counts[28];
+    this->cinematic_frames_count    = counts[29];
+    this->demo_data_count           = counts[30];
+    this->sound_details_count       = counts[31];
+    this->samples_count             = counts[32];
+    this->samples_data_size         = counts[33];
+    this->sample_indices_count      = counts[34];
+    this->frame_data_size           = counts[35];
+    this->mesh_tree_data_size       = counts[36];
+
+    /*
+     * Tables are read in place: on a failure the destructor frees what is
+     * read, so room and mesh pointers are cleared before their tables.
+     */
+    this->textile32 = (tr4_textile32_t*)TR_Cache_ReadArray(&src, this->textile32_count * sizeof(tr4_textile32_t));
+    this->rooms = (tr5_room_t*)TR_Cache_ReadArray(&src, this->rooms_count * sizeof(tr5_room_t));
+    if(this->rooms)
+    {
+        for(uint32_t i = 0; i < this->rooms_count; i++)
+        {
+            tr5_room_t *r = this->rooms + i;
+            r->layers = NULL;
+            r->vertices = NULL;
+            r->rectangles = NULL;
+            r->triangles = NULL;
+            r->sprites = NULL;
+            r->portals = NULL;
+            r->sector_list = NULL;
+            r->lights = NULL;
+            r->static_meshes = NULL;
+        }
+        for(uint32_t i = 0; src.ok && (i < this->rooms_count); i++)
+        {
+            tr5_room_t *r = this->rooms + i;
+            r->layers = (tr5_room_layer_t*)TR_Cache_ReadArray(&src, r->num_layers * sizeof(tr5_room_layer_t));
+            r->vertices = (tr5_room_vertex_t*)TR_Cache_ReadArray(&src, r->num_vertices * sizeof(tr5_room_vertex_t));
+            r->rectangles = (tr4_face4_t*)TR_Cache_ReadArray(&src, r->num_rectangles * sizeof(tr4_face4_t));
+            r->triangles = (tr4_face3_t*)TR_Cache_ReadArray(&src, r->num_triangles * sizeof(tr4_face3_t));
+            r->sprites = (tr_room_sprite_t*)TR_Cache_ReadArray(&src, r->num_sprites * sizeof(tr_room_sprite_t));
+            r->portals = (tr_room_portal_t*)TR_Cache_ReadArray(&src, r->num_portals * sizeof(tr_room_portal_t));
+            r->sector_list = (tr_room_sector_t*)TR_Cache_ReadArray(&src, r->num_xsectors * r->num_zsectors * sizeof(tr_room_sector_t));
+            r->lights = (tr5_room_light_t*)TR_Cache_ReadArray(&src, r->num_lights * sizeof(tr5_room_light_t));
+            r->static_meshes = (tr2_room_staticmesh_t*)TR_Cache_ReadArray(&src, r->num_static_meshes * sizeof(tr2_room_staticmesh_t));
+        }
+    }
+    this->floor_data = (uint16_t*)TR_Cache_ReadArray(&src, this->floor_data_size * sizeof(uint16_t));
+    this->meshes = (tr4_mesh_t*)TR_Cache_ReadArray(&src, this->meshes_count * sizeof(tr4_mesh_t));
+    if(this->meshes)
+    {
+        for(uint32_t i = 0; i < this->meshes_count; i++)
+        {
+            tr4_mesh_t *m = this->meshes + i;
+            m->vertices = NULL;
+            m->normals = NULL;
+            m->lights = NULL;
+            m->textured_rectangles = NULL;
+            m->textured_triangles = NULL;
+            m->coloured_rectangles = NULL;
+            m->coloured_triangles = NULL;
+        }
+        for(uint32_t i = 0; src.ok && (i < this->meshes_count); i++)
+        {
+            tr4_mesh_t *m = this->meshes + i;
+            m->vertices = (tr5_vertex_t*)TR_Cache_ReadArray(&src, m->num_vertices * sizeof(tr5_vertex_t));
+            m->normals = (tr5_vertex_t*)TR_Cache_ReadArray(&src, m->num_normals * sizeof(tr5_vertex_t));
+            m->lights = (int16_t*)TR_Cache_ReadArray(&src, m->num_lights * sizeof(int16_t));
+            m->textured_rectangles = (tr4_face4_t*)TR_Cache_ReadArray(&src, m->num_textured_rectangles * sizeof(tr4_face4_t));
+            m->textured_triangles = (tr4_face3_t*)TR_Cache_ReadArray(&src, m->num_textured_triangles * sizeof(tr4_face3_t));
+            m->coloured_rectangles = (tr4_face4_t*)TR_Cache_ReadArray(&src, m->num_coloured_rectangles * sizeof(tr4_face4_t));
+            m->coloured_triangles = (tr4_face3_t*)TR_Cache_ReadArray(&src, m->num_coloured_triangles * sizeof(tr4_face3_t));
+        }
+    }
+    this->mesh_indices = (uint32_t*)TR_Cache_ReadArray(&src, this->mesh_indices_count * sizeof(uint32_t));
+    this->animations = (tr_animation_t*)TR_Cache_ReadArray(&src, this->animations_count * sizeof(tr_animation_t));
+    this->state_changes = (tr_state_change_t*)TR_Cache_ReadArray(&src, this->state_changes_count * sizeof(tr_state_change_t));
+    this->anim_dispatches = (tr_anim_dispatch_t*)TR_Cache_ReadArray(&src, this->anim_dispatches_count * sizeof(tr_anim_dispatch_t));
+    this->anim_commands = (int16_t*)TR_Cache_ReadArray(&src, this->anim_commands_count * sizeof(int16_t));
+    this->moveables = (tr_moveable_t*)TR_Cache_ReadArray(&src, this->moveables_count * sizeof(tr_moveable_t));
+    this->static_meshes = (tr_staticmesh_t*)TR_Cache_ReadArray(&src, this->static_meshes_count * sizeof(tr_staticmesh_t));
+    this->object_textures = (tr4_object_texture_t*)TR_Cache_ReadArray(&src, this->object_textures_count * sizeof(tr4_object_texture_t));
+    this->animated_textures = (uint16_t*)TR_Cache_ReadArray(&src, this->animated_textures_count * sizeof(uint16_t));
+    this->sprite_textures = (tr_sprite_texture_t*)TR_Cache_ReadArray(&src, this->sprite_textures_count * sizeof(tr_sprite_texture_t));
+    this->sprite_sequences = (tr_sprite_sequence_t*)TR_Cache_ReadArray(&src, this->sprite_sequences_count * sizeof(tr_sprite_sequence_t));
+    this->cameras = (tr_camera_t*)TR_Cache_ReadArray(&src, this->cameras_count * sizeof(tr_camera_t));
+    this->flyby_cameras = (tr4_flyby_camera_t*)TR_Cache_ReadArray(&src, this->flyby_cameras_count * sizeof(tr4_flyby_camera_t));
+    this->sound_sources = (tr_sound_source_t*)TR_Cache_ReadArray(&src, this->sound_sources_count * sizeof(tr_sound_source_t));
+    this->boxes = (tr_box_t*)TR_Cache_ReadArray(&src, this->boxes_count * sizeof(tr_box_t));
+    this->zones = (tr2_zone_t*)TR_Cache_ReadArray(&src, this->boxes_count * sizeof(tr2_zone_t));
+    this->overlaps = (uint16_t*)TR_Cache_ReadArray(&src, this->overlaps_count * sizeof(uint16_t));
+    this->items = (tr2_item_t*)TR_Cache_ReadArray(&src, this->items_count * sizeof(tr2_item_t));
+    this->ai_objects = (tr4_ai_object_t*)TR_Cache_ReadArray(&src, this->ai_objects_count * sizeof(tr4_ai_object_t));
+    this->cinematic_frames = (tr_cinematic_frame_t*)TR_Cache_ReadArray(&src, this->cinematic_frames_count * sizeof(tr_cinematic_frame_t));
+    this->demo_data = (uint8_t*)TR_Cache_ReadArray(&src, this->demo_data_count * sizeof(uint8_t));
+    this->soundmap = (int16_t*)TR_Cache_ReadArray(&src, TR_Cache_GetSoundmapSize(this->game_version) * sizeof(int16_t));
+    this->sound_details = (tr_sound_details_t*)TR_Cache_ReadArray(&src, this->sound_details_count * sizeof(tr_sound_details_t));
+    this->samples_data = (uint8_t*)TR_Cache_ReadArray(&src, this->samples_data_size * sizeof(uint8_t));
+    this->sample_indices = (uint32_t*)TR_Cache_ReadArray(&src, this->sample_indices_count * sizeof(uint32_t));
+    this->frame_data = (uint16_t*)TR_Cache_ReadArray(&src, this->frame_data_size * sizeof(uint16_t));
+    this->mesh_tree_data = (uint32_t*)TR_Cache_ReadArray(&src, this->mesh_tree_data_size * sizeof(uint32_t));
+
+    free(data);
+    if(!src.ok || (src.pos != src.size))
+    {
+        this->rooms_count = (this->rooms) ? (this->rooms_count) : (0);
+        this->meshes_count = (this->meshes) ? (this->meshes_count) : (0);
+        return false;
+    }
+    return true;
+}
@@ -21,159 +21,329 @@
 
 #include <assert.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_endian.h>
 
 #include "l_main.h"
 #include "../core/system.h"
 
-/** \brief reads signed 8-bit value.
+/** \brief makes a reader over data owned by caller; data must outlive the reader.
+  */
+tr_reader_t *TR_Reader_Create(const void *data, size_t size)
+{
+    tr_reader_t *reader = (tr_reader_t*)calloc(1, sizeof(tr_reader_t));
+
+    if (reader)
+    {
+        reader->data = (const uint8_t*)data;
+        reader->size = size;
+    }
+
+    return reader;
+}
+
+/** \brief makes a reader over the whole file.
   *
-  * uses current position from src. throws TR_ReadError when not successful.
+  * The file gets mapped where mmap is available, otherwise (or if mapping fails) it is read
+  * by one SDL_RWread call. Returns NULL if file can not be opened.
   */
+tr_reader_t *TR_Reader_CreateFromFile(const char *filename)
+{
+    tr_reader_t *reader = NULL;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+
+    if (fd >= 0)
+    {
+        struct stat st;
+        void *mapping = MAP_FAILED;
+        if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+        {
+            mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+
+        if (mapping != MAP_FAILED)
+        {
+            madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+            reader = TR_Reader_Create(mapping, st.st_size);
+            if (reader)
+            {
+                reader->mapping = mapping;
+                return reader;
+            }
+            munmap(mapping, st.st_size);
+        }
+    }
+#endif
+    SDL_RWops *src = SDL_RWFromFile(filename, "rb");
+
+    if (src)
+    {
+        reader = TR_Reader_CreateFromRW(src);
+        SDL_RWclose(src);
+    }
+
+    return reader;
+}
 
-int8_t TR_Level::read_bit8(SDL_RWops * const src)
+/** \brief makes a reader over the rest of src, read by one call; src may be closed after.
+  */
+tr_reader_t *TR_Reader_CreateFromRW(SDL_RWops *src)
 {
-    int8_t data;
+    int64_t pos = SDL_RWtell(src);
+    int64_t size = SDL_RWsize(src);
+    uint8_t *buffer;
+    tr_reader_t *reader;
+
+    if ((pos < 0) || (size < pos))
+    {
+        return NULL;
+    }
+
+    size -= pos;
+    buffer = (uint8_t*)malloc((size > 0) ? size : 1);
+    if (!buffer || ((size > 0) && (SDL_RWread(src, buffer, size, 1) != 1)))
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    reader = TR_Reader_Create(buffer, size);
+    if (!reader)
+    {
+        free(buffer);
+        return NULL;
+    }
+    reader->buffer = buffer;
+
+    return reader;
+}
 
-    if (src == NULL)
-        Sys_extError("read_bit8: src == NULL");
+void TR_Reader_Close(tr_reader_t *reader)
+{
+    if (reader)
+    {
+#ifndef _WIN32
+        if (reader->mapping)
+        {
+            munmap(reader->mapping, reader->size);
+        }
+#endif
+        free(reader->buffer);
+        free(reader);
+    }
+}
 
-    if (SDL_RWread(src, &data, 1, 1) < 1)
-        Sys_extError("read_bit8");
+size_t TR_Reader_Read(tr_reader_t *reader, void *ptr, size_t size, size_t maxnum)
+{
+    size_t num = (size > 0) ? ((reader->size - reader->pos) / size) : 0;
+
+    num = (num < maxnum) ? num : maxnum;
+    memcpy(ptr, reader->data + reader->pos, num * size);
+    reader->pos += num * size;
 
-    return data;
+    return num;
 }
 
-/** \brief reads unsigned 8-bit value.
+int64_t TR_Reader_Seek(tr_reader_t *reader, int64_t offset, int whence)
+{
+    switch (whence)
+    {
+        case RW_SEEK_CUR:
+            offset += reader->pos;
+            break;
+        case RW_SEEK_END:
+            offset += reader->size;
+            break;
+    }
+
+    if ((offset < 0) || (offset > (int64_t)reader->size))
+    {
+        return -1;
+    }
+    reader->pos = offset;
+
+    return offset;
+}
+
+int64_t TR_Reader_Tell(tr_reader_t *reader)
+{
+    return reader->pos;
+}
+
+int64_t TR_Reader_Size(tr_reader_t *reader)
+{
+    return reader->size;
+}
+
+/** \brief reads signed 8-bit value.
   *
   * uses current position from src. throws TR_ReadError when not successful.
   */
-uint8_t TR_Level::read_bitu8(SDL_RWops * const src)
+
+int8_t TR_Level::read_bit8(tr_reader_t * const src)
 {
-    uint8_t data;
+    if (src->pos + 1 > src->size)
+        Sys_extError("read_bit8");
 
-    if (src == NULL)
-        Sys_extError("read_bitu8: src == NULL");
+    return (int8_t)src->data[src->pos++];
+}
 
-    if (SDL_RWread(src, &data, 1, 1) < 1)
+/** \brief reads unsigned 8-bit value.
+  *
+  * uses current position from src. throws TR_ReadError when not successful.
+  */
+uint8_t TR_Level::read_bitu8(tr_reader_t * const src)
+{
+    if (src->pos + 1 > src->size)
         Sys_extError("read_bitu8");
 
-    return data;
+    return src->data[src->pos++];
 }
 
 /** \brief reads signed 16-bit value.
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-int16_t TR_Level::read_bit16(SDL_RWops * const src)
+int16_t TR_Level::read_bit16(tr_reader_t * const src)
 {
     int16_t data;
 
-    if (src == NULL)
-        Sys_extError("read_bit16: src == NULL");
-
-    if (SDL_RWread(src, &data, 2, 1) < 1)
+    if (src->pos + 2 > src->size)
         Sys_extError("read_bit16");
 
-    data = SDL_SwapLE16(data);
+    memcpy(&data, src->data + src->pos, 2);
+    src->pos += 2;
 
-    return data;
+    return SDL_SwapLE16(data);
 }
 
 /** \brief reads unsigned 16-bit value.
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-uint16_t TR_Level::read_bitu16(SDL_RWops * const src)
+uint16_t TR_Level::read_bitu16(tr_reader_t * const src)
 {
     uint16_t data;
 
-    if (src == NULL)
-        Sys_extError("read_bitu16: src == NULL");
-
-    if (SDL_RWread(src, &data, 2, 1) < 1)
+    if (src->pos + 2 > src->size)
         Sys_extError("read_bitu16");
 
-    data = SDL_SwapLE16(data);
+    memcpy(&data, src->data + src->pos, 2);
+    src->pos += 2;
 
-    return data;
+    return SDL_SwapLE16(data);
 }
 
 /** \brief reads signed 32-bit value.
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-int32_t TR_Level::read_bit32(SDL_RWops * const src)
+int32_t TR_Level::read_bit32(tr_reader_t * const src)
 {
     int32_t data;
 
-    if (src == NULL)
-        Sys_extError("read_bit32: src == NULL");
-
-    if (SDL_RWread(src, &data, 4, 1) < 1)
+    if (src->pos + 4 > src->size)
         Sys_extError("read_bit32");
 
-    data = SDL_SwapLE32(data);
+    memcpy(&data, src->data + src->pos, 4);
+    src->pos += 4;
 
-    return data;
+    return SDL_SwapLE32(data);
 }
 
 /** \brief reads unsigned 32-bit value.
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-uint32_t TR_Level::read_bitu32(SDL_RWops * const src)
+uint32_t TR_Level::read_bitu32(tr_reader_t * const src)
 {
     uint32_t data;
 
-    if (src == NULL)
-        Sys_extError("read_bitu32: src == NULL");
-
-    if (SDL_RWread(src, &data, 4, 1) < 1)
+    if (src->pos + 4 > src->size)
         Sys_extError("read_bitu32");
 
-    data = SDL_SwapLE32(data);
+    memcpy(&data, src->data + src->pos, 4);
+    src->pos += 4;
 
-    return data;
+    return SDL_SwapLE32(data);
 }
 
 /** \brief reads float value.
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-float TR_Level::read_float(SDL_RWops * const src)
+float TR_Level::read_float(tr_reader_t * const src)
 {
-    float data;
-
-    if (src == NULL)
-        Sys_extError("read_float: src == NULL");
+    uint32_t data;
+    float ret;
 
-    if (SDL_RWread(src, &data, 4, 1) < 1)
+    if (src->pos + 4 > src->size)
         Sys_extError("read_float");
 
+    memcpy(&data, src->data + src->pos, 4);
+    src->pos += 4;
     data = SDL_SwapLE32(data);
+    memcpy(&ret, &data, 4);
 
-    return data;
+    return ret;
 }
 
 /** \brief reads mixed TR-specific float value (used in animation speed/accel fields).
   *
   * uses current position from src. does endian correction. throws TR_ReadError when not successful.
   */
-float TR_Level::read_mixfloat(SDL_RWops * const src)
+float TR_Level::read_mixfloat(tr_reader_t * const src)
 {
-    int16_t base_int;
-    uint16_t sign_int;
+    int16_t data[2];
 
-    if (src == NULL)
-        Sys_extError("read_mixfloat: src == NULL");
+    read_bit16_array(src, data, 2);
 
-    if ((SDL_RWread(src, &sign_int, 2, 1) < 1) || (SDL_RWread(src, &base_int, 2, 1) < 1))
-        Sys_extError("read_mixfloat");
+    return ((float)data[1] + ((float)(uint16_t)data[0] / 65535.0));
+}
 
-    base_int = SDL_SwapLE32(base_int);
-    sign_int = SDL_SwapLE32(sign_int);
+/** \brief reads array of signed 16-bit values.
+  *
+  * one bounds check and copy for the whole array. does endian correction. throws TR_ReadError when not successful.
+  */
+void TR_Level::read_bit16_array(tr_reader_t * const src, int16_t *data, uint32_t count)
+{
+    read_bitu16_array(src, (uint16_t*)data, count);
+}
+
+/** \brief reads array of unsigned 16-bit values.
+  *
+  * one bounds check and copy for the whole array. does endian correction. throws TR_ReadError when not successful.
+  */
+void TR_Level::read_bitu16_array(tr_reader_t * const src, uint16_t *data, uint32_t count)
+{
+    if (TR_Reader_Read(src, data, 2, count) < count)
+        Sys_extError("read_bitu16_array");
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    for (uint32_t i = 0; i < count; i++)
+        data[i] = SDL_SwapLE16(data[i]);
+#endif
+}
+
+/** \brief reads array of unsigned 32-bit values.
+  *
+  * one bounds check and copy for the whole array. does endian correction. throws TR_ReadError when not successful.
+  */
+void TR_Level::read_bitu32_array(tr_reader_t * const src, uint32_t *data, uint32_t count)
+{
+    if (TR_Reader_Read(src, data, 4, count) < count)
+        Sys_extError("read_bitu32_array");
 
-    return ((float)base_int + ((float)sign_int / 65535.0));
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    for (uint32_t i = 0; i < count; i++)
+        data[i] = SDL_SwapLE32(data[i]);
+#endif
 }
@@ -21,17 +21,18 @@
 
 #include <SDL2/SDL.h>
 #include <string.h>
+#include <zlib.h>
 
 #include "l_main.h"
 #include "../core/system.h"
+#include "../core/jobs.h"
 
 #define RCSID "$Id: l_main.cpp,v 1.10 2002/09/20 15:59:02 crow Exp $"
 
 /// \brief reads the mesh data.
-void TR_Level::read_mesh_data(SDL_RWops * const src)
+void TR_Level::read_mesh_data(tr_reader_t * const src)
 {
-    uint8_t *buffer;
-    SDL_RWops *newsrc = NULL;
+    tr_reader_t *newsrc = NULL;
     uint32_t size;
     uint32_t pos = 0;
     int mesh = 0;
@@ -41,18 +42,17 @@ void TR_Level::read_mesh_data(SDL_RWops * const src)
     num_mesh_data = read_bitu32(src);
 
     size = num_mesh_data * 2;
-    buffer = new uint8_t[size];
+    if ((uint64_t)src->pos + size > src->size)
+        Sys_extError("read_tr_mesh_data: mesh data size");
 
-    if (SDL_RWread(src, buffer, 1, size) < size)
-        Sys_extError("read_tr_mesh_data: SDL_RWread(buffer)");
-
-    if ((newsrc = SDL_RWFromMem(buffer, size)) == NULL)
-        Sys_extError("read_tr_mesh_data: SDL_RWFromMem");
+    // meshes are parsed in place from the level data.
+    if ((newsrc = TR_Reader_Create(src->data + src->pos, size)) == NULL)
+        Sys_extError("read_tr_mesh_data: TR_Reader_Create");
+    src->pos += size;
 
     this->mesh_indices_count = read_bitu32(src);
     this->mesh_indices = (uint32_t*)malloc(this->mesh_indices_count * sizeof(uint32_t));
-    for (i = 0; i < this->mesh_indices_count; i++)
-        this->mesh_indices[i] = read_bitu32(src);
+    read_bitu32_array(src, this->mesh_indices, this->mesh_indices_count);
 
     this->meshes_count = this->mesh_indices_count;
     this->meshes = (tr4_mesh_t*)calloc(this->meshes_count, sizeof(tr4_mesh_t));
@@ -65,7 +65,7 @@ void TR_Level::read_mesh_data(SDL_RWops * const src)
             if (this->mesh_indices[j] == pos)
                 this->mesh_indices[j] = mesh;
 
-        SDL_RWseek(newsrc, pos, RW_SEEK_SET);
+        TR_Reader_Seek(newsrc, pos, RW_SEEK_SET);
 
         if (this->game_version >= TR_IV)
             read_tr4_mesh(newsrc, this->meshes[mesh]);
@@ -81,27 +81,25 @@ void TR_Level::read_mesh_data(SDL_RWops * const src)
                 break;
             }
     }
-    SDL_RWclose(newsrc);
+    TR_Reader_Close(newsrc);
     newsrc = NULL;
-    delete [] buffer;
 }
 
 /// \brief reads frame and moveable data.
-void TR_Level::read_frame_moveable_data(SDL_RWops * const src)
+void TR_Level::read_frame_moveable_data(tr_reader_t * const src)
 {
     uint32_t i;
-    SDL_RWops *newsrc = NULL;
+    tr_reader_t *newsrc = NULL;
     uint32_t pos = 0;
     uint32_t frame = 0;
 
     this->frame_data_size = read_bitu32(src);
     this->frame_data = (uint16_t*)malloc(this->frame_data_size * sizeof(uint16_t));
 
-    if (SDL_RWread(src, this->frame_data, sizeof(uint16_t), this->frame_data_size) < frame_data_size)
-        Sys_extError("read_tr_level: frame_data: SDL_RWread(buffer)");
+    read_bitu16_array(src, this->frame_data, this->frame_data_size);
 
-    if ((newsrc = SDL_RWFromMem(this->frame_data, this->frame_data_size)) == NULL)
-        Sys_extError("read_tr_level: frame_data: SDL_RWFromMem");
+    if ((newsrc = TR_Reader_Create(this->frame_data, this->frame_data_size)) == NULL)
+        Sys_extError("read_tr_level: frame_data: TR_Reader_Create");
 
     this->moveables_count = read_bitu32(src);
     this->moveables = (tr_moveable_t*)calloc(this->moveables_count, sizeof(tr_moveable_t));
@@ -124,7 +122,7 @@ void TR_Level::read_frame_moveable_data(SDL_RWops * const src)
                 this->moveables[j].frame_offset = 0;
             }
 
-        SDL_RWseek(newsrc, pos, RW_SEEK_SET);
+        TR_Reader_Seek(newsrc, pos, RW_SEEK_SET);
 
         frame++;
 
@@ -137,20 +135,138 @@ void TR_Level::read_frame_moveable_data(SDL_RWops * const src)
             }
     }
 
-    SDL_RWclose(newsrc);
+    TR_Reader_Close(newsrc);
     newsrc = NULL;
 }
 
-void TR_Level::read_level(const char *filename, int32_t game_version)
+/** \brief reads packed chunk header and skips its data.
+  *
+  * Data is not copied: comp_data points into the level data, so src must stay alive until chunks are unpacked.
+  */
+void TR_Level::read_packed_chunk(tr_reader_t * const src, tr_packed_chunk_t & chunk, const char *name)
 {
-    int len, i, len2;
-    SDL_RWops *src = SDL_RWFromFile(filename, "rb");
+    chunk.uncomp_size = read_bitu32(src);
+    if (chunk.uncomp_size == 0)
+        Sys_extError("%s uncomp_size == 0", name);
+
+    chunk.comp_size = read_bitu32(src);
+    if ((uint64_t)src->pos + chunk.comp_size > src->size)
+        Sys_extError("%s: comp_size", name);
+
+    chunk.comp_data = src->data + src->pos;
+    chunk.data = NULL;
+    chunk.status = Z_OK;
+    src->pos += chunk.comp_size;
+}
+
+static void TR_UnpackChunksJob(void *data, uint32_t first, uint32_t last)
+{
+    tr_packed_chunk_t *chunks = (tr_packed_chunk_t*)data;
+
+    for (uint32_t i = first; i < last; i++)
+    {
+        tr_packed_chunk_t *chunk = chunks + i;
+        if (chunk->data)
+        {
+            uLongf size = chunk->uncomp_size;
+            chunk->status = uncompress(chunk->data, &size, chunk->comp_data, chunk->comp_size);
+            if ((chunk->status == Z_OK) && (size != chunk->uncomp_size))
+                chunk->status = Z_DATA_ERROR;
+        }
+    }
+}
+
+/** \brief inflates all chunks with comp_size > 0, one chunk per job.
+  *
+  * Buffers are allocated before jobs are started; on failure all of them are freed.
+  */
+void TR_Level::unpack_chunks(tr_packed_chunk_t *chunks, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        chunks[i].data = (chunks[i].comp_size > 0) ? (uint8_t*)malloc(chunks[i].uncomp_size) : NULL;
+        chunks[i].status = ((chunks[i].comp_size > 0) && !chunks[i].data) ? Z_MEM_ERROR : Z_OK;
+    }
+
+    Jobs_ParallelFor(TR_UnpackChunksJob, chunks, count, 1);
+
+    for (i = 0; i < count; i++)
+    {
+        if (chunks[i].status != Z_OK)
+        {
+            for (uint32_t j = 0; j < count; j++)
+            {
+                free(chunks[j].data);
+                chunks[j].data = NULL;
+            }
+            Sys_extError("unpack_chunks: uncompress");
+        }
+    }
+}
+
+bool TR_Level::read_level(const char *filename, int32_t game_version)
+{
+    tr_reader_t *src = TR_Reader_CreateFromFile(filename);
 
     if(src == NULL)
     {
-        return;
+        return false;
     }
 
+    this->set_sfx_path(filename);
+    this->read_level(src, game_version);
+    TR_Reader_Close(src);
+    return true;
+}
+
+/** \brief reads the level from the rest of SDL_RWops stream.
+  *
+  * The stream is read into memory by one call and parsed from there.
+  */
+void TR_Level::read_level(SDL_RWops * const src, int32_t game_version)
+{
+    tr_reader_t *reader;
+
+    if (!src)
+        Sys_extError("Invalid SDL_RWops");
+
+    if ((reader = TR_Reader_CreateFromRW(src)) == NULL)
+        Sys_extError("read_level: TR_Reader_CreateFromRW");
+
+    this->read_level(reader, game_version);
+    TR_Reader_Close(reader);
+}
+
+/** \brief reads the samples block.
+  *
+  * Copies size bytes from src and counts embedded RIFF (wav) samples in them.
+  */
+void TR_Level::read_samples_data(tr_reader_t * const src, uint32_t size)
+{
+    uint32_t i;
+
+    this->samples_count = 0;
+    this->samples_data_size = size;
+    this->samples_data = (uint8_t*)malloc(this->samples_data_size * sizeof(uint8_t));
+    if (TR_Reader_Read(src, this->samples_data, 1, size) < size)
+        Sys_extError("read_samples_data");
+
+    for(i = 4; i < this->samples_data_size; i++)
+    {
+        if(memcmp(this->samples_data + i - 4, "RIFF", 4) == 0)
+        {
+            this->samples_count++;
+        }
+    }
+}
+
+/// \brief sets MAIN.SFX path near the level file.
+void TR_Level::set_sfx_path(const char *filename)
+{
+    int len, i, len2;
+
     len = strlen(filename);
     len2 = 0;
     for(i = 0; i < len; i++)
@@ -167,19 +283,16 @@ void TR_Level::read_level(const char *filename, int32_t game_version)
         this->sfx_path[len2+1] = 0;
         strncat(this->sfx_path, "MAIN.SFX", 256);
     }
-
-    this->read_level(src, game_version);
-    SDL_RWclose(src);
 }
 
 /** \brief reads the level.
   *
-  * Takes a SDL_RWop and the game_version of the file and reads the structures into the members of TR_Level.
+  * Takes a reader over the level data and the game_version of the file and reads the structures into the members of TR_Level.
   */
-void TR_Level::read_level(SDL_RWops * const src, int32_t game_version)
+void TR_Level::read_level(tr_reader_t * const src, int32_t game_version)
 {
     if (!src)
-        Sys_extError("Invalid SDL_RWops");
+        Sys_extError("Invalid level reader");
 
     this->game_version = game_version;
 
@@ -29,6 +29,45 @@
 #define TR_AUDIO_DEFAULT_RANGE 8
 #define TR_AUDIO_DEFAULT_PITCH 1.0       // 0.0 - only noise
 
+/** \brief level data in memory, read by a bounds checked cursor.
+  *
+  * Level files are mapped (or read in one call) as a whole and all structures are decoded
+  * from memory; nested streams (mesh data, packed TR4-5 chunks, TR5 rooms) are readers over
+  * a part of the parent data or of an uncompressed buffer, without copies.
+  * TR_Reader_Read / Seek / Tell / Size follow SDL_RWops semantics.
+  */
+typedef struct tr_reader_s
+{
+    const uint8_t  *data;
+    size_t          size;
+    size_t          pos;
+    void           *mapping;            ///< \brief mapped file, unmapped on close.
+    uint8_t        *buffer;             ///< \brief file contents read by one call, freed on close.
+} tr_reader_t;
+
+tr_reader_t *TR_Reader_Create(const void *data, size_t size);
+tr_reader_t *TR_Reader_CreateFromFile(const char *filename);
+tr_reader_t *TR_Reader_CreateFromRW(SDL_RWops *src);
+void    TR_Reader_Close(tr_reader_t *reader);
+size_t  TR_Reader_Read(tr_reader_t *reader, void *ptr, size_t size, size_t maxnum);
+int64_t TR_Reader_Seek(tr_reader_t *reader, int64_t offset, int whence);
+int64_t TR_Reader_Tell(tr_reader_t *reader);
+int64_t TR_Reader_Size(tr_reader_t *reader);
+
+/** \brief zlib packed chunk of TR4-5 level.
+  *
+  * Headers of all chunks are read first, then chunks with comp_size > 0 are inflated
+  * together on job workers into preallocated data buffers.
+  */
+typedef struct tr_packed_chunk_s
+{
+    const uint8_t  *comp_data;          ///< \brief packed data, points into level data.
+    uint32_t        comp_size;          ///< \brief 0 if chunk is absent or skipped.
+    uint32_t        uncomp_size;
+    uint8_t        *data;               ///< \brief inflated data, freed by owner.
+    int             status;             ///< \brief zlib result of inflation.
+} tr_packed_chunk_t;
+
 /** \brief A complete TR level.
   *
   * This contains all necessary functions to load a TR level.
@@ -542,8 +581,19 @@ class TR_Level
         
     char     sfx_path[256];
         
-    void read_level(const char *filename, int32_t game_version);
+    bool read_level(const char *filename, int32_t game_version);     // false if file can not be opened
     void read_level(SDL_RWops * const src, int32_t game_version);
+    void read_level(tr_reader_t * const src, int32_t game_version);
+    void set_sfx_path(const char *filename);
+
+    /** \brief binary cache of read and prepared level (see l_cache.cpp).
+      *
+      * read_cache() fails if cache is missing or made for another level file or build;
+      * level object must be deleted after a failed read.
+      */
+    static uint64_t get_file_hash(const char *filename, uint64_t *file_size);
+    bool read_cache(const char *cache_name, uint64_t level_hash, uint64_t level_size);
+    bool write_cache(const char *cache_name, uint64_t level_hash, uint64_t level_size);
     tr_mesh_thee_tag_t get_mesh_tree_tag_for_model(tr_moveable_t *model, int index);
     void get_anim_frame_data(tr5_vertex_t min_max_pos[3], tr5_vertex_t *rotations, int meshes_count, tr_animation_t *anim, int frame);
     
@@ -555,90 +605,96 @@ class TR_Level
     uint32_t num_misc_textiles;     ///< \brief number of 256x256 misc textiles (TR4-5).
     bool read_32bit_textiles;       ///< \brief are other 32bit textiles than misc ones read?
 
-    int8_t read_bit8(SDL_RWops * const src);
-    uint8_t read_bitu8(SDL_RWops * const src);
-    int16_t read_bit16(SDL_RWops * const src);
-    uint16_t read_bitu16(SDL_RWops * const src);
-    int32_t read_bit32(SDL_RWops * const src);
-    uint32_t read_bitu32(SDL_RWops * const src);
-    float read_float(SDL_RWops * const src);
-    float read_mixfloat(SDL_RWops * const src);
+    int8_t read_bit8(tr_reader_t * const src);
+    uint8_t read_bitu8(tr_reader_t * const src);
+    int16_t read_bit16(tr_reader_t * const src);
+    uint16_t read_bitu16(tr_reader_t * const src);
+    int32_t read_bit32(tr_reader_t * const src);
+    uint32_t read_bitu32(tr_reader_t * const src);
+    float read_float(tr_reader_t * const src);
+    float read_mixfloat(tr_reader_t * const src);
+    void read_bit16_array(tr_reader_t * const src, int16_t *data, uint32_t count);
+    void read_bitu16_array(tr_reader_t * const src, uint16_t *data, uint32_t count);
+    void read_bitu32_array(tr_reader_t * const src, uint32_t *data, uint32_t count);
 
-    void read_mesh_data(SDL_RWops * const src);
-    void read_frame_moveable_data(SDL_RWops * const src);
+    void read_mesh_data(tr_reader_t * const src);
+    void read_frame_moveable_data(tr_reader_t * const src);
+    void read_samples_data(tr_reader_t * const src, uint32_t size);
+    void read_packed_chunk(tr_reader_t * const src, tr_packed_chunk_t & chunk, const char *name);
+    void unpack_chunks(tr_packed_chunk_t *chunks, uint32_t count);
 
-    void read_tr_colour(SDL_RWops * const src, tr2_colour_t & colour);
-    void read_tr_vertex16(SDL_RWops * const src, tr5_vertex_t & vertex);
-    void read_tr_vertex32(SDL_RWops * const src, tr5_vertex_t & vertex);
-    void read_tr_face3(SDL_RWops * const src, tr4_face3_t & face);
-    void read_tr_face4(SDL_RWops * const src, tr4_face4_t & face);
-    void read_tr_textile8(SDL_RWops * const src, tr_textile8_t & textile);
-    void read_tr_lightmap(SDL_RWops * const src, tr_lightmap_t & lightmap);
-    void read_tr_palette(SDL_RWops * const src, tr2_palette_t & palette);
-    void read_tr_box(SDL_RWops * const src, tr_box_t & box);
-    void read_tr_zone(SDL_RWops * const src, tr2_zone_t & zone);
-    void read_tr_room_sprite(SDL_RWops * const src, tr_room_sprite_t & room_sprite);
-    void read_tr_room_portal(SDL_RWops * const src, tr_room_portal_t & portal);
-    void read_tr_room_sector(SDL_RWops * const src, tr_room_sector_t & room_sector);
-    void read_tr_room_light(SDL_RWops * const src, tr5_room_light_t & light);
-    void read_tr_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex);
-    void read_tr_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh);
-    void read_tr_room(SDL_RWops * const src, tr5_room_t & room);
-    void read_tr_object_texture_vert(SDL_RWops * const src, tr4_object_texture_vert_t & vert);
-    void read_tr_object_texture(SDL_RWops * const src, tr4_object_texture_t & object_texture);
-    void read_tr_sprite_texture(SDL_RWops * const src, tr_sprite_texture_t & sprite_texture);
-    void read_tr_sprite_sequence(SDL_RWops * const src, tr_sprite_sequence_t & sprite_sequence);
-    void read_tr_mesh(SDL_RWops * const src, tr4_mesh_t & mesh);
-    void read_tr_state_changes(SDL_RWops * const src, tr_state_change_t & state_change);
-    void read_tr_anim_dispatches(SDL_RWops * const src, tr_anim_dispatch_t & anim_dispatch);
-    void read_tr_animation(SDL_RWops * const src, tr_animation_t & animation);
-    void read_tr_moveable(SDL_RWops * const src, tr_moveable_t & moveable);
-    void read_tr_item(SDL_RWops * const src, tr2_item_t & item);
-    void read_tr_cinematic_frame(SDL_RWops * const src, tr_cinematic_frame_t & cf);
-    void read_tr_staticmesh(SDL_RWops * const src, tr_staticmesh_t & mesh);
-    void read_tr_level(SDL_RWops * const src, bool demo_or_ub);
+    void read_tr_colour(tr_reader_t * const src, tr2_colour_t & colour);
+    void read_tr_vertex16(tr_reader_t * const src, tr5_vertex_t & vertex);
+    void read_tr_vertex32(tr_reader_t * const src, tr5_vertex_t & vertex);
+    void read_tr_face3(tr_reader_t * const src, tr4_face3_t & face);
+    void read_tr_face4(tr_reader_t * const src, tr4_face4_t & face);
+    void read_tr_textile8(tr_reader_t * const src, tr_textile8_t & textile);
+    void read_tr_lightmap(tr_reader_t * const src, tr_lightmap_t & lightmap);
+    void read_tr_palette(tr_reader_t * const src, tr2_palette_t & palette);
+    void read_tr_box(tr_reader_t * const src, tr_box_t & box);
+    void read_tr_zone(tr_reader_t * const src, tr2_zone_t & zone);
+    void read_tr_room_sprite(tr_reader_t * const src, tr_room_sprite_t & room_sprite);
+    void read_tr_room_portal(tr_reader_t * const src, tr_room_portal_t & portal);
+    void read_tr_room_sector(tr_reader_t * const src, tr_room_sector_t & room_sector);
+    void read_tr_room_light(tr_reader_t * const src, tr5_room_light_t & light);
+    void read_tr_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex);
+    void read_tr_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh);
+    void read_tr_room(tr_reader_t * const src, tr5_room_t & room);
+    void read_tr_object_texture_vert(tr_reader_t * const src, tr4_object_texture_vert_t & vert);
+    void read_tr_object_texture(tr_reader_t * const src, tr4_object_texture_t & object_texture);
+    void read_tr_sprite_texture(tr_reader_t * const src, tr_sprite_texture_t & sprite_texture);
+    void read_tr_sprite_sequence(tr_reader_t * const src, tr_sprite_sequence_t & sprite_sequence);
+    void read_tr_mesh(tr_reader_t * const src, tr4_mesh_t & mesh);
+    void read_tr_state_changes(tr_reader_t * const src, tr_state_change_t & state_change);
+    void read_tr_anim_dispatches(tr_reader_t * const src, tr_anim_dispatch_t & anim_dispatch);
+    void read_tr_animation(tr_reader_t * const src, tr_animation_t & animation);
+    void read_tr_moveable(tr_reader_t * const src, tr_moveable_t & moveable);
+    void read_tr_item(tr_reader_t * const src, tr2_item_t & item);
+    void read_tr_cinematic_frame(tr_reader_t * const src, tr_cinematic_frame_t & cf);
+    void read_tr_staticmesh(tr_reader_t * const src, tr_staticmesh_t & mesh);
+    void read_tr_level(tr_reader_t * const src, bool demo_or_ub);
 
-    void read_tr2_colour4(SDL_RWops * const src, tr2_colour_t & colour);
-    void read_tr2_palette16(SDL_RWops * const src, tr2_palette_t & palette16);
-    void read_tr2_textile16(SDL_RWops * const src, tr2_textile16_t & textile);
-    void read_tr2_box(SDL_RWops * const src, tr_box_t & box);
-    void read_tr2_zone(SDL_RWops * const src, tr2_zone_t & zone);
-    void read_tr2_room_light(SDL_RWops * const src, tr5_room_light_t & light);
-    void read_tr2_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex);
-    void read_tr2_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh);
-    void read_tr2_room(SDL_RWops * const src, tr5_room_t & room);
-    void read_tr2_item(SDL_RWops * const src, tr2_item_t & item);
-    void read_tr2_level(SDL_RWops * const src, bool demo);
+    void read_tr2_colour4(tr_reader_t * const src, tr2_colour_t & colour);
+    void read_tr2_palette16(tr_reader_t * const src, tr2_palette_t & palette16);
+    void read_tr2_textile16(tr_reader_t * const src, tr2_textile16_t & textile);
+    void read_tr2_box(tr_reader_t * const src, tr_box_t & box);
+    void read_tr2_zone(tr_reader_t * const src, tr2_zone_t & zone);
+    void read_tr2_room_light(tr_reader_t * const src, tr5_room_light_t & light);
+    void read_tr2_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex);
+    void read_tr2_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh);
+    void read_tr2_room(tr_reader_t * const src, tr5_room_t & room);
+    void read_tr2_item(tr_reader_t * const src, tr2_item_t & item);
+    void read_tr2_level(tr_reader_t * const src, bool demo);
 
-    void read_tr3_room_light(SDL_RWops * const src, tr5_room_light_t & light);
-    void read_tr3_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex);
-    void read_tr3_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh);
-    void read_tr3_room(SDL_RWops * const src, tr5_room_t & room);
-    void read_tr3_item(SDL_RWops * const src, tr2_item_t & item);
-    void read_tr3_level(SDL_RWops * const src);
+    void read_tr3_room_light(tr_reader_t * const src, tr5_room_light_t & light);
+    void read_tr3_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex);
+    void read_tr3_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh);
+    void read_tr3_room(tr_reader_t * const src, tr5_room_t & room);
+    void read_tr3_item(tr_reader_t * const src, tr2_item_t & item);
+    void read_tr3_level(tr_reader_t * const src);
 
-    void read_tr4_vertex_float(SDL_RWops * const src, tr5_vertex_t & vertex);
-    void read_tr4_textile32(SDL_RWops * const src, tr4_textile32_t & textile);
-    void read_tr4_face3(SDL_RWops * const src, tr4_face3_t & meshface);
-    void read_tr4_face4(SDL_RWops * const src, tr4_face4_t & meshface);
-    void read_tr4_room_light(SDL_RWops * const src, tr5_room_light_t & light);
-    void read_tr4_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex);
-     void read_tr4_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh);
-    void read_tr4_room(SDL_RWops * const src, tr5_room_t & room);
-    void read_tr4_item(SDL_RWops * const src, tr2_item_t & item);
-    void read_tr4_object_texture_vert(SDL_RWops * const src, tr4_object_texture_vert_t & vert);
-    void read_tr4_object_texture(SDL_RWops * const src, tr4_object_texture_t & object_texture);
-    void read_tr4_sprite_texture(SDL_RWops * const src, tr_sprite_texture_t & sprite_texture);
-    void read_tr4_mesh(SDL_RWops * const src, tr4_mesh_t & mesh);
-    void read_tr4_animation(SDL_RWops * const src, tr_animation_t & animation);
-    void read_tr4_level(SDL_RWops * const _src);
+    void read_tr4_vertex_float(tr_reader_t * const src, tr5_vertex_t & vertex);
+    void read_tr4_textile32(tr_reader_t * const src, tr4_textile32_t & textile);
+    void read_tr4_face3(tr_reader_t * const src, tr4_face3_t & meshface);
+    void read_tr4_face4(tr_reader_t * const src, tr4_face4_t & meshface);
+    void read_tr4_room_light(tr_reader_t * const src, tr5_room_light_t & light);
+    void read_tr4_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex);
+     void read_tr4_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh);
+    void read_tr4_room(tr_reader_t * const src, tr5_room_t & room);
+    void read_tr4_item(tr_reader_t * const src, tr2_item_t & item);
+    void read_tr4_object_texture_vert(tr_reader_t * const src, tr4_object_texture_vert_t & vert);
+    void read_tr4_object_texture(tr_reader_t * const src, tr4_object_texture_t & object_texture);
+    void read_tr4_sprite_texture(tr_reader_t * const src, tr_sprite_texture_t & sprite_texture);
+    void read_tr4_mesh(tr_reader_t * const src, tr4_mesh_t & mesh);
+    void read_tr4_animation(tr_reader_t * const src, tr_animation_t & animation);
+    void read_tr4_level(tr_reader_t * const _src);
 
-    void read_tr5_room_light(SDL_RWops * const src, tr5_room_light_t & light);
-    void read_tr5_room_layer(SDL_RWops * const src, tr5_room_layer_t & layer);
-    void read_tr5_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & vert);
-    void read_tr5_room(SDL_RWops * const orgsrc, tr5_room_t & room);
-    void read_tr5_moveable(SDL_RWops * const src, tr_moveable_t & moveable);
-    void read_tr5_level(SDL_RWops * const src);
+    void read_tr5_room_light(tr_reader_t * const src, tr5_room_light_t & light);
+    void read_tr5_room_layer(tr_reader_t * const src, tr5_room_layer_t & layer);
+    void read_tr5_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & vert);
+    void read_tr5_room(tr_reader_t * const orgsrc, tr5_room_t & room);
+    void read_tr5_moveable(tr_reader_t * const src, tr_moveable_t & moveable);
+    void read_tr5_level(tr_reader_t * const src);
 };
 
 #endif // _L_MAIN_H_
@@ -31,7 +31,7 @@
   * Reads three rgb colour components. The read 6-bit values get shifted, so they are 8-bit.
   * The alpha value of tr2_colour_t gets set to 0.
   */
-void TR_Level::read_tr_colour(SDL_RWops * const src, tr2_colour_t & colour)
+void TR_Level::read_tr_colour(tr_reader_t * const src, tr2_colour_t & colour)
 {
     // read 6 bit color and change to 8 bit
     colour.r = read_bitu8(src) << 2;
@@ -44,19 +44,22 @@ void TR_Level::read_tr_colour(SDL_RWops * const src, tr2_colour_t & colour)
   *
   * The values get converted from bit16 to float. y and z are negated to fit OpenGLs coordinate system.
   */
-void TR_Level::read_tr_vertex16(SDL_RWops * const src, tr5_vertex_t & vertex)
+void TR_Level::read_tr_vertex16(tr_reader_t * const src, tr5_vertex_t & vertex)
 {
+    int16_t data[3];
+
     // read vertex and change coordinate system
-    vertex.x = (float)read_bit16(src);
-    vertex.y = (float)-read_bit16(src);
-    vertex.z = (float)-read_bit16(src);
+    read_bit16_array(src, data, 3);
+    vertex.x = (float)data[0];
+    vertex.y = (float)-data[1];
+    vertex.z = (float)-data[2];
 }
 
 /** \brief reads three 32-bit vertex components.
   *
   * The values get converted from bit32 to float. y and z are negated to fit OpenGLs coordinate system.
   */
-void TR_Level::read_tr_vertex32(SDL_RWops * const src, tr5_vertex_t & vertex)
+void TR_Level::read_tr_vertex32(tr_reader_t * const src, tr5_vertex_t & vertex)
 {
     // read vertex and change coordinate system
     vertex.x = (float)read_bit32(src);
@@ -68,12 +71,15 @@ void TR_Level::read_tr_vertex32(SDL_RWops * const src, tr5_vertex_t & vertex)
   *
   * The lighting value is set to 0, as it is only in TR4-5.
   */
-void TR_Level::read_tr_face3(SDL_RWops * const src, tr4_face3_t & meshface)
+void TR_Level::read_tr_face3(tr_reader_t * const src, tr4_face3_t & meshface)
 {
-    meshface.vertices[0] = read_bitu16(src);
-    meshface.vertices[1] = read_bitu16(src);
-    meshface.vertices[2] = read_bitu16(src);
-    meshface.texture = read_bitu16(src);
+    uint16_t data[4];
+
+    read_bitu16_array(src, data, 4);
+    meshface.vertices[0] = data[0];
+    meshface.vertices[1] = data[1];
+    meshface.vertices[2] = data[2];
+    meshface.texture = data[3];
     // lighting only in TR4-5
     meshface.lighting = 0;
 }
@@ -82,40 +88,42 @@ void TR_Level::read_tr_face3(SDL_RWops * const src, tr4_face3_t & meshface)
   *
   * The lighting value is set to 0, as it is only in TR4-5.
   */
-void TR_Level::read_tr_face4(SDL_RWops * const src, tr4_face4_t & meshface)
+void TR_Level::read_tr_face4(tr_reader_t * const src, tr4_face4_t & meshface)
 {
-    meshface.vertices[0] = read_bitu16(src);
-    meshface.vertices[1] = read_bitu16(src);
-    meshface.vertices[2] = read_bitu16(src);
-    meshface.vertices[3] = read_bitu16(src);
-    meshface.texture = read_bitu16(src);
+    uint16_t data[5];
+
+    read_bitu16_array(src, data, 5);
+    meshface.vertices[0] = data[0];
+    meshface.vertices[1] = data[1];
+    meshface.vertices[2] = data[2];
+    meshface.vertices[3] = data[3];
+    meshface.texture = data[4];
     // only in TR4-TR5
     meshface.lighting = 0;
 }
 
 /// \brief reads a 8-bit 256x256 textile.
-void TR_Level::read_tr_textile8(SDL_RWops * const src, tr_textile8_t & textile)
+void TR_Level::read_tr_textile8(tr_reader_t * const src, tr_textile8_t & textile)
 {
-    for (int i = 0; i < 256; i++)
-        if (SDL_RWread(src, textile.pixels[i], 1, 256) < 256)
-                        Sys_extError("read_tr_textile8");
+    if (TR_Reader_Read(src, textile.pixels, 256, 256) < 256)
+        Sys_extError("read_tr_textile8");
 }
 
 /// \brief reads the lightmap.
-void TR_Level::read_tr_lightmap(SDL_RWops * const src, tr_lightmap_t & lightmap)
+void TR_Level::read_tr_lightmap(tr_reader_t * const src, tr_lightmap_t & lightmap)
 {
-    for (int i = 0; i < (32 * 256); i++)
-        lightmap.map[i] = read_bitu8(src);
+    if (TR_Reader_Read(src, lightmap.map, 1, 32 * 256) < 32 * 256)
+        Sys_extError("read_tr_lightmap");
 }
 
 /// \brief reads the 256 colour palette values.
-void TR_Level::read_tr_palette(SDL_RWops * const src, tr2_palette_t & palette)
+void TR_Level::read_tr_palette(tr_reader_t * const src, tr2_palette_t & palette)
 {
     for (int i = 0; i < 256; i++)
         read_tr_colour(src, palette.colour[i]);
 }
 
-void TR_Level::read_tr_box(SDL_RWops * const src, tr_box_t & box)
+void TR_Level::read_tr_box(tr_reader_t * const src, tr_box_t & box)
 {
     box.zmax =-read_bit32(src);
     box.zmin =-read_bit32(src);
@@ -125,7 +133,7 @@ void TR_Level::read_tr_box(SDL_RWops * const src, tr_box_t & box)
     box.overlap_index = read_bitu16(src);
 }
 
-void TR_Level::read_tr_zone(SDL_RWops * const src, tr2_zone_t & zone)
+void TR_Level::read_tr_zone(tr_reader_t * const src, tr2_zone_t & zone)
 {
     zone.GroundZone1_Normal = read_bit16(src);
     zone.GroundZone2_Normal = read_bit16(src);
@@ -140,7 +148,7 @@ void TR_Level::read_tr_zone(SDL_RWops * const src, tr2_zone_t & zone)
 }
 
 /// \brief reads a room sprite definition.
-void TR_Level::read_tr_room_sprite(SDL_RWops * const src, tr_room_sprite_t & room_sprite)
+void TR_Level::read_tr_room_sprite(tr_reader_t * const src, tr_room_sprite_t & room_sprite)
 {
     room_sprite.vertex = read_bit16(src);
     room_sprite.texture = read_bit16(src);
@@ -150,7 +158,7 @@ void TR_Level::read_tr_room_sprite(SDL_RWops * const src, tr_room_sprite_t & roo
   *
   * A check is preformed to see wether the normal lies on a coordinate axis, if not an exception gets thrown.
   */
-void TR_Level::read_tr_room_portal(SDL_RWops * const src, tr_room_portal_t & portal)
+void TR_Level::read_tr_room_portal(tr_reader_t * const src, tr_room_portal_t & portal)
 {
     portal.adjoining_room = read_bitu16(src);
     read_tr_vertex16(src, portal.normal);
@@ -174,14 +182,17 @@ void TR_Level::read_tr_room_portal(SDL_RWops * const src, tr_room_portal_t & por
 }
 
 /// \brief reads a room sector definition.
-void TR_Level::read_tr_room_sector(SDL_RWops * const src, tr_room_sector_t & sector)
+void TR_Level::read_tr_room_sector(tr_reader_t * const src, tr_room_sector_t & sector)
 {
-    sector.fd_index = read_bitu16(src);
-    sector.box_index = read_bitu16(src);
-    sector.room_below = read_bitu8(src);
-    sector.floor = read_bit8(src);
-    sector.room_above = read_bitu8(src);
-    sector.ceiling = read_bit8(src);
+    uint16_t data[4];
+
+    read_bitu16_array(src, data, 4);
+    sector.fd_index = data[0];
+    sector.box_index = data[1];
+    sector.room_below = data[2] & 0xFF;
+    sector.floor = (int8_t)(data[2] >> 8);
+    sector.room_above = data[3] & 0xFF;
+    sector.ceiling = (int8_t)(data[3] >> 8);
 }
 
 /** \brief reads a room light definition.
@@ -189,7 +200,7 @@ void TR_Level::read_tr_room_sector(SDL_RWops * const src, tr_room_sector_t & sec
   * intensity1 gets converted, so it matches the 0-32768 range introduced in TR3.
   * intensity2 and fade2 are introduced in TR2 and are set to intensity1 and fade1 for TR1.
   */
-void TR_Level::read_tr_room_light(SDL_RWops * const src, tr5_room_light_t & light)
+void TR_Level::read_tr_room_light(tr_reader_t * const src, tr5_room_light_t & light)
 {
     read_tr_vertex32(src, light.pos);
     // read and make consistent
@@ -227,7 +238,7 @@ void TR_Level::read_tr_room_light(SDL_RWops * const src, tr5_room_light_t & ligh
   * attributes is introduced in TR2 and is set 0 for TR1.
   * All other values are introduced in TR5 and get set to appropiate values.
   */
-void TR_Level::read_tr_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex)
+void TR_Level::read_tr_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex)
 {
     read_tr_vertex16(src, room_vertex.vertex);
     // read and make consistent
@@ -256,7 +267,7 @@ void TR_Level::read_tr_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & ro
   * intensity1 gets converted, so it matches the 0-32768 range introduced in TR3.
   * intensity2 is introduced in TR2 and is set to intensity1 for TR1.
   */
-void TR_Level::read_tr_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh)
+void TR_Level::read_tr_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh)
 {
     read_tr_vertex32(src, room_static_mesh.pos);
     room_static_mesh.rotation = (float)read_bitu16(src) / 16384.0f * -90;
@@ -279,7 +290,7 @@ void TR_Level::read_tr_room_staticmesh(SDL_RWops * const src, tr2_room_staticmes
   * light_mode is only in TR2 and is set 0 for TR1.
   * light_colour is only in TR3-4 and gets set appropiatly.
   */
-void TR_Level::read_tr_room(SDL_RWops * const src, tr5_room_t & room)
+void TR_Level::read_tr_room(tr_reader_t * const src, tr5_room_t & room)
 {
     uint32_t num_data_words;
     uint32_t i;
@@ -294,7 +305,7 @@ void TR_Level::read_tr_room(SDL_RWops * const src, tr5_room_t & room)
 
     num_data_words = read_bitu32(src);
 
-    pos = SDL_RWseek(src, 0, RW_SEEK_CUR);
+    pos = TR_Reader_Seek(src, 0, RW_SEEK_CUR);
 
     room.num_layers = 0;
 
@@ -319,7 +330,7 @@ void TR_Level::read_tr_room(SDL_RWops * const src, tr5_room_t & room)
         read_tr_room_sprite(src, room.sprites[i]);
 
     // set to the right position in case that there is some unused data
-    SDL_RWseek(src, pos + (num_data_words * 2), RW_SEEK_SET);
+    TR_Reader_Seek(src, pos + (num_data_words * 2), RW_SEEK_SET);
 
     room.num_portals = read_bitu16(src);
     room.portals = (tr_room_portal_t*)malloc(room.num_portals * sizeof(tr_room_portal_t));
@@ -368,7 +379,7 @@ void TR_Level::read_tr_room(SDL_RWops * const src, tr5_room_t & room)
 }
 
 /// \brief reads object texture vertex definition.
-void TR_Level::read_tr_object_texture_vert(SDL_RWops * const src, tr4_object_texture_vert_t & vert)
+void TR_Level::read_tr_object_texture_vert(tr_reader_t * const src, tr4_object_texture_vert_t & vert)
 {
     vert.xcoordinate = read_bit8(src);
     vert.xpixel = read_bitu8(src);
@@ -381,7 +392,7 @@ void TR_Level::read_tr_object_texture_vert(SDL_RWops * const src, tr4_object_tex
   * some sanity checks get done and if they fail an exception gets thrown.
   * all values introduced in TR4 get set appropiatly.
   */
-void TR_Level::read_tr_object_texture(SDL_RWops * const src, tr4_object_texture_t & object_texture)
+void TR_Level::read_tr_object_texture(tr_reader_t * const src, tr4_object_texture_t & object_texture)
 {
     object_texture.transparency_flags = read_bitu16(src);
     object_texture.tile_and_flag = read_bitu16(src);
@@ -408,7 +419,7 @@ void TR_Level::read_tr_object_texture(SDL_RWops * const src, tr4_object_texture_
   *
   * some sanity checks get done and if they fail an exception gets thrown.
   */
-void TR_Level::read_tr_sprite_texture(SDL_RWops * const src, tr_sprite_texture_t & sprite_texture)
+void TR_Level::read_tr_sprite_texture(tr_reader_t * const src, tr_sprite_texture_t & sprite_texture)
 {
     int tx, ty, tw, th, tleft, tright, ttop, tbottom;
     float w, h;
@@ -443,7 +454,7 @@ void TR_Level::read_tr_sprite_texture(SDL_RWops * const src, tr_sprite_texture_t
   *
   * length is negative when read and thus gets negated.
   */
-void TR_Level::read_tr_sprite_sequence(SDL_RWops * const src, tr_sprite_sequence_t & sprite_sequence)
+void TR_Level::read_tr_sprite_sequence(tr_reader_t * const src, tr_sprite_sequence_t & sprite_sequence)
 {
     sprite_sequence.object_id = read_bit32(src);
     sprite_sequence.length = -read_bit16(src);
@@ -455,7 +466,7 @@ void TR_Level::read_tr_sprite_sequence(SDL_RWops * const src, tr_sprite_sequence
   * The read num_normals value is positive when normals are available and negative when light
   * values are available. The values get set appropiatly.
   */
-void TR_Level::read_tr_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
+void TR_Level::read_tr_mesh(tr_reader_t * const src, tr4_mesh_t & mesh)
 {
     int i;
 
@@ -479,8 +490,7 @@ void TR_Level::read_tr_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
         mesh.num_lights = -mesh.num_normals;
         mesh.num_normals = 0;
         mesh.lights = (int16_t*)malloc(mesh.num_lights * sizeof(int16_t));
-        for (i = 0; i < mesh.num_lights; i++)
-            mesh.lights[i] = read_bit16(src);
+        read_bit16_array(src, mesh.lights, mesh.num_lights);
     }
 
     mesh.num_textured_rectangles = read_bit16(src);
@@ -505,7 +515,7 @@ void TR_Level::read_tr_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
 }
 
 /// \brief reads an animation state change.
-void TR_Level::read_tr_state_changes(SDL_RWops * const src, tr_state_change_t & state_change)
+void TR_Level::read_tr_state_changes(tr_reader_t * const src, tr_state_change_t & state_change)
 {
     state_change.state_id = read_bitu16(src);
     state_change.num_anim_dispatches = read_bitu16(src);
@@ -513,7 +523,7 @@ void TR_Level::read_tr_state_changes(SDL_RWops * const src, tr_state_change_t &
 }
 
 /// \brief reads an animation dispatch.
-void TR_Level::read_tr_anim_dispatches(SDL_RWops * const src, tr_anim_dispatch_t & anim_dispatch)
+void TR_Level::read_tr_anim_dispatches(tr_reader_t * const src, tr_anim_dispatch_t & anim_dispatch)
 {
     anim_dispatch.low = read_bit16(src);
     anim_dispatch.high = read_bit16(src);
@@ -522,7 +532,7 @@ void TR_Level::read_tr_anim_dispatches(SDL_RWops * const src, tr_anim_dispatch_t
 }
 
 /// \brief reads an animation definition.
-void TR_Level::read_tr_animation(SDL_RWops * const src, tr_animation_t & animation)
+void TR_Level::read_tr_animation(tr_reader_t * const src, tr_animation_t & animation)
 {
     animation.frame_offset = read_bitu32(src);
     animation.frame_rate = read_bitu8(src);
@@ -548,7 +558,7 @@ void TR_Level::read_tr_animation(SDL_RWops * const src, tr_animation_t & animati
   * some sanity checks get done which throw a exception on failure.
   * frame_offset needs to be corrected later in TR_Level::read_tr_level.
   */
-void TR_Level::read_tr_moveable(SDL_RWops * const src, tr_moveable_t & moveable)
+void TR_Level::read_tr_moveable(tr_reader_t * const src, tr_moveable_t & moveable)
 {
     moveable.object_id = read_bitu32(src);
     moveable.num_meshes = read_bitu16(src);
@@ -565,7 +575,7 @@ void TR_Level::read_tr_moveable(SDL_RWops * const src, tr_moveable_t & moveable)
 }
 
 /// \brief reads an item definition.
-void TR_Level::read_tr_item(SDL_RWops * const src, tr2_item_t & item)
+void TR_Level::read_tr_item(tr_reader_t * const src, tr2_item_t & item)
 {
     item.object_id = read_bit16(src);
     item.room = read_bit16(src);
@@ -580,7 +590,7 @@ void TR_Level::read_tr_item(SDL_RWops * const src, tr2_item_t & item)
 }
 
 /// \brief reads a cinematic frame
-void TR_Level::read_tr_cinematic_frame(SDL_RWops * const src, tr_cinematic_frame_t & cf)
+void TR_Level::read_tr_cinematic_frame(tr_reader_t * const src, tr_cinematic_frame_t & cf)
 {
     //Camera look at position
     cf.targetx = read_bit16(src);
@@ -595,7 +605,7 @@ void TR_Level::read_tr_cinematic_frame(SDL_RWops * const src, tr_cinematic_frame
 }
 
 /// \brief reads a static mesh definition.
-void TR_Level::read_tr_staticmesh(SDL_RWops * const src, tr_staticmesh_t & mesh)
+void TR_Level::read_tr_staticmesh(tr_reader_t * const src, tr_staticmesh_t & mesh)
 {
     mesh.object_id = read_bitu32(src);
     mesh.mesh = read_bitu16(src);
@@ -617,7 +627,7 @@ void TR_Level::read_tr_staticmesh(SDL_RWops * const src, tr_staticmesh_t & mesh)
     mesh.flags = read_bitu16(src);
 }
 
-void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
+void TR_Level::read_tr_level(tr_reader_t * const src, bool demo_or_ub)
 {
     uint32_t i;
 
@@ -650,8 +660,7 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
 
     this->floor_data_size = read_bitu32(src);
     this->floor_data = (uint16_t*)malloc(this->floor_data_size * sizeof(uint16_t));
-    for(i = 0; i < this->floor_data_size; i++)
-        this->floor_data[i] = read_bitu16(src);
+    read_bitu16_array(src, this->floor_data, this->floor_data_size);
 
     read_mesh_data(src);
 
@@ -672,13 +681,11 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
 
     this->anim_commands_count = read_bitu32(src);
     this->anim_commands = (int16_t*)malloc(this->anim_commands_count * sizeof(int16_t));
-    for (i = 0; i < this->anim_commands_count; i++)
-        this->anim_commands[i] = read_bit16(src);
+    read_bit16_array(src, this->anim_commands, this->anim_commands_count);
 
     this->mesh_tree_data_size = read_bitu32(src);
     this->mesh_tree_data = (uint32_t*)malloc(this->mesh_tree_data_size * sizeof(uint32_t));
-    for (i = 0; i < this->mesh_tree_data_size; i++)
-        this->mesh_tree_data[i] = read_bitu32(src);
+    read_bitu32_array(src, this->mesh_tree_data, this->mesh_tree_data_size);
 
     read_frame_moveable_data(src);
 
@@ -744,8 +751,7 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
 
     this->overlaps_count = read_bitu32(src);
     this->overlaps = (uint16_t*)malloc(this->overlaps_count * sizeof(uint16_t));
-    for (i = 0; i < this->overlaps_count; i++)
-        this->overlaps[i] = read_bitu16(src);
+    read_bitu16_array(src, this->overlaps, this->overlaps_count);
 
     // Zones
     for (i = 0; i < this->boxes_count; i++)
@@ -754,10 +760,7 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
     this->animated_textures_count = read_bitu32(src);
     this->animated_textures_uv_count = 0; // No UVRotate in TR1
     this->animated_textures = (uint16_t*)malloc(this->animated_textures_count * sizeof(uint16_t));
-    for (i = 0; i < this->animated_textures_count; i++)
-    {
-        this->animated_textures[i] = read_bitu16(src);
-    }
+    read_bitu16_array(src, this->animated_textures, this->animated_textures_count);
 
     this->items_count = read_bitu32(src);
     this->items = (tr2_item_t*)malloc(this->items_count * sizeof(tr2_item_t));
@@ -778,13 +781,12 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
 
     this->demo_data_count = read_bitu16(src);
     this->demo_data = (uint8_t*)malloc(this->demo_data_count * sizeof(uint8_t));
-    for(i=0; i < this->demo_data_count; i++)
-        this->demo_data[i] = read_bitu8(src);
+    if (TR_Reader_Read(src, this->demo_data, 1, this->demo_data_count) < this->demo_data_count)
+        Sys_extError("read_tr_level: demo_data");
 
     // Soundmap
     this->soundmap = (int16_t*)malloc(TR_AUDIO_MAP_SIZE_TR1 * sizeof(int16_t));
-    for(i=0; i < TR_AUDIO_MAP_SIZE_TR1; i++)
-        this->soundmap[i] = read_bit16(src);
+    read_bit16_array(src, this->soundmap, TR_AUDIO_MAP_SIZE_TR1);
 
     this->sound_details_count = read_bitu32(src);
     this->sound_details = (tr_sound_details_t*)malloc(this->sound_details_count * sizeof(tr_sound_details_t));
@@ -805,20 +807,9 @@ void TR_Level::read_tr_level(SDL_RWops * const src, bool demo_or_ub)
     // In TR1, samples are embedded into level file as solid block, preceded by
     // block size in bytes. Sample block is followed by sample indices array.
 
-    this->samples_count = 0;
-    this->samples_data_size = read_bitu32(src);
-    this->samples_data = (uint8_t*)malloc(this->samples_data_size * sizeof(uint8_t));
-    for(i=0; i < this->samples_data_size; i++)
-    {
-        this->samples_data[i] = read_bitu8(src);
-        if((i >= 4) && (*((uint32_t*)(this->samples_data+i-4)) == 0x46464952))   /// RIFF
-        {
-            this->samples_count++;
-        }
-    }
+    read_samples_data(src, read_bitu32(src));
 
     this->sample_indices_count = read_bitu32(src);
     this->sample_indices = (uint32_t*)malloc(this->sample_indices_count * sizeof(uint32_t));
-    for(i=0; i < this->sample_indices_count; i++)
-        this->sample_indices[i] = read_bitu32(src);
+    read_bitu32_array(src, this->sample_indices, this->sample_indices_count);
 }
@@ -26,7 +26,7 @@
 
 #define RCSID "$Id: l_tr2.cpp,v 1.15 2002/09/20 15:59:02 crow Exp $"
 
-void TR_Level::read_tr2_colour4(SDL_RWops * const src, tr2_colour_t & colour)
+void TR_Level::read_tr2_colour4(tr_reader_t * const src, tr2_colour_t & colour)
 {
     // read 6 bit color and change to 8 bit
     colour.r = read_bitu8(src) << 2;
@@ -35,16 +35,16 @@ void TR_Level::read_tr2_colour4(SDL_RWops * const src, tr2_colour_t & colour)
     colour.a = read_bitu8(src) << 2;
 }
 
-void TR_Level::read_tr2_palette16(SDL_RWops * const src, tr2_palette_t & palette)
+void TR_Level::read_tr2_palette16(tr_reader_t * const src, tr2_palette_t & palette)
 {
     for (int i = 0; i < 256; i++)
         read_tr2_colour4(src, palette.colour[i]);
 }
 
-void TR_Level::read_tr2_textile16(SDL_RWops * const src, tr2_textile16_t & textile)
+void TR_Level::read_tr2_textile16(tr_reader_t * const src, tr2_textile16_t & textile)
 {
     for (int i = 0; i < 256; i++) {
-        if (SDL_RWread(src, textile.pixels[i], 2, 256) < 256)
+        if (TR_Reader_Read(src, textile.pixels[i], 2, 256) < 256)
             Sys_extError("read_tr2_textile16");
 
         for (int j = 0; j < 256; j++)
@@ -52,7 +52,7 @@ void TR_Level::read_tr2_textile16(SDL_RWops * const src, tr2_textile16_t & texti
     }
 }
 
-void TR_Level::read_tr2_box(SDL_RWops * const src, tr_box_t & box)
+void TR_Level::read_tr2_box(tr_reader_t * const src, tr_box_t & box)
 {
     box.zmax =-1024 * read_bitu8(src);
     box.zmin =-1024 * read_bitu8(src);
@@ -62,7 +62,7 @@ void TR_Level::read_tr2_box(SDL_RWops * const src, tr_box_t & box)
     box.overlap_index = read_bitu16(src);
 }
 
-void TR_Level::read_tr2_zone(SDL_RWops * const src, tr2_zone_t & zone)
+void TR_Level::read_tr2_zone(tr_reader_t * const src, tr2_zone_t & zone)
 {
     zone.GroundZone1_Normal = read_bit16(src);
     zone.GroundZone2_Normal = read_bit16(src);
@@ -76,7 +76,7 @@ void TR_Level::read_tr2_zone(SDL_RWops * const src, tr2_zone_t & zone)
     zone.FlyZone_Alternate = read_bit16(src);
 }
 
-void TR_Level::read_tr2_room_light(SDL_RWops * const src, tr5_room_light_t & light)
+void TR_Level::read_tr2_room_light(tr_reader_t * const src, tr5_room_light_t & light)
 {
     read_tr_vertex32(src, light.pos);
     light.intensity1 = read_bitu16(src);
@@ -101,7 +101,7 @@ void TR_Level::read_tr2_room_light(SDL_RWops * const src, tr5_room_light_t & lig
     light.color.b = 0xff;
 }
 
-void TR_Level::read_tr2_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex)
+void TR_Level::read_tr2_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex)
 {
     read_tr_vertex16(src, room_vertex.vertex);
     // read and make consistent
@@ -118,7 +118,7 @@ void TR_Level::read_tr2_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & r
     room_vertex.colour.a = 1.0f;
 }
 
-void TR_Level::read_tr2_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh)
+void TR_Level::read_tr2_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh)
 {
     read_tr_vertex32(src, room_static_mesh.pos);
     room_static_mesh.rotation = (float)read_bitu16(src) / 16384.0f * -90;
@@ -135,7 +135,7 @@ void TR_Level::read_tr2_room_staticmesh(SDL_RWops * const src, tr2_room_staticme
     room_static_mesh.tint.a = 1.0f;
 }
 
-void TR_Level::read_tr2_room(SDL_RWops * const src, tr5_room_t & room)
+void TR_Level::read_tr2_room(tr_reader_t * const src, tr5_room_t & room)
 {
     uint32_t num_data_words;
     uint32_t i;
@@ -150,7 +150,7 @@ void TR_Level::read_tr2_room(SDL_RWops * const src, tr5_room_t & room)
 
     num_data_words = read_bitu32(src);
 
-    pos = SDL_RWseek(src, 0, RW_SEEK_CUR);
+    pos = TR_Reader_Seek(src, 0, RW_SEEK_CUR);
 
     room.num_layers = 0;
 
@@ -175,7 +175,7 @@ void TR_Level::read_tr2_room(SDL_RWops * const src, tr5_room_t & room)
         read_tr_room_sprite(src, room.sprites[i]);
 
     // set to the right position in case that there is some unused data
-    SDL_RWseek(src, pos + (num_data_words * 2), RW_SEEK_SET);
+    TR_Reader_Seek(src, pos + (num_data_words * 2), RW_SEEK_SET);
 
     room.num_portals = read_bitu16(src);
     room.portals = (tr_room_portal_t*)malloc(room.num_portals * sizeof(tr_room_portal_t));
@@ -223,7 +223,7 @@ void TR_Level::read_tr2_room(SDL_RWops * const src, tr5_room_t & room)
     room.light_colour.a = 1.0f;
 }
 
-void TR_Level::read_tr2_item(SDL_RWops * const src, tr2_item_t & item)
+void TR_Level::read_tr2_item(tr_reader_t * const src, tr2_item_t & item)
 {
     item.object_id = read_bit16(src);
     item.room = read_bit16(src);
@@ -239,7 +239,7 @@ void TR_Level::read_tr2_item(SDL_RWops * const src, tr2_item_t & item)
     item.flags = read_bitu16(src);
 }
 
-void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
+void TR_Level::read_tr2_level(tr_reader_t * const src, bool demo)
 {
     uint32_t i;
 
@@ -279,8 +279,7 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
 
     this->floor_data_size = read_bitu32(src);
     this->floor_data = (uint16_t*)malloc(this->floor_data_size * sizeof(uint16_t));
-    for(i = 0; i < this->floor_data_size; i++)
-        this->floor_data[i] = read_bitu16(src);
+    read_bitu16_array(src, this->floor_data, this->floor_data_size);
 
     read_mesh_data(src);
 
@@ -301,13 +300,11 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
 
     this->anim_commands_count = read_bitu32(src);
     this->anim_commands = (int16_t*)malloc(this->anim_commands_count * sizeof(int16_t));
-    for (i = 0; i < this->anim_commands_count; i++)
-        this->anim_commands[i] = read_bit16(src);
+    read_bit16_array(src, this->anim_commands, this->anim_commands_count);
 
     this->mesh_tree_data_size = read_bitu32(src);
     this->mesh_tree_data = (uint32_t*)malloc(this->mesh_tree_data_size * sizeof(uint32_t));
-    for (i = 0; i < this->mesh_tree_data_size; i++)
-        this->mesh_tree_data[i] = read_bitu32(src);                     // 4 bytes
+    read_bitu32_array(src, this->mesh_tree_data, this->mesh_tree_data_size);
 
     read_frame_moveable_data(src);
 
@@ -366,8 +363,7 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
 
     this->overlaps_count = read_bitu32(src);
     this->overlaps = (uint16_t*)malloc(this->overlaps_count * sizeof(uint16_t));
-    for (i = 0; i < this->overlaps_count; i++)
-        this->overlaps[i] = read_bitu16(src);
+    read_bitu16_array(src, this->overlaps, this->overlaps_count);
 
     // Zones
     for (i = 0; i < this->boxes_count; i++)
@@ -376,10 +372,7 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
     this->animated_textures_count = read_bitu32(src);
     this->animated_textures_uv_count = 0; // No UVRotate in TR2
     this->animated_textures = (uint16_t*)malloc(this->animated_textures_count * sizeof(uint16_t));
-    for (i = 0; i < this->animated_textures_count; i++)
-    {
-        this->animated_textures[i] = read_bitu16(src);
-    }
+    read_bitu16_array(src, this->animated_textures, this->animated_textures_count);
 
     this->items_count = read_bitu32(src);
     this->items = (tr2_item_t*)malloc(this->items_count * sizeof(tr2_item_t));
@@ -398,13 +391,12 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
 
     this->demo_data_count = read_bitu16(src);
     this->demo_data = (uint8_t*)malloc(this->demo_data_count * sizeof(uint8_t));
-    for(i=0; i < this->demo_data_count; i++)
-        this->demo_data[i] = read_bitu8(src);
+    if (TR_Reader_Read(src, this->demo_data, 1, this->demo_data_count) < this->demo_data_count)
+        Sys_extError("read_tr2_level: demo_data");
 
     // Soundmap
     this->soundmap = (int16_t*)malloc(TR_AUDIO_MAP_SIZE_TR2 * sizeof(int16_t));
-    for(i=0; i < TR_AUDIO_MAP_SIZE_TR2; i++)
-        this->soundmap[i] = read_bit16(src);
+    read_bit16_array(src, this->soundmap, TR_AUDIO_MAP_SIZE_TR2);
 
     this->sound_details_count = read_bitu32(src);
     this->sound_details = (tr_sound_details_t*)malloc(this->sound_details_count * sizeof(tr_sound_details_t));
@@ -422,8 +414,7 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
 
     this->sample_indices_count = read_bitu32(src);
     this->sample_indices = (uint32_t*)malloc(this->sample_indices_count * sizeof(uint32_t));
-    for(i=0; i < this->sample_indices_count; i++)
-        this->sample_indices[i] = read_bitu32(src);
+    read_bitu32_array(src, this->sample_indices, this->sample_indices_count);
 
     // remap all sample indices here
     for(i = 0; i < this->sound_details_count; i++)
@@ -439,26 +430,15 @@ void TR_Level::read_tr2_level(SDL_RWops * const src, bool demo)
     // In TR2, samples are stored in separate file called MAIN.SFX.
     // If there is no such files, no samples are loaded.
 
-    SDL_RWops *newsrc = SDL_RWFromFile(this->sfx_path, "rb");
+    tr_reader_t *newsrc = TR_Reader_CreateFromFile(this->sfx_path);
     if (newsrc == NULL)
     {
         Sys_extWarn("read_tr2_level: failed to open \"%s\"! No samples loaded.", this->sfx_path);
     }
     else
     {
-        this->samples_data_size = SDL_RWsize(newsrc);
-        this->samples_count = 0;
-        this->samples_data = (uint8_t*)malloc(this->samples_data_size * sizeof(uint8_t));
-        for(i = 0; i < this->samples_data_size; i++)
-        {
-            this->samples_data[i] = read_bitu8(newsrc);
-            if((i >= 4) && (*((uint32_t*)(this->samples_data+i-4)) == 0x46464952))   /// RIFF
-            {
-                this->samples_count++;
-            }
-        }
-
-        SDL_RWclose(newsrc);
+        read_samples_data(newsrc, TR_Reader_Size(newsrc));
+        TR_Reader_Close(newsrc);
         newsrc = NULL;
     }
 }
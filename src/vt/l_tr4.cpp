@@ -21,24 +21,23 @@
 
 #include <SDL2/SDL_endian.h>
 
-#include <zlib.h>
 #include "l_main.h"
 #include "tr_versions.h"
 #include "../core/system.h"
 
 #define RCSID "$Id: l_tr4.cpp,v 1.14 2002/09/20 15:59:02 crow Exp $"
 
-void TR_Level::read_tr4_vertex_float(SDL_RWops * const src, tr5_vertex_t & vertex)
+void TR_Level::read_tr4_vertex_float(tr_reader_t * const src, tr5_vertex_t & vertex)
 {
     vertex.x = read_float(src);
     vertex.y = -read_float(src);
     vertex.z = -read_float(src);
 }
 
-void TR_Level::read_tr4_textile32(SDL_RWops * const src, tr4_textile32_t & textile)
+void TR_Level::read_tr4_textile32(tr_reader_t * const src, tr4_textile32_t & textile)
 {
     for (int i = 0; i < 256; i++) {
-        if (SDL_RWread(src, textile.pixels[i], 4, 256) < 256)
+        if (TR_Reader_Read(src, textile.pixels[i], 4, 256) < 256)
             Sys_extError("read_tr4_textile32");
 
         for (int j = 0; j < 256; j++)
@@ -46,7 +45,7 @@ void TR_Level::read_tr4_textile32(SDL_RWops * const src, tr4_textile32_t & texti
     }
 }
 
-void TR_Level::read_tr4_face3(SDL_RWops * const src, tr4_face3_t & meshface)
+void TR_Level::read_tr4_face3(tr_reader_t * const src, tr4_face3_t & meshface)
 {
     meshface.vertices[0] = read_bitu16(src);
     meshface.vertices[1] = read_bitu16(src);
@@ -55,7 +54,7 @@ void TR_Level::read_tr4_face3(SDL_RWops * const src, tr4_face3_t & meshface)
     meshface.lighting = read_bitu16(src);
 }
 
-void TR_Level::read_tr4_face4(SDL_RWops * const src, tr4_face4_t & meshface)
+void TR_Level::read_tr4_face4(tr_reader_t * const src, tr4_face4_t & meshface)
 {
     meshface.vertices[0] = read_bitu16(src);
     meshface.vertices[1] = read_bitu16(src);
@@ -65,7 +64,7 @@ void TR_Level::read_tr4_face4(SDL_RWops * const src, tr4_face4_t & meshface)
     meshface.lighting = read_bitu16(src);
 }
 
-void TR_Level::read_tr4_room_light(SDL_RWops * const src, tr5_room_light_t & light)
+void TR_Level::read_tr4_room_light(tr_reader_t * const src, tr5_room_light_t & light)
 {
     read_tr_vertex32(src, light.pos);
     read_tr_colour(src, light.color);
@@ -81,7 +80,7 @@ void TR_Level::read_tr4_room_light(SDL_RWops * const src, tr5_room_light_t & lig
     read_tr4_vertex_float(src, light.dir);
 }
 
-void TR_Level::read_tr4_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & room_vertex)
+void TR_Level::read_tr4_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & room_vertex)
 {
     read_tr_vertex16(src, room_vertex.vertex);
     // read and make consistent
@@ -99,7 +98,7 @@ void TR_Level::read_tr4_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & r
     room_vertex.colour.a = 1.0f;
 }
 
-void TR_Level::read_tr4_room_staticmesh(SDL_RWops * const src, tr2_room_staticmesh_t & room_static_mesh)
+void TR_Level::read_tr4_room_staticmesh(tr_reader_t * const src, tr2_room_staticmesh_t & room_static_mesh)
 {
     read_tr_vertex32(src, room_static_mesh.pos);
     room_static_mesh.rotation = (float)read_bitu16(src) / 16384.0f * -90;
@@ -115,7 +114,7 @@ void TR_Level::read_tr4_room_staticmesh(SDL_RWops * const src, tr2_room_staticme
     room_static_mesh.tint.a = 1.0f;
 }
 
-void TR_Level::read_tr4_room(SDL_RWops * const src, tr5_room_t & room)
+void TR_Level::read_tr4_room(tr_reader_t * const src, tr5_room_t & room)
 {
     uint32_t num_data_words;
     uint32_t i;
@@ -130,7 +129,7 @@ void TR_Level::read_tr4_room(SDL_RWops * const src, tr5_room_t & room)
 
     num_data_words = read_bitu32(src);
 
-    pos = SDL_RWseek(src, 0, SEEK_CUR);
+    pos = TR_Reader_Seek(src, 0, SEEK_CUR);
 
     room.num_layers = 0;
 
@@ -155,7 +154,7 @@ void TR_Level::read_tr4_room(SDL_RWops * const src, tr5_room_t & room)
         read_tr_room_sprite(src, room.sprites[i]);
 
     // set to the right position in case that there is some unused data
-    SDL_RWseek(src, pos + (num_data_words * 2), SEEK_SET);
+    TR_Reader_Seek(src, pos + (num_data_words * 2), SEEK_SET);
 
     room.num_portals = read_bitu16(src);
     room.portals = (tr_room_portal_t*)malloc(room.num_portals * sizeof(tr_room_portal_t));
@@ -199,7 +198,7 @@ void TR_Level::read_tr4_room(SDL_RWops * const src, tr5_room_t & room)
     room.alternate_group = read_bitu8(src);
 }
 
-void TR_Level::read_tr4_item(SDL_RWops * const src, tr2_item_t & item)
+void TR_Level::read_tr4_item(tr_reader_t * const src, tr2_item_t & item)
 {
     item.object_id = read_bit16(src);
     item.room = read_bit16(src);
@@ -211,7 +210,7 @@ void TR_Level::read_tr4_item(SDL_RWops * const src, tr2_item_t & item)
     item.flags = read_bitu16(src);
 }
 
-void TR_Level::read_tr4_object_texture_vert(SDL_RWops * const src, tr4_object_texture_vert_t & vert)
+void TR_Level::read_tr4_object_texture_vert(tr_reader_t * const src, tr4_object_texture_vert_t & vert)
 {
     vert.xcoordinate = read_bit8(src);
     vert.xpixel = read_bitu8(src);
@@ -223,7 +222,7 @@ void TR_Level::read_tr4_object_texture_vert(SDL_RWops * const src, tr4_object_te
         vert.ycoordinate = 1;
 }
 
-void TR_Level::read_tr4_object_texture(SDL_RWops * const src, tr4_object_texture_t & object_texture)
+void TR_Level::read_tr4_object_texture(tr_reader_t * const src, tr4_object_texture_t & object_texture)
 {
     object_texture.transparency_flags = read_bitu16(src);
     object_texture.tile_and_flag = read_bitu16(src);
@@ -244,7 +243,7 @@ void TR_Level::read_tr4_object_texture(SDL_RWops * const src, tr4_object_texture
  /*
   * tr4 + sprite loading
   */
-void TR_Level::read_tr4_sprite_texture(SDL_RWops * const src, tr_sprite_texture_t & sprite_texture)
+void TR_Level::read_tr4_sprite_texture(tr_reader_t * const src, tr_sprite_texture_t & sprite_texture)
 {
     int tx, ty, tw, th, tleft, tright, ttop, tbottom;
 
@@ -272,7 +271,7 @@ void TR_Level::read_tr4_sprite_texture(SDL_RWops * const src, tr_sprite_texture_
     sprite_texture.top_side = ty + th / (256);
 }
 
-void TR_Level::read_tr4_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
+void TR_Level::read_tr4_mesh(tr_reader_t * const src, tr4_mesh_t & mesh)
 {
     int i;
 
@@ -299,8 +298,7 @@ void TR_Level::read_tr4_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
         mesh.num_lights = -mesh.num_normals;
         mesh.num_normals = 0;
         mesh.lights = (int16_t*)malloc(mesh.num_lights * sizeof(int16_t));
-        for (i = 0; i < mesh.num_lights; i++)
-            mesh.lights[i] = read_bit16(src);
+        read_bit16_array(src, mesh.lights, mesh.num_lights);
     }
 
     mesh.num_textured_rectangles = read_bit16(src);
@@ -318,7 +316,7 @@ void TR_Level::read_tr4_mesh(SDL_RWops * const src, tr4_mesh_t & mesh)
 }
 
 /// \brief reads an animation definition.
-void TR_Level::read_tr4_animation(SDL_RWops * const src, tr_animation_t & animation)
+void TR_Level::read_tr4_animation(tr_reader_t * const src, tr_animation_t & animation)
 {
     animation.frame_offset = read_bitu32(src);
     animation.frame_rate = read_bitu8(src);
@@ -341,13 +339,12 @@ void TR_Level::read_tr4_animation(SDL_RWops * const src, tr_animation_t & animat
     animation.anim_command = read_bitu16(src);
 }
 
-void TR_Level::read_tr4_level(SDL_RWops * const _src)
+void TR_Level::read_tr4_level(tr_reader_t * const _src)
 {
-    SDL_RWops *src = _src;
+    tr_reader_t *src = _src;
     uint32_t i;
-    uint8_t *uncomp_buffer = NULL;
-    uint8_t *comp_buffer = NULL;
-    SDL_RWops *newsrc = NULL;
+    tr_packed_chunk_t chunks[4];    // textiles32, textiles16, misc textiles32, geometry
+    tr_reader_t *newsrc = NULL;
 
     // Version
     uint32_t file_version = read_bitu32(src);
@@ -362,211 +359,80 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
     this->num_misc_textiles = 0;
     this->read_32bit_textiles = false;
 
-    {
-        uint32_t uncomp_size;
-        uint32_t comp_size;
-        unsigned long size;
-
-        this->num_room_textiles = read_bitu16(src);
-        this->num_obj_textiles = read_bitu16(src);
-        this->num_bump_textiles = read_bitu16(src);
-        this->num_misc_textiles = 2;
-        this->num_textiles = this->num_room_textiles + this->num_obj_textiles + this->num_bump_textiles + this->num_misc_textiles;
-
-        uncomp_size = read_bitu32(src);
-        if (uncomp_size == 0)
-            Sys_extError("read_tr4_level: textiles32 uncomp_size == 0");
-
-        comp_size = read_bitu32(src);
-        if (comp_size > 0)
-        {
-            uncomp_buffer = new uint8_t[uncomp_size];
-
-            this->textile32_count = this->num_textiles;
-            this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
-            comp_buffer = new uint8_t[comp_size];
-
-            if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-                Sys_extError("read_tr4_level: textiles32");
-
-            size = uncomp_size;
-            if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-                Sys_extError("read_tr4_level: uncompress");
-
-            if (size != uncomp_size)
-                Sys_extError("read_tr4_level: uncompress size mismatch");
-            delete [] comp_buffer;
-
-            comp_buffer = NULL;
-            if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-                Sys_extError("read_tr4_level: SDL_RWFromMem");
+    this->num_room_textiles = read_bitu16(src);
+    this->num_obj_textiles = read_bitu16(src);
+    this->num_bump_textiles = read_bitu16(src);
+    this->num_misc_textiles = 2;
+    this->num_textiles = this->num_room_textiles + this->num_obj_textiles + this->num_bump_textiles + this->num_misc_textiles;
 
-            for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
-                read_tr4_textile32(newsrc, this->textile32[i]);
-            SDL_RWclose(newsrc);
-            newsrc = NULL;
-            delete [] uncomp_buffer;
+    read_packed_chunk(src, chunks[0], "read_tr4_level: textiles32");
+    read_packed_chunk(src, chunks[1], "read_tr4_level: textiles16");
+    read_packed_chunk(src, chunks[2], "read_tr4_level: textiles32d");
+    read_packed_chunk(src, chunks[3], "read_tr4_level: packed geometry");
 
-            uncomp_buffer = NULL;
-            this->read_32bit_textiles = true;
-        }
-
-        uncomp_size = read_bitu32(src);
-        if (uncomp_size == 0)
-            Sys_extError("read_tr4_level: textiles16 uncomp_size == 0");
-
-        comp_size = read_bitu32(src);
-        if (comp_size > 0)
-        {
-            if (this->textile32_count == 0)
-            {
-                uncomp_buffer = new uint8_t[uncomp_size];
-
-                this->textile16_count = this->num_textiles;
-                this->textile16 = (tr2_textile16_t*)malloc(this->textile16_count * sizeof(tr2_textile16_t));
-                comp_buffer = new uint8_t[comp_size];
-
-                if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-                {
-                    delete [] comp_buffer;
-                    delete [] uncomp_buffer;
-                    Sys_extError("read_tr4_level: textiles16");
-                }
-
-                size = uncomp_size;
-                if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-                {
-                    delete [] comp_buffer;
-                    delete [] uncomp_buffer;
-                    Sys_extError("read_tr4_level: uncompress");
-                }
-
-                delete [] comp_buffer;
-                comp_buffer = NULL;
-
-                if (size != uncomp_size)
-                {
-                    delete [] uncomp_buffer;
-                    Sys_extError("read_tr4_level: uncompress size mismatch");
-                }
-
-                if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-                {
-                    delete [] uncomp_buffer;
-                    Sys_extError("read_tr4_level: SDL_RWFromMem");
-                }
-
-                for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
-                    read_tr2_textile16(newsrc, this->textile16[i]);
-
-                SDL_RWclose(newsrc);
-                newsrc = NULL;
-                delete [] uncomp_buffer;
-                uncomp_buffer = NULL;
-            }
-            else
-            {
-                SDL_RWseek(src, comp_size, SEEK_CUR);
-            }
-        }
-
-        uncomp_size = read_bitu32(src);
-        if (uncomp_size == 0)
-            Sys_extError("read_tr4_level: textiles32d uncomp_size == 0");
-
-        comp_size = read_bitu32(src);
-        if (comp_size > 0)
-        {
-            uncomp_buffer = new uint8_t[uncomp_size];
-
-            if ((uncomp_size / (256 * 256 * 4)) > 2)
-                Sys_extWarn("read_tr4_level: num_misc_textiles > 2");
-
-            if (this->textile32_count == 0)
-            {
-                this->textile32_count = this->num_textiles;
-                this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
-            }
-            comp_buffer = new uint8_t[comp_size];
-
-            if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-            {
-                delete [] uncomp_buffer;
-                delete [] comp_buffer;
-                Sys_extError("read_tr4_level: misc_textiles");
-            }
-
-            size = uncomp_size;
-            if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-            {
-                delete [] uncomp_buffer;
-                delete [] comp_buffer;
-                Sys_extError("read_tr4_level: uncompress");
-            }
-
-            delete [] comp_buffer;
-            comp_buffer = NULL;
-            if (size != uncomp_size)
-            {
-                delete [] uncomp_buffer;
-                Sys_extError("read_tr4_level: uncompress size mismatch");
-            }
-
-            if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-            {
-                delete [] uncomp_buffer;
-                Sys_extError("read_tr4_level: SDL_RWFromMem");
-            }
-
-            for (i = (this->num_textiles - this->num_misc_textiles); i < this->num_textiles; i++)
-                read_tr4_textile32(newsrc, this->textile32[i]);
-
-            SDL_RWclose(newsrc);
-            newsrc = NULL;
-            delete [] uncomp_buffer;
-            uncomp_buffer = NULL;
-        }
+    if (chunks[3].comp_size == 0)
+        Sys_extError("read_tr4_level: packed geometry");
 
-        uncomp_size = read_bitu32(src);
-        if (uncomp_size == 0)
-            Sys_extError("read_tr4_level: packed geometry uncomp_size == 0");
+    // 16-bit textiles are needed only if there are no 32-bit ones.
+    if (chunks[0].comp_size > 0)
+        chunks[1].comp_size = 0;
 
-        comp_size = read_bitu32(src);
+    unpack_chunks(chunks, 4);
 
-        if (!comp_size)
-            Sys_extError("read_tr4_level: packed geometry");
+    if (chunks[0].data)
+    {
+        this->textile32_count = this->num_textiles;
+        this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
+
+        newsrc = TR_Reader_Create(chunks[0].data, chunks[0].uncomp_size);
+        for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
+            read_tr4_textile32(newsrc, this->textile32[i]);
+        TR_Reader_Close(newsrc);
+        newsrc = NULL;
+        free(chunks[0].data);
+        chunks[0].data = NULL;
+
+        this->read_32bit_textiles = true;
+    }
 
-        uncomp_buffer = new uint8_t[uncomp_size];
-        comp_buffer = new uint8_t[comp_size];
+    if (chunks[1].data)
+    {
+        this->textile16_count = this->num_textiles;
+        this->textile16 = (tr2_textile16_t*)malloc(this->textile16_count * sizeof(tr2_textile16_t));
+
+        newsrc = TR_Reader_Create(chunks[1].data, chunks[1].uncomp_size);
+        for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
+            read_tr2_textile16(newsrc, this->textile16[i]);
+        TR_Reader_Close(newsrc);
+        newsrc = NULL;
+        free(chunks[1].data);
+        chunks[1].data = NULL;
+    }
 
-        if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-        {
-            delete [] uncomp_buffer;
-            delete [] comp_buffer;
-            Sys_extError("read_tr4_level: packed geometry");
-        }
+    if (chunks[2].data)
+    {
+        if ((chunks[2].uncomp_size / (256 * 256 * 4)) > 2)
+            Sys_extWarn("read_tr4_level: num_misc_textiles > 2");
 
-        size = uncomp_size;
-        if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
+        if (this->textile32_count == 0)
         {
-            delete [] uncomp_buffer;
-            delete [] comp_buffer;
-            Sys_extError("read_tr4_level: uncompress");
+            this->textile32_count = this->num_textiles;
+            this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
         }
 
-        delete [] comp_buffer;
-        comp_buffer = NULL;
-        if (size != uncomp_size)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr4_level: uncompress size mismatch");
-        }
+        newsrc = TR_Reader_Create(chunks[2].data, chunks[2].uncomp_size);
+        for (i = (this->num_textiles - this->num_misc_textiles); i < this->num_textiles; i++)
+            read_tr4_textile32(newsrc, this->textile32[i]);
+        TR_Reader_Close(newsrc);
+        newsrc = NULL;
+        free(chunks[2].data);
+        chunks[2].data = NULL;
+    }
 
-        if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr4_level: SDL_RWFromMem");
-        }
+    if ((newsrc = TR_Reader_Create(chunks[3].data, chunks[3].uncomp_size)) == NULL)
+    {
+        free(chunks[3].data);
+        Sys_extError("read_tr4_level: TR_Reader_Create");
     }
 
     // Unused
@@ -580,8 +446,7 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
 
     this->floor_data_size = read_bitu32(newsrc);
     this->floor_data = (uint16_t*)malloc(this->floor_data_size * sizeof(uint16_t));
-    for(i = 0; i < this->floor_data_size; i++)
-        this->floor_data[i] = read_bitu16(newsrc);
+    read_bitu16_array(newsrc, this->floor_data, this->floor_data_size);
 
     read_mesh_data(newsrc);
 
@@ -602,13 +467,11 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
 
     this->anim_commands_count = read_bitu32(newsrc);
     this->anim_commands = (int16_t*)malloc(this->anim_commands_count * sizeof(int16_t));
-    for (i = 0; i < this->anim_commands_count; i++)
-        this->anim_commands[i] = read_bit16(newsrc);
+    read_bit16_array(newsrc, this->anim_commands, this->anim_commands_count);
 
     this->mesh_tree_data_size = read_bitu32(newsrc);
     this->mesh_tree_data = (uint32_t*)malloc(this->mesh_tree_data_size * sizeof(uint32_t));
-    for (i = 0; i < this->mesh_tree_data_size; i++)
-        this->mesh_tree_data[i] = read_bitu32(newsrc);                     // 4 bytes
+    read_bitu32_array(newsrc, this->mesh_tree_data, this->mesh_tree_data_size);
 
     read_frame_moveable_data(newsrc);
 
@@ -647,7 +510,7 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
         this->cameras[i].room = read_bit16(newsrc);
         this->cameras[i].unknown1 = read_bitu16(newsrc);
     }
-    //SDL_RWseek(newsrc, this->cameras.size() * 16, SEEK_CUR);
+    //TR_Reader_Seek(newsrc, this->cameras.size() * 16, SEEK_CUR);
 
     this->flyby_cameras_count = read_bitu32(newsrc);
     this->flyby_cameras = (tr4_flyby_camera_t*)malloc(this->flyby_cameras_count * sizeof(tr4_flyby_camera_t));
@@ -692,8 +555,7 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
 
     this->overlaps_count = read_bitu32(newsrc);
     this->overlaps = (uint16_t*)malloc(this->overlaps_count * sizeof(uint16_t));
-    for (i = 0; i < this->overlaps_count; i++)
-        this->overlaps[i] = read_bitu16(newsrc);
+    read_bitu16_array(newsrc, this->overlaps, this->overlaps_count);
 
     // Zones
     for (i = 0; i < this->boxes_count; i++)
@@ -701,10 +563,7 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
 
     this->animated_textures_count = read_bitu32(newsrc);
     this->animated_textures = (uint16_t*)malloc(this->animated_textures_count * sizeof(uint16_t));
-    for (i = 0; i < this->animated_textures_count; i++)
-    {
-        this->animated_textures[i] = read_bitu16(newsrc);
-    }
+    read_bitu16_array(newsrc, this->animated_textures, this->animated_textures_count);
 
     this->animated_textures_uv_count = read_bitu8(newsrc);
 
@@ -745,13 +604,12 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
 
     this->demo_data_count = read_bitu16(newsrc);
     this->demo_data = (uint8_t*)malloc(this->demo_data_count * sizeof(uint8_t));
-    for(i=0; i < this->demo_data_count; i++)
-        this->demo_data[i] = read_bitu8(newsrc);
+    if (TR_Reader_Read(newsrc, this->demo_data, 1, this->demo_data_count) < this->demo_data_count)
+        Sys_extError("read_tr4_level: demo_data");
 
     // Soundmap
     this->soundmap = (int16_t*)malloc(TR_AUDIO_MAP_SIZE_TR4 * sizeof(int16_t));
-    for(i=0; i < TR_AUDIO_MAP_SIZE_TR4; i++)
-        this->soundmap[i] = read_bit16(newsrc);
+    read_bit16_array(newsrc, this->soundmap, TR_AUDIO_MAP_SIZE_TR4);
 
     this->sound_details_count = 0;
     i = read_bitu32(newsrc);
@@ -788,10 +646,10 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
         this->sample_indices = NULL;
     }
 
-    SDL_RWclose(newsrc);
+    TR_Reader_Close(newsrc);
     newsrc = NULL;
-    delete [] uncomp_buffer;
-    uncomp_buffer = NULL;
+    free(chunks[3].data);
+    chunks[3].data = NULL;
 
     // LOAD SAMPLES
 
@@ -800,9 +658,8 @@ void TR_Level::read_tr4_level(SDL_RWops * const _src)
     {
         // Since sample data is the last part, we simply load whole last
         // block of file as single array.
-        this->samples_data_size = (uint32_t) (SDL_RWsize(src) - SDL_RWtell(src));
+        this->samples_data_size = (uint32_t) (TR_Reader_Size(src) - TR_Reader_Tell(src));
         this->samples_data = (uint8_t*)malloc(this->samples_data_size * sizeof(uint8_t));
-        for(i = 0; i < this->samples_data_size; i++)
-            this->samples_data[i] = read_bitu8(src);
+        TR_Reader_Read(src, this->samples_data, 1, this->samples_data_size);
     }
 }
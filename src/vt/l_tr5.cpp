@@ -20,13 +20,12 @@
  */
 
 #include <SDL2/SDL.h>
-#include <zlib.h>
 #include "l_main.h"
 #include "../core/system.h"
 
 #define RCSID "$Id: l_tr5.cpp,v 1.14 2002/09/20 15:59:02 crow Exp $"
 
-void TR_Level::read_tr5_room_light(SDL_RWops * const src, tr5_room_light_t & light)
+void TR_Level::read_tr5_room_light(tr_reader_t * const src, tr5_room_light_t & light)
 {
     uint32_t temp;
 
@@ -63,7 +62,7 @@ void TR_Level::read_tr5_room_light(SDL_RWops * const src, tr5_room_light_t & lig
         Sys_extWarn("read_tr5_room_light: seperator4 has wrong value");
 }
 
-void TR_Level::read_tr5_room_layer(SDL_RWops * const src, tr5_room_layer_t & layer)
+void TR_Level::read_tr5_room_layer(tr_reader_t * const src, tr5_room_layer_t & layer)
 {
     layer.num_vertices = read_bitu16(src);
     layer.unknown_l1 = read_bitu16(src);
@@ -100,7 +99,7 @@ void TR_Level::read_tr5_room_layer(SDL_RWops * const src, tr5_room_layer_t & lay
     layer.unknown_l8b = read_bit16(src);
 }
 
-void TR_Level::read_tr5_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & vert)
+void TR_Level::read_tr5_room_vertex(tr_reader_t * const src, tr5_room_vertex_t & vert)
 {
     read_tr4_vertex_float(src, vert.vertex);
     read_tr4_vertex_float(src, vert.normal);
@@ -110,7 +109,7 @@ void TR_Level::read_tr5_room_vertex(SDL_RWops * const src, tr5_room_vertex_t & v
     vert.colour.a = read_bitu8(src) / 255.0f;
 }
 
-void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
+void TR_Level::read_tr5_room(tr_reader_t * const src, tr5_room_t & room)
 {
     uint32_t room_data_size;
     //uint32_t portal_offset;
@@ -123,25 +122,21 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
     uint32_t vertices_size;
     //uint32_t light_size;
 
-    SDL_RWops *newsrc = NULL;
+    tr_reader_t *newsrc = NULL;
     uint32_t temp;
     uint32_t i;
-    uint8_t *buffer;
 
     if (read_bitu32(src) != 0x414C4558)
         Sys_extError("read_tr5_room: 'XELA' not found");
 
     room_data_size = read_bitu32(src);
-    buffer = new uint8_t[room_data_size];
-
-    if (SDL_RWread(src, buffer, 1, room_data_size) < room_data_size)
+    if ((uint64_t)src->pos + room_data_size > src->size)
         Sys_extError("read_tr5_room: room_data");
 
-    if ((newsrc = SDL_RWFromMem(buffer, room_data_size)) == NULL)
-    {
-        delete [] buffer;
-        Sys_extError("read_tr5_room: SDL_RWFromMem");
-    }
+    // room is parsed in place from the level data.
+    if ((newsrc = TR_Reader_Create(src->data + src->pos, room_data_size)) == NULL)
+        Sys_extError("read_tr5_room: TR_Reader_Create");
+    src->pos += room_data_size;
 
     room.intensity1 = 32767;
     room.intensity2 = 32767;
@@ -257,8 +252,7 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
     /*light_size = */read_bitu32(newsrc);
     if (read_bitu32(newsrc) != room.num_lights)
     {
-        SDL_RWclose(newsrc);
-        delete [] buffer;
+        TR_Reader_Close(newsrc);
         Sys_extError("read_tr5_room: room.num_lights2 != room.num_lights");
     }
 
@@ -288,16 +282,14 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
     poly_offset2 = read_bitu32(newsrc);
     if (poly_offset != poly_offset2)
     {
-        SDL_RWclose(newsrc);
-        delete [] buffer;
+        TR_Reader_Close(newsrc);
         Sys_extError("read_tr5_room: poly_offset != poly_offset2");
     }
 
     vertices_size = read_bitu32(newsrc);
     if ((vertices_size % 28) != 0)
     {
-        SDL_RWclose(newsrc);
-        delete [] buffer;
+        TR_Reader_Close(newsrc);
         Sys_extError("read_tr5_room: vertices_size has wrong value");
     }
 
@@ -317,7 +309,7 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
     for (i = 0; i < room.num_lights; i++)
         read_tr5_room_light(newsrc, room.lights[i]);
 
-    SDL_RWseek(newsrc, 208 + sector_data_offset, SEEK_SET);
+    TR_Reader_Seek(newsrc, 208 + sector_data_offset, SEEK_SET);
 
     room.sector_list = (tr_room_sector_t*)malloc(room.num_zsectors * room.num_xsectors * sizeof(tr_room_sector_t));
     for (i = 0; i < (uint32_t)(room.num_zsectors * room.num_xsectors); i++)
@@ -328,7 +320,7 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
         {
             if (room.portal_offset != (room.sector_data_offset + (room.num_zsectors * room.num_xsectors * 8)))
             throw TR_ReadError("read_tr5_room: portal_offset has wrong value");
-            SDL_RWseek(newsrc, 208 + room.portal_offset, SEEK_SET);
+            TR_Reader_Seek(newsrc, 208 + room.portal_offset, SEEK_SET);
         }
      */
 
@@ -337,19 +329,19 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
     for (i = 0; i < room.num_portals; i++)
         read_tr_room_portal(newsrc, room.portals[i]);
 
-    SDL_RWseek(newsrc, 208 + static_meshes_offset, SEEK_SET);
+    TR_Reader_Seek(newsrc, 208 + static_meshes_offset, SEEK_SET);
 
     room.static_meshes = (tr2_room_staticmesh_t*)malloc(room.num_static_meshes * sizeof(tr2_room_staticmesh_t));
     for (i = 0; i < room.num_static_meshes; i++)
         read_tr4_room_staticmesh(newsrc, room.static_meshes[i]);
 
-    SDL_RWseek(newsrc, 208 + layer_offset, SEEK_SET);
+    TR_Reader_Seek(newsrc, 208 + layer_offset, SEEK_SET);
 
     room.layers = (tr5_room_layer_t*)malloc(room.num_layers * sizeof(tr5_room_layer_t));
     for (i = 0; i < room.num_layers; i++)
         read_tr5_room_layer(newsrc, room.layers[i]);
 
-    SDL_RWseek(newsrc, 208 + poly_offset, SEEK_SET);
+    TR_Reader_Seek(newsrc, 208 + poly_offset, SEEK_SET);
 
     {
         uint32_t vertex_index = 0;
@@ -380,7 +372,7 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
         }
     }
 
-    SDL_RWseek(newsrc, 208 + vertices_offset, SEEK_SET);
+    TR_Reader_Seek(newsrc, 208 + vertices_offset, SEEK_SET);
 
     {
         uint32_t vertex_index = 0;
@@ -395,26 +387,24 @@ void TR_Level::read_tr5_room(SDL_RWops * const src, tr5_room_t & room)
         }
     }
 
-    SDL_RWseek(newsrc, room_data_size, SEEK_SET);
+    TR_Reader_Seek(newsrc, room_data_size, SEEK_SET);
 
-    SDL_RWclose(newsrc);
+    TR_Reader_Close(newsrc);
     newsrc = NULL;
-    delete [] buffer;
 }
 
-void TR_Level::read_tr5_moveable(SDL_RWops * const src, tr_moveable_t & moveable)
+void TR_Level::read_tr5_moveable(tr_reader_t * const src, tr_moveable_t & moveable)
 {
     read_tr_moveable(src, moveable);
     if (read_bitu16(src) != 0xFFEF)
         Sys_extWarn("read_tr5_moveable: filler has wrong value");
 }
 
-void TR_Level::read_tr5_level(SDL_RWops * const src)
+void TR_Level::read_tr5_level(tr_reader_t * const src)
 {
     uint32_t i;
-    uint8_t *comp_buffer = NULL;
-    uint8_t *uncomp_buffer = NULL;
-    SDL_RWops *newsrc = NULL;
+    tr_packed_chunk_t chunks[3];    // textiles32, textiles16, misc textiles32
+    tr_reader_t *newsrc = NULL;
 
     // Version
     uint32_t file_version = read_bitu32(src);
@@ -429,131 +419,55 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
     this->num_misc_textiles = 0;
     this->read_32bit_textiles = false;
 
-    uint32_t uncomp_size;
-    uint32_t comp_size;
-    unsigned long size;
-
     this->num_room_textiles = read_bitu16(src);
     this->num_obj_textiles = read_bitu16(src);
     this->num_bump_textiles = read_bitu16(src);
     this->num_misc_textiles = 3;
     this->num_textiles = this->num_room_textiles + this->num_obj_textiles + this->num_bump_textiles + this->num_misc_textiles;
 
-    uncomp_size = read_bitu32(src);
-    if (uncomp_size == 0)
-        Sys_extError("read_tr5_level: textiles32 uncomp_size == 0");
+    read_packed_chunk(src, chunks[0], "read_tr5_level: textiles32");
+    read_packed_chunk(src, chunks[1], "read_tr5_level: textiles16");
+    read_packed_chunk(src, chunks[2], "read_tr5_level: textiles32d");
 
-    comp_size = read_bitu32(src);
-    if (comp_size > 0)
+    // 16-bit textiles are needed only if there are no 32-bit ones.
+    if (chunks[0].comp_size > 0)
+        chunks[1].comp_size = 0;
+
+    unpack_chunks(chunks, 3);
+
+    if (chunks[0].data)
     {
-        comp_buffer = new uint8_t[comp_size];
         this->textile32_count = this->num_textiles;
         this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
 
-        if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-        {
-            delete [] comp_buffer;
-            Sys_extError("read_tr5_level: textiles32");
-        }
-
-        uncomp_buffer = new uint8_t[uncomp_size];
-        size = uncomp_size;
-        if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-        {
-            delete [] comp_buffer;
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr5_level: uncompress");
-        }
-
-        delete [] comp_buffer;
-        comp_buffer = NULL;
-        if (size != uncomp_size)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr5_level: uncompress size mismatch");
-        }
-
-        if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr5_level: SDL_RWFromMem");
-        }
-
+        newsrc = TR_Reader_Create(chunks[0].data, chunks[0].uncomp_size);
         for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
             read_tr4_textile32(newsrc, this->textile32[i]);
-
-        SDL_RWclose(newsrc);
+        TR_Reader_Close(newsrc);
         newsrc = NULL;
-        delete [] uncomp_buffer;
-        uncomp_buffer = NULL;
+        free(chunks[0].data);
+        chunks[0].data = NULL;
 
         this->read_32bit_textiles = true;
     }
 
-    uncomp_size = read_bitu32(src);
-    if (uncomp_size == 0)
-        Sys_extError("read_tr5_level: textiles16 uncomp_size == 0");
-
-    comp_size = read_bitu32(src);
-    if (comp_size > 0)
+    if (chunks[1].data)
     {
-        if (this->textile32_count == 0)
-        {
-            comp_buffer = new uint8_t[comp_size];
-            this->textile16_count = this->num_textiles;
-            this->textile16 = (tr2_textile16_t*)malloc(this->textile16_count * sizeof(tr2_textile16_t));
-
-            if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-            {
-                delete [] comp_buffer;
-                Sys_extError("read_tr5_level: textiles16");
-            }
+        this->textile16_count = this->num_textiles;
+        this->textile16 = (tr2_textile16_t*)malloc(this->textile16_count * sizeof(tr2_textile16_t));
 
-            uncomp_buffer = new uint8_t[uncomp_size];
-            size = uncomp_size;
-            if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-            {
-                delete [] comp_buffer;
-                delete [] uncomp_buffer;
-                Sys_extError("read_tr5_level: uncompress");
-            }
-            delete [] comp_buffer;
-            comp_buffer = NULL;
-
-            if (size != uncomp_size)
-            {
-                delete [] uncomp_buffer;
-                Sys_extError("read_tr5_level: uncompress size mismatch");
-            }
-
-            if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-            {
-                delete [] uncomp_buffer;
-                Sys_extError("read_tr5_level: SDL_RWFromMem");
-            }
-
-            for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
-                read_tr2_textile16(newsrc, this->textile16[i]);
-
-            SDL_RWclose(newsrc);
-            newsrc = NULL;
-            delete [] uncomp_buffer;
-            uncomp_buffer = NULL;
-        }
-        else
-        {
-            SDL_RWseek(src, comp_size, SEEK_CUR);
-        }
+        newsrc = TR_Reader_Create(chunks[1].data, chunks[1].uncomp_size);
+        for (i = 0; i < (this->num_textiles - this->num_misc_textiles); i++)
+            read_tr2_textile16(newsrc, this->textile16[i]);
+        TR_Reader_Close(newsrc);
+        newsrc = NULL;
+        free(chunks[1].data);
+        chunks[1].data = NULL;
     }
 
-    uncomp_size = read_bitu32(src);
-    if (uncomp_size == 0)
-        Sys_extError("read_tr5_level: textiles32d uncomp_size == 0");
-
-    comp_size = read_bitu32(src);
-    if (comp_size > 0)
+    if (chunks[2].data)
     {
-        if ((uncomp_size / (256 * 256 * 4)) > 3)
+        if ((chunks[2].uncomp_size / (256 * 256 * 4)) > 3)
             Sys_extWarn("read_tr5_level: num_misc_textiles > 3");
 
         if (this->textile32_count == 0)
@@ -562,43 +476,13 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
             this->textile32 = (tr4_textile32_t*)malloc(this->textile32_count * sizeof(tr4_textile32_t));
         }
 
-        comp_buffer = new uint8_t[comp_size];
-        if (SDL_RWread(src, comp_buffer, 1, comp_size) < comp_size)
-        {
-            delete [] comp_buffer;
-            Sys_extError("read_tr5_level: misc_textiles");
-        }
-
-        uncomp_buffer = new uint8_t[uncomp_size];
-        size = uncomp_size;
-        if (uncompress(uncomp_buffer, &size, comp_buffer, comp_size) != Z_OK)
-        {
-            delete [] uncomp_buffer;
-            delete [] comp_buffer;
-            Sys_extError("read_tr5_level: uncompress");
-        }
-        delete [] comp_buffer;
-        comp_buffer = NULL;
-
-        if (size != uncomp_size)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr5_level: uncompress size mismatch");
-        }
-
-        if ((newsrc = SDL_RWFromMem(uncomp_buffer, uncomp_size)) == NULL)
-        {
-            delete [] uncomp_buffer;
-            Sys_extError("read_tr5_level: SDL_RWFromMem");
-        }
-
+        newsrc = TR_Reader_Create(chunks[2].data, chunks[2].uncomp_size);
         for (i = (this->num_textiles - this->num_misc_textiles); i < this->num_textiles; i++)
             read_tr4_textile32(newsrc, this->textile32[i]);
-
-        SDL_RWclose(newsrc);
+        TR_Reader_Close(newsrc);
         newsrc = NULL;
-        delete [] uncomp_buffer;
-        uncomp_buffer = NULL;
+        free(chunks[2].data);
+        chunks[2].data = NULL;
     }
 
     // flags?
@@ -653,8 +537,7 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->floor_data_size = read_bitu32(src);
     this->floor_data = (uint16_t*)malloc(this->floor_data_size * sizeof(uint16_t));
-    for(i = 0; i < this->floor_data_size; i++)
-        this->floor_data[i] = read_bitu16(src);
+    read_bitu16_array(src, this->floor_data, this->floor_data_size);
 
     read_mesh_data(src);
 
@@ -677,13 +560,11 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->anim_commands_count = read_bitu32(src);
     this->anim_commands = (int16_t*)malloc(this->anim_commands_count * sizeof(int16_t));
-    for (i = 0; i < this->anim_commands_count; i++)
-        this->anim_commands[i] = read_bit16(src);
+    read_bit16_array(src, this->anim_commands, this->anim_commands_count);
 
     this->mesh_tree_data_size = read_bitu32(src);
     this->mesh_tree_data = (uint32_t*)malloc(this->mesh_tree_data_size * sizeof(uint32_t));
-    for (i = 0; i < this->mesh_tree_data_size; i++)
-        this->mesh_tree_data[i] = read_bitu32(src);                     // 4 bytes
+    read_bitu32_array(src, this->mesh_tree_data, this->mesh_tree_data_size);
 
     read_frame_moveable_data(src);
 
@@ -769,8 +650,7 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->overlaps_count = read_bitu32(src);
     this->overlaps = (uint16_t*)malloc(this->overlaps_count * sizeof(uint16_t));
-    for (i = 0; i < this->overlaps_count; i++)
-        this->overlaps[i] = read_bitu16(src);
+    read_bitu16_array(src, this->overlaps, this->overlaps_count);
 
     // Zones
     for (i = 0; i < this->boxes_count; i++)
@@ -778,10 +658,7 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->animated_textures_count = read_bitu32(src);
     this->animated_textures = (uint16_t*)malloc(this->animated_textures_count * sizeof(uint16_t));
-    for (i = 0; i < this->animated_textures_count; i++)
-    {
-        this->animated_textures[i] = read_bitu16(src);
-    }
+    read_bitu16_array(src, this->animated_textures, this->animated_textures_count);
 
     this->animated_textures_uv_count = read_bitu8(src);
 
@@ -829,13 +706,12 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->demo_data_count = read_bitu16(src);
     this->demo_data = (uint8_t*)malloc(this->demo_data_count * sizeof(uint8_t));
-    for(i=0; i < this->demo_data_count; i++)
-        this->demo_data[i] = read_bitu8(src);
+    if (TR_Reader_Read(src, this->demo_data, 1, this->demo_data_count) < this->demo_data_count)
+        Sys_extError("read_tr5_level: demo_data");
 
     // Soundmap
     this->soundmap = (int16_t*)malloc(TR_AUDIO_MAP_SIZE_TR5 * sizeof(int16_t));
-    for(i=0; i < TR_AUDIO_MAP_SIZE_TR5; i++)
-        this->soundmap[i] = read_bit16(src);
+    read_bit16_array(src, this->soundmap, TR_AUDIO_MAP_SIZE_TR5);
 
     this->sound_details_count = read_bitu32(src);
     this->sound_details = (tr_sound_details_t*)malloc(this->sound_details_count * sizeof(tr_sound_details_t));
@@ -853,10 +729,9 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
 
     this->sample_indices_count = read_bitu32(src);
     this->sample_indices = (uint32_t*)malloc(this->sample_indices_count * sizeof(uint32_t));
-    for(i=0; i < this->sample_indices_count; i++)
-        this->sample_indices[i] = read_bitu32(src);
+    read_bitu32_array(src, this->sample_indices, this->sample_indices_count);
 
-    SDL_RWseek(src, 6, SEEK_CUR);   // In TR5, sample indices are followed by 6 0xCD bytes. - correct - really 0xCDCDCDCDCDCD
+    TR_Reader_Seek(src, 6, SEEK_CUR);   // In TR5, sample indices are followed by 6 0xCD bytes. - correct - really 0xCDCDCDCDCDCD
 
     // LOAD SAMPLES
     this->samples_count = read_bitu32(src);                                                       // Read num samples
@@ -864,9 +739,8 @@ void TR_Level::read_tr5_level(SDL_RWops * const src)
     {
         // Since sample data is the last part, we simply load whole last
         // block of file as single array.
-        this->samples_data_size = SDL_RWsize(src) - SDL_RWtell(src);
+        this->samples_data_size = TR_Reader_Size(src) - TR_Reader_Tell(src);
         this->samples_data = (uint8_t*)malloc(this->samples_data_size * sizeof(uint8_t));
-        for(i = 0; i < this->samples_data_size; i++)
-            this->samples_data[i] = read_bitu8(src);
+        TR_Reader_Read(src, this->samples_data, 1, this->samples_data_size);
     }
 }
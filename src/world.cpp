@@ -17,6 +17,7 @@ extern "C" {
 #include "core/vmath.h"
 #include "core/polygon.h"
 #include "core/obb.h"
+#include "core/jobs.h"
 #include "render/camera.h"
 #include "render/frustum.h"
 #include "render/render.h"
@@ -41,6 +42,25 @@ extern "C" {
 #include "trigger.h"
 
 
+/*
+ * Uniform 2D grid of real rooms by sector sized cells: a cell lists rooms
+ * whose box covers it, in ids order. Rooms boxes and real rooms do not
+ * change on flips (rooms swap contents only), so the grid is built once.
+ */
+#define ROOM_GRID_MAX_CELLS     (1 << 20)
+
+typedef struct room_grid_s
+{
+    float                           min[2];
+    float                           cell_size;
+    uint32_t                        size_x;
+    uint32_t                        size_y;
+    uint32_t                       *cell_offset;            // cell rooms: rooms[cell_offset[c] .. cell_offset[c + 1]]
+    struct room_s                 **rooms;
+    uint32_t                       *room_stamps;            // for rooms uniqueness in area queries
+    uint32_t                        stamp;
+}room_grid_t, *room_grid_p;
+
  struct world_s
 {
     char                           *name;
@@ -52,6 +72,7 @@ extern "C" {
 
     uint32_t                        room_boxes_count;
     struct room_box_s              *room_boxes;
+    struct room_grid_s              room_grid;
 
     struct box_overlap_s           *overlaps;
     uint32_t                        overlaps_count;
@@ -105,7 +126,7 @@ void World_AutoexecOpen();
 bool Res_CreateEntityFunc(lua_State *lua, const char* func_name, int entity_id);
 
 
-void World_GenTextures(class VT_Level *tr);
+void World_GenTextures(class VT_Level *tr, const char *cache_path, uint64_t level_hash);
 void World_GenAnimTextures(class VT_Level *tr);
 void World_GenMeshes(class VT_Level *tr);
 void World_GenSprites(class VT_Level *tr);
@@ -125,6 +146,8 @@ void World_GenRoomCollision();
 void World_FixRooms();
 void World_BuildNearRoomsList(struct room_s *room);
 void World_BuildOverlappedRoomsList(struct room_s *room);
+void World_GenRoomGrid();
+void World_ClearRoomGrid();
 
 extern "C" void AVL_DeleteEntity(void *p) { Entity_Delete((entity_p)p); }
 extern "C" void AVL_DeleteItem(void *p) { BaseItem_Delete((base_item_p)p); }
@@ -155,6 +178,7 @@ void World_Prepare()
     global_world.textures = 0;
     global_world.room_boxes = NULL;
     global_world.room_boxes_count = 0;
+    memset(&global_world.room_grid, 0x00, sizeof(global_world.room_grid));
     global_world.overlaps = NULL;
     global_world.overlaps_count = 0;
     global_world.cameras_sinks = NULL;
@@ -174,11 +198,71 @@ void World_Prepare()
 }
 
 
+/*
+ * Level cache file: base_path/cache/<level path with '_' separators><ext>,
+ * it is checked by level file hash, so a stale one is just rewritten.
+ */
+static void World_GetLevelCachePath(char *buf, size_t buf_size, const char *path, const char *ext, bool make_dir)
+{
+    const char *base_path = Engine_GetBasePath();
+    size_t base_len = strlen(base_path);
+    size_t len;
+
+    if(strncmp(path, base_path, base_len) == 0)
+    {
+        path += base_len;
+    }
+
+    strncpy(buf, base_path, buf_size - 1);
+    buf[buf_size - 1] = 0;
+    strncat(buf, "cache", buf_size - strlen(buf) - 1);
+    if(make_dir)
+    {
+        Sys_MakeDir(buf);
+    }
+    strncat(buf, "/", buf_size - strlen(buf) - 1);
+    len = strlen(buf);
+    strncat(buf, path, buf_size - len - 1);
+    for(char *ch = buf + len; *ch; ch++)
+    {
+        *ch = ((*ch == '/') || (*ch == '\\') || (*ch == ':')) ? ('_') : (*ch);
+    }
+    strncat(buf, ext, buf_size - strlen(buf) - 1);
+}
+
+
 void World_Open(const char *path, int trv)
 {
     VT_Level *tr = new VT_Level();
-    tr->read_level(path, trv);
-    tr->prepare_level();
+    char cache_path[1024];
+    uint64_t level_size = 0;
+    uint64_t level_hash = VT_Level::get_file_hash(path, &level_size);
+
+    World_GetLevelCachePath(cache_path, sizeof(cache_path), path, ".cache", false);
+    if(tr->read_cache(cache_path, level_hash, level_size))
+    {
+        tr->set_sfx_path(path);
+    }
+    else
+    {
+        delete tr;
+        tr = new VT_Level();
+        if(tr->read_level(path, trv))
+        {
+            tr->prepare_level();
+            World_GetLevelCachePath(cache_path, sizeof(cache_path), path, ".cache", true);
+            if(!tr->write_cache(cache_path, level_hash, level_size))
+            {
+                Sys_DebugLog(SYS_LOG_FILENAME, "Can not write level cache \"%s\"\n", cache_path);
+            }
+        }
+        else
+        {
+            // nothing was read, never cache an empty level under this file hash
+            Sys_DebugLog(SYS_LOG_FILENAME, "Can not read level \"%s\"\n", path);
+            tr->prepare_level();
+        }
+    }
     //tr_level->dump_textures();
     World_Clear();
 
@@ -187,7 +271,8 @@ void World_Open(const char *path, int trv)
     World_ScriptsOpen(path);            // Open configuration scripts.
     Gui_DrawLoadScreen(200);
 
-    World_GenTextures(tr);              // Generate OGL textures
+    World_GetLevelCachePath(cache_path, sizeof(cache_path), path, ".textures", true);
+    World_GenTextures(tr, cache_path, level_hash);   // Generate OGL textures
     Gui_DrawLoadScreen(300);
 
     World_GenAnimTextures(tr);          // Generate animated textures
@@ -294,6 +379,7 @@ void World_Clear()
     /* Now we can delete physics misc objects */
     Physics_CleanUpObjects();
 
+    World_ClearRoomGrid();
     for(uint32_t i = 0; i < global_world.rooms_count; i++)
     {
         Room_Clear(global_world.rooms + i);
@@ -318,6 +404,8 @@ void World_Clear()
         free(global_world.room_boxes);
         global_world.room_boxes = NULL;
     }
+    Room_ClearPathSearch();
+    Room_ClearBoxesGraph();
 
     if(global_world.overlaps_count)
     {
@@ -823,14 +911,31 @@ struct room_s *World_GetRoomByID(uint32_t id)
 }
 
 
+static void World_RoomGridCell(float pos[3], uint32_t *first, uint32_t *last)
+{
+    room_grid_p grid = &global_world.room_grid;
+    int32_t x = (pos[0] - grid->min[0]) / grid->cell_size;
+    int32_t y = (pos[1] - grid->min[1]) / grid->cell_size;
+    if(grid->cell_offset && (pos[0] >= grid->min[0]) && (pos[1] >= grid->min[1]) &&
+       ((uint32_t)x < grid->size_x) && ((uint32_t)y < grid->size_y))
+    {
+        uint32_t cell = x * grid->size_y + y;
+        *first = grid->cell_offset[cell];
+        *last = grid->cell_offset[cell + 1];
+    }
+}
+
+
 struct room_s *World_FindRoomByPos(float pos[3])
 {
     const float z_margin = TR_METERING_SECTORSIZE / 2.0f;
-    room_p r = global_world.rooms;
-    for(uint32_t i = 0; i < global_world.rooms_count; i++, r++)
+    uint32_t first = 0, last = 0;
+
+    World_RoomGridCell(pos, &first, &last);
+    for(uint32_t i = first; i < last; i++)
     {
-        if((r == r->real_room) &&
-           (pos[0] >= r->bb_min[0]) && (pos[0] < r->bb_max[0]) &&
+        room_p r = global_world.room_grid.rooms[i];
+        if((pos[0] >= r->bb_min[0]) && (pos[0] < r->bb_max[0]) &&
            (pos[1] >= r->bb_min[1]) && (pos[1] < r->bb_max[1]) &&
            (pos[2] >= r->bb_min[2] - z_margin) && (pos[2] < r->bb_max[2]))
         {
@@ -846,6 +951,57 @@ struct room_s *World_FindRoomByPos(float pos[3])
 }
 
 
+uint32_t World_GetRoomsNearPos(struct room_s **rooms, uint32_t max_rooms, float pos[3], float radius)
+{
+    const float z_margin = TR_METERING_SECTORSIZE / 2.0f;
+    room_grid_p grid = &global_world.room_grid;
+    uint32_t ret = 0;
+    int32_t x0, y0, x1, y1;
+
+    if(!grid->cell_offset)
+    {
+        return 0;
+    }
+
+    x0 = (pos[0] - radius - grid->min[0]) / grid->cell_size;
+    y0 = (pos[1] - radius - grid->min[1]) / grid->cell_size;
+    x1 = (pos[0] + radius - grid->min[0]) / grid->cell_size;
+    y1 = (pos[1] + radius - grid->min[1]) / grid->cell_size;
+    x0 = (x0 < 0) ? (0) : (x0);
+    y0 = (y0 < 0) ? (0) : (y0);
+    x1 = (x1 < (int32_t)grid->size_x) ? (x1) : ((int32_t)grid->size_x - 1);
+    y1 = (y1 < (int32_t)grid->size_y) ? (y1) : ((int32_t)grid->size_y - 1);
+
+    if(++grid->stamp == 0)
+    {
+        memset(grid->room_stamps, 0x00, global_world.rooms_count * sizeof(uint32_t));
+        grid->stamp = 1;
+    }
+
+    for(int32_t x = x0; x <= x1; x++)
+    {
+        for(int32_t y = y0; y <= y1; y++)
+        {
+            uint32_t cell = x * grid->size_y + y;
+            for(uint32_t i = grid->cell_offset[cell]; (i < grid->cell_offset[cell + 1]) && (ret < max_rooms); i++)
+            {
+                room_p r = grid->rooms[i];
+                if((grid->room_stamps[r->id] != grid->stamp) &&
+                   (pos[0] + radius >= r->bb_min[0]) && (pos[0] - radius < r->bb_max[0]) &&
+                   (pos[1] + radius >= r->bb_min[1]) && (pos[1] - radius < r->bb_max[1]) &&
+                   (pos[2] + radius >= r->bb_min[2] - z_margin) && (pos[2] - radius < r->bb_max[2]))
+                {
+                    grid->room_stamps[r->id] = grid->stamp;
+                    rooms[ret++] = r;
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+
 struct room_s *World_FindRoomByPosCogerrence(float pos[3], struct room_s *old_room)
 {
     if(old_room == NULL)
@@ -1306,7 +1462,7 @@ void World_SetEntityFunction(struct entity_s *ent)
 }
 
 // Functions setting parameters from configuration scripts.
-void World_GenTextures(class VT_Level *tr)
+void World_GenTextures(class VT_Level *tr, const char *cache_path, uint64_t level_hash)
 {
     int border_size = renderer.settings.texture_border;
     border_size = (border_size < 0) ? (0) : (border_size);
@@ -1324,7 +1480,11 @@ void World_GenTextures(class VT_Level *tr)
 
     qglPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     qglPixelZoom(1, 1);
-    global_world.tex_atlas->createTextures(global_world.textures);
+    if(!renderer.settings.texture_compression ||
+       !global_world.tex_atlas->createCompressedTextures(global_world.textures, cache_path, level_hash))
+    {
+        global_world.tex_atlas->createTextures(global_world.textures);
+    }
 
     qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);   // Mag filter is always linear.
 
@@ -1471,16 +1631,30 @@ void World_GenAnimTextures(class VT_Level *tr)
 }
 
 
+static void World_GenMeshesJob(void *data, uint32_t first, uint32_t last)
+{
+    VT_Level *tr = (VT_Level*)data;
+    base_mesh_p base_mesh = global_world.meshes + first;
+
+    for(uint32_t i = first; i < last; i++, base_mesh++)
+    {
+        TR_GenMesh(base_mesh, i, global_world.anim_sequences, global_world.anim_sequences_count, global_world.tex_atlas, tr);
+        BaseMesh_GenFaces(base_mesh);
+    }
+}
+
+
 void World_GenMeshes(class VT_Level *tr)
 {
     base_mesh_p base_mesh;
 
     global_world.meshes_count = tr->meshes_count;
     base_mesh = global_world.meshes = (base_mesh_p)calloc(global_world.meshes_count, sizeof(base_mesh_t));
+    // geometry is built by workers, VBO upload stays on GL thread
+    Jobs_ParallelFor(World_GenMeshesJob, tr, global_world.meshes_count, 16);
     for(uint32_t i = 0; i < global_world.meshes_count; i++, base_mesh++)
     {
-        TR_GenMesh(base_mesh, i, global_world.anim_sequences, global_world.anim_sequences_count, global_world.tex_atlas, tr);
-        BaseMesh_GenFaces(base_mesh);
+        BaseMesh_GenVBO(base_mesh);
     }
 }
 
@@ -1579,6 +1753,7 @@ void World_GenBoxes(class VT_Level *tr)
             r_box->zone[1].FlyZone = tr->zones[i].FlyZone_Alternate;
         }
     }
+    Room_GenBoxesGraph();
 }
 
 
@@ -1725,6 +1900,7 @@ void World_GenRoom(struct room_s *room, class VT_Level *tr)
     room->content->physics_body = NULL;
     room->content->physics_alt_tween = NULL;
     room->content->mesh = NULL;
+    room->content->batch = NULL;
     room->content->static_mesh = NULL;
     room->content->sprites = NULL;
     room->content->sprites_vertices = NULL;
@@ -1742,6 +1918,7 @@ void World_GenRoom(struct room_s *room, class VT_Level *tr)
     if(room->content->mesh)
     {
         BaseMesh_GenFaces(room->content->mesh);
+        BaseMesh_GenVBO(room->content->mesh);
     }
     /*
      * let us load sectors
@@ -2045,6 +2222,7 @@ void World_GenRoom(struct room_s *room, class VT_Level *tr)
 
         r_static->physics_body = NULL;
         r_static->hide = 0;
+        r_static->batched = 0;
 
         // Disable static mesh collision, if flag value is 3 (TR1) or all bounding box
         // coordinates are equal (TR2-5).
@@ -2064,6 +2242,9 @@ void World_GenRoom(struct room_s *room, class VT_Level *tr)
         Physics_GenStaticMeshRigidBody(r_static);
     }
 
+    // Merge room and static meshes geometry, hide flags are already set.
+    Room_GenBatch(room);
+
     /*
      * sprites loading section
      */
@@ -2118,15 +2299,13 @@ void World_GenRoomFlipMap()
 }
 
 
-void World_GenSkeletalModels(class VT_Level *tr)
+static void World_GenSkeletalModelsJob(void *data, uint32_t first, uint32_t last)
 {
-    skeletal_model_p smodel;
+    VT_Level *tr = (VT_Level*)data;
+    skeletal_model_p smodel = global_world.skeletal_models + first;
     tr_moveable_t *tr_moveable;
 
-    global_world.skeletal_models_count = tr->moveables_count;
-    smodel = global_world.skeletal_models = (skeletal_model_p)calloc(global_world.skeletal_models_count, sizeof(skeletal_model_t));
-
-    for(uint32_t i = 0; i < global_world.skeletal_models_count; i++, smodel++)
+    for(uint32_t i = first; i < last; i++, smodel++)
     {
         tr_moveable = &tr->moveables[i];
         smodel->id = tr_moveable->object_id;
@@ -2137,6 +2316,15 @@ void World_GenSkeletalModels(class VT_Level *tr)
 }
 
 
+void World_GenSkeletalModels(class VT_Level *tr)
+{
+    global_world.skeletal_models_count = tr->moveables_count;
+    global_world.skeletal_models = (skeletal_model_p)calloc(global_world.skeletal_models_count, sizeof(skeletal_model_t));
+    // models are independent; frames interpolation is the heaviest part of loading
+    Jobs_ParallelFor(World_GenSkeletalModelsJob, tr, global_world.skeletal_models_count, 1);
+}
+
+
 void World_GenEntities(class VT_Level *tr)
 {
     int top;
@@ -2401,6 +2589,108 @@ void World_GenRoomProperties(class VT_Level *tr)
             Room_AddToNearRoomsList(r->content->near_room_list[j], r);
         }
     }
+
+    World_GenRoomGrid();
+}
+
+
+void World_GenRoomGrid()
+{
+    room_grid_p grid = &global_world.room_grid;
+    float max[2];
+    uint32_t *fill = NULL;
+
+    World_ClearRoomGrid();
+    if(global_world.rooms_count == 0)
+    {
+        return;
+    }
+
+    grid->min[0] = grid->min[1] = 0.0f;
+    max[0] = max[1] = 0.0f;
+    for(uint32_t i = 0; i < global_world.rooms_count; i++)
+    {
+        room_p r = global_world.rooms + i;
+        for(int k = 0; k < 2; k++)
+        {
+            grid->min[k] = ((i == 0) || (r->bb_min[k] < grid->min[k])) ? (r->bb_min[k]) : (grid->min[k]);
+            max[k] = ((i == 0) || (r->bb_max[k] > max[k])) ? (r->bb_max[k]) : (max[k]);
+        }
+    }
+
+    // huge sparse levels get bigger cells, to keep the grid in memory bounds
+    grid->cell_size = TR_METERING_SECTORSIZE;
+    do
+    {
+        grid->size_x = (max[0] - grid->min[0]) / grid->cell_size + 1;
+        grid->size_y = (max[1] - grid->min[1]) / grid->cell_size + 1;
+        grid->cell_size *= 2.0f;
+    }
+    while(grid->size_x * grid->size_y > ROOM_GRID_MAX_CELLS);
+    grid->cell_size *= 0.5f;
+
+    grid->cell_offset = (uint32_t*)calloc(grid->size_x * grid->size_y + 1, sizeof(uint32_t));
+    grid->room_stamps = (uint32_t*)calloc(global_world.rooms_count, sizeof(uint32_t));
+    grid->stamp = 0;
+
+    // two passes: count rooms per cell, then fill cells in rooms ids order
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(uint32_t i = 0; i < global_world.rooms_count; i++)
+        {
+            room_p r = global_world.rooms + i;
+            if(r == r->real_room)
+            {
+                uint32_t x0 = (r->bb_min[0] - grid->min[0]) / grid->cell_size;
+                uint32_t y0 = (r->bb_min[1] - grid->min[1]) / grid->cell_size;
+                uint32_t x1 = (r->bb_max[0] - grid->min[0]) / grid->cell_size;
+                uint32_t y1 = (r->bb_max[1] - grid->min[1]) / grid->cell_size;
+                x1 = (x1 < grid->size_x) ? (x1) : (grid->size_x - 1);
+                y1 = (y1 < grid->size_y) ? (y1) : (grid->size_y - 1);
+                for(uint32_t x = x0; x <= x1; x++)
+                {
+                    for(uint32_t y = y0; y <= y1; y++)
+                    {
+                        uint32_t cell = x * grid->size_y + y;
+                        if(pass == 0)
+                        {
+                            grid->cell_offset[cell + 1]++;
+                        }
+                        else
+                        {
+                            grid->rooms[fill[cell]++] = r;
+                        }
+                    }
+                }
+            }
+        }
+
+        if(pass == 0)
+        {
+            uint32_t cells_count = grid->size_x * grid->size_y;
+            for(uint32_t c = 0; c < cells_count; c++)
+            {
+                grid->cell_offset[c + 1] += grid->cell_offset[c];
+            }
+            grid->rooms = (room_p*)malloc((grid->cell_offset[cells_count] + 1) * sizeof(room_p));
+            fill = (uint32_t*)malloc(cells_count * sizeof(uint32_t));
+            memcpy(fill, grid->cell_offset, cells_count * sizeof(uint32_t));
+        }
+    }
+    free(fill);
+}
+
+
+void World_ClearRoomGrid()
+{
+    room_grid_p grid = &global_world.room_grid;
+    if(grid->cell_offset)
+    {
+        free(grid->cell_offset);
+        free(grid->rooms);
+        free(grid->room_stamps);
+    }
+    memset(grid, 0x00, sizeof(room_grid_t));
 }
 
 
@@ -43,6 +43,11 @@ struct skeletal_model_s* World_GetSkybox();
 struct room_s *World_GetRoomByID(uint32_t id);
 struct room_s *World_FindRoomByPos(float pos[3]);
 struct room_s *World_FindRoomByPosCogerrence(float pos[3], struct room_s *old_room);
+/*
+ * Fills rooms with up to max_rooms real rooms, whose boxes intersect the cube
+ * around pos; returns their count.
+ */
+uint32_t World_GetRoomsNearPos(struct room_s **rooms, uint32_t max_rooms, float pos[3], float radius);
 struct room_sector_s *World_GetRoomSector(int room_id, int x, int y);
 uint32_t World_GetRoomBoxesCount();
 struct room_box_s *World_GetRoomBoxByID(uint32_t id);